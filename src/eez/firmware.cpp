@@ -121,8 +121,6 @@ void boot() {
 
     bp3c::io_exp::init();
 
-    psu::ontime::g_mcuCounter.init();
-
     for (uint8_t slotIndex = 0; slotIndex < NUM_SLOTS; slotIndex++) {
         static const uint16_t ADDRESS = 0;
         uint16_t value[3];
@@ -140,10 +138,11 @@ void boot() {
         
         if (moduleType != MODULE_TYPE_NONE) {
             psu::persist_conf::loadModuleConf(slotIndex);
-            psu::ontime::g_moduleCounters[slotIndex].init();
         }
     }
 
+    psu::ontime::init();
+
     psu::persist_conf::init();
 
 #if OPTION_DISPLAY
@@ -345,13 +344,7 @@ void shutdown() {
 
     event_queue::shutdownSave();
 
-    // save on-time counters
-    persist_conf::writeTotalOnTime(ontime::g_mcuCounter.getType(), ontime::g_mcuCounter.getTotalTime());
-    for (int slotIndex = 0; slotIndex < NUM_SLOTS; slotIndex++) {
-        if (g_slots[slotIndex]->moduleInfo->moduleType != MODULE_TYPE_NONE) {
-            persist_conf::writeTotalOnTime(ontime::g_moduleCounters[slotIndex].getType(), ontime::g_moduleCounters[slotIndex].getTotalTime());
-        }
-    }
+    ontime::shutdownSave();
 
     if (g_restart) {
         delay(800);
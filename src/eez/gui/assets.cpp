@@ -45,27 +45,27 @@ static Assets g_externalAssets;
 static Assets *g_fixPointersAssets;
 
 void StyleList_fixPointers() {
-    g_fixPointersAssets->styles->first = (Style *)((uint8_t *)g_fixPointersAssets->styles + (uint32_t)g_fixPointersAssets->styles->first);
+    g_fixPointersAssets->styles->first.fix(g_fixPointersAssets->styles);
 }
 
 void WidgetList_fixPointers(WidgetList &widgetList) {
-    widgetList.first = (Widget *)((uint8_t *)g_fixPointersAssets->document + (uint32_t)widgetList.first);
+    widgetList.first.fix(g_fixPointersAssets->document);
     for (uint32_t i = 0; i < widgetList.count; ++i) {
         Widget_fixPointers((Widget *)widgetList.first + i);
     }
 }
 
 void ColorList_fixPointers(ColorList &colorList) {
-    colorList.first = (uint16_t *)((uint8_t *)g_fixPointersAssets->colorsData + (uint32_t)colorList.first);
+    colorList.first.fix(g_fixPointersAssets->colorsData);
 }
 
 void Theme_fixPointers(Theme *theme) {
-    theme->name = (const char *)((uint8_t *)g_fixPointersAssets->colorsData + (uint32_t)theme->name);
+    theme->name.fix(g_fixPointersAssets->colorsData);
     ColorList_fixPointers(theme->colors);
 }
 
 void ThemeList_fixPointers(ThemeList &themeList) {
-    themeList.first = (Theme *)((uint8_t *)g_fixPointersAssets->colorsData + (uint32_t)themeList.first);
+    themeList.first.fix(g_fixPointersAssets->colorsData);
     for (uint32_t i = 0; i < themeList.count; ++i) {
         Theme_fixPointers((Theme *)themeList.first + i);
     }
@@ -78,9 +78,9 @@ void ColorsData_fixPointers() {
 
 void NameList_fixPointers(NameList *nameList) {
     if (nameList) {
-        nameList->first = (const char **)((uint8_t *)nameList + (uint32_t)nameList->first);
+        nameList->first.fix(nameList);
         for (uint32_t i = 0; i < nameList->count; i++) {
-            nameList->first[i] = (const char *)((uint8_t *)nameList + (uint32_t)nameList->first[i]);
+            ((AssetsPtr<const char> *)nameList->first)[i].fix(nameList);
         }
     }
 }
@@ -130,7 +130,7 @@ static FixPointersFunctionType *g_fixWidgetPointersFunctions[] = {
 // };
 
 void Widget_fixPointers(Widget *widget) {
-    widget->specific = (void *)((uint8_t *)g_fixPointersAssets->document + (uint32_t)widget->specific);
+    widget->specific.fix(g_fixPointersAssets->document);
     if (*g_fixWidgetPointersFunctions[widget->type]) {
         (*g_fixWidgetPointersFunctions[widget->type])(widget, g_fixPointersAssets);
     }
@@ -153,14 +153,14 @@ void FLOAT_value_to_text(const Value &value, char *text, int count) {
             strcat(text, "< ");
         }
 
+        char *p = text + strlen(text);
         if (unit == UNIT_WATT || unit == UNIT_MILLI_WATT) {
-            strcatFloat(text, floatValue, 2);
+            p += floatToText(p, floatValue, 2, true);
         } else {
-            strcatFloat(text, floatValue);
+            p += floatToText(p, floatValue, -1, true);
         }
-        removeTrailingZerosFromFloat(text);
-        strcat(text, " ");
-        strcat(text, getUnitName(unit));
+        *p++ = ' ';
+        strcpy(p, getUnitName(unit));
     } else {
         text[0] = 0;
     }
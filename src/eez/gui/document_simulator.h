@@ -430,7 +430,8 @@ enum DataEnum {
     DATA_ID_SIMULATOR_LOAD2 = 428,
     DATA_ID_MAIN_APP_VIEW = 429,
     DATA_ID_FRONT_PANEL_SLOT2_VIEW = 430,
-    DATA_ID_FRONT_PANEL_SLOT3_VIEW = 431
+    DATA_ID_FRONT_PANEL_SLOT3_VIEW = 431,
+    DATA_ID_FILE_MANAGER_FILE_THUMBNAIL = 432
 };
 
 void data_none(DataOperationEnum operation, Cursor cursor, Value &value);
@@ -865,6 +866,7 @@ void data_simulator_load2(DataOperationEnum operation, Cursor cursor, Value &val
 void data_main_app_view(DataOperationEnum operation, Cursor cursor, Value &value);
 void data_front_panel_slot2_view(DataOperationEnum operation, Cursor cursor, Value &value);
 void data_front_panel_slot3_view(DataOperationEnum operation, Cursor cursor, Value &value);
+void data_file_manager_file_thumbnail(DataOperationEnum operation, Cursor cursor, Value &value);
 
 typedef void (*DataOperationsFunction)(DataOperationEnum operation, Cursor cursor, Value &value);
 
@@ -1933,4 +1935,4 @@ enum PagesEnum {
     PAGE_ID_FRONT_PANEL_NUMERIC_KEYPAD = 182
 };
 
-extern const uint8_t assets[518235];
+extern const uint8_t assets[518306];
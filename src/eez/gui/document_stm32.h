@@ -422,7 +422,8 @@ enum DataEnum {
     DATA_ID_DIB_MIO168_OUTPUT_NO = 420,
     DATA_ID_DIB_MIO168_OUTPUT_STATE = 421,
     DATA_ID_DIB_MIO168_ANALOG_INPUTS = 422,
-    DATA_ID_DIB_MIO168_ANALOG_INPUT_VALUE = 423
+    DATA_ID_DIB_MIO168_ANALOG_INPUT_VALUE = 423,
+    DATA_ID_FILE_MANAGER_FILE_THUMBNAIL = 424
 };
 
 void data_none(DataOperationEnum operation, Cursor cursor, Value &value);
@@ -849,6 +850,7 @@ void data_dib_mio168_output_no(DataOperationEnum operation, Cursor cursor, Value
 void data_dib_mio168_output_state(DataOperationEnum operation, Cursor cursor, Value &value);
 void data_dib_mio168_analog_inputs(DataOperationEnum operation, Cursor cursor, Value &value);
 void data_dib_mio168_analog_input_value(DataOperationEnum operation, Cursor cursor, Value &value);
+void data_file_manager_file_thumbnail(DataOperationEnum operation, Cursor cursor, Value &value);
 
 typedef void (*DataOperationsFunction)(DataOperationEnum operation, Cursor cursor, Value &value);
 
@@ -1874,4 +1876,4 @@ enum PagesEnum {
     PAGE_ID_DIB_DCM220_CH_SETTINGS_SPECIFIC = 172
 };
 
-extern const uint8_t assets[310180];
+extern const uint8_t assets[310262];
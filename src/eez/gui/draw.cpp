@@ -590,6 +590,7 @@ void drawLine(int x1, int y1, int x2, int y2) {
    float yinc = (float)dy / length;
    float x = (float)x1;
    float y = (float)y1;
+   mcu::display::beginPixelDrawing(MIN(x1, x2), MIN(y1, y2), MAX(x1, x2), MAX(y1, y2));
    for (int i = 0; i < length; i++) {
        mcu::display::drawPixel((int)roundf(x), (int)roundf(y));
        x += xinc;
@@ -604,6 +605,9 @@ void drawAntialiasedLine(int x0, int y0, int x1, int y1) {
     int err = dx - dy, e2, x2;                       /* error value e_xy */
     int ed = dx + dy == 0 ? 1 : (int)sqrt((float)dx*dx + (float)dy*dy);
 
+    // neighbour pixels can be one pixel outside of the line end points
+    mcu::display::beginPixelDrawing(MIN(x0, x1) - 1, MIN(y0, y1) - 1, MAX(x0, x1) + 1, MAX(y0, y1) + 1);
+
     for (; ; ) {                                         /* pixel loop */
         mcu::display::drawPixel(x0, y0, 255 - 255 * abs(err - dx + dy) / ed);
         e2 = err; x2 = x0;
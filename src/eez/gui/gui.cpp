@@ -38,6 +38,8 @@ namespace gui {
 bool g_isBlinkTime;
 static bool g_wasBlinkTime;
 
+static RunTimeStatistics g_frameStatistics;
+
 ////////////////////////////////////////////////////////////////////////////////
 
 #if OPTION_GUI_THREAD
@@ -87,6 +89,10 @@ void onGuiQueueMessage(uint8_t type, int16_t param) {
         getAppContextFromId(param)->doShowPage();
     } else if (type == GUI_QUEUE_MESSAGE_TYPE_PUSH_PAGE) {
         getAppContextFromId(param)->doPushPage();
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    } else if (type == GUI_QUEUE_MESSAGE_TYPE_TEST_LAYERS) {
+        mcu::display::doTestLayers();
+#endif
     } else {
         onGuiQueueMessageHook(type, param);
     }
@@ -139,6 +145,8 @@ void oneIter() {
     appContext->rect.w = mcu::display::getDisplayWidth();
     appContext->rect.h = mcu::display::getDisplayHeight();
 
+    uint32_t frameStartTime = micros();
+
     eventHandling();
     stateManagmentHook();
 
@@ -157,10 +165,16 @@ void oneIter() {
     if (wasOn || mcu::display::isOn()) {
         mcu::display::endBuffersDrawing();
     }
+
+    g_frameStatistics.add(micros() - frameStartTime);
 }
 
 #endif
 
+const RunTimeStatistics &getFrameStatistics() {
+    return g_frameStatistics;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 bool isPageInternal(int pageId) {
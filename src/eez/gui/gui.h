@@ -20,6 +20,7 @@
 
 #if OPTION_GUI_THREAD
 #include <cmsis_os.h>
+#include <eez/system.h>
 #endif
 
 #include <eez/gui/assets.h>
@@ -53,11 +54,17 @@ namespace gui {
 
 void startThread();
 
+// event handling and drawing duration of one GUI thread iteration
+const RunTimeStatistics &getFrameStatistics();
+
 extern osThreadId g_guiTaskHandle;
 extern osMessageQId g_guiMessageQueueId;
 
 #define GUI_QUEUE_MESSAGE_TYPE_SHOW_PAGE 1
 #define GUI_QUEUE_MESSAGE_TYPE_PUSH_PAGE 2
+#if defined(EEZ_PLATFORM_SIMULATOR)
+#define GUI_QUEUE_MESSAGE_TYPE_TEST_LAYERS 3
+#endif
 
 #define GUI_QUEUE_MESSAGE(type, param) ((((uint32_t)(uint16_t)(int16_t)param) << 8) | (type))
 #define GUI_QUEUE_MESSAGE_TYPE(message) ((message) & 0xFF)
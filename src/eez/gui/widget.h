@@ -18,6 +18,9 @@
 
 #pragma once
 
+#include <assert.h>
+#include <stdint.h>
+
 #include <eez/gui/geometry.h>
 
 namespace eez {
@@ -66,6 +69,94 @@ typedef void (*OnTouchFunctionType)(const WidgetCursor &widgetCursor, Event &tou
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// Pointer stored inside assets. In assets blob it is 32-bit offset from some base
+// (document, styles, colors, ...) which is replaced by the pointer in fixPointers.
+// On 64-bit platforms (simulator) pointer doesn't fit into 32 bits, so the offset
+// is replaced by the offset relative to the field itself.
+template <typename T, uint32_t ptrSize> struct AssetsPtrImpl;
+
+template <typename T> struct AssetsPtrImpl<T, 4> {
+    T *ptr;
+
+    void fix(const void *base) {
+        ptr = (T *)((const uint8_t *)base + (uint32_t)ptr);
+    }
+
+    AssetsPtrImpl &operator=(T *p) {
+        ptr = p;
+        return *this;
+    }
+
+    operator T *() const {
+        return ptr;
+    }
+
+    template <typename U> explicit operator U *() const {
+        return (U *)ptr;
+    }
+
+    T *operator->() const {
+        return ptr;
+    }
+};
+
+template <typename T> struct AssetsPtrImpl<T, 8> {
+    int32_t offset;
+
+    AssetsPtrImpl() : offset(0) {
+    }
+
+    AssetsPtrImpl(const AssetsPtrImpl &other) {
+        set(other.get());
+    }
+
+    void fix(const void *base) {
+        set((T *)((const uint8_t *)base + (uint32_t)offset));
+    }
+
+    AssetsPtrImpl &operator=(const AssetsPtrImpl &other) {
+        set(other.get());
+        return *this;
+    }
+
+    AssetsPtrImpl &operator=(T *p) {
+        set(p);
+        return *this;
+    }
+
+    operator T *() const {
+        return get();
+    }
+
+    template <typename U> explicit operator U *() const {
+        return (U *)get();
+    }
+
+    T *operator->() const {
+        return get();
+    }
+
+  private:
+    // zero offset is reserved for the null pointer, field never points to itself
+    void set(T *p) {
+        if (p) {
+            int64_t diff = (const uint8_t *)p - (const uint8_t *)this;
+            assert(diff != 0 && diff == (int32_t)diff);
+            offset = (int32_t)diff;
+        } else {
+            offset = 0;
+        }
+    }
+
+    T *get() const {
+        return offset ? (T *)((const uint8_t *)this + offset) : nullptr;
+    }
+};
+
+template <typename T> using AssetsPtr = AssetsPtrImpl<T, sizeof(void *)>;
+
+////////////////////////////////////////////////////////////////////////////////
+
 struct Bitmap {
     int16_t w;
     int16_t h;
@@ -117,7 +208,7 @@ struct Style {
 
 struct StyleList {
     uint32_t count;
-    const Style *first;
+    AssetsPtr<const Style> first;
 };
 
 void StyleList_fixPointers(StyleList &styleList);
@@ -133,14 +224,14 @@ struct Widget {
     int16_t w;
     int16_t h;
     uint16_t style;
-    const void *specific;
+    AssetsPtr<const void> specific;
 };
 
 void Widget_fixPointers(Widget *widget);
 
 struct WidgetList {
     uint32_t count;
-    const Widget *first;
+    AssetsPtr<const Widget> first;
 };
 
 void WidgetList_fixPointers(WidgetList &widgetList);
@@ -164,13 +255,13 @@ struct Document {
 
 struct ColorList {
     uint32_t count;
-    const uint16_t *first;
+    AssetsPtr<const uint16_t> first;
 };
 
 void ColorList_fixPointers(ColorList &colorList);
 
 struct Theme {
-    const char *name;
+    AssetsPtr<const char> name;
     ColorList colors;
 };
 
@@ -178,7 +269,7 @@ void Theme_fixPointers(Theme *theme);
 
 struct ThemeList {
     uint32_t count;
-    const Theme *first;
+    AssetsPtr<const Theme> first;
 };
 
 void ThemeList_fixPointers(ThemeList &themeList);
@@ -192,7 +283,7 @@ struct Colors {
 
 struct NameList {
     uint32_t count;
-    const char **first;
+    AssetsPtr<AssetsPtr<const char>> first;
 };
 
 struct Assets {
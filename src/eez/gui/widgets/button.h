@@ -22,7 +22,7 @@ namespace eez {
 namespace gui {
 
 struct ButtonWidget {
-    const char *text;
+    AssetsPtr<const char> text;
     int16_t enabled;
     uint16_t disabledStyle;
 };
@@ -34,8 +34,8 @@ namespace gui {
 struct ScrollBarWidget {
     uint16_t thumbStyle;
     uint16_t buttonsStyle;
-    const char *leftButtonText;
-	const char *rightButtonText;
+    AssetsPtr<const char> leftButtonText;
+	AssetsPtr<const char> rightButtonText;
 };
 
 enum ScrollBarWidgetSegment {
@@ -57,8 +57,8 @@ struct ScrollBarWidgetState {
 
 FixPointersFunctionType SCROLL_BAR_fixPointers = [](Widget *widget, Assets *assets) {
     ScrollBarWidget *scrollBarWidget = (ScrollBarWidget *)widget->specific;
-    scrollBarWidget->leftButtonText = (const char *)((uint8_t *)assets->document + (uint32_t)scrollBarWidget->leftButtonText);
-    scrollBarWidget->rightButtonText = (const char *)((uint8_t *)assets->document + (uint32_t)scrollBarWidget->rightButtonText);
+    scrollBarWidget->leftButtonText.fix(assets->document);
+    scrollBarWidget->rightButtonText.fix(assets->document);
 };
 
 EnumFunctionType SCROLL_BAR_enum = nullptr;
@@ -114,8 +114,9 @@ struct YTGraphDrawHelper {
 
         display::setColor16(dataColor16[valueIndex]);
 
+        // single pixel is also drawn as a line, so it stays in order with the other lines of the graph
         if (yPrev[valueIndex] == INT_MIN || abs(yPrev[valueIndex] - y[valueIndex]) <= 1) {
-            display::drawPixel(x, widgetCursor.y + y[valueIndex]);
+            display::drawVLine(x, widgetCursor.y + y[valueIndex], 0);
         } else {
             if (yPrev[valueIndex] < y[valueIndex]) {
                 display::drawVLine(x, widgetCursor.y + yPrev[valueIndex] + 1, y[valueIndex] - yPrev[valueIndex] - 1);
@@ -128,7 +129,7 @@ struct YTGraphDrawHelper {
     void drawStep() {
         if (y[0] != INT_MIN && y[1] != INT_MIN && abs(yPrev[0] - y[0]) <= 1 && abs(yPrev[1] - y[1]) <= 1 && y[0] == y[1]) {
             display::setColor16(position % 2 ? dataColor16[1] : dataColor16[0]);
-            display::drawPixel(x, widgetCursor.y + y[0]);
+            display::drawVLine(x, widgetCursor.y + y[0], 0);
         } else {
             drawValue(0);
             drawValue(1);
@@ -298,11 +299,7 @@ struct YTGraphStaticDrawHelper {
             yTo = widget->h - 1;
         }
 
-        if (yFrom == yTo) {
-            display::drawPixel(x, widgetCursor.y + yFrom);
-        } else {
-            display::drawVLine(x, widgetCursor.y + yFrom, yTo - yFrom);
-        }
+        display::drawVLine(x, widgetCursor.y + yFrom, yTo - yFrom);
     }
 
     void getMinMax(int *yLabels, int n, int &yMin, int &yMax) {
@@ -19,6 +19,7 @@
 #include <stdint.h>
 
 #include <eez/memory.h>
+#include <eez/util.h>
 #include <eez/libs/sd_fat/sd_fat.h>
 #include <eez/libs/image/bitmap.h>
 
@@ -70,19 +71,13 @@ uint16_t readUint16(const uint8_t *bytes) {
     return bytes[0] | (bytes[1] << 8);
 }
 
-bool bitmapDecode(const char *filePath, Image *image) {
-    eez::File file;
-    if (!file.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
-        return false;
-    }
-
+static bool readHeader(eez::File &file, uint32_t &offset, uint32_t &width, uint32_t &height) {
     uint32_t bytesRead;
 
     uint8_t bmpHeader[14];
 
     bytesRead = file.read(bmpHeader, sizeof(bmpHeader));
     if (bytesRead != sizeof(bmpHeader)) {
-        file.close();
         return false;
     }
 
@@ -90,36 +85,50 @@ bool bitmapDecode(const char *filePath, Image *image) {
 
     bytesRead = file.read(dibHeader, sizeof(dibHeader));
     if (bytesRead != sizeof(dibHeader)) {
-        file.close();
         return false;
     }
 
-    uint32_t offset = readUint32(bmpHeader + 10);
+    offset = readUint32(bmpHeader + 10);
 
-    uint32_t width = readUint32(dibHeader + 4);
-    if (width > 480) {
-        file.close();
+    width = readUint32(dibHeader + 4);
+    if (width == 0 || width > 480) {
         return false;
     }
 
-    uint32_t height = readUint32(dibHeader + 8);
-    if (height > 272) {
-        file.close();
+    height = readUint32(dibHeader + 8);
+    if (height == 0 || height > 272) {
         return false;
     }
 
     uint16_t numColorPlanes = readUint16(dibHeader + 12);
     if (numColorPlanes != 1) {
-        file.close();
         return false;
     }
 
     uint16_t bitsPerPixel = readUint16(dibHeader + 14);
     if (bitsPerPixel != 24) {
+        return false;
+    }
+
+    return true;
+}
+
+bool bitmapDecode(const char *filePath, Image *image) {
+    eez::File file;
+    if (!file.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
+        return false;
+    }
+
+    uint32_t offset;
+    uint32_t width;
+    uint32_t height;
+    if (!readHeader(file, offset, width, height)) {
         file.close();
         return false;
     }
 
+    uint32_t bytesRead;
+
     uint32_t lineBytes = width * 3;
 
     offset += height * lineBytes;
@@ -158,3 +167,87 @@ bool bitmapDecode(const char *filePath, Image *image) {
 
     return true;
 }
+
+// Same result as bitmapDecode followed by imageDownscale, but only one band of
+// scale lines is in memory at a time. Lines of a band are contiguous in the file
+// (bottom to top), so each band is a single seek and read.
+bool bitmapDecodeThumbnail(const char *filePath, uint32_t scale, Image *image) {
+    eez::File file;
+    if (!file.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
+        return false;
+    }
+
+    uint32_t offset;
+    uint32_t width;
+    uint32_t height;
+    if (!readHeader(file, offset, width, height)) {
+        file.close();
+        return false;
+    }
+
+    uint32_t lineBytes = width * 3;
+
+    uint32_t thumbnailWidth = width / scale;
+    if (thumbnailWidth == 0) {
+        thumbnailWidth = 1;
+    }
+    uint32_t thumbnailHeight = height / scale;
+    if (thumbnailHeight == 0) {
+        thumbnailHeight = 1;
+    }
+
+    uint8_t *out = FILE_VIEW_BUFFER;
+    uint8_t *bandBuffer = FILE_VIEW_BUFFER + thumbnailWidth * thumbnailHeight * 3;
+
+    for (uint32_t y = 0; y < thumbnailHeight; y++) {
+        uint32_t y1 = y * scale;
+        uint32_t y2 = MIN(y1 + scale, height);
+        uint32_t bandBytes = (y2 - y1) * lineBytes;
+
+        if (!file.seek(offset + (height - y2) * lineBytes)) {
+            file.close();
+            return false;
+        }
+
+        if (file.read(bandBuffer, bandBytes) != bandBytes) {
+            file.close();
+            return false;
+        }
+
+        for (uint32_t x = 0; x < thumbnailWidth; x++) {
+            uint32_t x1 = x * scale;
+            uint32_t x2 = MIN(x1 + scale, width);
+
+            uint32_t r = 0;
+            uint32_t g = 0;
+            uint32_t b = 0;
+
+            for (uint32_t yy = y1; yy < y2; yy++) {
+                const uint8_t *in = bandBuffer + (yy - y1) * lineBytes + x1 * 3;
+                for (uint32_t xx = x1; xx < x2; xx++) {
+                    b += in[0];
+                    g += in[1];
+                    r += in[2];
+                    in += 3;
+                }
+            }
+
+            uint32_t n = (y2 - y1) * (x2 - x1);
+
+            out[0] = (uint8_t)(r / n);
+            out[1] = (uint8_t)(g / n);
+            out[2] = (uint8_t)(b / n);
+            out += 3;
+        }
+    }
+
+    file.close();
+
+    image->width = thumbnailWidth;
+    image->height = thumbnailHeight;
+    image->bpp = 24;
+    image->lineOffset = 0;
+    image->pixels = FILE_VIEW_BUFFER;
+
+    return true;
+}
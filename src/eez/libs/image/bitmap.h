@@ -21,3 +21,4 @@
 #include <eez/libs/image/image.h>
 
 bool bitmapDecode(const char *filePath, Image *image);
+bool bitmapDecodeThumbnail(const char *filePath, uint32_t scale, Image *image);
@@ -27,4 +27,75 @@ bool imageDecode(const char *filePath, Image *image) {
         return bitmapDecode(filePath, image);
     }
     return jpegDecode(filePath, image);
+}
+
+bool imageDecodeThumbnail(const char *filePath, Image *image) {
+    if (eez::endsWithNoCase(filePath, ".bmp")) {
+        return bitmapDecodeThumbnail(filePath, THUMBNAIL_SCALE, image);
+    }
+    return jpegDecodeThumbnail(filePath, image);
+}
+
+void imageDownscale(const Image *src, uint32_t scale, uint8_t *dst, Image *result) {
+    uint32_t width = src->width / scale;
+    if (width == 0) {
+        width = 1;
+    }
+    uint32_t height = src->height / scale;
+    if (height == 0) {
+        height = 1;
+    }
+
+    uint32_t bytesPerPixel = src->bpp / 8;
+    uint32_t srcLineBytes = (src->width + src->lineOffset) * bytesPerPixel;
+
+    uint8_t *out = dst;
+
+    for (uint32_t y = 0; y < height; y++) {
+        uint32_t y1 = y * scale;
+        uint32_t y2 = MIN(y1 + scale, src->height);
+
+        for (uint32_t x = 0; x < width; x++) {
+            uint32_t x1 = x * scale;
+            uint32_t x2 = MIN(x1 + scale, src->width);
+
+            uint32_t r = 0;
+            uint32_t g = 0;
+            uint32_t b = 0;
+
+            for (uint32_t yy = y1; yy < y2; yy++) {
+                const uint8_t *in = src->pixels + yy * srcLineBytes + x1 * bytesPerPixel;
+                for (uint32_t xx = x1; xx < x2; xx++) {
+                    if (bytesPerPixel == 2) {
+                        uint16_t color = *(const uint16_t *)in;
+                        r += color >> 11;
+                        g += (color >> 5) & 0x3F;
+                        b += color & 0x1F;
+                    } else {
+                        r += in[0];
+                        g += in[1];
+                        b += in[2];
+                    }
+                    in += bytesPerPixel;
+                }
+            }
+
+            uint32_t n = (y2 - y1) * (x2 - x1);
+
+            if (bytesPerPixel == 2) {
+                *(uint16_t *)out = (uint16_t)(((r / n) << 11) | ((g / n) << 5) | (b / n));
+            } else {
+                out[0] = (uint8_t)(r / n);
+                out[1] = (uint8_t)(g / n);
+                out[2] = (uint8_t)(b / n);
+            }
+            out += bytesPerPixel;
+        }
+    }
+
+    result->width = width;
+    result->height = height;
+    result->bpp = src->bpp;
+    result->lineOffset = 0;
+    result->pixels = dst;
 }
\ No newline at end of file
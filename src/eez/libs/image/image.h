@@ -28,4 +28,16 @@ struct Image {
     uint8_t *pixels;
 };
 
-bool imageDecode(const char *filePath, Image *image);
\ No newline at end of file
+// Thumbnails are decoded at 1/8 of the original image size,
+// i.e. 60 x 34 pixels for the 480 x 272 screenshot.
+static const uint32_t THUMBNAIL_SCALE = 8;
+static const uint32_t THUMBNAIL_MAX_WIDTH = 480 / THUMBNAIL_SCALE;
+static const uint32_t THUMBNAIL_MAX_HEIGHT = 272 / THUMBNAIL_SCALE;
+static const uint32_t THUMBNAIL_MAX_SIZE = THUMBNAIL_MAX_WIDTH * THUMBNAIL_MAX_HEIGHT * 3;
+
+bool imageDecode(const char *filePath, Image *image);
+bool imageDecodeThumbnail(const char *filePath, Image *image);
+
+// Box filter downscale of 16 bpp (RGB565) or 24 bpp image. It is safe to pass
+// src->pixels as dst, i.e. image can be downscaled in place.
+void imageDownscale(const Image *src, uint32_t scale, uint8_t *dst, Image *result);
\ No newline at end of file
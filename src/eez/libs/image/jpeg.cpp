@@ -60,6 +60,77 @@ uint8_t *g_fileData;
 
 static bool g_jpegInitialized;
 
+static inline uint8_t clampColor(int32_t value) {
+    return value < 0 ? 0 : value > 255 ? 255 : (uint8_t)value;
+}
+
+// JPEG codec can't scale, but YCbCr to RGB conversion is linear so the thumbnail
+// is built directly from the decoded MCUs: one pixel per 8x8 Y block, averaged
+// with the part of Cb/Cr blocks covering it. That skips converting the whole
+// image to RGB and then downscaling it.
+static void mcuThumbnail(const uint8_t *mcus, uint32_t chromaSubsampling, uint32_t blockSize, uint32_t width, uint32_t height, uint16_t *out, Image *image) {
+    uint32_t mcuWidth = chromaSubsampling == JPEG_444_SUBSAMPLING ? 8 : 16;
+    uint32_t mcuHeight = chromaSubsampling == JPEG_420_SUBSAMPLING ? 16 : 8;
+    uint32_t mcusPerLine = (width + mcuWidth - 1) / mcuWidth;
+    uint32_t yBlocksPerLine = mcuWidth / 8;
+    uint32_t chromaOffset = yBlocksPerLine * (mcuHeight / 8) * 64;
+
+    // part of 8x8 chroma block covering one 8x8 Y block
+    uint32_t chromaWidth = 64 / mcuWidth;
+    uint32_t chromaHeight = 64 / mcuHeight;
+
+    uint32_t thumbnailWidth = width / 8;
+    if (thumbnailWidth == 0) {
+        thumbnailWidth = 1;
+    }
+    uint32_t thumbnailHeight = height / 8;
+    if (thumbnailHeight == 0) {
+        thumbnailHeight = 1;
+    }
+
+    for (uint32_t y = 0; y < thumbnailHeight; y++) {
+        uint32_t by = y % (mcuHeight / 8);
+        for (uint32_t x = 0; x < thumbnailWidth; x++) {
+            uint32_t bx = x % yBlocksPerLine;
+
+            const uint8_t *mcu = mcus + ((y / (mcuHeight / 8)) * mcusPerLine + x / yBlocksPerLine) * blockSize;
+
+            const uint8_t *yBlock = mcu + (by * yBlocksPerLine + bx) * 64;
+            int32_t yy = 0;
+            for (uint32_t i = 0; i < 64; i++) {
+                yy += yBlock[i];
+            }
+            yy = (yy + 32) / 64;
+
+            const uint8_t *cbBlock = mcu + chromaOffset + by * chromaHeight * 8 + bx * chromaWidth;
+            const uint8_t *crBlock = cbBlock + 64;
+            int32_t cb = 0;
+            int32_t cr = 0;
+            for (uint32_t i = 0; i < chromaHeight; i++) {
+                for (uint32_t j = 0; j < chromaWidth; j++) {
+                    cb += cbBlock[i * 8 + j];
+                    cr += crBlock[i * 8 + j];
+                }
+            }
+            uint32_t n = chromaWidth * chromaHeight;
+            cb = (int32_t)((cb + n / 2) / n) - 128;
+            cr = (int32_t)((cr + n / 2) / n) - 128;
+
+            // ITU-R BT.601 full range, 16.16 fixed point
+            uint8_t r = clampColor(yy + ((91881 * cr + 32768) >> 16));
+            uint8_t g = clampColor(yy - ((22554 * cb + 46802 * cr + 32768) >> 16));
+            uint8_t b = clampColor(yy + ((116130 * cb + 32768) >> 16));
+
+            *out++ = (uint16_t)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+        }
+    }
+
+    image->width = thumbnailWidth;
+    image->height = thumbnailHeight;
+    image->bpp = 16;
+    image->lineOffset = 0;
+}
+
 #else
 
 extern "C" void * const g_jpegDecodeContext = (void *)FILE_VIEW_BUFFER;
@@ -100,7 +171,7 @@ extern "C" void njCopyMem(void* dest, const void* src, int size) {
 
 #endif
 
-bool jpegDecode(const char *filePath, Image *image) {
+static bool decode(const char *filePath, Image *image, bool thumbnail) {
     eez::File file;
     if (!file.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
         return false;
@@ -176,6 +247,12 @@ bool jpegDecode(const char *filePath, Image *image) {
     uint32_t inputBufferSize = numMCUs * blockSize;
     uint8_t *outputBuffer = FILE_VIEW_BUFFER + inputBufferSize;
 
+    if (thumbnail) {
+        mcuThumbnail(FILE_VIEW_BUFFER, jpegInfo.ChromaSubsampling, blockSize, width, height, (uint16_t *)outputBuffer, image);
+        image->pixels = outputBuffer;
+        return true;
+    }
+
     uint32_t convertedDataCount;
     convertFunction(FILE_VIEW_BUFFER, outputBuffer, 0, inputBufferSize, &convertedDataCount);
 
@@ -193,6 +270,9 @@ bool jpegDecode(const char *filePath, Image *image) {
 
     njInit();
 
+    // for the thumbnail only DC coefficients are used, that gives 1/8 scaled image without IDCT
+    njSetDCOnly(thumbnail ? 1 : 0);
+
     if (njDecode(g_fileData, fileSize) != NJ_OK) {
         return false;
     }
@@ -211,3 +291,11 @@ bool jpegDecode(const char *filePath, Image *image) {
 
 #endif
 }
+
+bool jpegDecode(const char *filePath, Image *image) {
+    return decode(filePath, image, false);
+}
+
+bool jpegDecodeThumbnail(const char *filePath, Image *image) {
+    return decode(filePath, image, true);
+}
@@ -23,3 +23,4 @@
 int jpegEncode(const uint8_t *screenshotPixels, unsigned char **imageData, size_t *imageDataSize);
 
 bool jpegDecode(const char *filePath, Image *image);
+bool jpegDecodeThumbnail(const char *filePath, Image *image);
@@ -170,6 +170,12 @@ int njGetImageSize(void);
 // image after a njDone() call.
 void njDone(void);
 
+// njSetDCOnly: Enable or disable DC-only decoding.
+// In DC-only mode the inverse DCT is skipped and every 8x8 block is
+// replaced by its DC coefficient, i.e. the image is decoded at 1/8 scale.
+// The setting is kept across njDecode() calls.
+void njSetDCOnly(int enable);
+
 #endif//_NANOJPEG_H
 
 
@@ -333,6 +339,8 @@ extern "C" void * const g_jpegDecodeContext;
 
 static nj_context_t &nj = *(nj_context_t *)g_jpegDecodeContext;
 
+static int njDCOnly = 0;
+
 static const char njZZ[64] = { 0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18,
 11, 4, 5, 12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28, 35,
 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51, 58, 59, 52, 45,
@@ -562,12 +570,17 @@ NJ_INLINE void njDecodeSOF(void) {
     nj.mbsizey = ssymax << 3;
     nj.mbwidth = (nj.width + nj.mbsizex - 1) / nj.mbsizex;
     nj.mbheight = (nj.height + nj.mbsizey - 1) / nj.mbsizey;
+    if (njDCOnly) {
+        // one pixel per block
+        nj.width = (nj.width + 7) >> 3;
+        nj.height = (nj.height + 7) >> 3;
+    }
     for (i = 0, c = nj.comp;  i < nj.ncomp;  ++i, ++c) {
         c->width = (nj.width * c->ssx + ssxmax - 1) / ssxmax;
         c->height = (nj.height * c->ssy + ssymax - 1) / ssymax;
-        c->stride = nj.mbwidth * c->ssx << 3;
+        c->stride = njDCOnly ? nj.mbwidth * c->ssx : nj.mbwidth * c->ssx << 3;
         if (((c->width < 3) && (c->ssx != ssxmax)) || ((c->height < 3) && (c->ssy != ssymax))) njThrow(NJ_UNSUPPORTED);
-        if (!(c->pixels = (unsigned char*) njAllocMem(c->stride * nj.mbheight * c->ssy << 3))) njThrow(NJ_OUT_OF_MEM);
+        if (!(c->pixels = (unsigned char*) njAllocMem(njDCOnly ? c->stride * nj.mbheight * c->ssy : c->stride * nj.mbheight * c->ssy << 3))) njThrow(NJ_OUT_OF_MEM);
     }
     if (nj.ncomp == 3) {
         nj.rgb = (unsigned char*) njAllocMem(nj.width * nj.height * nj.ncomp);
@@ -671,6 +684,11 @@ NJ_INLINE void njDecodeBlock(nj_component_t* c, unsigned char* out) {
         if (coef > 63) njThrow(NJ_SYNTAX_ERROR);
         nj.block[(int) njZZ[coef]] = value * nj.qtab[c->qtsel][coef];
     } while (coef < 63);
+    if (njDCOnly) {
+        // average value of the block, same scaling as njRowIDCT + njColIDCT
+        *out = njClip(((nj.block[0] + 4) >> 3) + 128);
+        return;
+    }
     for (coef = 0;  coef < 64;  coef += 8)
         njRowIDCT(&nj.block[coef]);
     for (coef = 0;  coef < 8;  ++coef)
@@ -699,7 +717,10 @@ NJ_INLINE void njDecodeScan(void) {
         for (i = 0, c = nj.comp;  i < nj.ncomp;  ++i, ++c)
             for (sby = 0;  sby < c->ssy;  ++sby)
                 for (sbx = 0;  sbx < c->ssx;  ++sbx) {
-                    njDecodeBlock(c, &c->pixels[((mby * c->ssy + sby) * c->stride + mbx * c->ssx + sbx) << 3]);
+                    if (njDCOnly)
+                        njDecodeBlock(c, &c->pixels[(mby * c->ssy + sby) * c->stride + mbx * c->ssx + sbx]);
+                    else
+                        njDecodeBlock(c, &c->pixels[((mby * c->ssy + sby) * c->stride + mbx * c->ssx + sbx) << 3]);
                     njCheckError();
                 }
         if (++mbx >= nj.mbwidth) {
@@ -914,5 +935,6 @@ int njGetHeight(void)           { return nj.height; }
 int njIsColor(void)             { return (nj.ncomp != 1); }
 unsigned char* njGetImage(void) { return (nj.ncomp == 1) ? nj.comp[0].pixels : nj.rgb; }
 int njGetImageSize(void)        { return nj.width * nj.height * nj.ncomp; }
+void njSetDCOnly(int enable)    { njDCOnly = enable; }
 
 #endif // _NJ_INCLUDE_HEADER_ONLY
\ No newline at end of file
@@ -50,6 +50,11 @@
 #include <eez/modules/psu/psu.h>
 #include <eez/modules/psu/serial_psu.h>
 #include <eez/modules/psu/sd_card.h>
+#include <eez/modules/psu/io_pins.h>
+
+#if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
+#include <eez/platform/simulator/benchmark.h>
+#endif
 
  ////////////////////////////////////////////////////////////////////////////////
 
@@ -137,6 +142,12 @@ int main(int argc, char **argv) {
     //SCB_EnableDCache();
 #endif
 
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    if (!eez::platform::simulator::benchmark::parseCommandLine(argc, argv)) {
+        return 1;
+    }
+#endif
+
     g_mainTaskHandle = osThreadCreate(osThread(g_mainTask), nullptr);
 
     osKernelStart();
@@ -171,6 +182,7 @@ void mainTask(const void *) {
 
 #if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
     g_consoleInputTaskHandle = osThreadCreate(osThread(g_consoleInputTask), nullptr);
+    eez::platform::simulator::benchmark::start();
 #endif
 
     while (true) {
@@ -201,6 +213,8 @@ extern "C" void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
         eez::psu::sd_card::onSdDetectInterrupt();
     } else if (GPIO_Pin == ENC_A_Pin || GPIO_Pin == ENC_B_Pin) {
         eez::mcu::encoder::onPinInterrupt();
+    } else if (GPIO_Pin == DIN2_Pin) {
+        eez::psu::io_pins::onExtTrigInterrupt(EXT_TRIG2);
     }
 }
 #endif
@@ -42,7 +42,13 @@ static const uint32_t DECOMPRESSED_ASSETS_SIZE = 8 * 1024 * 1024;
 static uint8_t * const DLOG_RECORD_BUFFER = DECOMPRESSED_ASSETS_START_ADDRESS + DECOMPRESSED_ASSETS_SIZE;
 static const uint32_t DLOG_RECORD_BUFFER_SIZE = 128 * 1024;
 
-static uint8_t * const FILE_VIEW_BUFFER = DLOG_RECORD_BUFFER + DLOG_RECORD_BUFFER_SIZE;
+static uint8_t * const ACQUISITION_BUFFER = DLOG_RECORD_BUFFER + DLOG_RECORD_BUFFER_SIZE;
+static const uint32_t ACQUISITION_BUFFER_SIZE = 192 * 1024;
+
+static uint8_t * const DOWNLOAD_BUFFER = ACQUISITION_BUFFER + ACQUISITION_BUFFER_SIZE;
+static const uint32_t DOWNLOAD_BUFFER_SIZE = 128 * 1024;
+
+static uint8_t * const FILE_VIEW_BUFFER = DOWNLOAD_BUFFER + DOWNLOAD_BUFFER_SIZE;
 #if defined(EEZ_PLATFORM_STM32)
 static const uint32_t FILE_VIEW_BUFFER_SIZE = 1024 * 1024;
 #endif
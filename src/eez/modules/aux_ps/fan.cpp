@@ -18,11 +18,14 @@
 
 #if OPTION_FAN
 
+#include <stdio.h>
+
 #include <eez/modules/aux_ps/fan.h>
 #include <eez/modules/aux_ps/pid.h>
 
 #include <eez/modules/psu/psu.h>
 #include <eez/modules/psu/channel.h>
+#include <eez/modules/psu/channel_dispatcher.h>
 #include <eez/modules/psu/scpi/psu.h>
 #include <eez/modules/psu/temperature.h>
 #include <eez/modules/psu/persist_conf.h>
@@ -30,6 +33,7 @@
 #include <eez/modules/dib-dcp405/channel.h>
 
 #include <eez/system.h>
+#include <eez/tasks.h>
 
 #if defined(EEZ_PLATFORM_STM32)
 #include <i2c.h>
@@ -47,7 +51,7 @@ namespace fan {
 
 TestResult g_testResult = TEST_FAILED;
 
-static int g_fanSpeedPWM;
+int g_fanSpeedPWM;
 
 double g_Kp = FAN_PID_KP;
 double g_Ki = FAN_PID_KI_MIN;
@@ -59,6 +63,12 @@ static double g_pidDuty;
 static double g_pidTarget = FAN_MIN_TEMP;
 static PID g_fanPID(&g_pidTemp, &g_pidDuty, &g_pidTarget, FAN_PID_KP, FAN_PID_KI_MIN, FAN_PID_KD, FAN_PID_POn, REVERSE);
 
+FanModel g_model = {
+	false, FAN_MODEL_K_OUT, FAN_MODEL_U_DROP, FAN_MODEL_RTH, FAN_MODEL_GAIN, FAN_MODEL_AMBIENT
+};
+
+static float g_predictedTemperature = NAN;
+
 int g_rpm = 0;
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -401,6 +411,22 @@ void getIMonMax(float &iMonMax, float &iMax) {
 	}
 }
 
+// returns predicted heatsink temperature of the hottest channel
+float predictMaxChannelTemperature() {
+	using namespace psu;
+	float maxPower = 0;
+	for (int i = 0; i < CH_NUM; ++i) {
+		Channel& channel = Channel::get(i);
+		if (channel.isOutputEnabled()) {
+			float power = g_model.kOut * channel.u.mon_last * channel.i.mon_last + g_model.uDrop * channel.i.mon_last;
+			if (power > maxPower) {
+				maxPower = power;
+			}
+		}
+	}
+	return g_model.ambient + g_model.rth * maxPower;
+}
+
 #if defined(EEZ_PLATFORM_STM32)
 void genFanError() {
 	g_testResult = TEST_FAILED;
@@ -495,6 +521,8 @@ int updateFanSpeed() {
 				}
 			}
 
+			// Ki and target follow the load also with the model, which only adds feed-forward,
+			// otherwise the trim is too slow to remove the model error at high load
 			float iMonMax, iMax;
 			getIMonMax(iMonMax, iMax);
 			float Ki = roundPrec(remap(iMonMax * iMonMax, 0, FAN_PID_KI_MIN, iMax * iMax, FAN_PID_KI_MAX), 0.05f);
@@ -504,9 +532,24 @@ int updateFanSpeed() {
 				g_pidTarget = FAN_MIN_TEMP - 2.0 * iMonMax;
 			}
 
+			double feedForwardDuty = 0;
+			if (g_model.enabled) {
+				g_predictedTemperature = predictMaxChannelTemperature();
+				if (g_predictedTemperature > g_pidTarget) {
+					feedForwardDuty = g_model.gain * (g_predictedTemperature - g_pidTarget);
+					if (feedForwardDuty > 255) {
+						feedForwardDuty = 255;
+					}
+				}
+				// while heating up, far below the target, negative trim would only wind up
+				// and then delay the trim once the target is reached
+				double trimMin = maxChannelTemperature < g_pidTarget - FAN_MODEL_TRIM_BAND ? 0 : -feedForwardDuty;
+				g_fanPID.SetOutputLimits(trimMin, 255 - feedForwardDuty);
+			}
+
 			g_pidTemp = setMaxPwm ? TEMP_SENSOR_MAX_VALID_TEMPERATURE : maxChannelTemperature;
 			if (g_fanPID.Compute()) {
-				newFanSpeedPWM = (int)round(g_pidDuty);
+				newFanSpeedPWM = (int)round(feedForwardDuty + g_pidDuty);
 
 				if (newFanSpeedPWM <= 0) {
 					newFanSpeedPWM = 0;
@@ -587,6 +630,22 @@ void setPidTunings(double Kp, double Ki, double Kd, int POn) {
 	g_fanPID.SetTunings(g_Kp, g_Ki, g_Kd, g_POn);
 }
 
+void setModel(const FanModel &model) {
+	g_model = model;
+
+	if (!g_model.enabled) {
+		g_predictedTemperature = NAN;
+		g_fanPID.SetOutputLimits(0, 255);
+	}
+
+	g_Ki = 0; // forces Ki retune on next update
+	g_fanPID.SetTunings(g_Kp, g_Ki, g_Kd, g_POn);
+}
+
+float getPredictedTemperature() {
+	return g_predictedTemperature;
+}
+
 float readTemperature() {
 #if defined(EEZ_PLATFORM_STM32)
 	float temperature;
@@ -597,6 +656,175 @@ float readTemperature() {
 	return NAN;
 }
 
+#if defined(EEZ_PLATFORM_SIMULATOR)
+
+#define STEP_SAMPLE_INTERVAL 100 // ms
+#define STEP_MAX_SAMPLES (STEP_RESPONSE_MAX_DURATION * 1000 / STEP_SAMPLE_INTERVAL)
+#define STEP_SETTLING_BAND 1.0f // oC
+#define STEP_PLANT_TAU 8.0f // s, few sensor reads and PID samples per time constant
+
+// load step: 30 V, 4 A into 7.5 ohm, settles below FAN_MIN_TEMP only with the fan running
+#define STEP_U_SET 30.0f
+#define STEP_I_SET 4.0f
+#define STEP_LOAD 7.5f
+
+static float g_stepSamples[STEP_MAX_SAMPLES];
+
+static void resetController() {
+	g_pidDuty = 0;
+	g_fanPID.SetMode(MANUAL);
+	g_fanPID.SetMode(AUTOMATIC);
+}
+
+// returns false if output was disabled during the step
+static bool measureStepResponse(psu::Channel &channel, uint32_t duration, StepResponse &response) {
+	using namespace psu;
+
+	// start from ambient, with the filtered sensor temperature also at ambient
+	float filterTimeConstant = temperature::getFilterTimeConstant();
+	temperature::setFilterTimeConstant(0);
+	simulator::resetThermalPlant();
+	delayWithoutIoLock(2 * TEMP_SENSOR_READ_EVERY_MS);
+	temperature::setFilterTimeConstant(filterTimeConstant);
+	resetController();
+
+	channel_dispatcher::outputEnable(channel, true);
+
+	int numSamples = duration * 1000 / STEP_SAMPLE_INTERVAL;
+	int maxPwm = 0;
+	for (int i = 0; i < numSamples; i++) {
+		delayWithoutIoLock(STEP_SAMPLE_INTERVAL);
+		g_stepSamples[i] = simulator::getTemperature(temp_sensor::CH1 + channel.channelIndex);
+		if (g_fanSpeedPWM > maxPwm) {
+			maxPwm = g_fanSpeedPWM;
+		}
+	}
+
+	if (!channel.isOutputEnabled()) {
+		return false;
+	}
+
+	channel_dispatcher::outputEnable(channel, false);
+
+	// final value is the average of the last 10% of samples
+	int numFinalSamples = numSamples / 10;
+	float sum = 0;
+	for (int i = numSamples - numFinalSamples; i < numSamples; i++) {
+		sum += g_stepSamples[i];
+	}
+	response.final = sum / numFinalSamples;
+
+	response.peak = g_stepSamples[0];
+	int lastOutsideBand = -1;
+	for (int i = 0; i < numSamples; i++) {
+		if (g_stepSamples[i] > response.peak) {
+			response.peak = g_stepSamples[i];
+		}
+		if (fabsf(g_stepSamples[i] - response.final) > STEP_SETTLING_BAND) {
+			lastOutsideBand = i;
+		}
+	}
+
+	response.overshoot = response.peak - response.final;
+	response.settlingTime = (lastOutsideBand + 1) * STEP_SAMPLE_INTERVAL / 1000.0f;
+	response.settled = lastOutsideBand < numSamples - numFinalSamples;
+	response.maxPwm = maxPwm;
+
+	return true;
+}
+
+bool stepResponseSelfTest(psu::Channel &channel, uint32_t duration, StepResponse responses[2], char *message, int messageSize) {
+	using namespace psu;
+
+	if (g_testResult != TEST_OK || persist_conf::devConf.fanMode != FAN_MODE_AUTO) {
+		snprintf(message, messageSize, "fan is not in auto mode");
+		return false;
+	}
+
+	if (channel_dispatcher::getCouplingType() != channel_dispatcher::COUPLING_TYPE_NONE || channel.flags.trackingEnabled) {
+		snprintf(message, messageSize, "channel is coupled or tracked");
+		return false;
+	}
+
+	if (duration < STEP_RESPONSE_MIN_DURATION || duration > STEP_RESPONSE_MAX_DURATION) {
+		snprintf(message, messageSize, "duration out of range");
+		return false;
+	}
+
+	// let PSU thread apply pending settings, then save them
+	delayWithoutIoLock(50);
+	float uSet = channel.u.set;
+	float iSet = channel.i.set;
+	bool loadEnabled = channel.simulator.getLoadEnabled();
+	float load = channel.simulator.getLoad();
+	bool outputEnabled = channel.isOutputEnabled();
+	FanModel model = g_model;
+	bool plantEnabled = simulator::isThermalPlantEnabled();
+	float plantTau = simulator::getThermalPlantTau();
+	bool otpState = temperature::getChannelSensorState(&channel);
+	float otpLevel = temperature::getChannelSensorLevel(&channel);
+	float otpDelay = temperature::getChannelSensorDelay(&channel);
+
+	channel_dispatcher::outputEnable(channel, false);
+	channel_dispatcher::setOtpParameters(channel, 1, otpLevel, otpDelay);
+	channel_dispatcher::setVoltage(channel, STEP_U_SET);
+	channel_dispatcher::setCurrent(channel, STEP_I_SET);
+	channel_dispatcher::setLoadEnabled(channel, true);
+	channel_dispatcher::setLoad(channel, STEP_LOAD);
+	simulator::setThermalPlantTau(STEP_PLANT_TAU);
+	simulator::setThermalPlantEnabled(true);
+
+	// PID only, then feed-forward model with PID trim
+	bool outputDisabled = false;
+	for (int i = 0; i < 2 && !outputDisabled; i++) {
+		FanModel stepModel = model;
+		stepModel.enabled = i == 1;
+		setModel(stepModel);
+		outputDisabled = !measureStepResponse(channel, duration, responses[i]);
+	}
+
+	bool result = false;
+	if (outputDisabled) {
+		snprintf(message, messageSize, "output was disabled during the step");
+	} else if (!responses[0].settled) {
+		snprintf(message, messageSize, "PID didn't settle within %u s", (unsigned)duration);
+	} else if (!responses[1].settled) {
+		snprintf(message, messageSize, "model didn't settle within %u s", (unsigned)duration);
+	} else if (responses[0].maxPwm == 0 || responses[1].maxPwm == 0) {
+		snprintf(message, messageSize, "fan didn't start");
+	} else if (responses[1].peak >= otpLevel) {
+		snprintf(message, messageSize, "model peak %.2f oC reached OTP level", responses[1].peak);
+	} else if (responses[1].overshoot > responses[0].overshoot) {
+		snprintf(message, messageSize, "model overshoot %.2f oC, PID %.2f oC", responses[1].overshoot, responses[0].overshoot);
+	} else if (responses[1].final > responses[0].final + STEP_SETTLING_BAND) {
+		// both regulate to the same target, within the band they are settled at the same point
+		snprintf(message, messageSize, "model final %.2f oC, PID %.2f oC", responses[1].final, responses[0].final);
+	} else {
+		snprintf(message, messageSize, "settled within %u s", (unsigned)duration);
+		result = true;
+	}
+
+	// restore settings
+	simulator::resetThermalPlant();
+	simulator::setThermalPlantTau(plantTau);
+	simulator::setThermalPlantEnabled(plantEnabled);
+	setModel(model);
+	resetController();
+	channel_dispatcher::setOtpParameters(channel, otpState, otpLevel, otpDelay);
+	channel_dispatcher::setLoad(channel, load);
+	channel_dispatcher::setLoadEnabled(channel, loadEnabled);
+	channel_dispatcher::setVoltage(channel, uSet);
+	channel_dispatcher::setCurrent(channel, iSet);
+	if (outputEnabled) {
+		channel_dispatcher::outputEnable(channel, true);
+	}
+	delayWithoutIoLock(50);
+
+	return result;
+}
+
+#endif
+
 } // namespace fan
 } // namespace aux_ps
 } // namespace eez
@@ -22,14 +22,20 @@
 
 #include <eez/firmware.h>
 
+namespace eez {
+namespace psu {
+struct Channel;
+}
+}
+
 #define FAN_MODE_AUTO 0
 #define FAN_MODE_MANUAL 1
 
 enum FanStatus {
-    FAN_STATUS_INVALID,
-    FAN_STATUS_VALID,
-    FAN_STATUS_TESTING,
-    FAN_STATUS_NOT_INSTALLED
+	FAN_STATUS_INVALID,
+	FAN_STATUS_VALID,
+	FAN_STATUS_TESTING,
+	FAN_STATUS_NOT_INSTALLED
 };
 
 namespace eez {
@@ -50,6 +56,50 @@ extern int g_POn;
 
 void setPidTunings(double Kp, double Ki, double Kd, int POn);
 
+// Feed-forward thermal model. Heat dissipated in the channel is estimated
+// from output power and current (pass element drop) and heatsink temperature
+// is predicted as Tamb + Rth * P. Fan PWM is set ahead from the predicted
+// temperature above PID target and PID trims the residual error.
+struct FanModel {
+	bool enabled;
+	float kOut; // part of the output power dissipated in the channel
+	float uDrop; // V, pass element voltage drop
+	float rth; // oC/W, heatsink thermal resistance
+	float gain; // PWM per oC of predicted temperature above PID target
+	float ambient; // oC
+};
+
+extern FanModel g_model;
+
+void setModel(const FanModel &model);
+
+// predicted heatsink temperature of the hottest channel, NAN if model is disabled
+float getPredictedTemperature();
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+
+#define STEP_RESPONSE_MIN_DURATION 10 // s
+#define STEP_RESPONSE_MAX_DURATION 120 // s
+
+struct StepResponse {
+	float peak; // oC
+	float final; // oC, average over the last 10% of the step
+	float overshoot; // oC, peak above final
+	float settlingTime; // s, until temperature stays within 1 oC of final
+	bool settled;
+	int maxPwm;
+};
+
+// Load step on the channel against the simulator thermal plant, first with
+// PID only and then with the feed-forward model, responses[0] and [1].
+// Channel OTP stays enabled. Fails if the model's overshoot is bigger than
+// PID's, or its final temperature is higher by more than the settling band.
+bool stepResponseSelfTest(psu::Channel &channel, uint32_t duration, StepResponse responses[2], char *message, int messageSize);
+
+#endif
+
+extern int g_fanSpeedPWM;
+
 float readTemperature();
 
 FanStatus getStatus();
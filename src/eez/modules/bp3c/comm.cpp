@@ -24,9 +24,14 @@
 #include <stdlib.h>
 #endif
 
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
 #include <eez/debug.h>
 #include <eez/index.h>
 #include <eez/system.h>
+#include <eez/tasks.h>
 
 #include <eez/modules/bp3c/comm.h>
 
@@ -103,6 +108,13 @@ bool masterSynchro(int slotIndex) {
 #endif
 }
 
+#if defined(EEZ_PLATFORM_STM32)
+static TransferResult checkCrc(uint8_t *input, uint32_t bufferSize) {
+    uint32_t crc = HAL_CRC_Calculate(&hcrc, (uint32_t *)input, bufferSize - 4);
+    return crc == *((uint32_t *)(input + bufferSize - 4)) ? TRANSFER_STATUS_OK : TRANSFER_STATUS_CRC_ERROR;
+}
+#endif
+
 TransferResult transfer(int slotIndex, uint8_t *output, uint8_t *input, uint32_t bufferSize) {
 #if defined(EEZ_PLATFORM_STM32)
     spi::handle[slotIndex]->ErrorCode = 0;
@@ -119,8 +131,7 @@ TransferResult transfer(int slotIndex, uint8_t *output, uint8_t *input, uint32_t
         }
     } else {
         if (result == HAL_OK) {
-            uint32_t crc = HAL_CRC_Calculate(&hcrc, (uint32_t *)input, bufferSize - 4);
-            return crc == *((uint32_t *)(input + bufferSize - 4)) ? TRANSFER_STATUS_OK : TRANSFER_STATUS_CRC_ERROR;
+            return checkCrc(input, bufferSize);
         } else {
             return (TransferResult)result;
         }
@@ -146,6 +157,320 @@ TransferResult transferDMA(int slotIndex, uint8_t *output, uint8_t *input, uint3
 #endif
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+struct ScheduledTransfer {
+    volatile bool inProgress;
+    volatile bool completed;
+    volatile int status;
+    uint8_t *input;
+    uint32_t bufferSize;
+    uint32_t startTime;
+    TransferStatistics statistics;
+};
+
+static ScheduledTransfer g_scheduledTransfers[NUM_SLOTS];
+
+TransferResult startTransfer(int slotIndex, uint8_t *output, uint8_t *input, uint32_t bufferSize) {
+    auto &scheduledTransfer = g_scheduledTransfers[slotIndex];
+
+    if (scheduledTransfer.inProgress) {
+        return TRANSFER_STATUS_BUSY;
+    }
+
+    scheduledTransfer.input = input;
+    scheduledTransfer.bufferSize = bufferSize;
+    scheduledTransfer.completed = false;
+    scheduledTransfer.startTime = micros();
+    scheduledTransfer.inProgress = true;
+
+    auto status = transferDMA(slotIndex, output, input, bufferSize);
+    if (status != TRANSFER_STATUS_OK) {
+        scheduledTransfer.inProgress = false;
+        scheduledTransfer.statistics.numErrors++;
+        return status;
+    }
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    // there is no DMA in simulator, complete immediately
+    onTransferCompleted(slotIndex, TRANSFER_STATUS_OK);
+#endif
+
+    return TRANSFER_STATUS_OK;
+}
+
+bool isTransferInProgress(int slotIndex) {
+    auto &scheduledTransfer = g_scheduledTransfers[slotIndex];
+
+    if (scheduledTransfer.inProgress && micros() - scheduledTransfer.startTime > TRANSFER_TIMEOUT_US) {
+        abortTransfer(slotIndex);
+
+        scheduledTransfer.statistics.numTimeouts++;
+        scheduledTransfer.status = TRANSFER_STATUS_TIMEOUT;
+        scheduledTransfer.completed = true;
+    }
+
+    return scheduledTransfer.inProgress;
+}
+
+void onTransferCompleted(int slotIndex, int status) {
+    auto &scheduledTransfer = g_scheduledTransfers[slotIndex];
+
+    if (!scheduledTransfer.inProgress) {
+        return;
+    }
+
+    uint32_t latency = micros() - scheduledTransfer.startTime;
+    scheduledTransfer.statistics.lastLatencyUs = latency;
+    if (latency > scheduledTransfer.statistics.maxLatencyUs) {
+        scheduledTransfer.statistics.maxLatencyUs = latency;
+    }
+    scheduledTransfer.statistics.totalLatencyUs += latency;
+    scheduledTransfer.statistics.numTransfers++;
+
+    if (status == TRANSFER_STATUS_CRC_ERROR) {
+        scheduledTransfer.statistics.numCrcErrors++;
+    } else if (status != TRANSFER_STATUS_OK) {
+        scheduledTransfer.statistics.numErrors++;
+    }
+
+    scheduledTransfer.status = status;
+    scheduledTransfer.completed = true;
+    scheduledTransfer.inProgress = false;
+}
+
+bool getCompletedTransfer(int slotIndex, TransferResult &result) {
+    auto &scheduledTransfer = g_scheduledTransfers[slotIndex];
+
+    if (!scheduledTransfer.completed) {
+        return false;
+    }
+
+    scheduledTransfer.completed = false;
+
+    result = (TransferResult)scheduledTransfer.status;
+
+#if defined(EEZ_PLATFORM_STM32)
+    // CRC peripheral is also used from the other threads, so check CRC here and not in IRQ
+    if (result == TRANSFER_STATUS_OK && !g_slots[slotIndex]->moduleInfo->spiCrcCalculationEnable) {
+        result = checkCrc(scheduledTransfer.input, scheduledTransfer.bufferSize);
+        if (result == TRANSFER_STATUS_CRC_ERROR) {
+            scheduledTransfer.statistics.numCrcErrors++;
+        }
+    }
+#endif
+
+    return true;
+}
+
+void abortTransfer(int slotIndex) {
+    auto &scheduledTransfer = g_scheduledTransfers[slotIndex];
+
+#if defined(EEZ_PLATFORM_STM32)
+    if (scheduledTransfer.inProgress) {
+        HAL_SPI_Abort(spi::handle[slotIndex]);
+        spi::deselect(slotIndex);
+    }
+#endif
+
+    scheduledTransfer.inProgress = false;
+    scheduledTransfer.completed = false;
+}
+
+void getTransferStatistics(int slotIndex, TransferStatistics &statistics) {
+    memcpy(&statistics, &g_scheduledTransfers[slotIndex].statistics, sizeof(TransferStatistics));
+}
+
+void resetTransferStatistics(int slotIndex) {
+    memset(&g_scheduledTransfers[slotIndex].statistics, 0, sizeof(TransferStatistics));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct OutputScheduler {
+    bool enabled;
+    bool lastOutputValid;
+    bool changePending;
+    bool actuationPending;
+    uint32_t keepAliveInterval; // ms
+    uint32_t lastTransferTime; // ms
+    uint32_t changeTime; // us
+    uint32_t actuationStartTime; // us
+    uint8_t lastOutput[OUTPUT_FRAME_MAX_SIZE];
+    OutputStatistics statistics;
+};
+
+static OutputScheduler g_outputSchedulers[NUM_SLOTS];
+
+void resetOutputScheduler(int slotIndex) {
+    auto &scheduler = g_outputSchedulers[slotIndex];
+
+    if (!scheduler.enabled) {
+        scheduler.keepAliveInterval = KEEP_ALIVE_INTERVAL_DEFAULT;
+        scheduler.enabled = true;
+    }
+
+    scheduler.lastOutputValid = false;
+    scheduler.changePending = false;
+    scheduler.actuationPending = false;
+}
+
+bool hasOutputScheduler(int slotIndex) {
+    return g_outputSchedulers[slotIndex].enabled;
+}
+
+void setKeepAliveInterval(int slotIndex, uint32_t keepAliveInterval) {
+    g_outputSchedulers[slotIndex].keepAliveInterval = keepAliveInterval;
+}
+
+uint32_t getKeepAliveInterval(int slotIndex) {
+    return g_outputSchedulers[slotIndex].keepAliveInterval;
+}
+
+bool isOutputTransferDue(int slotIndex, const uint8_t *output, uint32_t bufferSize) {
+    auto &scheduler = g_outputSchedulers[slotIndex];
+
+    assert(bufferSize <= OUTPUT_FRAME_MAX_SIZE);
+
+    if (!scheduler.lastOutputValid || memcmp(scheduler.lastOutput, output, bufferSize) != 0) {
+        if (!scheduler.changePending) {
+            scheduler.changePending = true;
+            scheduler.changeTime = micros();
+        }
+        return true;
+    }
+
+    return millis() - scheduler.lastTransferTime >= scheduler.keepAliveInterval;
+}
+
+void onOutputTransferStarted(int slotIndex, const uint8_t *output, uint32_t bufferSize) {
+    auto &scheduler = g_outputSchedulers[slotIndex];
+
+    memcpy(scheduler.lastOutput, output, bufferSize);
+    scheduler.lastOutputValid = true;
+    scheduler.lastTransferTime = millis();
+
+    if (scheduler.changePending) {
+        scheduler.changePending = false;
+        scheduler.actuationPending = true;
+        scheduler.actuationStartTime = scheduler.changeTime;
+        scheduler.statistics.numChangeFrames++;
+    } else {
+        scheduler.statistics.numKeepAliveFrames++;
+    }
+}
+
+void onOutputTransferCompleted(int slotIndex) {
+    auto &scheduler = g_outputSchedulers[slotIndex];
+
+    if (scheduler.actuationPending) {
+        scheduler.actuationPending = false;
+
+        uint32_t latency = micros() - scheduler.actuationStartTime;
+        scheduler.statistics.lastActuationLatencyUs = latency;
+        if (latency > scheduler.statistics.maxActuationLatencyUs) {
+            scheduler.statistics.maxActuationLatencyUs = latency;
+        }
+    }
+}
+
+void getOutputStatistics(int slotIndex, OutputStatistics &statistics) {
+    memcpy(&statistics, &g_outputSchedulers[slotIndex].statistics, sizeof(OutputStatistics));
+}
+
+void resetOutputStatistics(int slotIndex) {
+    memset(&g_outputSchedulers[slotIndex].statistics, 0, sizeof(OutputStatistics));
+}
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+
+bool outputSchedulerSelfTest(char *message, int messageSize) {
+    static const uint32_t KEEP_ALIVE_INTERVAL[2] = { 10, 40 }; // ms
+    static const uint32_t DURATION = 400; // ms
+
+    int slots[2];
+    int numSlots = 0;
+    for (int slotIndex = 0; slotIndex < NUM_SLOTS && numSlots < 2; slotIndex++) {
+        if (hasOutputScheduler(slotIndex)) {
+            slots[numSlots++] = slotIndex;
+        }
+    }
+    if (numSlots < 2) {
+        snprintf(message, messageSize, "two PREL6/SMX46 modules required, found %d", numSlots);
+        return false;
+    }
+
+    uint32_t savedKeepAliveInterval[2];
+    for (int i = 0; i < 2; i++) {
+        savedKeepAliveInterval[i] = getKeepAliveInterval(slots[i]);
+        setKeepAliveInterval(slots[i], KEEP_ALIVE_INTERVAL[i]);
+    }
+
+    // new interval is used from the next tick, wait for the first frame with it
+    delayWithoutIoLock(KEEP_ALIVE_INTERVAL[1]);
+
+    bool result = true;
+    *message = 0;
+
+    // keep-alive rate of each slot
+    OutputStatistics statistics[2];
+    for (int i = 0; i < 2; i++) {
+        resetOutputStatistics(slots[i]);
+    }
+    delayWithoutIoLock(DURATION);
+    for (int i = 0; i < 2; i++) {
+        getOutputStatistics(slots[i], statistics[i]);
+    }
+
+    for (int i = 0; i < 2 && result; i++) {
+        // frame is sent on the first tick after interval expires, so there can be less frames but not more
+        uint32_t maxFrames = DURATION / KEEP_ALIVE_INTERVAL[i] + 1;
+        uint32_t minFrames = maxFrames / 2;
+        if (statistics[i].numChangeFrames != 0) {
+            snprintf(message, messageSize, "slot %d sent %u change frames without output change",
+                slots[i] + 1, (unsigned)statistics[i].numChangeFrames);
+            result = false;
+        } else if (statistics[i].numKeepAliveFrames < minFrames || statistics[i].numKeepAliveFrames > maxFrames) {
+            snprintf(message, messageSize, "slot %d sent %u keep-alive frames, expected %u to %u",
+                slots[i] + 1, (unsigned)statistics[i].numKeepAliveFrames, (unsigned)minFrames, (unsigned)maxFrames);
+            result = false;
+        }
+    }
+
+    if (result) {
+        // output change on the first slot only, forgetting the last sent output is the same as changing it
+        for (int i = 0; i < 2; i++) {
+            resetOutputStatistics(slots[i]);
+        }
+        g_outputSchedulers[slots[0]].lastOutputValid = false;
+        delayWithoutIoLock(2 * KEEP_ALIVE_INTERVAL[0]);
+        for (int i = 0; i < 2; i++) {
+            getOutputStatistics(slots[i], statistics[i]);
+        }
+
+        if (statistics[0].numChangeFrames != 1) {
+            snprintf(message, messageSize, "slot %d sent %u change frames for one output change",
+                slots[0] + 1, (unsigned)statistics[0].numChangeFrames);
+            result = false;
+        } else if (statistics[1].numChangeFrames != 0) {
+            snprintf(message, messageSize, "slot %d sent change frame for output change on slot %d",
+                slots[1] + 1, slots[0] + 1);
+            result = false;
+        } else {
+            snprintf(message, messageSize, "slots=%d,%d actuation_latency=%u us",
+                slots[0] + 1, slots[1] + 1, (unsigned)statistics[0].lastActuationLatencyUs);
+        }
+    }
+
+    for (int i = 0; i < 2; i++) {
+        setKeepAliveInterval(slots[i], savedKeepAliveInterval[i]);
+    }
+
+    return result;
+}
+
+#endif
+
 } // namespace comm
 } // namespace bp3c
 } // namespace eez
@@ -37,6 +37,84 @@ enum TransferResult {
 TransferResult transfer(int slotIndex, uint8_t *output, uint8_t *input, uint32_t bufferSize);
 TransferResult transferDMA(int slotIndex, uint8_t *output, uint8_t *input, uint32_t bufferSize);
 
+////////////////////////////////////////////////////////////////////////////////
+// Slot transfer scheduler.
+// Every slot has its own SPI peripheral, so DMA transfers for all the slots
+// can run at the same time. Module starts the transfer with startTransfer,
+// transfer is completed from SPI DMA IRQ and module picks up the result
+// (including CRC check, if SPI hardware CRC is not used) with
+// getCompletedTransfer from the PSU thread.
+// If completion doesn't arrive within TRANSFER_TIMEOUT_US (e.g. lost IRQ),
+// isTransferInProgress aborts the transfer and it is completed with
+// TRANSFER_STATUS_TIMEOUT, so module continues with the next transfer.
+
+static const uint32_t TRANSFER_TIMEOUT_US = 20000;
+
+struct TransferStatistics {
+    uint32_t numTransfers;
+    uint32_t numCrcErrors;
+    uint32_t numErrors;
+    uint32_t numTimeouts;
+    uint32_t lastLatencyUs;
+    uint32_t maxLatencyUs;
+    uint64_t totalLatencyUs;
+};
+
+TransferResult startTransfer(int slotIndex, uint8_t *output, uint8_t *input, uint32_t bufferSize);
+bool isTransferInProgress(int slotIndex);
+bool getCompletedTransfer(int slotIndex, TransferResult &result);
+void abortTransfer(int slotIndex);
+
+// called from SPI DMA transfer complete and error callbacks
+void onTransferCompleted(int slotIndex, int status);
+
+void getTransferStatistics(int slotIndex, TransferStatistics &statistics);
+void resetTransferStatistics(int slotIndex);
+
+////////////////////////////////////////////////////////////////////////////////
+// Output frame scheduler, for modules that only send their state (PREL6, SMX46).
+// Frame is sent on the first tick after output is changed, so all changes
+// made between two ticks are merged into one frame. If output is not changed,
+// frame is sent as keep-alive once per keep-alive interval.
+
+static const uint32_t OUTPUT_FRAME_MAX_SIZE = 16;
+
+static const uint32_t KEEP_ALIVE_INTERVAL_MIN = 1; // ms
+static const uint32_t KEEP_ALIVE_INTERVAL_MAX = 60000; // ms
+static const uint32_t KEEP_ALIVE_INTERVAL_DEFAULT = 25; // ms
+
+struct OutputStatistics {
+    uint32_t numChangeFrames;
+    uint32_t numKeepAliveFrames;
+    // from the tick output change is noticed until transfer is completed
+    uint32_t lastActuationLatencyUs;
+    uint32_t maxActuationLatencyUs;
+};
+
+// called when module is synchronized, next frame is sent immediately
+void resetOutputScheduler(int slotIndex);
+bool hasOutputScheduler(int slotIndex);
+
+void setKeepAliveInterval(int slotIndex, uint32_t keepAliveInterval);
+uint32_t getKeepAliveInterval(int slotIndex);
+
+// Returns true if output frame should be sent now. It is called every tick
+// also when module is not ready to receive, to note the time of the change.
+bool isOutputTransferDue(int slotIndex, const uint8_t *output, uint32_t bufferSize);
+void onOutputTransferStarted(int slotIndex, const uint8_t *output, uint32_t bufferSize);
+void onOutputTransferCompleted(int slotIndex);
+
+void getOutputStatistics(int slotIndex, OutputStatistics &statistics);
+void resetOutputStatistics(int slotIndex);
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+// Needs two modules with output scheduler (PREL6, SMX46). Runs them with
+// different keep-alive intervals and checks that each slot sends keep-alive
+// frames at its own rate, and that output change on one slot sends exactly
+// one change frame only on that slot. Intervals are restored at the end.
+bool outputSchedulerSelfTest(char *message, int messageSize);
+#endif
+
 } // namespace comm
 } // namespace bp3c
 } // namespace eez
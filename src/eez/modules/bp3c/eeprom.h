@@ -27,11 +27,22 @@
 |0      |   2|Module type                               |
 |2      |   2|Module revision                           |
 |4      |   2|0xA5A5 if firmware is installed           |
+|32     |   8|[Module ID](#module-id)                   |
 |40     |  24|[ON-time counter](#ontime-counter)        |
 |64     |  64|[Module configuration](#module-congiguration)|
 |128    | 144|CH1 [calibration parameters](#calibration)|
 |272    | 144|CH2 [calibration parameters](#calibration)|
 
+## <a name="module-id">Module ID</a>
+
+Random number assigned on the first boot with the module, ON-time journal
+uses it to recognize the module.
+
+|Offset|Size|Type                     |Description                  |
+|------|----|-------------------------|-----------------------------|
+|0     |4   |int                      |Module ID, never 0           |
+|4     |4   |int                      |CRC32 of the module ID       |
+
 ## <a name="ontime-counter">ON-time counter</a>
 
 |Offset|Size|Type                     |Description                  |
@@ -99,6 +110,7 @@ namespace eez {
 namespace bp3c {
 namespace eeprom {
 
+static const uint16_t EEPROM_MODULE_ID_START_ADDRESS = 32;
 static const uint16_t EEPROM_ONTIME_START_ADDRESS = 40;
 
 void init();
@@ -380,6 +380,9 @@ public:
     }
 
     void onPowerDown() {
+#if defined(EEZ_PLATFORM_STM32)
+        bp3c::comm::abortTransfer(slotIndex);
+#endif
         synchronized = false;
     }
 
@@ -418,7 +421,12 @@ public:
 
 #if defined(EEZ_PLATFORM_STM32)
     void transfer() {
+        bp3c::comm::abortTransfer(slotIndex);
         auto status = bp3c::comm::transfer(slotIndex, output, input, BUFFER_SIZE);
+        onTransferCompleted(status);
+    }
+
+    void onTransferCompleted(bp3c::comm::TransferResult status) {
         if (status == bp3c::comm::TRANSFER_STATUS_OK) {
             numCrcErrors = 0;
         } else {
@@ -461,7 +469,32 @@ public:
         return roundPrec(Tcelsius, 1.0f);
     }
 
+    // Transfers are pipelined: tick processes the frame received by the
+    // DMA transfer started in the previous tick and then starts a new one with
+    // the latest set values, so all changes made since the last tick are sent
+    // in one frame and PSU thread never waits for the SPI bus.
     void tick(uint8_t slotIndex) {
+        if (bp3c::comm::isTransferInProgress(slotIndex)) {
+            return;
+        }
+
+        bp3c::comm::TransferResult status;
+        if (bp3c::comm::getCompletedTransfer(slotIndex, status)) {
+            onTransferCompleted(status);
+            if (numCrcErrors == 0) {
+                processInput(slotIndex);
+            }
+        }
+
+        fillOutput(slotIndex);
+
+        status = bp3c::comm::startTransfer(slotIndex, output, input, BUFFER_SIZE);
+        if (status != bp3c::comm::TRANSFER_STATUS_OK) {
+            onTransferCompleted(status);
+        }
+    }
+
+    void fillOutput(uint8_t slotIndex) {
         DcmChannel &channel1 = (DcmChannel &)*Channel::getBySlotIndex(slotIndex, 0);
         DcmChannel &channel2 = (DcmChannel &)*Channel::getBySlotIndex(slotIndex, 1);
 
@@ -481,45 +514,43 @@ public:
         psu::debug::g_uDac[channel2.channelIndex].set(channel2.uSet);
         psu::debug::g_iDac[channel2.channelIndex].set(channel2.iSet);
 #endif
+    }
 
-        transfer();
+    void processInput(uint8_t slotIndex) {
+        uint16_t *inputSetValues = (uint16_t *)(input + 2);
 
-        if (numCrcErrors == 0) {
-            uint16_t *inputSetValues = (uint16_t *)(input + 2);
-
-            for (int subchannelIndex = 0; subchannelIndex < 2; subchannelIndex++) {
-                auto &channel = *(DcmChannel *)Channel::getBySlotIndex(slotIndex, subchannelIndex);
-                int offset = subchannelIndex * 2;
+        for (int subchannelIndex = 0; subchannelIndex < 2; subchannelIndex++) {
+            auto &channel = *(DcmChannel *)Channel::getBySlotIndex(slotIndex, subchannelIndex);
+            int offset = subchannelIndex * 2;
 
-                channel.ccMode = (input[0] & (subchannelIndex == 0 ? REG0_CC1_MASK : REG0_CC2_MASK)) != 0;
+            channel.ccMode = (input[0] & (subchannelIndex == 0 ? REG0_CC1_MASK : REG0_CC2_MASK)) != 0;
 
-                uint16_t uMonAdc = inputSetValues[offset];
-                float uMon = remap(uMonAdc, (float)ADC_MIN, 0, (float)ADC_MAX, channel.params.U_MAX);
-                channel.onAdcData(ADC_DATA_TYPE_U_MON, uMon);
+            uint16_t uMonAdc = inputSetValues[offset];
+            float uMon = remap(uMonAdc, (float)ADC_MIN, 0, (float)ADC_MAX, channel.params.U_MAX);
+            channel.onAdcData(ADC_DATA_TYPE_U_MON, uMon);
 
-                uint16_t iMonAdc = inputSetValues[offset + 1];
-                const float FULL_SCALE = 2.0F;
-                const float U_REF = 2.5F;
-                float iMon = remap(iMonAdc, (float)ADC_MIN, 0, FULL_SCALE * ADC_MAX / U_REF, /*params.I_MAX*/ channel.I_MAX_FOR_REMAP);
-                iMon = roundPrec(iMon, I_MON_RESOLUTION);
-                channel.onAdcData(ADC_DATA_TYPE_I_MON, iMon);
+            uint16_t iMonAdc = inputSetValues[offset + 1];
+            const float FULL_SCALE = 2.0F;
+            const float U_REF = 2.5F;
+            float iMon = remap(iMonAdc, (float)ADC_MIN, 0, FULL_SCALE * ADC_MAX / U_REF, /*params.I_MAX*/ channel.I_MAX_FOR_REMAP);
+            iMon = roundPrec(iMon, I_MON_RESOLUTION);
+            channel.onAdcData(ADC_DATA_TYPE_I_MON, iMon);
 
 #if !CONF_SKIP_PWRGOOD_TEST
-                bool pwrGood = input[0] & REG0_PWRGOOD_MASK ? true : false;
-                if (!pwrGood) {
-                    channel.flags.powerOk = 0;
-                    generateError(SCPI_ERROR_CH1_FAULT_DETECTED - channel.channelIndex);
-                    powerDownBySensor();
-                }
+            bool pwrGood = input[0] & REG0_PWRGOOD_MASK ? true : false;
+            if (!pwrGood) {
+                channel.flags.powerOk = 0;
+                generateError(SCPI_ERROR_CH1_FAULT_DETECTED - channel.channelIndex);
+                powerDownBySensor();
+            }
 #endif
 
-                channel.temperature = calcTemperature(*((uint16_t *)(input + 10 + subchannelIndex * 2)));
+            channel.temperature = calcTemperature(*((uint16_t *)(input + 10 + subchannelIndex * 2)));
 
 #ifdef DEBUG
-                psu::debug::g_uMon[channel.channelIndex].set(uMonAdc);
-                psu::debug::g_iMon[channel.channelIndex].set(iMonAdc);
+            psu::debug::g_uMon[channel.channelIndex].set(uMonAdc);
+            psu::debug::g_iMon[channel.channelIndex].set(iMonAdc);
 #endif
-            }
         }
     }
 #endif
@@ -27,6 +27,7 @@
 #include <eez/modules/psu/debug.h>
 #include <eez/modules/psu/profile.h>
 #include <eez/modules/psu/channel_dispatcher.h>
+#include <eez/modules/psu/protection.h>
 
 #include <eez/scpi/regs.h>
 
@@ -334,13 +335,16 @@ struct DcpChannel : public Channel {
 				if (dac.isOverHwOvpThreshold()) {
 					// activate HW OVP
 					prot_conf.flags.u_hwOvpDeactivated = 0;
+					protection::invalidate();
 					ioexp.changeBit(IOExpander::IO_BIT_OUT_OVP_ENABLE, true);
 				} else {
 					prot_conf.flags.u_hwOvpDeactivated = 1;
+					protection::invalidate();
 				}
 			} else if ((fallingEdge || !isHwOvpEnabled(*this)) && ioexp.testBit(IOExpander::IO_BIT_OUT_OVP_ENABLE)) {
 				// deactivate HW OVP
 				prot_conf.flags.u_hwOvpDeactivated = fallingEdge ? 0 : 1;
+				protection::invalidate();
 				ioexp.changeBit(IOExpander::IO_BIT_OUT_OVP_ENABLE, false);
 			}
 		}
@@ -465,6 +469,7 @@ struct DcpChannel : public Channel {
 					if (dac.isOverHwOvpThreshold()) {
 						// OVP has to be enabled after OE activation
 						prot_conf.flags.u_hwOvpDeactivated = 0;
+						protection::invalidate();
 						ioexp.changeBit(IOExpander::IO_BIT_OUT_OVP_ENABLE, true);
 					}
 				}
@@ -489,6 +494,7 @@ struct DcpChannel : public Channel {
 				if (isHwOvpEnabled(*this)) {
 					// OVP has to be disabled before OE deactivation
 					prot_conf.flags.u_hwOvpDeactivated = 1;
+					protection::invalidate();
 					ioexp.changeBit(IOExpander::IO_BIT_OUT_OVP_ENABLE, false);
 				}
 			}
@@ -591,12 +597,14 @@ struct DcpChannel : public Channel {
 				if (isHwOvpEnabled(*this)) {
 					// deactivate HW OVP
 					prot_conf.flags.u_hwOvpDeactivated = 0; // this flag should be 0 while fallingEdge is true
+					protection::invalidate();
 					ioexp.changeBit(IOExpander::IO_BIT_OUT_OVP_ENABLE, false);
 				}
 			} else if (belowThreshold) {
 				if (isHwOvpEnabled(*this)) {
 					// deactivate HW OVP
 					prot_conf.flags.u_hwOvpDeactivated = 1;
+					protection::invalidate();
 					ioexp.changeBit(IOExpander::IO_BIT_OUT_OVP_ENABLE, false);
 				}
 			}
@@ -19,6 +19,7 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <memory.h>
+#include <math.h>
 
 #if defined(EEZ_PLATFORM_STM32)
 #include <spi.h>
@@ -29,8 +30,11 @@
 #include <eez/firmware.h>
 #include <eez/index.h>
 #include <eez/hmi.h>
+#include <eez/system.h>
 #include <eez/gui/gui.h>
+#include <eez/modules/psu/psu.h>
 #include <eez/modules/psu/event_queue.h>
+#include <eez/modules/psu/dlog_record.h>
 #include <eez/modules/bp3c/comm.h>
 #include <eez/modules/bp3c/flash_slave.h>
 
@@ -72,6 +76,13 @@ public:
 
 #define BUFFER_SIZE 1024
 
+// analog input samples start at this offset in the input buffer,
+// number of samples (uint16_t) is stored just before
+#define ANALOG_INPUT_SAMPLES_OFFSET 24
+#define MAX_ANALOG_INPUT_SAMPLES_PER_FRAME ((BUFFER_SIZE - ANALOG_INPUT_SAMPLES_OFFSET) / 2)
+
+#define SAMPLE_RATE_MEASURE_PERIOD_US 1000000
+
 struct Mio168Module : public Module {
 public:
     TestResult testResult = TEST_NONE;
@@ -81,14 +92,31 @@ public:
     uint8_t output[BUFFER_SIZE];
     uint8_t inputPinStates = 0;
     uint8_t outputPinStates = 0;
-    uint16_t analogInputValues[4];
+    uint16_t analogInputValues[NUM_ANALOG_INPUTS];
     bool spiReady;
 
+    // acquisition state, written from onSpiDmaTransferCompleted
+    uint16_t analogInputSamples[ANALOG_INPUT_BUFFER_SIZE][NUM_ANALOG_INPUTS];
+    volatile uint32_t analogInputPosition = 0;
+    uint32_t analogInputTotalSamples = 0;
+    uint32_t analogInputAccumulators[NUM_ANALOG_INPUTS];
+    int analogInputAveragingCounter = 0;
+    int analogInputAveraging = ANALOG_INPUT_AVERAGING_DEFAULT;
+
+    uint32_t sampleRateLastTickCount = 0;
+    uint32_t sampleRateLastPosition = 0;
+    float sampleRate = 0;
+
+    bool dlogTraceEnabled = false;
+    uint32_t dlogTracePosition = 0;
+
     Mio168Module(uint8_t slotIndex, ModuleInfo *moduleInfo, uint16_t moduleRevision, bool firmwareInstalled)
         : Module(slotIndex, moduleInfo, moduleRevision, firmwareInstalled)
     {
         memset(input, 0, sizeof(input));
         memset(output, 0, sizeof(output));
+        memset(analogInputValues, 0, sizeof(analogInputValues));
+        resetAcquisition();
     }
 
     TestResult getTestResult() override {
@@ -98,6 +126,7 @@ public:
     void initChannels() override {
         if (!synchronized) {
             if (bp3c::comm::masterSynchro(slotIndex)) {
+                resetAcquisition();
                 synchronized = true;
                 numCrcErrors = 0;
                 testResult = TEST_OK;
@@ -122,11 +151,26 @@ public:
         // cnt = 0;
 
 #if defined(EEZ_PLATFORM_STM32)
-        if (spiReady) {
-            spiReady = false;
-            transfer();
+        // Result is handled from SPI DMA IRQ, here only a lost completion is timed out.
+        // spiReady is kept until the transfer is completed or timed out.
+        if (!bp3c::comm::isTransferInProgress(slotIndex)) {
+            bp3c::comm::TransferResult status;
+            if (bp3c::comm::getCompletedTransfer(slotIndex, status) && status == bp3c::comm::TRANSFER_STATUS_TIMEOUT) {
+                onSpiDmaTransferCompleted(status);
+            }
+
+            if (spiReady) {
+                spiReady = false;
+                transfer();
+            }
         }
 #endif
+
+        measureSampleRate();
+
+        if (dlogTraceEnabled) {
+            dlogTraceTick();
+        }
     }
 
 #if defined(EEZ_PLATFORM_STM32)
@@ -139,7 +183,7 @@ public:
         output[0] = inputPinStates;
         output[1] = outputPinStates;
 
-        auto status = bp3c::comm::transferDMA(slotIndex, output, input, BUFFER_SIZE);
+        auto status = bp3c::comm::startTransfer(slotIndex, output, input, BUFFER_SIZE);
         if (status != bp3c::comm::TRANSFER_STATUS_OK) {
         	auto &slot = *g_slots[slotIndex];
         	slot.onSpiDmaTransferCompleted(status);
@@ -152,20 +196,17 @@ public:
 
             inputPinStates = input[0];
 
-            static uint32_t totalSamples = 0;
-
-            uint16_t *inputU16 = (uint16_t *)(input + 24);
+            uint16_t *inputU16 = (uint16_t *)(input + ANALOG_INPUT_SAMPLES_OFFSET);
 
             uint16_t numSamples = inputU16[-1];
+            if (numSamples > MAX_ANALOG_INPUT_SAMPLES_PER_FRAME) {
+                DebugTrace("Slot %d invalid number of samples %d\n", slotIndex + 1, (int)numSamples);
+                numSamples = MAX_ANALOG_INPUT_SAMPLES_PER_FRAME;
+            }
 
-            analogInputValues[(totalSamples + 0) % 4] = inputU16[0];
-            analogInputValues[(totalSamples + 1) % 4] = inputU16[1];
-            analogInputValues[(totalSamples + 2) % 4] = inputU16[2];
-            analogInputValues[(totalSamples + 3) % 4] = inputU16[3];
-
-            analogInputValues[3] = numSamples;
-
-            totalSamples += numSamples;
+            for (uint16_t i = 0; i < numSamples; i++) {
+                addAnalogInputSample(inputU16[i]);
+            }
         } else {
             if (status == bp3c::comm::TRANSFER_STATUS_CRC_ERROR) {
                 if (++numCrcErrors >= 10) {
@@ -185,6 +226,105 @@ public:
         synchronized = false;
     }
 
+    void resetAcquisition() {
+        analogInputTotalSamples = 0;
+        memset(analogInputAccumulators, 0, sizeof(analogInputAccumulators));
+        analogInputAveragingCounter = 0;
+
+        analogInputPosition = 0;
+        sampleRateLastTickCount = micros();
+        sampleRateLastPosition = 0;
+        sampleRate = 0;
+
+        dlogTracePosition = 0;
+    }
+
+    // Samples in the stream are interleaved: sample N belongs to analog input N % NUM_ANALOG_INPUTS.
+    void addAnalogInputSample(uint16_t sample) {
+        int analogInputIndex = analogInputTotalSamples % NUM_ANALOG_INPUTS;
+        analogInputTotalSamples++;
+
+        analogInputAccumulators[analogInputIndex] += sample;
+
+        if (analogInputIndex < NUM_ANALOG_INPUTS - 1) {
+            return;
+        }
+
+        if (++analogInputAveragingCounter < analogInputAveraging) {
+            return;
+        }
+
+        uint32_t position = analogInputPosition;
+        uint16_t *row = analogInputSamples[position % ANALOG_INPUT_BUFFER_SIZE];
+
+        for (int i = 0; i < NUM_ANALOG_INPUTS; i++) {
+            row[i] = (uint16_t)((analogInputAccumulators[i] + analogInputAveragingCounter / 2) / analogInputAveragingCounter);
+            analogInputValues[i] = row[i];
+            analogInputAccumulators[i] = 0;
+        }
+
+        analogInputAveragingCounter = 0;
+
+        // publish row only after it is completely written
+        analogInputPosition = position + 1;
+    }
+
+    void setAveraging(int averaging) {
+        if (averaging < ANALOG_INPUT_AVERAGING_MIN) {
+            averaging = ANALOG_INPUT_AVERAGING_MIN;
+        } else if (averaging > ANALOG_INPUT_AVERAGING_MAX) {
+            averaging = ANALOG_INPUT_AVERAGING_MAX;
+        }
+        analogInputAveraging = averaging;
+    }
+
+    void measureSampleRate() {
+        uint32_t tickCount = micros();
+        int32_t diff = tickCount - sampleRateLastTickCount;
+        if (diff >= SAMPLE_RATE_MEASURE_PERIOD_US) {
+            uint32_t position = analogInputPosition;
+            sampleRate = (position - sampleRateLastPosition) * 1E6f / diff;
+            sampleRateLastPosition = position;
+            sampleRateLastTickCount = tickCount;
+        }
+    }
+
+    uint32_t readSamples(uint32_t &position, uint16_t *samples, uint32_t maxRows) {
+        uint32_t head = analogInputPosition;
+
+        // keep one row reserve because it can be overwritten while we read
+        if (head - position > ANALOG_INPUT_BUFFER_SIZE - 1) {
+            position = head - (ANALOG_INPUT_BUFFER_SIZE - 1);
+        }
+
+        uint32_t numRows = MIN(head - position, maxRows);
+        for (uint32_t i = 0; i < numRows; i++) {
+            memcpy(samples, analogInputSamples[position % ANALOG_INPUT_BUFFER_SIZE], NUM_ANALOG_INPUTS * sizeof(uint16_t));
+            samples += NUM_ANALOG_INPUTS;
+            position++;
+        }
+
+        return numRows;
+    }
+
+    void dlogTraceTick() {
+        using namespace psu;
+
+        if (!dlog_record::isTraceExecuting()) {
+            dlogTracePosition = analogInputPosition;
+            return;
+        }
+
+        uint16_t row[NUM_ANALOG_INPUTS];
+        while (readSamples(dlogTracePosition, row, 1)) {
+            float values[dlog_view::MAX_NUM_OF_Y_AXES];
+            for (int yAxisIndex = 0; yAxisIndex < dlog_record::g_recording.parameters.numYAxes; yAxisIndex++) {
+                values[yAxisIndex] = yAxisIndex < NUM_ANALOG_INPUTS ? row[yAxisIndex] : NAN;
+            }
+            dlog_record::log(values);
+        }
+    }
+
     int getInputPinState(int pin) {
         return inputPinStates & (1 << pin) ? 1 : 0;
     }
@@ -209,6 +349,50 @@ Module *Mio168ModuleInfo::createModule(uint8_t slotIndex, uint16_t moduleRevisio
 static Mio168ModuleInfo g_mio168ModuleInfo;
 ModuleInfo *g_moduleInfo = &g_mio168ModuleInfo;
 
+////////////////////////////////////////////////////////////////////////////////
+
+static Mio168Module *getModule(int slotIndex) {
+    if (slotIndex < 0 || slotIndex >= NUM_SLOTS || g_slots[slotIndex]->moduleInfo != g_moduleInfo) {
+        return nullptr;
+    }
+    return (Mio168Module *)g_slots[slotIndex];
+}
+
+int getAnalogInputAveraging(int slotIndex) {
+    auto module = getModule(slotIndex);
+    return module ? module->analogInputAveraging : ANALOG_INPUT_AVERAGING_DEFAULT;
+}
+
+void setAnalogInputAveraging(int slotIndex, int averaging) {
+    auto module = getModule(slotIndex);
+    if (module) {
+        module->setAveraging(averaging);
+    }
+}
+
+float getAnalogInputSampleRate(int slotIndex) {
+    auto module = getModule(slotIndex);
+    return module ? module->sampleRate : 0;
+}
+
+uint32_t readAnalogInputSamples(int slotIndex, uint32_t &position, uint16_t *samples, uint32_t maxRows) {
+    auto module = getModule(slotIndex);
+    return module ? module->readSamples(position, samples, maxRows) : 0;
+}
+
+bool isAnalogInputDlogTraceEnabled(int slotIndex) {
+    auto module = getModule(slotIndex);
+    return module ? module->dlogTraceEnabled : false;
+}
+
+void setAnalogInputDlogTraceEnabled(int slotIndex, bool enabled) {
+    auto module = getModule(slotIndex);
+    if (module) {
+        module->dlogTracePosition = module->analogInputPosition;
+        module->dlogTraceEnabled = enabled;
+    }
+}
+
 } // namespace dib_mio168
 
 namespace gui {
@@ -263,16 +447,16 @@ void action_dib_mio168_toggle_output_state() {
 
 void data_dib_mio168_analog_inputs(DataOperationEnum operation, Cursor cursor, Value &value) {
     if (operation == DATA_OPERATION_COUNT) {
-        value = 4;
+        value = dib_mio168::NUM_ANALOG_INPUTS;
     } else if (operation == DATA_OPERATION_GET_CURSOR_VALUE) {
-        value = hmi::g_selectedSlotIndex * 4 + value.getInt();
+        value = hmi::g_selectedSlotIndex * dib_mio168::NUM_ANALOG_INPUTS + value.getInt();
     }
 }
 
 void data_dib_mio168_analog_input_value(DataOperationEnum operation, Cursor cursor, Value &value) {
     if (operation == DATA_OPERATION_GET) {
-        auto mio168Module = (dib_mio168::Mio168Module *)g_slots[cursor / 4];
-        value = mio168Module->analogInputValues[cursor % 4];
+        auto mio168Module = (dib_mio168::Mio168Module *)g_slots[cursor / dib_mio168::NUM_ANALOG_INPUTS];
+        value = mio168Module->analogInputValues[cursor % dib_mio168::NUM_ANALOG_INPUTS];
     }
 }
 
@@ -25,7 +25,34 @@ namespace dib_mio168 {
 
 static const uint16_t MODULE_REVISION_R1B2  = 0x0102;
 
+static const int NUM_ANALOG_INPUTS = 4;
+
+static const int ANALOG_INPUT_AVERAGING_MIN = 1;
+static const int ANALOG_INPUT_AVERAGING_MAX = 1000;
+static const int ANALOG_INPUT_AVERAGING_DEFAULT = 1;
+
+// number of rows (one sample for each analog input) kept in acquisition buffer
+static const uint32_t ANALOG_INPUT_BUFFER_SIZE = 512;
+
 extern ModuleInfo *g_moduleInfo;
 
+// Analog input acquisition.
+// Every sample received in SPI DMA frame is stored, after averaging,
+// in per slot ring buffer. Readers keep their own position in the stream.
+int getAnalogInputAveraging(int slotIndex);
+void setAnalogInputAveraging(int slotIndex, int averaging);
+
+// measured rate of rows written to acquisition buffer, i.e. after averaging
+float getAnalogInputSampleRate(int slotIndex);
+
+// Copies rows starting at position into samples (NUM_ANALOG_INPUTS values per row),
+// returns number of rows copied and advances position. If reader is too slow,
+// position is moved to the oldest row still available.
+uint32_t readAnalogInputSamples(int slotIndex, uint32_t &position, uint16_t *samples, uint32_t maxRows);
+
+// when enabled, rows are written into DLOG recording while DLOG trace is executing
+bool isAnalogInputDlogTraceEnabled(int slotIndex);
+void setAnalogInputDlogTraceEnabled(int slotIndex, bool enabled);
+
 } // namespace dib_mio168
 } // namespace eez
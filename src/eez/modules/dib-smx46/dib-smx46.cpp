@@ -18,6 +18,7 @@
 
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 
 #if defined(EEZ_PLATFORM_STM32)
 #include <spi.h>
@@ -75,11 +76,13 @@ public:
     int numCrcErrors = 0;
     uint8_t input[BUFFER_SIZE];
     uint8_t output[BUFFER_SIZE];
-    bool spiReady;
+    bool spiReady = false;
 
     Smx46Module(uint8_t slotIndex, ModuleInfo *moduleInfo, uint16_t moduleRevision, bool firmwareInstalled)
         : Module(slotIndex, moduleInfo, moduleRevision, firmwareInstalled)
     {
+        memset(input, 0, sizeof(input));
+        memset(output, 0, sizeof(output));
     }
 
     TestResult getTestResult() override {
@@ -92,6 +95,7 @@ public:
                 synchronized = true;
                 numCrcErrors = 0;
                 testResult = TEST_OK;
+                bp3c::comm::resetOutputScheduler(slotIndex);
             } else {
                 if (g_slots[slotIndex]->firmwareInstalled) {
                     psu::event_queue::pushEvent(psu::event_queue::EVENT_ERROR_SLOT1_SYNC_ERROR + slotIndex);
@@ -106,18 +110,39 @@ public:
             return;
         }
 
-        static int cnt = 0;
-        if (++cnt < 25) {
+        // called also while transfer is in progress, so the time of the output change is noted
+        bool transferDue = bp3c::comm::isOutputTransferDue(slotIndex, output, BUFFER_SIZE);
+
+        if (bp3c::comm::isTransferInProgress(slotIndex)) {
+            return;
+        }
+
+        bp3c::comm::TransferResult status;
+        if (bp3c::comm::getCompletedTransfer(slotIndex, status)) {
+            bp3c::comm::onOutputTransferCompleted(slotIndex);
+            onTransferCompleted(status);
+            if (!synchronized) {
+                return;
+            }
+        }
+
+        if (!transferDue) {
             return;
         }
-        cnt = 0;
 
 #if defined(EEZ_PLATFORM_STM32)
-        if (spiReady) {
-            spiReady = false;
-            transfer();
+        if (!spiReady) {
+            return;
         }
+        spiReady = false;
 #endif
+
+        status = bp3c::comm::startTransfer(slotIndex, output, input, BUFFER_SIZE);
+        if (status == bp3c::comm::TRANSFER_STATUS_OK) {
+            bp3c::comm::onOutputTransferStarted(slotIndex, output, BUFFER_SIZE);
+        } else {
+            onTransferCompleted(status);
+        }
     }
 
 #if defined(EEZ_PLATFORM_STM32)
@@ -126,8 +151,7 @@ public:
     }
 #endif
 
-    void transfer() {
-        auto status = bp3c::comm::transfer(slotIndex, output, input, BUFFER_SIZE);
+    void onTransferCompleted(bp3c::comm::TransferResult status) {
         if (status == bp3c::comm::TRANSFER_STATUS_OK) {
             numCrcErrors = 0;
         } else {
@@ -1,558 +1,1008 @@
-/*
- * EEZ Modular Firmware
- * Copyright (C) 2015-present, Envox d.o.o.
- *
- * This program is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License as published by
- * the Free Software Foundation, either version 3 of the License, or
- * (at your option) any later version.
-
- * This program is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- * GNU General Public License for more details.
-
- * You should have received a copy of the GNU General Public License
- * along with this program.  If not, see <http://www.gnu.org/licenses/>.
- */
-
-#include <stdio.h>
-
-#if OPTION_DISPLAY
-
-#include <eez/util.h>
-
-#include <eez/gui/gui.h>
-
-// TODO
-#include <eez/modules/psu/psu.h>
-#include <eez/modules/psu/persist_conf.h>
-
-#define CONF_BACKDROP_OPACITY 128
-
-using namespace eez::gui;
-
-namespace eez {
-namespace mcu {
-namespace display {
-
-uint16_t g_fc, g_bc;
-uint8_t g_opacity = 255;
-
-gui::font::Font g_font;
-
-static uint8_t g_colorCache[256][4];
-
-#define FLOAT_TO_COLOR_COMPONENT(F) ((F) < 0 ? 0 : (F) > 255 ? 255 : (uint8_t)(F))
-#define RGB_TO_HIGH_BYTE(R, G, B) (((R) & 248) | (G) >> 5)
-#define RGB_TO_LOW_BYTE(R, G, B) (((G) & 28) << 3 | (B) >> 3)
-
-static const uint16_t *g_themeColors;
-static uint32_t g_themeColorsCount;
-static const uint16_t *g_colors;
-
-uint32_t color16to32(uint16_t color, uint8_t opacity) {
-    uint32_t color32;
-    ((uint8_t *)&color32)[0] = COLOR_TO_B(color);
-    ((uint8_t *)&color32)[1] = COLOR_TO_G(color);
-    ((uint8_t *)&color32)[2] = COLOR_TO_R(color);
-    ((uint8_t *)&color32)[3] = opacity;
-    return color32;
-}
-
-uint16_t color32to16(uint32_t color) {
-    auto pcolor = (uint8_t *)&color;
-    return RGB_TO_COLOR(pcolor[2], pcolor[1], pcolor[0]);
-}
-
-uint32_t blendColor(uint32_t fgColor, uint32_t bgColor) {
-    uint8_t *fg = (uint8_t *)&fgColor;
-    uint8_t *bg = (uint8_t *)&bgColor;
-
-    float alphaMult = fg[3] * bg[3] / 255.0f;
-    float alphaOut = fg[3] + bg[3] - alphaMult;
-
-    float r = (fg[2] * fg[3] + bg[2] * bg[3] - bg[2] * alphaMult) / alphaOut;
-    float g = (fg[1] * fg[3] + bg[1] * bg[3] - bg[1] * alphaMult) / alphaOut;
-    float b = (fg[0] * fg[3] + bg[0] * bg[3] - bg[0] * alphaMult) / alphaOut;
-
-    r = clamp(r, 0.0f, 255.0f);
-    g = clamp(g, 0.0f, 255.0f);
-    b = clamp(b, 0.0f, 255.0f);
-
-    uint32_t result;
-    uint8_t *presult = (uint8_t *)&result;
-    presult[0] = (uint8_t)b;
-    presult[1] = (uint8_t)g;
-    presult[2] = (uint8_t)r;
-    presult[3] = (uint8_t)alphaOut;
-
-    return result;
-}
-
-void onThemeChanged() {
-	if (g_assetsLoaded) {
-		g_themeColors = getThemeColors(psu::persist_conf::devConf.selectedThemeIndex);
-		g_themeColorsCount = getThemeColorsCount(psu::persist_conf::devConf.selectedThemeIndex);
-		g_colors = getColors();
-	}
-}
-
-void onLuminocityChanged() {
-    // invalidate cache
-    for (int i = 0; i < 256; ++i) {
-        g_colorCache[i][0] = 0;
-        g_colorCache[i][1] = 0;
-        g_colorCache[i][2] = 0;
-        g_colorCache[i][3] = 0;
-    }
-}
-
-#define swap(type, i, j) {type t = i; i = j; j = t;}
-
-void rgbToHsl(float r, float g, float b, float &h, float &s, float &l) {
-    r /= 255;
-    g /= 255;
-    b /= 255;
-
-    float min = r;
-    float mid = g;
-    float max = b;
-
-    if (min > mid) {
-        swap(float, min, mid);
-    }
-    if (mid > max) {
-        swap(float, mid, max);
-    }
-    if (min > mid) {
-        swap(float, min, mid);
-    }
-
-    l = (max + min) / 2;
-
-    if (max == min) {
-        h = s = 0; // achromatic
-    } else {
-        float d = max - min;
-        s = l > 0.5 ? d / (2 - max - min) : d / (max + min);
-
-        if (max == r) {
-            h = (g - b) / d + (g < b ? 6 : 0);
-        } else if (max == g) {
-            h = (b - r) / d + 2;
-        } else if (max == b) {
-            h = (r - g) / d + 4;
-        }
-
-        h /= 6;
-    }
-}
-
-float hue2rgb(float p, float q, float t) {
-    if (t < 0) t += 1;
-    if (t > 1) t -= 1;
-    if (t < 1.0f/6) return p + (q - p) * 6 * t;
-    if (t < 1.0f/2) return q;
-    if (t < 2.0f/3) return p + (q - p) * (2.0f/3 - t) * 6;
-    return p;
-}
-
-void hslToRgb(float h, float s, float l, float &r, float &g, float &b) {
-    if (s == 0) {
-        r = g = b = l; // achromatic
-    } else {
-        float q = l < 0.5 ? l * (1 + s) : l + s - l * s;
-        float p = 2 * l - q;
-
-        r = hue2rgb(p, q, h + 1.0f/3);
-        g = hue2rgb(p, q, h);
-        b = hue2rgb(p, q, h - 1.0f/3);
-    }
-
-    r *= 255;
-    g *= 255;
-    b *= 255;
-}
-
-void adjustColor(uint16_t &c) {
-    if (psu::persist_conf::devConf.displayBackgroundLuminosityStep == DISPLAY_BACKGROUND_LUMINOSITY_STEP_DEFAULT) {
-        return;
-    }
-
-	uint8_t ch = c >> 8;
-	uint8_t cl = c & 0xFF;
-
-    int i = (ch & 0xF0) | (cl & 0x0F);
-    if (ch == g_colorCache[i][0] && cl == g_colorCache[i][1]) {
-        // cache hit!
-		c = (g_colorCache[i][2] << 8) | g_colorCache[i][3];
-        return;
-    }
-
-    uint8_t r, g, b;
-    r = ch & 248;
-    g = ((ch << 5) | (cl >> 3)) & 252;
-    b = cl << 3;
-
-    float h, s, l;
-    rgbToHsl(r, g, b, h, s, l);
-
-    float a = l < 0.5 ? l : 1 - l;
-    if (a > 0.3f) {
-        a = 0.3f;
-    }
-    float lmin = l - a;
-    float lmax = l + a;
-
-    float lNew = remap((float)psu::persist_conf::devConf.displayBackgroundLuminosityStep,
-        (float)DISPLAY_BACKGROUND_LUMINOSITY_STEP_MIN,
-        lmin,
-        (float)DISPLAY_BACKGROUND_LUMINOSITY_STEP_MAX,
-        lmax);
-
-    float floatR, floatG, floatB;
-    hslToRgb(h, s, lNew, floatR, floatG, floatB);
-
-    r = FLOAT_TO_COLOR_COMPONENT(floatR);
-    g = FLOAT_TO_COLOR_COMPONENT(floatG);
-    b = FLOAT_TO_COLOR_COMPONENT(floatB);
-
-    uint8_t chNew = RGB_TO_HIGH_BYTE(r, g, b);
-    uint8_t clNew = RGB_TO_LOW_BYTE(r, g, b);
-
-    // store new color in the cache
-    g_colorCache[i][0] = ch;
-    g_colorCache[i][1] = cl;
-    g_colorCache[i][2] = chNew;
-    g_colorCache[i][3] = clNew;
-
-	c = (chNew << 8) | clNew;
-}
-
-uint16_t getColor16FromIndex(uint16_t color) {
-    color = transformColorHook(color);
-	return color < g_themeColorsCount ? g_themeColors[color] : g_colors[color - g_themeColorsCount];
-}
-
-void setColor(uint8_t r, uint8_t g, uint8_t b) {
-    g_fc = RGB_TO_COLOR(r, g, b);
-	adjustColor(g_fc);
-}
-
-void setColor16(uint16_t color) {
-    g_fc = color;
-    adjustColor(g_fc);
-}
-
-void setColor(uint16_t color, bool ignoreLuminocity) {
-    g_fc = getColor16FromIndex(color);
-	adjustColor(g_fc);
-}
-
-uint16_t getColor() {
-    return g_fc;
-}
-
-void setBackColor(uint8_t r, uint8_t g, uint8_t b) {
-    g_bc = RGB_TO_COLOR(r, g, b);
-	adjustColor(g_bc);
-}
-
-void setBackColor(uint16_t color, bool ignoreLuminocity) {
-	g_bc = getColor16FromIndex(color);
-	adjustColor(g_bc);
-}
-
-uint16_t getBackColor() {
-    return g_bc;
-}
-
-uint8_t setOpacity(uint8_t opacity) {
-    uint8_t savedOpacity = g_opacity;
-    g_opacity = opacity;
-    return savedOpacity;
-}
-
-uint8_t getOpacity() {
-    return g_opacity;
-}
-
-// static int g_prevDirtyX1;
-// static int g_prevDirtyY1;
-// static int g_prevDirtyX2;
-// static int g_prevDirtyY2;
-
-// static int g_nextDirtyX1 = getDisplayWidth();
-// static int g_nextDirtyY1 = getDisplayHeight();
-// static int g_nextDirtyX2 = -1;
-// static int g_nextDirtyY2 = -1;
-
-// static int g_dirtyX1;
-// static int g_dirtyY1;
-// static int g_dirtyX2;
-// static int g_dirtyY2;
-
-bool g_dirty;
-
-void clearDirty() {
-    g_dirty = false;
-
-    // g_prevDirtyX1 = g_nextDirtyX1;
-    // g_prevDirtyY1 = g_nextDirtyY1;
-    // g_prevDirtyX2 = g_nextDirtyX2;
-    // g_prevDirtyY2 = g_nextDirtyY2;
-
-    // g_nextDirtyX1 = getDisplayWidth();
-    // g_nextDirtyY1 = getDisplayHeight();
-    // g_nextDirtyX2 = -1;
-    // g_nextDirtyY2 = -1;
-}
-
-// void markDirty(int x1, int y1, int x2, int y2) {
-//     if (x1 < g_nextDirtyX1) {
-//         g_nextDirtyX1 = x1;
-//     }
-//     if (y1 < g_nextDirtyY1) {
-//         g_nextDirtyY1 = y1;
-//     }
-//     if (x2 > g_nextDirtyX2) {
-//         g_nextDirtyX2 = x2;
-//     }
-//     if (y2 > g_nextDirtyY2) {
-//         g_nextDirtyY2 = y2;
-//     }
-// }
-
-bool isDirty() {
-    // g_dirtyX1 = MIN(g_prevDirtyX1, g_nextDirtyX1);
-    // g_dirtyY1 = MIN(g_prevDirtyY1, g_nextDirtyY1);
-    // g_dirtyX2 = MAX(g_prevDirtyX2, g_nextDirtyX2);
-    // g_dirtyY2 = MAX(g_prevDirtyY2, g_nextDirtyY2);
-
-    // if (g_dirtyX1 <= g_dirtyX2 && g_dirtyY1 <= g_dirtyY2) {
-    //     // char msg[50];
-    //     // sprintf(msg, "%d x %d\n", g_dirtyX2 - g_dirtyX1 + 1, g_dirtyY2 - g_dirtyY1 + 1);
-    //     // Serial.println(msg);
-    //     return true;
-    // }
-
-    // return false;
-
-    return g_dirty;
-}
-
-static int8_t measureGlyph(uint8_t encoding) {
-    gui::font::Glyph glyph;
-    g_font.getGlyph(encoding, glyph);
-    if (!glyph)
-        return 0;
-
-    return glyph.dx;
-}
-
-int8_t measureGlyph(uint8_t encoding, gui::font::Font &font) {
-    gui::font::Glyph glyph;
-    font.getGlyph(encoding, glyph);
-    if (!glyph)
-        return 0;
-
-    return glyph.dx;
-}
-
-int measureStr(const char *text, int textLength, gui::font::Font &font, int max_width) {
-    g_font = font;
-
-    int width = 0;
-
-    if (textLength == -1) {
-        char encoding;
-        while ((encoding = *text++) != 0) {
-            int glyph_width = measureGlyph(encoding);
-            if (max_width > 0 && width + glyph_width > max_width) {
-                return max_width;
-            }
-            width += glyph_width;
-        }
-    } else {
-        for (int i = 0; i < textLength && text[i]; ++i) {
-            char encoding = text[i];
-            int glyph_width = measureGlyph(encoding);
-            if (max_width > 0 && width + glyph_width > max_width) {
-                return max_width;
-            }
-            width += glyph_width;
-        }
-    }
-
-    return width;
-}
-
-Buffer g_buffers[NUM_BUFFERS];
-
-static void *g_bufferPointer;
-
-static int g_bufferToDrawIndexes[NUM_BUFFERS];
-static int g_numBuffersToDraw;
-
-//int getNumFreeBuffers() {
-//    int count = 0;
-//    for (int bufferIndex = 0; bufferIndex < NUM_BUFFERS; bufferIndex++) {
-//        if (!g_buffers[bufferIndex].flags.allocated) {
-//            count++;
-//        }
-//    }
-//    return count;
-//}
-
-int allocBuffer() {
-    int bufferIndex;
-
-    for (bufferIndex = 0; bufferIndex < NUM_BUFFERS; bufferIndex++) {
-        if (!g_buffers[bufferIndex].flags.allocated) {
-            // DebugTrace("Buffer %d allocated, %d more left!\n", bufferIndex, getNumFreeBuffers());
-            break;
-        }
-    }
-
-    if (bufferIndex == NUM_BUFFERS) {
-        // DebugTrace("There is no free buffer available!\n");
-        bufferIndex = NUM_BUFFERS - 1;
-    }
-
-    g_buffers[bufferIndex].flags.allocated = true;
-
-    return bufferIndex;
-}
-
-void freeBuffer(int bufferIndex) {
-    g_buffers[bufferIndex].flags.allocated = false;
-    // DebugTrace("Buffer %d freed up, %d buffers available now!\n", bufferIndex, getNumFreeBuffers());
-}
-
-void selectBuffer(int bufferIndex) {
-    g_buffers[bufferIndex].flags.used = true;
-    g_bufferToDrawIndexes[g_numBuffersToDraw++] = bufferIndex;
-    setBufferPointer(g_buffers[bufferIndex].bufferPointer);
-}
-
-void setBufferBounds(int bufferIndex, int x, int y, int width, int height, bool withShadow, uint8_t opacity, int xOffset, int yOffset, Rect *backdrop) {
-    Buffer &buffer = g_buffers[bufferIndex];
-    
-    if (buffer.x != x || buffer.y != y || buffer.width != width || buffer.height != height || buffer.withShadow != withShadow || buffer.opacity != opacity || buffer.xOffset != xOffset || buffer.yOffset != yOffset || backdrop != buffer.backdrop) {
-        buffer.x = x;
-        buffer.y = y;
-        buffer.width = width;
-        buffer.height = height;
-        buffer.withShadow = withShadow;
-        buffer.opacity = opacity;
-        buffer.xOffset = xOffset;
-        buffer.yOffset = yOffset;
-        buffer.backdrop = backdrop;
-
-        int x1 = x + xOffset;
-        int y1 = y + yOffset;
-        int x2 = x1 + width - 1;
-        int y2 = y1 + height - 1;
-
-        if (withShadow) {
-            expandRectWithShadow(x1, y1, x2, y2);
-        }
-
-        markDirty(x1, y1, x2, y2);
-    }
-
-    for (int i = 0; i < g_numBuffersToDraw; i++) {
-        if (g_bufferToDrawIndexes[i] == bufferIndex) {
-            if (i > 0) {
-                setBufferPointer(g_buffers[g_bufferToDrawIndexes[i - 1]].bufferPointer);
-            }
-            break;
-        }
-    }
-}
-
-void clearBufferUsage() {
-    for (int bufferIndex = 0; bufferIndex < NUM_BUFFERS; bufferIndex++) {
-        g_buffers[bufferIndex].flags.used = false;
-    }
-}
-
-void freeUnusedBuffers() {
-    for (int bufferIndex = 0; bufferIndex < NUM_BUFFERS; bufferIndex++) {
-        if (g_buffers[bufferIndex].flags.allocated && !g_buffers[bufferIndex].flags.used) {
-            g_buffers[bufferIndex].flags.allocated = false;
-            // DebugTrace("Buffer %d allocated but not used!\n", bufferIndex);
-        }
-    }
-    
-    clearBufferUsage();
-}
-
-void beginBuffersDrawing() {
-    g_bufferPointer = getBufferPointer();
-}
-
-void endBuffersDrawing() {
-    setBufferPointer(g_bufferPointer);
-
-    if (isDirty()) {
-        for (int i = 0; i < g_numBuffersToDraw; i++) {
-            int bufferIndex = g_bufferToDrawIndexes[i];
-            Buffer &buffer = g_buffers[bufferIndex];
-
-            int sx = buffer.x;
-            int sy = buffer.y;
-
-            int x1 = buffer.x + buffer.xOffset;
-            int y1 = buffer.y + buffer.yOffset;
-            int x2 = x1 + buffer.width - 1;
-            int y2 = y1 + buffer.height - 1;
-
-            if (buffer.backdrop) {
-                auto savedOpacity = setOpacity(CONF_BACKDROP_OPACITY);
-                setColor(COLOR_ID_BACKDROP);
-                fillRect(buffer.backdrop->x, buffer.backdrop->y, buffer.backdrop->x + buffer.backdrop->w - 1, buffer.backdrop->y + buffer.backdrop->h - 1);
-                setOpacity(savedOpacity);
-            }
-
-            if (buffer.withShadow) {
-                // if (x1 > g_dirtyY1 || y1 > g_dirtyY1 || x2 < g_dirtyX2 || y2 < g_dirtyY2) {
-                    drawShadow(x1, y1, x2, y2);
-                // }
-            }
-
-            // if (x1 < g_dirtyX1) {
-            //     int xd = g_dirtyX1 - x1;
-            //     sx += xd;
-            //     x1 += xd;
-            // }
-
-            // if (y1 < g_dirtyY1) {
-            //     int yd = g_dirtyY1 - y1;
-            //     sy += yd;
-            //     y1 += yd;
-            // }
-
-            // if (x2 > g_dirtyX2) {
-            //     x2 = g_dirtyX2;
-            // }
-
-            // if (y2 > g_dirtyY2) {
-            //     y2 = g_dirtyY2;
-            // }
-
-            bitBlt(buffer.bufferPointer, nullptr, sx, sy, x2 - x1 + 1, y2 - y1 + 1, x1, y1, buffer.opacity);
-        }
-    }
-
-    g_numBuffersToDraw = 0;
-
-    freeUnusedBuffers();
-}
-
-} // namespace display
-} // namespace mcu
-} // namespace eez
-
-#endif
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#if OPTION_DISPLAY
+
+#include <eez/debug.h>
+#include <eez/util.h>
+#if defined(EEZ_PLATFORM_SIMULATOR)
+#include <eez/tasks.h>
+#endif
+
+#include <eez/gui/gui.h>
+
+// TODO
+#include <eez/modules/psu/psu.h>
+#include <eez/modules/psu/persist_conf.h>
+
+#define CONF_BACKDROP_OPACITY 128
+
+using namespace eez::gui;
+
+namespace eez {
+namespace mcu {
+namespace display {
+
+uint16_t g_fc, g_bc;
+uint8_t g_opacity = 255;
+
+gui::font::Font g_font;
+
+static uint8_t g_colorCache[256][4];
+
+#define FLOAT_TO_COLOR_COMPONENT(F) ((F) < 0 ? 0 : (F) > 255 ? 255 : (uint8_t)(F))
+#define RGB_TO_HIGH_BYTE(R, G, B) (((R) & 248) | (G) >> 5)
+#define RGB_TO_LOW_BYTE(R, G, B) (((G) & 28) << 3 | (B) >> 3)
+
+static const uint16_t *g_themeColors;
+static uint32_t g_themeColorsCount;
+static const uint16_t *g_colors;
+
+uint32_t color16to32(uint16_t color, uint8_t opacity) {
+    uint32_t color32;
+    ((uint8_t *)&color32)[0] = COLOR_TO_B(color);
+    ((uint8_t *)&color32)[1] = COLOR_TO_G(color);
+    ((uint8_t *)&color32)[2] = COLOR_TO_R(color);
+    ((uint8_t *)&color32)[3] = opacity;
+    return color32;
+}
+
+uint16_t color32to16(uint32_t color) {
+    auto pcolor = (uint8_t *)&color;
+    return RGB_TO_COLOR(pcolor[2], pcolor[1], pcolor[0]);
+}
+
+uint32_t blendColor(uint32_t fgColor, uint32_t bgColor) {
+    uint8_t *fg = (uint8_t *)&fgColor;
+    uint8_t *bg = (uint8_t *)&bgColor;
+
+    float alphaMult = fg[3] * bg[3] / 255.0f;
+    float alphaOut = fg[3] + bg[3] - alphaMult;
+
+    float r = (fg[2] * fg[3] + bg[2] * bg[3] - bg[2] * alphaMult) / alphaOut;
+    float g = (fg[1] * fg[3] + bg[1] * bg[3] - bg[1] * alphaMult) / alphaOut;
+    float b = (fg[0] * fg[3] + bg[0] * bg[3] - bg[0] * alphaMult) / alphaOut;
+
+    r = clamp(r, 0.0f, 255.0f);
+    g = clamp(g, 0.0f, 255.0f);
+    b = clamp(b, 0.0f, 255.0f);
+
+    uint32_t result;
+    uint8_t *presult = (uint8_t *)&result;
+    presult[0] = (uint8_t)b;
+    presult[1] = (uint8_t)g;
+    presult[2] = (uint8_t)r;
+    presult[3] = (uint8_t)alphaOut;
+
+    return result;
+}
+
+void onThemeChanged() {
+	if (g_assetsLoaded) {
+		g_themeColors = getThemeColors(psu::persist_conf::devConf.selectedThemeIndex);
+		g_themeColorsCount = getThemeColorsCount(psu::persist_conf::devConf.selectedThemeIndex);
+		g_colors = getColors();
+	}
+}
+
+void onLuminocityChanged() {
+    // invalidate cache
+    for (int i = 0; i < 256; ++i) {
+        g_colorCache[i][0] = 0;
+        g_colorCache[i][1] = 0;
+        g_colorCache[i][2] = 0;
+        g_colorCache[i][3] = 0;
+    }
+}
+
+#define swap(type, i, j) {type t = i; i = j; j = t;}
+
+void rgbToHsl(float r, float g, float b, float &h, float &s, float &l) {
+    r /= 255;
+    g /= 255;
+    b /= 255;
+
+    float min = r;
+    float mid = g;
+    float max = b;
+
+    if (min > mid) {
+        swap(float, min, mid);
+    }
+    if (mid > max) {
+        swap(float, mid, max);
+    }
+    if (min > mid) {
+        swap(float, min, mid);
+    }
+
+    l = (max + min) / 2;
+
+    if (max == min) {
+        h = s = 0; // achromatic
+    } else {
+        float d = max - min;
+        s = l > 0.5 ? d / (2 - max - min) : d / (max + min);
+
+        if (max == r) {
+            h = (g - b) / d + (g < b ? 6 : 0);
+        } else if (max == g) {
+            h = (b - r) / d + 2;
+        } else if (max == b) {
+            h = (r - g) / d + 4;
+        }
+
+        h /= 6;
+    }
+}
+
+float hue2rgb(float p, float q, float t) {
+    if (t < 0) t += 1;
+    if (t > 1) t -= 1;
+    if (t < 1.0f/6) return p + (q - p) * 6 * t;
+    if (t < 1.0f/2) return q;
+    if (t < 2.0f/3) return p + (q - p) * (2.0f/3 - t) * 6;
+    return p;
+}
+
+void hslToRgb(float h, float s, float l, float &r, float &g, float &b) {
+    if (s == 0) {
+        r = g = b = l; // achromatic
+    } else {
+        float q = l < 0.5 ? l * (1 + s) : l + s - l * s;
+        float p = 2 * l - q;
+
+        r = hue2rgb(p, q, h + 1.0f/3);
+        g = hue2rgb(p, q, h);
+        b = hue2rgb(p, q, h - 1.0f/3);
+    }
+
+    r *= 255;
+    g *= 255;
+    b *= 255;
+}
+
+void adjustColor(uint16_t &c) {
+    if (psu::persist_conf::devConf.displayBackgroundLuminosityStep == DISPLAY_BACKGROUND_LUMINOSITY_STEP_DEFAULT) {
+        return;
+    }
+
+	uint8_t ch = c >> 8;
+	uint8_t cl = c & 0xFF;
+
+    int i = (ch & 0xF0) | (cl & 0x0F);
+    if (ch == g_colorCache[i][0] && cl == g_colorCache[i][1]) {
+        // cache hit!
+		c = (g_colorCache[i][2] << 8) | g_colorCache[i][3];
+        return;
+    }
+
+    uint8_t r, g, b;
+    r = ch & 248;
+    g = ((ch << 5) | (cl >> 3)) & 252;
+    b = cl << 3;
+
+    float h, s, l;
+    rgbToHsl(r, g, b, h, s, l);
+
+    float a = l < 0.5 ? l : 1 - l;
+    if (a > 0.3f) {
+        a = 0.3f;
+    }
+    float lmin = l - a;
+    float lmax = l + a;
+
+    float lNew = remap((float)psu::persist_conf::devConf.displayBackgroundLuminosityStep,
+        (float)DISPLAY_BACKGROUND_LUMINOSITY_STEP_MIN,
+        lmin,
+        (float)DISPLAY_BACKGROUND_LUMINOSITY_STEP_MAX,
+        lmax);
+
+    float floatR, floatG, floatB;
+    hslToRgb(h, s, lNew, floatR, floatG, floatB);
+
+    r = FLOAT_TO_COLOR_COMPONENT(floatR);
+    g = FLOAT_TO_COLOR_COMPONENT(floatG);
+    b = FLOAT_TO_COLOR_COMPONENT(floatB);
+
+    uint8_t chNew = RGB_TO_HIGH_BYTE(r, g, b);
+    uint8_t clNew = RGB_TO_LOW_BYTE(r, g, b);
+
+    // store new color in the cache
+    g_colorCache[i][0] = ch;
+    g_colorCache[i][1] = cl;
+    g_colorCache[i][2] = chNew;
+    g_colorCache[i][3] = clNew;
+
+	c = (chNew << 8) | clNew;
+}
+
+uint16_t getColor16FromIndex(uint16_t color) {
+    color = transformColorHook(color);
+	return color < g_themeColorsCount ? g_themeColors[color] : g_colors[color - g_themeColorsCount];
+}
+
+void setColor(uint8_t r, uint8_t g, uint8_t b) {
+    g_fc = RGB_TO_COLOR(r, g, b);
+	adjustColor(g_fc);
+}
+
+void setColor16(uint16_t color) {
+    g_fc = color;
+    adjustColor(g_fc);
+}
+
+void setColor(uint16_t color, bool ignoreLuminocity) {
+    g_fc = getColor16FromIndex(color);
+	adjustColor(g_fc);
+}
+
+uint16_t getColor() {
+    return g_fc;
+}
+
+void setBackColor(uint8_t r, uint8_t g, uint8_t b) {
+    g_bc = RGB_TO_COLOR(r, g, b);
+	adjustColor(g_bc);
+}
+
+void setBackColor(uint16_t color, bool ignoreLuminocity) {
+	g_bc = getColor16FromIndex(color);
+	adjustColor(g_bc);
+}
+
+uint16_t getBackColor() {
+    return g_bc;
+}
+
+uint8_t setOpacity(uint8_t opacity) {
+    uint8_t savedOpacity = g_opacity;
+    g_opacity = opacity;
+    return savedOpacity;
+}
+
+uint8_t getOpacity() {
+    return g_opacity;
+}
+
+bool g_dirty;
+
+static const DirtyRect EMPTY_RECT = { 0, 0, -1, -1 };
+
+static inline bool isEmpty(const DirtyRect &rect) {
+    return rect.x1 > rect.x2 || rect.y1 > rect.y2;
+}
+
+static void unite(DirtyRect &rect, const DirtyRect &other) {
+    if (isEmpty(other)) {
+        return;
+    }
+    if (isEmpty(rect)) {
+        rect = other;
+        return;
+    }
+    rect.x1 = MIN(rect.x1, other.x1);
+    rect.y1 = MIN(rect.y1, other.y1);
+    rect.x2 = MAX(rect.x2, other.x2);
+    rect.y2 = MAX(rect.y2, other.y2);
+}
+
+static DirtyRect intersect(const DirtyRect &rect1, const DirtyRect &rect2) {
+    DirtyRect rect;
+    rect.x1 = MAX(rect1.x1, rect2.x1);
+    rect.y1 = MAX(rect1.y1, rect2.y1);
+    rect.x2 = MIN(rect1.x2, rect2.x2);
+    rect.y2 = MIN(rect1.y2, rect2.y2);
+    return rect;
+}
+
+static bool contains(const DirtyRect &outer, const DirtyRect &inner) {
+    return outer.x1 <= inner.x1 && outer.y1 <= inner.y1 && outer.x2 >= inner.x2 && outer.y2 >= inner.y2;
+}
+
+// changed outside of any buffer, in display coordinates
+static DirtyRect g_directDirtyRect = EMPTY_RECT;
+
+static int g_selectedBufferIndex = -1;
+
+static void markBufferDirty(Buffer &buffer, const DirtyRect &rect) {
+    buffer.version++;
+    unite(buffer.dirtyRect, rect);
+}
+
+void clearDirty() {
+    g_dirty = false;
+}
+
+void markDirty(int x1, int y1, int x2, int y2) {
+    g_dirty = true;
+
+    DirtyRect rect = { MIN(x1, x2), MIN(y1, y2), MAX(x1, x2), MAX(y1, y2) };
+    if (g_selectedBufferIndex != -1) {
+        markBufferDirty(g_buffers[g_selectedBufferIndex], rect);
+    } else {
+        unite(g_directDirtyRect, rect);
+    }
+}
+
+bool isDirty() {
+    return g_dirty;
+}
+
+static int8_t measureGlyph(uint8_t encoding) {
+    gui::font::Glyph glyph;
+    g_font.getGlyph(encoding, glyph);
+    if (!glyph)
+        return 0;
+
+    return glyph.dx;
+}
+
+int8_t measureGlyph(uint8_t encoding, gui::font::Font &font) {
+    gui::font::Glyph glyph;
+    font.getGlyph(encoding, glyph);
+    if (!glyph)
+        return 0;
+
+    return glyph.dx;
+}
+
+int measureStr(const char *text, int textLength, gui::font::Font &font, int max_width) {
+    g_font = font;
+
+    int width = 0;
+
+    if (textLength == -1) {
+        char encoding;
+        while ((encoding = *text++) != 0) {
+            int glyph_width = measureGlyph(encoding);
+            if (max_width > 0 && width + glyph_width > max_width) {
+                return max_width;
+            }
+            width += glyph_width;
+        }
+    } else {
+        for (int i = 0; i < textLength && text[i]; ++i) {
+            char encoding = text[i];
+            int glyph_width = measureGlyph(encoding);
+            if (max_width > 0 && width + glyph_width > max_width) {
+                return max_width;
+            }
+            width += glyph_width;
+        }
+    }
+
+    return width;
+}
+
+Buffer g_buffers[NUM_BUFFERS];
+
+static void *g_bufferPointer;
+
+static int g_bufferToDrawIndexes[NUM_BUFFERS];
+static int g_numBuffersToDraw;
+
+// draw list of the last composited frame
+static int g_composedBufferIndexes[NUM_BUFFERS];
+static int g_numComposedBuffers;
+
+// Display buffers are swapped after each composited frame, so display buffer
+// is missing everything that was composited into the other one since it was
+// composited last time.
+struct DisplayBuffer {
+    void *bufferPointer;
+    DirtyRect staleRect;
+};
+static const int NUM_DISPLAY_BUFFERS = 2;
+static DisplayBuffer g_displayBuffers[NUM_DISPLAY_BUFFERS];
+
+static bool g_wasOn;
+
+static CompositorStatistics g_compositorStatistics;
+
+// Set when all buffers are allocated and cleared when one is freed. Overlay
+// without a buffer calls allocBuffer on every frame, so the pool is searched
+// and failure is traced only once until something changes.
+static bool g_allBuffersAllocated;
+
+int allocBuffer() {
+    if (g_allBuffersAllocated) {
+        return -1;
+    }
+
+    for (int bufferIndex = 0; bufferIndex < NUM_BUFFERS; bufferIndex++) {
+        Buffer &buffer = g_buffers[bufferIndex];
+        if (!buffer.flags.allocated) {
+            buffer.flags.allocated = true;
+            buffer.boundsChanged = true;
+            buffer.dirtyRect = EMPTY_RECT;
+            return bufferIndex;
+        }
+    }
+
+    g_allBuffersAllocated = true;
+    g_compositorStatistics.numAllocFailures++;
+    DebugTrace("There is no free display buffer available!\n");
+    return -1;
+}
+
+void freeBuffer(int bufferIndex) {
+    if (bufferIndex != -1) {
+        g_buffers[bufferIndex].flags.allocated = false;
+        g_allBuffersAllocated = false;
+    }
+}
+
+void selectBuffer(int bufferIndex) {
+    if (bufferIndex == -1) {
+        // buffer was not allocated, draw into the current buffer
+        return;
+    }
+
+    g_buffers[bufferIndex].flags.used = true;
+
+    int i;
+    for (i = 0; i < g_numBuffersToDraw; i++) {
+        if (g_bufferToDrawIndexes[i] == bufferIndex) {
+            break;
+        }
+    }
+    if (i == g_numBuffersToDraw) {
+        g_bufferToDrawIndexes[g_numBuffersToDraw++] = bufferIndex;
+    }
+
+    g_selectedBufferIndex = bufferIndex;
+    setBufferPointer(g_buffers[bufferIndex].bufferPointer);
+}
+
+void setBufferBounds(int bufferIndex, int x, int y, int width, int height, bool withShadow, uint8_t opacity, int xOffset, int yOffset, Rect *backdrop) {
+    if (bufferIndex == -1) {
+        return;
+    }
+
+    Buffer &buffer = g_buffers[bufferIndex];
+    
+    if (buffer.x != x || buffer.y != y || buffer.width != width || buffer.height != height || buffer.withShadow != withShadow || buffer.opacity != opacity || buffer.xOffset != xOffset || buffer.yOffset != yOffset || backdrop != buffer.backdrop) {
+        buffer.x = x;
+        buffer.y = y;
+        buffer.width = width;
+        buffer.height = height;
+        buffer.withShadow = withShadow;
+        buffer.opacity = opacity;
+        buffer.xOffset = xOffset;
+        buffer.yOffset = yOffset;
+        buffer.backdrop = backdrop;
+        buffer.boundsChanged = true;
+
+        g_dirty = true;
+    }
+
+    for (int i = 0; i < g_numBuffersToDraw; i++) {
+        if (g_bufferToDrawIndexes[i] == bufferIndex) {
+            if (i > 0) {
+                g_selectedBufferIndex = g_bufferToDrawIndexes[i - 1];
+                setBufferPointer(g_buffers[g_selectedBufferIndex].bufferPointer);
+            }
+            break;
+        }
+    }
+}
+
+void clearBufferUsage() {
+    for (int bufferIndex = 0; bufferIndex < NUM_BUFFERS; bufferIndex++) {
+        g_buffers[bufferIndex].flags.used = false;
+    }
+}
+
+void freeUnusedBuffers() {
+    for (int bufferIndex = 0; bufferIndex < NUM_BUFFERS; bufferIndex++) {
+        if (g_buffers[bufferIndex].flags.allocated && !g_buffers[bufferIndex].flags.used) {
+            g_buffers[bufferIndex].flags.allocated = false;
+            g_allBuffersAllocated = false;
+            // DebugTrace("Buffer %d allocated but not used!\n", bufferIndex);
+        }
+    }
+    
+    clearBufferUsage();
+}
+
+void beginBuffersDrawing() {
+    g_bufferPointer = getBufferPointer();
+    g_selectedBufferIndex = -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static DirtyRect getScreenRect(const Buffer &buffer) {
+    int x1 = buffer.x + buffer.xOffset;
+    int y1 = buffer.y + buffer.yOffset;
+    DirtyRect rect = { x1, y1, x1 + buffer.width - 1, y1 + buffer.height - 1 };
+    return rect;
+}
+
+static DirtyRect getShadowRect(const Buffer &buffer) {
+    DirtyRect rect = getScreenRect(buffer);
+    if (buffer.withShadow) {
+        expandRectWithShadow(rect.x1, rect.y1, rect.x2, rect.y2);
+    }
+    return rect;
+}
+
+// display area changed by compositing this buffer
+static DirtyRect getFootprint(const Buffer &buffer) {
+    DirtyRect rect = getShadowRect(buffer);
+    if (buffer.backdrop) {
+        DirtyRect backdropRect = {
+            buffer.backdrop->x,
+            buffer.backdrop->y,
+            buffer.backdrop->x + buffer.backdrop->w - 1,
+            buffer.backdrop->y + buffer.backdrop->h - 1
+        };
+        unite(rect, backdropRect);
+    }
+    return rect;
+}
+
+static bool isInList(int bufferIndex, const int *bufferIndexes, int numBuffers) {
+    for (int i = 0; i < numBuffers; i++) {
+        if (bufferIndexes[i] == bufferIndex) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// union of everything changed since the last composited frame
+static DirtyRect getChangedRect(Buffer *buffers, const int *bufferIndexes, int numBuffers, const int *composedBufferIndexes, int numComposedBuffers) {
+    DirtyRect rect = EMPTY_RECT;
+
+    // removed buffers
+    for (int i = 0; i < numComposedBuffers; i++) {
+        Buffer &buffer = buffers[composedBufferIndexes[i]];
+        if (buffer.flags.composed && !isInList(composedBufferIndexes[i], bufferIndexes, numBuffers)) {
+            unite(rect, buffer.composedRect);
+        }
+    }
+
+    // from the first buffer in different order all buffers are changed
+    int numSame = 0;
+    while (numSame < numBuffers && numSame < numComposedBuffers && bufferIndexes[numSame] == composedBufferIndexes[numSame]) {
+        numSame++;
+    }
+
+    for (int i = 0; i < numBuffers; i++) {
+        Buffer &buffer = buffers[bufferIndexes[i]];
+        if (i >= numSame || !buffer.flags.composed || buffer.boundsChanged) {
+            unite(rect, getFootprint(buffer));
+            if (buffer.flags.composed) {
+                unite(rect, buffer.composedRect);
+            }
+        } else if (buffer.version != buffer.composedVersion && !isEmpty(buffer.dirtyRect)) {
+            DirtyRect dirtyRect = {
+                buffer.dirtyRect.x1 + buffer.xOffset,
+                buffer.dirtyRect.y1 + buffer.yOffset,
+                buffer.dirtyRect.x2 + buffer.xOffset,
+                buffer.dirtyRect.y2 + buffer.yOffset
+            };
+            unite(rect, intersect(dirtyRect, getScreenRect(buffer)));
+        }
+    }
+
+    return rect;
+}
+
+// Shadow is blended over what is below, so it can't be partially redrawn.
+// It is not redrawn at all if rect is inside of the opaque buffer.
+static bool isShadowRedrawn(const DirtyRect &rect, const Buffer &buffer) {
+    return buffer.withShadow &&
+        !isEmpty(intersect(rect, getShadowRect(buffer))) &&
+        !(buffer.opacity == 255 && contains(getScreenRect(buffer), rect));
+}
+
+static void expandWithShadows(DirtyRect &rect, Buffer *buffers, const int *bufferIndexes, int numBuffers) {
+    bool expanded;
+    do {
+        expanded = false;
+        for (int i = 0; i < numBuffers; i++) {
+            Buffer &buffer = buffers[bufferIndexes[i]];
+            if (isShadowRedrawn(rect, buffer)) {
+                DirtyRect shadowRect = getShadowRect(buffer);
+                if (!contains(rect, shadowRect)) {
+                    unite(rect, shadowRect);
+                    expanded = true;
+                }
+            }
+        }
+    } while (expanded);
+}
+
+static bool isCoveredByOpaqueBuffer(const DirtyRect &rect, Buffer *buffers, const int *bufferIndexes, int numBuffers, int i) {
+    for (int j = i + 1; j < numBuffers; j++) {
+        Buffer &buffer = buffers[bufferIndexes[j]];
+        if (buffer.opacity == 255 && contains(getScreenRect(buffer), rect)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+// what compositor would draw, see testLayers
+struct DrawRecord {
+    uint32_t numFills;
+    uint32_t numShadows;
+    uint32_t numBlits;
+    uint32_t numPixelsBlitted;
+};
+
+// if set, compositor draw calls are recorded instead of executed
+static DrawRecord *g_drawRecord;
+#endif
+
+static void compositeFillRect(const DirtyRect &rect) {
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    if (g_drawRecord) {
+        g_drawRecord->numFills++;
+        return;
+    }
+#endif
+    fillRect(rect.x1, rect.y1, rect.x2, rect.y2);
+}
+
+static void compositeShadow(const DirtyRect &rect) {
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    if (g_drawRecord) {
+        g_drawRecord->numShadows++;
+        return;
+    }
+#endif
+    drawShadow(rect.x1, rect.y1, rect.x2, rect.y2);
+}
+
+static void compositeBitBlt(const Buffer &buffer, int sx, int sy, const DirtyRect &rect) {
+    int width = rect.x2 - rect.x1 + 1;
+    int height = rect.y2 - rect.y1 + 1;
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    if (g_drawRecord) {
+        g_drawRecord->numBlits++;
+        g_drawRecord->numPixelsBlitted += width * height;
+        return;
+    }
+#endif
+    bitBlt(buffer.bufferPointer, nullptr, sx, sy, width, height, rect.x1, rect.y1, buffer.opacity);
+}
+
+// composites buffers inside rect and marks buffers as composited
+static void composite(DirtyRect rect, Buffer *buffers, const int *bufferIndexes, int numBuffers, CompositorStatistics &statistics) {
+    expandWithShadows(rect, buffers, bufferIndexes, numBuffers);
+
+    statistics.rect = rect;
+    statistics.numLayers = numBuffers;
+    statistics.numLayersComposited = 0;
+    statistics.numLayersSkipped = 0;
+    statistics.numPixelsMoved = 0;
+
+    for (int i = 0; i < numBuffers; i++) {
+        Buffer &buffer = buffers[bufferIndexes[i]];
+
+        DirtyRect footprint = getFootprint(buffer);
+
+        buffer.flags.composed = true;
+        buffer.composedRect = footprint;
+        buffer.composedVersion = buffer.version;
+        buffer.boundsChanged = false;
+        buffer.dirtyRect = EMPTY_RECT;
+
+        footprint = intersect(footprint, rect);
+        if (isEmpty(footprint) || isCoveredByOpaqueBuffer(footprint, buffers, bufferIndexes, numBuffers, i)) {
+            statistics.numLayersSkipped++;
+            continue;
+        }
+
+        DirtyRect screenRect = getScreenRect(buffer);
+
+        if (buffer.backdrop) {
+            DirtyRect backdropRect = {
+                buffer.backdrop->x,
+                buffer.backdrop->y,
+                buffer.backdrop->x + buffer.backdrop->w - 1,
+                buffer.backdrop->y + buffer.backdrop->h - 1
+            };
+            backdropRect = intersect(backdropRect, rect);
+            if (!isEmpty(backdropRect)) {
+                auto savedOpacity = setOpacity(CONF_BACKDROP_OPACITY);
+                setColor(COLOR_ID_BACKDROP);
+                compositeFillRect(backdropRect);
+                setOpacity(savedOpacity);
+            }
+        }
+
+        if (isShadowRedrawn(rect, buffer)) {
+            // rect contains the whole shadow, see expandWithShadows
+            compositeShadow(screenRect);
+        }
+
+        DirtyRect blitRect = intersect(screenRect, rect);
+        if (!isEmpty(blitRect)) {
+            int sx = buffer.x + blitRect.x1 - screenRect.x1;
+            int sy = buffer.y + blitRect.y1 - screenRect.y1;
+            compositeBitBlt(buffer, sx, sy, blitRect);
+            statistics.numPixelsMoved += (blitRect.x2 - blitRect.x1 + 1) * (blitRect.y2 - blitRect.y1 + 1);
+        }
+
+        statistics.numLayersComposited++;
+    }
+
+    statistics.numFrames++;
+}
+
+static DisplayBuffer &getDisplayBuffer(void *bufferPointer) {
+    for (int i = 0; i < NUM_DISPLAY_BUFFERS; i++) {
+        if (g_displayBuffers[i].bufferPointer == bufferPointer) {
+            return g_displayBuffers[i];
+        }
+    }
+
+    // not seen before, everything must be composited
+    DisplayBuffer &displayBuffer = g_displayBuffers[g_displayBuffers[0].bufferPointer ? 1 : 0];
+    displayBuffer.bufferPointer = bufferPointer;
+    displayBuffer.staleRect.x1 = 0;
+    displayBuffer.staleRect.y1 = 0;
+    displayBuffer.staleRect.x2 = getDisplayWidth() - 1;
+    displayBuffer.staleRect.y2 = getDisplayHeight() - 1;
+    return displayBuffer;
+}
+
+void endBuffersDrawing() {
+    setBufferPointer(g_bufferPointer);
+    g_selectedBufferIndex = -1;
+
+    DirtyRect changedRect = getChangedRect(g_buffers, g_bufferToDrawIndexes, g_numBuffersToDraw, g_composedBufferIndexes, g_numComposedBuffers);
+    unite(changedRect, g_directDirtyRect);
+    if (!isEmpty(changedRect)) {
+        g_dirty = true;
+    }
+
+    if (isDirty()) {
+        DirtyRect fullRect = { 0, 0, getDisplayWidth() - 1, getDisplayHeight() - 1 };
+
+        if (g_animationState.enabled || !g_wasOn) {
+            // display buffers are changed outside of compositor
+            for (int i = 0; i < NUM_DISPLAY_BUFFERS; i++) {
+                g_displayBuffers[i].staleRect = fullRect;
+            }
+        }
+
+        DisplayBuffer &displayBuffer = getDisplayBuffer(g_bufferPointer);
+
+        DirtyRect rect = changedRect;
+        unite(rect, displayBuffer.staleRect);
+        rect = intersect(rect, fullRect);
+
+        // buffers that are not drawn anymore
+        for (int i = 0; i < g_numComposedBuffers; i++) {
+            if (!isInList(g_composedBufferIndexes[i], g_bufferToDrawIndexes, g_numBuffersToDraw)) {
+                g_buffers[g_composedBufferIndexes[i]].flags.composed = false;
+            }
+        }
+
+        composite(rect, g_buffers, g_bufferToDrawIndexes, g_numBuffersToDraw, g_compositorStatistics);
+        if (contains(g_compositorStatistics.rect, fullRect)) {
+            g_compositorStatistics.numFullFrames++;
+        }
+
+        for (int i = 0; i < NUM_DISPLAY_BUFFERS; i++) {
+            if (&g_displayBuffers[i] == &displayBuffer) {
+                g_displayBuffers[i].staleRect = EMPTY_RECT;
+            } else {
+                unite(g_displayBuffers[i].staleRect, changedRect);
+            }
+        }
+
+        for (int i = 0; i < g_numBuffersToDraw; i++) {
+            g_composedBufferIndexes[i] = g_bufferToDrawIndexes[i];
+        }
+        g_numComposedBuffers = g_numBuffersToDraw;
+
+        // compositor itself draws into the display buffer
+        g_directDirtyRect = EMPTY_RECT;
+    }
+
+    g_wasOn = isOn();
+
+    g_numBuffersToDraw = 0;
+
+    freeUnusedBuffers();
+}
+
+void getCompositorStatistics(CompositorStatistics &statistics) {
+    statistics = g_compositorStatistics;
+}
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+
+enum { TEST_PAGE, TEST_POPUP1, TEST_POPUP2, NUM_TEST_LAYERS };
+
+struct TestLayer {
+    int x;
+    int y;
+    int width;
+    int height;
+    bool withShadow;
+};
+
+struct TestFrame {
+    const char *description;
+    int numLayers; // drawn in TEST_PAGE, TEST_POPUP1, TEST_POPUP2 order
+    uint8_t popup1Opacity;
+    bool popup1Backdrop;
+    int dirtyLayer; // -1 if nothing is drawn
+    DirtyRect dirtyRect;
+    DrawRecord expected;
+};
+
+static volatile bool g_testLayersRunning;
+static bool g_testLayersPassed;
+static char g_testLayersMessage[96];
+
+bool testLayers(char *message, int messageSize) {
+    g_testLayersRunning = true;
+    osMessagePut(gui::g_guiMessageQueueId, GUI_QUEUE_MESSAGE(GUI_QUEUE_MESSAGE_TYPE_TEST_LAYERS, 0), osWaitForever);
+    while (g_testLayersRunning) {
+        delayWithoutIoLock(1);
+    }
+
+    if (!g_testLayersPassed) {
+        snprintf(message, messageSize, "%s", g_testLayersMessage);
+    }
+    return g_testLayersPassed;
+}
+
+void doTestLayers() {
+    // popup 1 with shadow is 214 x 114, popup 2 is inside of popup 1
+    static const TestLayer layers[NUM_TEST_LAYERS] = {
+        { 0, 0, 480, 272, false },
+        { 100, 50, 200, 100, true },
+        { 150, 80, 80, 40, false }
+    };
+
+    // expected fills, shadows, blits and pixels blitted,
+    // translucent popup is composited together with its shadow
+    static const TestFrame frames[] = {
+        { "page shown", 1, 255, false, -1, EMPTY_RECT, { 0, 0, 1, 480 * 272 } },
+        { "nothing changed", 1, 255, false, -1, EMPTY_RECT, { 0, 0, 0, 0 } },
+        { "popup 1 opened", 2, 255, false, -1, EMPTY_RECT, { 0, 1, 2, 214 * 114 + 200 * 100 } },
+        { "popup 2 opened", 3, 255, false, -1, EMPTY_RECT, { 0, 0, 1, 80 * 40 } },
+        { "page changed outside of popups", 3, 255, false, TEST_PAGE, { 0, 0, 9, 9 }, { 0, 0, 1, 10 * 10 } },
+        { "page changed under popup 2", 3, 255, false, TEST_PAGE, { 160, 90, 169, 99 }, { 0, 0, 1, 10 * 10 } },
+        { "popup 2 closed", 2, 255, false, -1, EMPTY_RECT, { 0, 0, 1, 80 * 40 } },
+        { "popup 1 changed", 2, 255, false, TEST_POPUP1, { 110, 60, 119, 69 }, { 0, 0, 1, 10 * 10 } },
+        { "popup 1 opacity changed", 2, 128, false, -1, EMPTY_RECT, { 0, 1, 2, 214 * 114 + 200 * 100 } },
+        { "translucent popup 1 changed", 2, 128, false, TEST_POPUP1, { 110, 60, 119, 69 }, { 0, 1, 2, 214 * 114 + 200 * 100 } },
+        { "popup 1 backdrop added", 2, 128, true, -1, EMPTY_RECT, { 1, 1, 2, 480 * 272 + 200 * 100 } }
+    };
+
+    // save compositor state of the GUI, nothing is drawn so it is
+    // still valid when restored
+    static Buffer savedBuffers[NUM_BUFFERS];
+    memcpy(savedBuffers, g_buffers, sizeof(g_buffers));
+    int savedComposedBufferIndexes[NUM_BUFFERS];
+    memcpy(savedComposedBufferIndexes, g_composedBufferIndexes, sizeof(g_composedBufferIndexes));
+    int savedNumComposedBuffers = g_numComposedBuffers;
+    DisplayBuffer savedDisplayBuffers[NUM_DISPLAY_BUFFERS];
+    memcpy(savedDisplayBuffers, g_displayBuffers, sizeof(g_displayBuffers));
+    bool savedWasOn = g_wasOn;
+    CompositorStatistics savedCompositorStatistics = g_compositorStatistics;
+    bool savedAllBuffersAllocated = g_allBuffersAllocated;
+    bool savedDirty = g_dirty;
+    DirtyRect savedDirectDirtyRect = g_directDirtyRect;
+    bool savedAnimationEnabled = g_animationState.enabled;
+
+    for (int i = 0; i < NUM_BUFFERS; i++) {
+        void *bufferPointer = g_buffers[i].bufferPointer;
+        memset(&g_buffers[i], 0, sizeof(Buffer));
+        g_buffers[i].bufferPointer = bufferPointer;
+    }
+    g_numComposedBuffers = 0;
+    memset(g_displayBuffers, 0, sizeof(g_displayBuffers));
+    g_wasOn = true;
+    g_allBuffersAllocated = false;
+    g_directDirtyRect = EMPTY_RECT;
+    g_animationState.enabled = false;
+
+    DrawRecord record;
+    g_drawRecord = &record;
+
+    Rect backdrop = { 0, 0, (int16_t)getDisplayWidth(), (int16_t)getDisplayHeight() };
+    int bufferIndexes[NUM_TEST_LAYERS] = { -1, -1, -1 };
+
+    const char *error = nullptr;
+
+    for (unsigned i = 0; i < sizeof(frames) / sizeof(TestFrame) && !error; i++) {
+        const TestFrame &frame = frames[i];
+
+        memset(&record, 0, sizeof(record));
+        clearDirty();
+
+        beginBuffersDrawing();
+
+        for (int layer = 0; layer < frame.numLayers; layer++) {
+            // as overlay of the container widget: allocated when shown,
+            // freed by endBuffersDrawing when not selected anymore
+            if (bufferIndexes[layer] == -1) {
+                bufferIndexes[layer] = allocBuffer();
+            }
+
+            selectBuffer(bufferIndexes[layer]);
+
+            if (layer == frame.dirtyLayer) {
+                markDirty(frame.dirtyRect.x1, frame.dirtyRect.y1, frame.dirtyRect.x2, frame.dirtyRect.y2);
+            }
+
+            const TestLayer &testLayer = layers[layer];
+            bool isPopup1 = layer == TEST_POPUP1;
+            setBufferBounds(bufferIndexes[layer], testLayer.x, testLayer.y, testLayer.width, testLayer.height, testLayer.withShadow,
+                isPopup1 ? frame.popup1Opacity : 255, 0, 0, isPopup1 && frame.popup1Backdrop ? &backdrop : nullptr);
+        }
+
+        for (int layer = frame.numLayers; layer < NUM_TEST_LAYERS; layer++) {
+            bufferIndexes[layer] = -1;
+        }
+
+        endBuffersDrawing();
+
+        if (record.numFills != frame.expected.numFills ||
+            record.numShadows != frame.expected.numShadows ||
+            record.numBlits != frame.expected.numBlits ||
+            record.numPixelsBlitted != frame.expected.numPixelsBlitted
+        ) {
+            error = frame.description;
+        }
+    }
+
+    g_drawRecord = nullptr;
+
+    memcpy(g_buffers, savedBuffers, sizeof(g_buffers));
+    memcpy(g_composedBufferIndexes, savedComposedBufferIndexes, sizeof(g_composedBufferIndexes));
+    g_numComposedBuffers = savedNumComposedBuffers;
+    memcpy(g_displayBuffers, savedDisplayBuffers, sizeof(g_displayBuffers));
+    g_wasOn = savedWasOn;
+    g_compositorStatistics = savedCompositorStatistics;
+    g_allBuffersAllocated = savedAllBuffersAllocated;
+    g_dirty = savedDirty;
+    g_directDirtyRect = savedDirectDirtyRect;
+    g_animationState.enabled = savedAnimationEnabled;
+
+    g_testLayersPassed = !error;
+    if (error) {
+        snprintf(g_testLayersMessage, sizeof(g_testLayersMessage), "%s: fills=%u shadows=%u blits=%u pixels=%u", error,
+            (unsigned)record.numFills, (unsigned)record.numShadows, (unsigned)record.numBlits, (unsigned)record.numPixelsBlitted);
+    }
+    g_testLayersRunning = false;
+}
+
+#endif
+
+} // namespace display
+} // namespace mcu
+} // namespace eez
+
+#endif
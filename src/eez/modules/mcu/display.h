@@ -85,11 +85,15 @@ uint8_t getOpacity();
 const uint8_t * takeScreenshot();
 
 void clearDirty();
-// void markDirty(int x1, int y1, int x2, int y2);
+// marks rectangle in the selected buffer, or in the display buffer, as changed
+void markDirty(int x1, int y1, int x2, int y2);
 extern bool g_dirty;
-#define markDirty(x1, y1, x2, y2) g_dirty = true
 bool isDirty();
 
+// Pixels are written directly to the buffer, without waiting for pending
+// DMA2D commands, so call beginPixelDrawing once for the primitive's bounding
+// rectangle before drawing it pixel by pixel.
+void beginPixelDrawing(int x1, int y1, int x2, int y2);
 void drawPixel(int x, int y);
 void drawPixel(int x, int y, uint8_t opacity);
 void drawRect(int x1, int y1, int x2, int y2);
@@ -102,6 +106,17 @@ void bitBlt(void *src, int x1, int y1, int x2, int y2);
 void bitBlt(void *src, void *dst, int x1, int y1, int x2, int y2);
 void bitBlt(void *src, void *dst, int sx, int sy, int sw, int sh, int dx, int dy, uint8_t opacity);
 void drawBitmap(Image *image, int x, int y);
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+struct CompositorBenchmarkResult {
+    uint32_t referenceTime; // us, pixel by pixel compositor
+    uint32_t time; // us, row based compositor
+    bool sse2;
+};
+
+// composites full screen page with numOverlays translucent overlays on top
+bool benchmarkCompositor(int numFrames, int numOverlays, CompositorBenchmarkResult &result);
+#endif
 void drawStr(const char *text, int textLength, int x, int y, int clip_x1, int clip_y1, int clip_x2,
              int clip_y2, gui::font::Font &font);
 int8_t measureGlyph(uint8_t encoding, gui::font::Font &font);
@@ -111,6 +126,15 @@ static const int NUM_BUFFERS = 8;
 struct BufferFlags {
     unsigned allocated : 1;
     unsigned used : 1;
+    unsigned composed : 1;
+};
+
+// inclusive, empty if x1 > x2 or y1 > y2
+struct DirtyRect {
+    int x1;
+    int y1;
+    int x2;
+    int y2;
 };
 
 struct Buffer {
@@ -125,9 +149,44 @@ struct Buffer {
     int xOffset;
     int yOffset;
     gui::Rect *backdrop;
+
+    // incremented on every drawing into the buffer
+    uint32_t version;
+    uint32_t composedVersion;
+    bool boundsChanged;
+    // changed since last composited, in buffer coordinates
+    DirtyRect dirtyRect;
+    // display area covered when last composited, including shadow and backdrop
+    DirtyRect composedRect;
 };
 extern Buffer g_buffers[NUM_BUFFERS];
 
+struct CompositorStatistics {
+    uint32_t numFrames;
+    uint32_t numFullFrames; // whole display composited
+    uint32_t numAllocFailures; // counted once until a buffer is freed
+
+    // last composited frame
+    DirtyRect rect;
+    uint32_t numLayers;
+    uint32_t numLayersComposited;
+    uint32_t numLayersSkipped; // outside of the rect or covered by opaque layer above
+    uint32_t numPixelsMoved;
+};
+
+void getCompositorStatistics(CompositorStatistics &statistics);
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+// Runs doTestLayers in the GUI thread and waits for it. Returns false and
+// description of the first failed check.
+bool testLayers(char *message, int messageSize);
+// Draws frames with nested popups through beginBuffersDrawing and
+// endBuffersDrawing, with compositor draw calls recorded instead of executed,
+// and checks what would be drawn. GUI compositor state is restored afterwards.
+void doTestLayers();
+#endif
+
+// returns -1 if all buffers are allocated
 int allocBuffer();
 void freeBuffer(int bufferIndex);
 void selectBuffer(int bufferIndex);
@@ -0,0 +1,616 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2020-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(EEZ_PLATFORM_STM32)
+#include <dma2d.h>
+#endif
+
+#include <eez/modules/mcu/dma2d_queue.h>
+
+namespace eez {
+namespace mcu {
+namespace dma2d_queue {
+
+static const uint32_t QUEUE_SIZE = 64;
+
+struct Entry {
+    Command command;
+    // memory ranges accessed by the command, used by fence
+    const uint8_t *dstStart;
+    const uint8_t *dstEnd;
+    const uint8_t *srcStart;
+    const uint8_t *srcEnd;
+};
+
+static Entry g_queue[QUEUE_SIZE];
+
+// g_head is changed only by enqueue, g_tail only by completed command,
+// g_tail points to the running command
+static volatile uint32_t g_head;
+static volatile uint32_t g_tail;
+
+static Statistics g_statistics;
+
+////////////////////////////////////////////////////////////////////////////////
+
+static int getBytesPerPixel(uint8_t colorMode) {
+    if (colorMode == COLOR_MODE_ARGB8888) {
+        return 4;
+    }
+    if (colorMode == COLOR_MODE_RGB888) {
+        return 3;
+    }
+    if (colorMode == COLOR_MODE_RGB565) {
+        return 2;
+    }
+    return 1;
+}
+
+static const uint8_t *getEnd(const void *start, uint16_t width, uint16_t height, uint16_t offset, int bytesPerPixel) {
+    if (width == 0 || height == 0) {
+        return (const uint8_t *)start;
+    }
+    return (const uint8_t *)start + ((height - 1) * (width + offset) + width) * bytesPerPixel;
+}
+
+static bool overlaps(const uint8_t *start1, const uint8_t *end1, const uint8_t *start2, const uint8_t *end2) {
+    return start1 < end2 && start2 < end1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined(EEZ_PLATFORM_STM32)
+
+static volatile bool g_running;
+
+static Config g_config;
+static bool g_configValid;
+
+static bool isSameConfig(const Config &a, const Config &b) {
+    return a.mode == b.mode &&
+        a.outputColorMode == b.outputColorMode &&
+        a.redBlueSwap == b.redBlueSwap &&
+        a.fg.colorMode == b.fg.colorMode &&
+        a.fg.alphaMode == b.fg.alphaMode &&
+        a.fg.alpha == b.fg.alpha &&
+        (a.mode != MODE_BLEND || (
+            a.bg.colorMode == b.bg.colorMode &&
+            a.bg.alphaMode == b.bg.alphaMode &&
+            a.bg.alpha == b.bg.alpha
+        ));
+}
+
+static const uint32_t HAL_MODE[] = { DMA2D_R2M, DMA2D_M2M, DMA2D_M2M_PFC, DMA2D_M2M_BLEND };
+static const uint32_t HAL_OUTPUT_COLOR_MODE[] = { DMA2D_OUTPUT_ARGB8888, DMA2D_OUTPUT_RGB888, DMA2D_OUTPUT_RGB565 };
+static const uint32_t HAL_INPUT_COLOR_MODE[] = { DMA2D_INPUT_ARGB8888, DMA2D_INPUT_RGB888, DMA2D_INPUT_RGB565, DMA2D_INPUT_A8 };
+static const uint32_t HAL_ALPHA_MODE[] = { DMA2D_NO_MODIF_ALPHA, DMA2D_REPLACE_ALPHA, DMA2D_COMBINE_ALPHA };
+
+static void configLayer(uint32_t layerIndex, const LayerConfig &layerConfig, uint16_t offset) {
+    hdma2d.LayerCfg[layerIndex].InputOffset = offset;
+    hdma2d.LayerCfg[layerIndex].InputColorMode = HAL_INPUT_COLOR_MODE[layerConfig.colorMode];
+    hdma2d.LayerCfg[layerIndex].AlphaMode = HAL_ALPHA_MODE[layerConfig.alphaMode];
+    hdma2d.LayerCfg[layerIndex].InputAlpha = layerConfig.alpha;
+    HAL_DMA2D_ConfigLayer(&hdma2d, layerIndex);
+}
+
+static void configure(const Command &command) {
+    const Config &config = command.config;
+
+    hdma2d.Init.Mode = HAL_MODE[config.mode];
+    hdma2d.Init.ColorMode = HAL_OUTPUT_COLOR_MODE[config.outputColorMode];
+    hdma2d.Init.OutputOffset = command.outputOffset;
+    hdma2d.Init.RedBlueSwap = config.redBlueSwap ? DMA2D_RB_SWAP : DMA2D_RB_REGULAR;
+    HAL_DMA2D_Init(&hdma2d);
+
+    if (config.mode != MODE_FILL) {
+        configLayer(1, config.fg, command.fgOffset);
+        if (config.mode == MODE_BLEND) {
+            configLayer(0, config.bg, command.bgOffset);
+        }
+    }
+}
+
+static bool startCommand(const Command &command) {
+    if (g_configValid && isSameConfig(command.config, g_config)) {
+        g_statistics.numConfigSkipped++;
+    } else {
+        configure(command);
+        g_config = command.config;
+        g_configValid = true;
+    }
+
+    // offsets are not part of the config
+    WRITE_REG(hdma2d.Instance->OOR, command.outputOffset);
+    WRITE_REG(hdma2d.Instance->FGOR, command.fgOffset);
+    WRITE_REG(hdma2d.Instance->BGOR, command.bgOffset);
+
+    HAL_StatusTypeDef status;
+    if (command.config.mode == MODE_FILL) {
+        status = HAL_DMA2D_Start_IT(&hdma2d, command.color, (uint32_t)command.dst, command.width, command.height);
+    } else if (command.config.mode == MODE_BLEND) {
+        status = HAL_DMA2D_BlendingStart_IT(&hdma2d, (uint32_t)command.src, (uint32_t)command.dst, (uint32_t)command.dst, command.width, command.height);
+    } else {
+        status = HAL_DMA2D_Start_IT(&hdma2d, (uint32_t)command.src, (uint32_t)command.dst, command.width, command.height);
+    }
+
+    return status == HAL_OK;
+}
+
+// called from interrupt, or from enqueue with DMA2D interrupt disabled
+static void startNext() {
+    while (g_tail != g_head) {
+        if (startCommand(g_queue[g_tail % QUEUE_SIZE].command)) {
+            g_running = true;
+            return;
+        }
+        g_statistics.numErrors++;
+        g_configValid = false;
+        g_tail = g_tail + 1;
+    }
+    g_running = false;
+}
+
+extern "C" void DMA2D_IRQHandler(void) {
+    HAL_DMA2D_IRQHandler(&hdma2d);
+
+    if (!g_running || hdma2d.State == HAL_DMA2D_STATE_BUSY) {
+        return;
+    }
+
+    if (hdma2d.State == HAL_DMA2D_STATE_ERROR) {
+        // transfer or configuration error, skip the command
+        __HAL_DMA2D_DISABLE_IT(&hdma2d, DMA2D_IT_TC | DMA2D_IT_TE | DMA2D_IT_CE);
+        hdma2d.ErrorCode = HAL_DMA2D_ERROR_NONE;
+        hdma2d.State = HAL_DMA2D_STATE_READY;
+        g_statistics.numErrors++;
+        g_configValid = false;
+    }
+
+    g_tail = g_tail + 1;
+    startNext();
+}
+
+void init() {
+    // registers are not trusted after clock was disabled
+    g_configValid = false;
+
+    HAL_NVIC_SetPriority(DMA2D_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(DMA2D_IRQn);
+}
+
+static void push() {
+    // Only DMA2D interrupt is masked, not all interrupts with taskENTER_CRITICAL,
+    // because display can be turned on before scheduler is started.
+    HAL_NVIC_DisableIRQ(DMA2D_IRQn);
+    g_head = g_head + 1;
+    if (!g_running) {
+        startNext();
+    }
+    HAL_NVIC_EnableIRQ(DMA2D_IRQn);
+}
+
+static void waitUntilDone(uint32_t index) {
+    while ((int32_t)(g_tail - index) < 0) {
+    }
+}
+
+#endif // EEZ_PLATFORM_STM32
+
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+
+static uint32_t readPixel(uint8_t colorMode, const uint8_t *p, uint32_t color) {
+    if (colorMode == COLOR_MODE_ARGB8888) {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    if (colorMode == COLOR_MODE_RGB888) {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | 0xFF000000;
+    }
+
+    if (colorMode == COLOR_MODE_RGB565) {
+        uint16_t c = p[0] | (p[1] << 8);
+        uint32_t r = (c >> 11) & 0x1F;
+        uint32_t g = (c >> 5) & 0x3F;
+        uint32_t b = c & 0x1F;
+        // MSB bits are replicated to LSB bits, same as DMA2D
+        r = (r << 3) | (r >> 2);
+        g = (g << 2) | (g >> 4);
+        b = (b << 3) | (b >> 2);
+        return b | (g << 8) | (r << 16) | 0xFF000000;
+    }
+
+    // A8: color from the layer config, alpha from memory
+    return (color & 0x00FFFFFF) | ((uint32_t)p[0] << 24);
+}
+
+static void writePixel(uint8_t colorMode, uint8_t *p, uint32_t argb, bool redBlueSwap) {
+    uint32_t a = argb >> 24;
+    uint32_t r = (argb >> 16) & 0xFF;
+    uint32_t g = (argb >> 8) & 0xFF;
+    uint32_t b = argb & 0xFF;
+
+    if (redBlueSwap) {
+        uint32_t temp = r;
+        r = b;
+        b = temp;
+    }
+
+    if (colorMode == COLOR_MODE_ARGB8888) {
+        p[0] = b;
+        p[1] = g;
+        p[2] = r;
+        p[3] = a;
+    } else if (colorMode == COLOR_MODE_RGB888) {
+        p[0] = b;
+        p[1] = g;
+        p[2] = r;
+    } else {
+        uint16_t c = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+        p[0] = c & 0xFF;
+        p[1] = c >> 8;
+    }
+}
+
+static uint32_t modifyAlpha(uint32_t argb, const LayerConfig &layerConfig) {
+    if (layerConfig.alphaMode == ALPHA_MODE_NO_MODIF) {
+        return argb;
+    }
+
+    // for A8 constant alpha is in the upper byte of the color
+    uint32_t alpha = layerConfig.colorMode == COLOR_MODE_A8 ? layerConfig.alpha >> 24 : layerConfig.alpha & 0xFF;
+    if (layerConfig.alphaMode == ALPHA_MODE_COMBINE) {
+        alpha = (argb >> 24) * alpha / 255;
+    }
+
+    return (argb & 0x00FFFFFF) | (alpha << 24);
+}
+
+// DMA2D blender: a = af + ab - af * ab, c = (cf * af + cb * ab - cb * af * ab) / a
+static uint32_t blend(uint32_t fg, uint32_t bg) {
+    uint32_t af = fg >> 24;
+    uint32_t ab = bg >> 24;
+    uint32_t afab = af * ab / 255;
+    uint32_t a = af + ab - afab;
+    if (a == 0) {
+        return 0;
+    }
+
+    uint32_t result = a << 24;
+    for (int shift = 0; shift < 24; shift += 8) {
+        uint32_t cf = (fg >> shift) & 0xFF;
+        uint32_t cb = (bg >> shift) & 0xFF;
+        result |= ((cf * af + cb * ab - cb * afab) / a) << shift;
+    }
+    return result;
+}
+
+static void execute(const Command &command) {
+    const Config &config = command.config;
+
+    int outputBpp = getBytesPerPixel(config.outputColorMode);
+    int fgBpp = getBytesPerPixel(config.fg.colorMode);
+    int bgBpp = getBytesPerPixel(config.bg.colorMode);
+
+    uint8_t *dst = (uint8_t *)command.dst;
+    const uint8_t *src = (const uint8_t *)command.src;
+
+    for (int y = 0; y < command.height; y++) {
+        uint8_t *dstRow = dst + y * (command.width + command.outputOffset) * outputBpp;
+        const uint8_t *srcRow = src + y * (command.width + command.fgOffset) * fgBpp;
+        const uint8_t *bgRow = dst + y * (command.width + command.bgOffset) * bgBpp;
+
+        if (config.mode == MODE_COPY) {
+            memmove(dstRow, srcRow, command.width * outputBpp);
+            continue;
+        }
+
+        // simulator display is ARGB8888, fills are most of its commands
+        if (config.mode == MODE_FILL && config.outputColorMode == COLOR_MODE_ARGB8888 && !config.redBlueSwap) {
+            uint32_t *dst32 = (uint32_t *)dstRow;
+            for (int x = 0; x < command.width; x++) {
+                dst32[x] = command.color;
+            }
+            continue;
+        }
+
+        for (int x = 0; x < command.width; x++) {
+            uint32_t argb;
+            if (config.mode == MODE_FILL) {
+                argb = command.color;
+            } else {
+                argb = modifyAlpha(readPixel(config.fg.colorMode, srcRow + x * fgBpp, config.fg.alpha), config.fg);
+                if (config.mode == MODE_BLEND) {
+                    uint32_t bg = modifyAlpha(readPixel(config.bg.colorMode, bgRow + x * bgBpp, config.bg.alpha), config.bg);
+                    argb = blend(argb, bg);
+                }
+            }
+            writePixel(config.outputColorMode, dstRow + x * outputBpp, argb, config.redBlueSwap);
+        }
+    }
+}
+
+void init() {
+}
+
+static void push() {
+    g_head = g_head + 1;
+}
+
+// commands are executed here, when CPU needs the result
+static void waitUntilDone(uint32_t index) {
+    while ((int32_t)(g_tail - index) < 0) {
+        execute(g_queue[g_tail % QUEUE_SIZE].command);
+        g_tail = g_tail + 1;
+    }
+}
+
+#endif // EEZ_PLATFORM_SIMULATOR
+
+////////////////////////////////////////////////////////////////////////////////
+
+void enqueue(const Command &command) {
+    if (g_head - g_tail >= QUEUE_SIZE) {
+        g_statistics.numQueueFull++;
+        waitUntilDone(g_head - QUEUE_SIZE + 1);
+    }
+
+    Entry &entry = g_queue[g_head % QUEUE_SIZE];
+    entry.command = command;
+
+    entry.dstStart = (const uint8_t *)command.dst;
+    entry.dstEnd = getEnd(command.dst, command.width, command.height, command.outputOffset, getBytesPerPixel(command.config.outputColorMode));
+
+    if (command.config.mode == MODE_FILL) {
+        entry.srcStart = nullptr;
+        entry.srcEnd = nullptr;
+    } else {
+        entry.srcStart = (const uint8_t *)command.src;
+        entry.srcEnd = getEnd(command.src, command.width, command.height, command.fgOffset, getBytesPerPixel(command.config.fg.colorMode));
+    }
+
+    g_statistics.numCommands++;
+
+    push();
+
+    uint32_t numQueued = g_head - g_tail;
+    if (numQueued > g_statistics.maxQueued) {
+        g_statistics.maxQueued = numQueued;
+    }
+}
+
+void fence(const void *start, const void *end) {
+    g_statistics.numFences++;
+
+    uint32_t head = g_head;
+    uint32_t tail = g_tail;
+
+    // find the last pending command that accesses the region
+    bool found = false;
+    uint32_t last = 0;
+    for (uint32_t i = tail; i != head; i++) {
+        const Entry &entry = g_queue[i % QUEUE_SIZE];
+        if (
+            overlaps(entry.dstStart, entry.dstEnd, (const uint8_t *)start, (const uint8_t *)end) ||
+            overlaps(entry.srcStart, entry.srcEnd, (const uint8_t *)start, (const uint8_t *)end)
+        ) {
+            found = true;
+            last = i;
+        }
+    }
+
+    if (found) {
+        g_statistics.numFenceWaits++;
+        waitUntilDone(last + 1);
+    }
+}
+
+void fence() {
+    g_statistics.numFences++;
+
+    uint32_t head = g_head;
+    if (g_tail != head) {
+        g_statistics.numFenceWaits++;
+        waitUntilDone(head);
+    }
+}
+
+bool isIdle() {
+    return g_tail == g_head;
+}
+
+void getStatistics(Statistics &statistics) {
+    statistics = g_statistics;
+}
+
+void resetStatistics() {
+    memset(&g_statistics, 0, sizeof(g_statistics));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+
+static const int TEST_WIDTH = 16;
+static const int TEST_HEIGHT = 8;
+
+static uint16_t g_testBuffer1[TEST_WIDTH * TEST_HEIGHT];
+static uint16_t g_testBuffer2[TEST_WIDTH * TEST_HEIGHT];
+static uint32_t g_testAuxBuffer[TEST_WIDTH * TEST_HEIGHT];
+
+static Command fillCommand(void *dst, uint8_t colorMode, int x, int y, int width, int height, uint32_t color) {
+    Command command;
+    memset(&command, 0, sizeof(command));
+    command.config.mode = MODE_FILL;
+    command.config.outputColorMode = colorMode;
+    command.dst = (uint8_t *)dst + (y * TEST_WIDTH + x) * getBytesPerPixel(colorMode);
+    command.color = color;
+    command.outputOffset = TEST_WIDTH - width;
+    command.width = width;
+    command.height = height;
+    return command;
+}
+
+static Command copyCommand(const uint16_t *src, uint16_t *dst, int x, int y, int width, int height) {
+    Command command;
+    memset(&command, 0, sizeof(command));
+    command.config.mode = MODE_COPY;
+    command.config.outputColorMode = COLOR_MODE_RGB565;
+    command.config.fg.colorMode = COLOR_MODE_RGB565;
+    command.src = src + y * TEST_WIDTH + x;
+    command.dst = dst + y * TEST_WIDTH + x;
+    command.outputOffset = TEST_WIDTH - width;
+    command.fgOffset = TEST_WIDTH - width;
+    command.width = width;
+    command.height = height;
+    return command;
+}
+
+static Command blendCommand(const uint32_t *src, uint16_t *dst, int x, int y, int width, int height) {
+    Command command;
+    memset(&command, 0, sizeof(command));
+    command.config.mode = MODE_BLEND;
+    command.config.outputColorMode = COLOR_MODE_RGB565;
+    command.config.fg.colorMode = COLOR_MODE_ARGB8888;
+    command.config.bg.colorMode = COLOR_MODE_RGB565;
+    command.src = src + y * TEST_WIDTH + x;
+    command.dst = dst + y * TEST_WIDTH + x;
+    command.outputOffset = TEST_WIDTH - width;
+    command.fgOffset = TEST_WIDTH - width;
+    command.bgOffset = TEST_WIDTH - width;
+    command.width = width;
+    command.height = height;
+    return command;
+}
+
+static bool checkRect(const uint16_t *buffer, int x, int y, int width, int height, uint16_t color) {
+    for (int j = y; j < y + height; j++) {
+        for (int i = x; i < x + width; i++) {
+            if (buffer[j * TEST_WIDTH + i] != color) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static const char *runSelfTest() {
+    static const uint16_t BLACK = 0x0000;
+    static const uint16_t RED = 0xF800;
+    static const uint16_t BLUE = 0x001F;
+    static const uint16_t WHITE = 0xFFFF;
+    static const uint16_t PINK = 0xFC10; // 50% white over red
+
+    fence();
+
+    memset(g_testBuffer1, 0, sizeof(g_testBuffer1));
+    memset(g_testBuffer2, 0, sizeof(g_testBuffer2));
+
+    enqueue(fillCommand(g_testBuffer1, COLOR_MODE_RGB565, 0, 0, TEST_WIDTH, TEST_HEIGHT, 0xFFFF0000));
+    enqueue(copyCommand(g_testBuffer1, g_testBuffer2, 0, 0, TEST_WIDTH, TEST_HEIGHT));
+    enqueue(fillCommand(g_testBuffer1, COLOR_MODE_RGB565, 0, 0, TEST_WIDTH, TEST_HEIGHT, 0xFF0000FF));
+
+    if (!checkRect(g_testBuffer1, 0, 0, TEST_WIDTH, TEST_HEIGHT, BLACK)) {
+        return "command executed before fence";
+    }
+
+    // executes the first fill and the copy, but not the second fill
+    fence(g_testBuffer2, g_testBuffer2 + TEST_WIDTH * TEST_HEIGHT);
+    if (!checkRect(g_testBuffer2, 0, 0, TEST_WIDTH, TEST_HEIGHT, RED)) {
+        return "copy not done after region fence";
+    }
+    if (!checkRect(g_testBuffer1, 0, 0, TEST_WIDTH, TEST_HEIGHT, RED)) {
+        return "region fence executed non overlapping command";
+    }
+
+    fence(g_testBuffer1, g_testBuffer1 + 1);
+    if (!checkRect(g_testBuffer1, 0, 0, TEST_WIDTH, TEST_HEIGHT, BLUE)) {
+        return "fill not done after region fence";
+    }
+    if (!checkRect(g_testBuffer2, 0, 0, TEST_WIDTH, TEST_HEIGHT, RED)) {
+        return "commands executed out of order";
+    }
+
+    // translucent fill: fill aux. buffer, then blend it over part of the buffer 2
+    enqueue(fillCommand(g_testAuxBuffer, COLOR_MODE_ARGB8888, 4, 2, 8, 4, 0x80FFFFFF));
+    enqueue(blendCommand(g_testAuxBuffer, g_testBuffer2, 4, 2, 8, 4));
+    fence(g_testBuffer2 + 2 * TEST_WIDTH + 4, g_testBuffer2 + 2 * TEST_WIDTH + 5);
+    if (!checkRect(g_testBuffer2, 4, 2, 8, 4, PINK)) {
+        return "wrong blend result";
+    }
+    if (!checkRect(g_testBuffer2, 0, 0, TEST_WIDTH, 2, RED) || !checkRect(g_testBuffer2, 0, 6, TEST_WIDTH, 2, RED) ||
+        !checkRect(g_testBuffer2, 0, 2, 4, 4, RED) || !checkRect(g_testBuffer2, 12, 2, 4, 4, RED)) {
+        return "blend outside of the rectangle";
+    }
+
+    // fence must also wait for the command that reads the region
+    enqueue(copyCommand(g_testBuffer1, g_testBuffer2, 0, 0, TEST_WIDTH, 1));
+    fence(g_testBuffer1, g_testBuffer1 + 1);
+    if (!checkRect(g_testBuffer2, 0, 0, TEST_WIDTH, 1, BLUE)) {
+        return "region fence ignored command source";
+    }
+
+    // region fence doesn't wait for the command that doesn't access the region
+    enqueue(fillCommand(g_testBuffer1, COLOR_MODE_RGB565, 0, 0, TEST_WIDTH, TEST_HEIGHT, 0xFFFFFFFF));
+    Statistics statistics;
+    getStatistics(statistics);
+    uint32_t numFenceWaits = statistics.numFenceWaits;
+    fence(g_testBuffer2, g_testBuffer2 + TEST_WIDTH * TEST_HEIGHT);
+    getStatistics(statistics);
+    if (statistics.numFenceWaits != numFenceWaits || isIdle()) {
+        return "region fence waited for non overlapping command";
+    }
+
+    fence();
+    if (!isIdle() || !checkRect(g_testBuffer1, 0, 0, TEST_WIDTH, TEST_HEIGHT, WHITE)) {
+        return "fill not done after full fence";
+    }
+
+    // more commands than queue size, the oldest are executed to make room
+    for (uint32_t i = 0; i <= QUEUE_SIZE; i++) {
+        enqueue(fillCommand(g_testBuffer1, COLOR_MODE_RGB565, i % TEST_WIDTH, 0, 1, TEST_HEIGHT, i < TEST_WIDTH ? 0xFF000000 : 0xFFFF0000));
+    }
+    if (g_head - g_tail > QUEUE_SIZE) {
+        return "queue overflow";
+    }
+    fence();
+    if (!checkRect(g_testBuffer1, 0, 0, TEST_WIDTH, TEST_HEIGHT, RED)) {
+        return "wrong result after queue was full";
+    }
+
+    return nullptr;
+}
+
+bool selfTest(char *message, int messageSize) {
+    const char *error = runSelfTest();
+    if (error) {
+        snprintf(message, messageSize, "%s", error);
+        return false;
+    }
+    return true;
+}
+
+#endif // EEZ_PLATFORM_SIMULATOR
+
+} // namespace dma2d_queue
+} // namespace mcu
+} // namespace eez
@@ -0,0 +1,121 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2020-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// DMA2D command ring.
+//
+// Draw functions enqueue fill, copy and blend commands and return immediately.
+// On STM32 commands are chained from the DMA2D transfer complete interrupt and
+// HAL_DMA2D_Init/HAL_DMA2D_ConfigLayer is skipped when command has the same
+// configuration as the previous one (offsets are always written directly).
+//
+// CPU must call fence before it reads or writes memory that pending command
+// reads or writes. In the simulator commands are executed in software, in
+// the calling thread, when fence is called (or when ring is full), so missing
+// fence gives the wrong result also in the simulator.
+//
+// Only GUI thread enqueues commands.
+
+namespace eez {
+namespace mcu {
+namespace dma2d_queue {
+
+enum Mode {
+    MODE_FILL,    // register to memory
+    MODE_COPY,    // memory to memory, no pixel format conversion
+    MODE_CONVERT, // memory to memory with pixel format conversion
+    MODE_BLEND    // memory to memory with blending, background is also destination
+};
+
+enum ColorMode {
+    COLOR_MODE_ARGB8888,
+    COLOR_MODE_RGB888,
+    COLOR_MODE_RGB565,
+    COLOR_MODE_A8 // input only
+};
+
+enum AlphaMode {
+    ALPHA_MODE_NO_MODIF,
+    ALPHA_MODE_REPLACE,
+    ALPHA_MODE_COMBINE
+};
+
+struct LayerConfig {
+    uint8_t colorMode;
+    uint8_t alphaMode;
+    uint32_t alpha; // constant alpha, for A8 input ARGB color
+};
+
+// everything that requires HAL_DMA2D_Init/HAL_DMA2D_ConfigLayer
+struct Config {
+    uint8_t mode;
+    uint8_t outputColorMode;
+    uint8_t redBlueSwap;
+    LayerConfig fg;
+    LayerConfig bg;
+};
+
+struct Command {
+    Config config;
+    const void *src; // foreground, not used for MODE_FILL
+    void *dst;       // output, also background for MODE_BLEND
+    uint32_t color;  // ARGB color for MODE_FILL
+    uint16_t outputOffset;
+    uint16_t fgOffset;
+    uint16_t bgOffset;
+    uint16_t width;
+    uint16_t height;
+};
+
+struct Statistics {
+    uint32_t numCommands;
+    uint32_t numConfigSkipped; // commands started without HAL init
+    uint32_t numErrors;
+    uint32_t numFences;
+    uint32_t numFenceWaits;    // fences that had to wait for pending command
+    uint32_t numQueueFull;     // enqueue had to wait for free slot
+    uint32_t maxQueued;
+};
+
+void init();
+
+void enqueue(const Command &command);
+
+// waits until all commands that read or write [start, end) are done
+void fence(const void *start, const void *end);
+
+// waits until all commands are done
+void fence();
+
+bool isIdle();
+
+void getStatistics(Statistics &statistics);
+void resetStatistics();
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+// checks command order and fences using software backend,
+// returns false and description of the first failed check
+bool selfTest(char *message, int messageSize);
+#endif
+
+} // namespace dma2d_queue
+} // namespace mcu
+} // namespace eez
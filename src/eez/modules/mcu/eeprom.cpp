@@ -198,22 +198,21 @@ bool test() {
     return g_testResult != TEST_FAILED;
 }
 
-void resetAllExceptOnTimeCounters() {
+static void resetRange(uint32_t startAddress, uint32_t endAddress) {
     uint8_t buffer[64];
     
     memset(buffer, 0xFF, 64);
 
-    uint32_t address;
-
-    for (address = 0; address < EEPROM_ONTIME_START_ADDRESS; address += 64) {
+    for (uint32_t address = startAddress; address < endAddress; address += 64) {
         WATCHDOG_RESET();
-        write(buffer, MIN(EEPROM_ONTIME_START_ADDRESS - address, 64), (uint16_t)address);
+        write(buffer, MIN(endAddress - address, 64), (uint16_t)address);
     }
+}
 
-    for (address = EEPROM_ONTIME_START_ADDRESS + 6 * sizeof(uint32_t); address < EEPROM_SIZE; address += 64) {
-        WATCHDOG_RESET();
-        write(buffer, MIN(EEPROM_SIZE - address, 64), (uint16_t)address);
-    }
+void resetAllExceptOnTimeCounters() {
+    resetRange(0, EEPROM_ONTIME_START_ADDRESS);
+    resetRange(EEPROM_ONTIME_START_ADDRESS + 6 * sizeof(uint32_t), EEPROM_ONTIME_JOURNAL_START_ADDRESS);
+    resetRange(EEPROM_ONTIME_JOURNAL_START_ADDRESS + EEPROM_ONTIME_JOURNAL_SIZE, EEPROM_SIZE);
 }
 
 } // namespace eeprom
@@ -28,6 +28,7 @@
 |64     |  24|[Total ON-time counter](#ontime-counter)  |
 |1024   |  64|[Device configuration](#device)           |
 |1536   | 128|[Device configuration 2](#device2)        |
+|16384  |2048|[ON-time journal](#ontime-journal)        |
 
 ## <a name="ontime-counter">ON-time counter</a>
 
@@ -40,6 +41,22 @@
 |16    |4   |int                      |2nd counter                  |
 |20    |4   |int                      |2bd counter (copy)           |
 
+## <a name="ontime-journal">ON-time journal</a>
+
+32 record locations, 64 bytes each, written in turn. Record with the highest
+sequence number and valid checksum is the current one.
+
+|Offset|Size|Type                     |Description                  |
+|------|----|-------------------------|-----------------------------|
+|0     |4   |int                      |Magic number                 |
+|4     |4   |int                      |Sequence number              |
+|8     |48  |struct[4]                |MCU and slot 1-3 counters    |
+|56    |4   |int                      |Reserved                     |
+|60    |4   |int                      |CRC32 of bytes 0-59          |
+
+Each counter entry: module type (2), reserved (2), module ID from module
+EEPROM, 0 for the MCU counter (4), total time in minutes (4).
+
 ## <a name="device">Device configuration</a>
 
 |Offset|Size|Type                     |Description                  |
@@ -112,6 +129,9 @@ static const uint8_t WRITE = 2;
 
 static const uint16_t EEPROM_ONTIME_START_ADDRESS = 64;
 
+static const uint16_t EEPROM_ONTIME_JOURNAL_START_ADDRESS = 16384;
+static const uint16_t EEPROM_ONTIME_JOURNAL_SIZE = 2048;
+
 static const uint16_t EEPROM_SIZE = 32768;
 
 void init();
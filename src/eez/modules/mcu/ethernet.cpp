@@ -129,17 +129,29 @@ enum ConnectionState {
 static ConnectionState g_connectionState = CONNECTION_STATE_INITIALIZED;
 static uint16_t g_port;
 struct netconn *g_tcpListenConnection;
-struct netconn *g_tcpClientConnection;
-static netbuf *g_inbuf;
+struct netconn *g_tcpClientConnections[ETHERNET_MAX_SESSIONS];
+static netbuf *g_inbufs[ETHERNET_MAX_SESSIONS];
 static bool g_checkLinkWhileIdle = false;
 
+static int findSession(struct netconn *conn) {
+    for (int sessionIndex = 0; sessionIndex < ETHERNET_MAX_SESSIONS; sessionIndex++) {
+        if (g_tcpClientConnections[sessionIndex] == conn) {
+            return sessionIndex;
+        }
+    }
+    return -1;
+}
+
 static void netconnCallback(struct netconn *conn, enum netconn_evt evt, u16_t len) {
 	switch (evt) {
 	case NETCONN_EVT_RCVPLUS:
 		if (conn == g_tcpListenConnection) {
 			osMessagePut(g_ethernetMessageQueueId, QUEUE_MESSAGE_ACCEPT_CLIENT, osWaitForever);
-		} else if (conn == g_tcpClientConnection) {
-			sendMessageToLowPriorityThread(ETHERNET_INPUT_AVAILABLE);
+		} else {
+            int sessionIndex = findSession(conn);
+            if (sessionIndex != -1) {
+			    sendMessageToLowPriorityThread(ETHERNET_INPUT_AVAILABLE, sessionIndex);
+            }
 		}
 		break;
 
@@ -253,14 +265,15 @@ static void onEvent(uint8_t eventType) {
 		{
 			struct netconn *newConnection;
 			if (netconn_accept(g_tcpListenConnection, &newConnection) == ERR_OK) {
-				if (g_tcpClientConnection) {
-					// there is a client already connected, close this connection
+                int sessionIndex = findSession(nullptr);
+				if (sessionIndex == -1) {
+					// all sessions are taken, close this connection
 					netconn_close(newConnection);
 					netconn_delete(newConnection);
 				} else {
 					// connection with the client established
-					g_tcpClientConnection = newConnection;
-					sendMessageToLowPriorityThread(ETHERNET_CLIENT_CONNECTED);
+					g_tcpClientConnections[sessionIndex] = newConnection;
+					sendMessageToLowPriorityThread(ETHERNET_CLIENT_CONNECTED, sessionIndex);
 				}
 			}
 		}
@@ -297,25 +310,27 @@ void onIdle() {
 #define INPUT_BUFFER_SIZE 1024
 
 static uint16_t g_port;
-static char g_inputBuffer[INPUT_BUFFER_SIZE];
-static uint32_t g_inputBufferLength;
+static char g_inputBuffer[ETHERNET_MAX_SESSIONS][INPUT_BUFFER_SIZE];
+static uint32_t g_inputBufferLength[ETHERNET_MAX_SESSIONS];
 
 ////////////////////////////////////////////////////////////////////////////////
 
 bool bind(int port);
-bool client_available();
-bool connected();
-int available();
-int read(char *buffer, int buffer_size);
-int write(const char *buffer, int buffer_size);
-void stop();
+int client_available();
+bool connected(int sessionIndex);
+int available(int sessionIndex);
+int read(int sessionIndex, char *buffer, int buffer_size);
+int write(int sessionIndex, const char *buffer, int buffer_size);
+void stop(int sessionIndex);
+
+static_assert(ETHERNET_MAX_SESSIONS == 4, "client_socket initializer must match ETHERNET_MAX_SESSIONS");
 
 #ifdef EEZ_PLATFORM_SIMULATOR_WIN32
 static SOCKET listen_socket = INVALID_SOCKET;
-static SOCKET client_socket = INVALID_SOCKET;
+static SOCKET client_socket[ETHERNET_MAX_SESSIONS] = { INVALID_SOCKET, INVALID_SOCKET, INVALID_SOCKET, INVALID_SOCKET };
 #else
 static int listen_socket = -1;
-static int client_socket = -1;
+static int client_socket[ETHERNET_MAX_SESSIONS] = { -1, -1, -1, -1 };
 
 bool enable_non_blocking(int fd) {
     int flags = fcntl(fd, F_GETFL, 0);
@@ -441,76 +456,87 @@ bool bind(int port) {
 #endif    
 }
 
-bool client_available() {
+// returns index of the session for the newly accepted client or -1
+int client_available() {
 #ifdef EEZ_PLATFORM_SIMULATOR_WIN32
-    if (connected())
-        return true;
-
     if (listen_socket == INVALID_SOCKET) {
-        return false;
+        return -1;
+    }
+#else
+    if (listen_socket == -1) {
+        return -1;
+    }
+#endif
+
+    int sessionIndex;
+    for (sessionIndex = 0; sessionIndex < ETHERNET_MAX_SESSIONS; sessionIndex++) {
+        if (!connected(sessionIndex)) {
+            break;
+        }
+    }
+
+    if (sessionIndex == ETHERNET_MAX_SESSIONS) {
+        // all sessions are taken, leave the client in the listen backlog
+        return -1;
     }
 
+#ifdef EEZ_PLATFORM_SIMULATOR_WIN32
     // Accept a client socket
-    client_socket = accept(listen_socket, NULL, NULL);
-    if (client_socket == INVALID_SOCKET) {
+    client_socket[sessionIndex] = accept(listen_socket, NULL, NULL);
+    if (client_socket[sessionIndex] == INVALID_SOCKET) {
         if (WSAGetLastError() == WSAEWOULDBLOCK) {
-            return false;
+            return -1;
         }
 
         DebugTrace("EHTERNET accept failed with error %d\n", WSAGetLastError());
         closesocket(listen_socket);
         listen_socket = INVALID_SOCKET;
-        return false;
+        return -1;
     }
 
-    return true;
+    return sessionIndex;
 #else
-    if (connected())
-        return true;
-
-    if (listen_socket == -1) {
-        return 0;
-    }
-
     sockaddr_in cli_addr;
     socklen_t clilen = sizeof(cli_addr);
-    client_socket = accept(listen_socket, (sockaddr *)&cli_addr, &clilen);
-    if (client_socket < 0) {
+    int socket = accept(listen_socket, (sockaddr *)&cli_addr, &clilen);
+    if (socket < 0) {
         if (errno == EWOULDBLOCK) {
-            return false;
+            return -1;
         }
 
         DebugTrace("EHTERNET: accept failed with error %d", errno);
         close(listen_socket);
         listen_socket = -1;
-        return false;
+        return -1;
     }
 
-    if (!enable_non_blocking(client_socket)) {
+    if (!enable_non_blocking(socket)) {
         DebugTrace("EHTERNET: ioctl on client socket failed with error %d", errno);
-        close(client_socket);
-        listen_socket = -1;
-        return false;
+        close(socket);
+        return -1;
     }
 
-    return true;
+    client_socket[sessionIndex] = socket;
+
+    return sessionIndex;
 #endif    
 }
 
-bool connected() {
+bool connected(int sessionIndex) {
 #ifdef EEZ_PLATFORM_SIMULATOR_WIN32
-    return client_socket != INVALID_SOCKET;
+    return client_socket[sessionIndex] != INVALID_SOCKET;
 #else
-    return client_socket != -1;
+    return client_socket[sessionIndex] != -1;
 #endif    
 }
 
-int available() {
+int available(int sessionIndex) {
 #ifdef EEZ_PLATFORM_SIMULATOR_WIN32
-    if (client_socket == INVALID_SOCKET)
+    if (client_socket[sessionIndex] == INVALID_SOCKET)
         return 0;
 
-    int iResult = ::recv(client_socket, g_inputBuffer, INPUT_BUFFER_SIZE, MSG_PEEK);
+    char buffer[1000];
+    int iResult = ::recv(client_socket[sessionIndex], buffer, 1000, MSG_PEEK);
     if (iResult > 0) {
         return iResult;
     }
@@ -519,15 +545,15 @@ int available() {
         return 0;
     }
 
-    stop();
+    stop(sessionIndex);
 
     return 0;
 #else
-    if (client_socket == -1)
+    if (client_socket[sessionIndex] == -1)
         return 0;
 
     char buffer[1000];
-    int iResult = ::recv(client_socket, buffer, 1000, MSG_PEEK);
+    int iResult = ::recv(client_socket[sessionIndex], buffer, 1000, MSG_PEEK);
     if (iResult > 0) {
         return iResult;
     }
@@ -536,15 +562,15 @@ int available() {
         return 0;
     }
 
-    stop();
+    stop(sessionIndex);
 
     return 0;
 #endif        
 }
 
-int read(char *buffer, int buffer_size) {
+int read(int sessionIndex, char *buffer, int buffer_size) {
 #ifdef EEZ_PLATFORM_SIMULATOR_WIN32
-    int iResult = ::recv(client_socket, buffer, buffer_size, 0);
+    int iResult = ::recv(client_socket[sessionIndex], buffer, buffer_size, 0);
     if (iResult > 0) {
         return iResult;
     }
@@ -553,11 +579,11 @@ int read(char *buffer, int buffer_size) {
         return 0;
     }
 
-    stop();
+    stop(sessionIndex);
 
     return 0;
 #else
-    int n = ::read(client_socket, buffer, buffer_size);
+    int n = ::read(client_socket[sessionIndex], buffer, buffer_size);
     if (n > 0) {
         return n;
     }
@@ -566,23 +592,23 @@ int read(char *buffer, int buffer_size) {
         return 0;
     }
 
-    stop();
+    stop(sessionIndex);
 
     return 0;
 #endif    
 }
 
-int write(const char *buffer, int buffer_size) {
+int write(int sessionIndex, const char *buffer, int buffer_size) {
 #ifdef EEZ_PLATFORM_SIMULATOR_WIN32
     int iSendResult;
 
-    if (client_socket != INVALID_SOCKET) {
+    if (client_socket[sessionIndex] != INVALID_SOCKET) {
         // Echo the buffer back to the sender
-        iSendResult = ::send(client_socket, buffer, buffer_size, 0);
+        iSendResult = ::send(client_socket[sessionIndex], buffer, buffer_size, 0);
         if (iSendResult == SOCKET_ERROR) {
             DebugTrace("send failed with error: %d\n", WSAGetLastError());
-            closesocket(client_socket);
-            client_socket = INVALID_SOCKET;
+            closesocket(client_socket[sessionIndex]);
+            client_socket[sessionIndex] = INVALID_SOCKET;
             return 0;
         }
         return iSendResult;
@@ -590,11 +616,11 @@ int write(const char *buffer, int buffer_size) {
 
     return 0;
 #else
-    if (client_socket != -1) {
-        int n = ::write(client_socket, buffer, buffer_size);
+    if (client_socket[sessionIndex] != -1) {
+        int n = ::write(client_socket[sessionIndex], buffer, buffer_size);
         if (n < 0) {
-            close(client_socket);
-            client_socket = -1;
+            close(client_socket[sessionIndex]);
+            client_socket[sessionIndex] = -1;
             return 0;
         }
         return n;
@@ -604,23 +630,25 @@ int write(const char *buffer, int buffer_size) {
 #endif    
 }
 
-void stop() {
+void stop(int sessionIndex) {
 #ifdef EEZ_PLATFORM_SIMULATOR_WIN32
-    if (client_socket != INVALID_SOCKET) {
-        int iResult = ::shutdown(client_socket, SD_SEND);
+    if (client_socket[sessionIndex] != INVALID_SOCKET) {
+        int iResult = ::shutdown(client_socket[sessionIndex], SD_SEND);
         if (iResult == SOCKET_ERROR) {
             DebugTrace("EHTERNET shutdown failed with error %d\n", WSAGetLastError());
         }
-        closesocket(client_socket);
-        client_socket = INVALID_SOCKET;
+        closesocket(client_socket[sessionIndex]);
+        client_socket[sessionIndex] = INVALID_SOCKET;
     }
 #else
-    int result = ::shutdown(client_socket, SHUT_WR);
-    if (result < 0) {
-        DebugTrace("ETHERNET shutdown failed with error %d\n", errno);
+    if (client_socket[sessionIndex] != -1) {
+        int result = ::shutdown(client_socket[sessionIndex], SHUT_WR);
+        if (result < 0) {
+            DebugTrace("ETHERNET shutdown failed with error %d\n", errno);
+        }
+        close(client_socket[sessionIndex]);
+        client_socket[sessionIndex] = -1;
     }
-    close(client_socket);
-    client_socket = -1;
 #endif    
 }
 
@@ -649,24 +677,27 @@ void onEvent(uint8_t eventType) {
 }
 
 void onIdle() {
-    static bool wasConnected = false;
-
-    if (wasConnected) {
-        if (connected()) {
-            if (!g_inputBufferLength && available()) {
-                g_inputBufferLength = read(g_inputBuffer, INPUT_BUFFER_SIZE);
-                sendMessageToLowPriorityThread(ETHERNET_INPUT_AVAILABLE);
+    static bool wasConnected[ETHERNET_MAX_SESSIONS];
+
+    for (int sessionIndex = 0; sessionIndex < ETHERNET_MAX_SESSIONS; sessionIndex++) {
+        if (wasConnected[sessionIndex]) {
+            if (connected(sessionIndex)) {
+                if (!g_inputBufferLength[sessionIndex] && available(sessionIndex)) {
+                    g_inputBufferLength[sessionIndex] = read(sessionIndex, g_inputBuffer[sessionIndex], INPUT_BUFFER_SIZE);
+                    sendMessageToLowPriorityThread(ETHERNET_INPUT_AVAILABLE, sessionIndex);
+                }
+            } else {
+                sendMessageToLowPriorityThread(ETHERNET_CLIENT_DISCONNECTED, sessionIndex);
+                wasConnected[sessionIndex] = false;
             }
-        } else {
-            sendMessageToLowPriorityThread(ETHERNET_CLIENT_DISCONNECTED);
-            wasConnected = false;
-        }
-    } else {
-        if (client_available()) {
-            wasConnected = true;
-            sendMessageToLowPriorityThread(ETHERNET_CLIENT_CONNECTED);
         }
     }
+
+    int sessionIndex = client_available();
+    if (sessionIndex != -1) {
+        wasConnected[sessionIndex] = true;
+        sendMessageToLowPriorityThread(ETHERNET_CLIENT_CONNECTED, sessionIndex);
+    }
 }
 #endif
 
@@ -748,30 +779,33 @@ void endServer() {
     osMessagePut(g_ethernetMessageQueueId, QUEUE_MESSAGE_DESTROY_TCP_SERVER, osWaitForever);
 }
 
-void getInputBuffer(int bufferPosition, char **buffer, uint32_t *length) {
+void getInputBuffer(int sessionIndex, char **buffer, uint32_t *length) {
 #if defined(EEZ_PLATFORM_STM32)
-	if (!g_tcpClientConnection) {
+    struct netconn *tcpClientConnection = g_tcpClientConnections[sessionIndex];
+	if (!tcpClientConnection) {
+    	*buffer = nullptr;
+    	*length = 0;
 		return;
 	}
 
-	if (netconn_recv(g_tcpClientConnection, &g_inbuf) != ERR_OK) {
+	if (netconn_recv(tcpClientConnection, &g_inbufs[sessionIndex]) != ERR_OK) {
 		goto fail1;
 	}
 
-	if (netconn_err(g_tcpClientConnection) != ERR_OK) {
+	if (netconn_err(tcpClientConnection) != ERR_OK) {
 		goto fail2;
 	}
 
 	uint8_t* data;
 	u16_t dataLength;
-	netbuf_data(g_inbuf, (void**)&data, &dataLength);
+	netbuf_data(g_inbufs[sessionIndex], (void**)&data, &dataLength);
 
     if (dataLength > 0) {
     	*buffer = (char *)data;
     	*length = dataLength;
     } else {
-        netbuf_delete(g_inbuf);
-        g_inbuf = nullptr;
+        netbuf_delete(g_inbufs[sessionIndex]);
+        g_inbufs[sessionIndex] = nullptr;
     	*buffer = nullptr;
     	*length = 0;
     }
@@ -779,58 +813,67 @@ void getInputBuffer(int bufferPosition, char **buffer, uint32_t *length) {
     return;
 
 fail2:
-	netbuf_delete(g_inbuf);
-	g_inbuf = nullptr;
+	netbuf_delete(g_inbufs[sessionIndex]);
+	g_inbufs[sessionIndex] = nullptr;
 
 fail1:
-	netconn_close(g_tcpClientConnection);
-	netconn_delete(g_tcpClientConnection);
-	g_tcpClientConnection = nullptr;
-	sendMessageToLowPriorityThread(ETHERNET_CLIENT_DISCONNECTED);
+	netconn_close(tcpClientConnection);
+	netconn_delete(tcpClientConnection);
+	g_tcpClientConnections[sessionIndex] = nullptr;
+	sendMessageToLowPriorityThread(ETHERNET_CLIENT_DISCONNECTED, sessionIndex);
 
 	*buffer = nullptr;
-	length = 0;
+	*length = 0;
 #endif
 
 #if defined(EEZ_PLATFORM_SIMULATOR)
-    *buffer = g_inputBuffer;
-    *length = g_inputBufferLength;
+    *buffer = g_inputBuffer[sessionIndex];
+    *length = g_inputBufferLength[sessionIndex];
 #endif
 }
 
-void releaseInputBuffer() {
+void releaseInputBuffer(int sessionIndex) {
 #if defined(EEZ_PLATFORM_STM32)
-	netbuf_delete(g_inbuf);
-	g_inbuf = nullptr;
+	netbuf_delete(g_inbufs[sessionIndex]);
+	g_inbufs[sessionIndex] = nullptr;
 #endif
 
 #if defined(EEZ_PLATFORM_SIMULATOR)
-    g_inputBufferLength = 0;
+    g_inputBufferLength[sessionIndex] = 0;
 #endif
 }
 
-int writeBuffer(const char *buffer, uint32_t length) {
+int writeBuffer(int sessionIndex, const char *buffer, uint32_t length) {
 #if defined(EEZ_PLATFORM_STM32)
-	netconn_write(g_tcpClientConnection, (void *)buffer, (uint16_t)length, NETCONN_COPY);
+    if (!g_tcpClientConnections[sessionIndex]) {
+        return 0;
+    }
+    // NETCONN_NOCOPY would make lwIP reference the buffer until the client ACKs it,
+    // but none of the callers' buffers outlive this call: the SCPI output buffer is
+    // refilled right after the flush and the upload reuses its 512 byte stack chunk
+    // for the next read. Waiting for the ACK of every chunk would cost a round trip
+    // (and often a delayed ACK) per chunk, so the data is copied into the send buffer.
+	netconn_write(g_tcpClientConnections[sessionIndex], (void *)buffer, (uint16_t)length, NETCONN_COPY);
     return length;
 #endif
 
 #if defined(EEZ_PLATFORM_SIMULATOR)
-    int numWritten = write(buffer, length);
-    osDelay(1);
-    return numWritten;
+    return write(sessionIndex, buffer, length);
 #endif
 }
 
-void disconnectClient() {
+void disconnectClient(int sessionIndex) {
 #if defined(EEZ_PLATFORM_STM32)
-	netconn_close(g_tcpClientConnection);
-	netconn_delete(g_tcpClientConnection);
-	g_tcpClientConnection = nullptr;
+    if (!g_tcpClientConnections[sessionIndex]) {
+        return;
+    }
+	netconn_close(g_tcpClientConnections[sessionIndex]);
+	netconn_delete(g_tcpClientConnections[sessionIndex]);
+	g_tcpClientConnections[sessionIndex] = nullptr;
 #endif
 
 #if defined(EEZ_PLATFORM_SIMULATOR)
-    stop();
+    stop(sessionIndex);
 #endif    
 }
 
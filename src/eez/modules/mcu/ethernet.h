@@ -58,11 +58,14 @@ IPAddress dnsServerIP();
 void beginServer(uint16_t port);
 void endServer();
 
-void getInputBuffer(int bufferPosition, char **buffer, uint32_t *length);
-void releaseInputBuffer();
-
-int writeBuffer(const char *buffer, uint32_t length);
-void disconnectClient();
+// Each connected client gets its own session, sessionIndex is in [0, ETHERNET_MAX_SESSIONS).
+// ETHERNET_CLIENT_CONNECTED, ETHERNET_CLIENT_DISCONNECTED and ETHERNET_INPUT_AVAILABLE
+// messages are sent to the low priority thread with session index as parameter.
+void getInputBuffer(int sessionIndex, char **buffer, uint32_t *length);
+void releaseInputBuffer(int sessionIndex);
+
+int writeBuffer(int sessionIndex, const char *buffer, uint32_t length);
+void disconnectClient(int sessionIndex);
 
 void pushEvent(int16_t eventId);
 
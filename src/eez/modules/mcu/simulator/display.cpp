@@ -21,16 +21,27 @@
 #include <math.h>
 #include <memory.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <utility>
 #include <string>
 
+#if !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
 #include <SDL.h>
 #include <SDL_image.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DISPLAY_COMPOSITOR_SSE2 1
+#include <emmintrin.h>
+#else
+#define DISPLAY_COMPOSITOR_SSE2 0
+#endif
 
 #include <cmsis_os.h>
 
 #include <eez/modules/mcu/display.h>
+#include <eez/modules/mcu/dma2d_queue.h>
 
 #include <eez/modules/psu/gui/psu.h>
 #include <eez/debug.h>
@@ -49,13 +60,15 @@ namespace display {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+static bool g_isOn;
+
+#if !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
 static const char *TITLE = "EEZ Modular Firmware Simulator";
 static const char *ICON = "eez.png";
 
-static bool g_isOn;
-
 static SDL_Window *g_mainWindow;
 static SDL_Renderer *g_renderer;
+#endif
 
 static uint32_t *g_buffer;
 static uint32_t *g_lastBuffer;
@@ -79,6 +92,17 @@ std::string getFullPath(std::string category, std::string path) {
     return path;
 }
 
+#if defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+
+// Headless simulator has no window, frames are still drawn to VRAM buffers
+// (so frame cost and screenshots stay the same), but never presented.
+
+bool init() {
+    return true;
+}
+
+#else
+
 int getDesktopResolution(int *w, int *h) {
     SDL_Init(SDL_INIT_VIDEO);
 
@@ -142,6 +166,8 @@ bool init() {
     return true;
 }
 
+#endif
+
 void *getBufferPointer() {
     return g_buffer;
 }
@@ -154,6 +180,8 @@ void turnOn() {
     if (!isOn()) {
         g_isOn = true;
 
+        dma2d_queue::fence();
+
         memset(VRAM_BUFFER1_START_ADDRESS, 0, VRAM_BUFFER_SIZE);
         memset(VRAM_BUFFER2_START_ADDRESS, 0, VRAM_BUFFER_SIZE);
         memset(VRAM_ANIMATION_BUFFER1_START_ADDRESS, 0, VRAM_BUFFER_SIZE);
@@ -194,12 +222,16 @@ void updateBrightness() {
 }
 
 void updateScreen(uint32_t *buffer) {
+    // wait for all commands of this frame
+    dma2d_queue::fence();
+
     g_lastBuffer = buffer;
 
     if (!isOn()) {
         return;
     }
 
+#if !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
     SDL_Surface *rgbSurface = SDL_CreateRGBSurfaceFrom(
         buffer, DISPLAY_WIDTH, DISPLAY_HEIGHT, 32, 4 * DISPLAY_WIDTH, 0, 0, 0, 0);
     if (rgbSurface != NULL) {
@@ -219,6 +251,7 @@ void updateScreen(uint32_t *buffer) {
         printf("Unable to render text surface! SDL Error: %s\n", SDL_GetError());
     }
     SDL_RenderPresent(g_renderer);
+#endif
 }
 
 void animate() {
@@ -243,6 +276,8 @@ void animate() {
 }
 
 void doTakeScreenshot() {
+    dma2d_queue::fence();
+
     uint8_t *src = (uint8_t *)(g_lastBuffer + g_psuAppContext.rect.y * DISPLAY_WIDTH + g_psuAppContext.rect.x);
     uint8_t *dst = SCREENSHOOT_BUFFER_START_ADDRESS;
 
@@ -272,16 +307,22 @@ void sync() {
     int32_t diff = 1000 / 60 - (tickCount - g_lastTickCount);
     g_lastTickCount = tickCount;
     if (diff > 0 && diff < 1000 / 60) {
+#if defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+        osDelay(diff);
+#else
         SDL_Delay(diff);
+#endif
     }
 
     if (!isOn()) {
         return;
     }
 
+#if !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
     if (g_mainWindow == nullptr) {
         init();
     }
+#endif
 
     if (g_animationState.enabled) {
         animate();
@@ -353,6 +394,58 @@ const uint8_t *takeScreenshot() {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// command with ARGB8888 output to the display sized buffer
+static dma2d_queue::Command argb8888Command(uint8_t mode, void *dst, int width, int height) {
+    dma2d_queue::Command command;
+    memset(&command, 0, sizeof(command));
+    command.config.mode = mode;
+    command.config.outputColorMode = dma2d_queue::COLOR_MODE_ARGB8888;
+    command.dst = dst;
+    command.outputOffset = DISPLAY_WIDTH - width;
+    command.bgOffset = DISPLAY_WIDTH - width;
+    command.width = width;
+    command.height = height;
+    return command;
+}
+
+static void fillRect(uint32_t *dst, int x, int y, int width, int height, uint32_t color32) {
+    if ((color32 & 0xFF000000) == 0xFF000000) {
+        auto command = argb8888Command(dma2d_queue::MODE_FILL, dst + y * DISPLAY_WIDTH + x, width, height);
+        command.color = color32;
+        dma2d_queue::enqueue(command);
+    } else {
+        // fill aux. buffer with translucent color
+        auto auxBufferOffset = (uint32_t *)VRAM_AUX_BUFFER9_START_ADDRESS + y * DISPLAY_WIDTH + x;
+
+        auto command = argb8888Command(dma2d_queue::MODE_FILL, auxBufferOffset, width, height);
+        command.color = color32;
+        dma2d_queue::enqueue(command);
+
+        // blend aux. buffer with dst buffer
+        command = argb8888Command(dma2d_queue::MODE_BLEND, dst + y * DISPLAY_WIDTH + x, width, height);
+        command.config.fg.colorMode = dma2d_queue::COLOR_MODE_ARGB8888;
+        command.config.bg.colorMode = dma2d_queue::COLOR_MODE_ARGB8888;
+        command.src = auxBufferOffset;
+        command.fgOffset = DISPLAY_WIDTH - width;
+        dma2d_queue::enqueue(command);
+    }
+}
+
+static void bitBlt(uint32_t *src, uint32_t *dst, int sx, int sy, int width, int height, int dx, int dy) {
+    auto command = argb8888Command(dma2d_queue::MODE_COPY, dst + dy * DISPLAY_WIDTH + dx, width, height);
+    command.config.fg.colorMode = dma2d_queue::COLOR_MODE_ARGB8888;
+    command.src = src + sy * DISPLAY_WIDTH + sx;
+    command.fgOffset = DISPLAY_WIDTH - width;
+    dma2d_queue::enqueue(command);
+}
+
+// waits for pending commands before CPU draws into the rectangle of the buffer
+static void fenceRect(uint32_t *buffer, int x1, int y1, int x2, int y2) {
+    dma2d_queue::fence(buffer + y1 * DISPLAY_WIDTH + x1, buffer + y2 * DISPLAY_WIDTH + x2 + 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 static void doDrawGlyph(const gui::font::Glyph &glyph, int x_glyph, int y_glyph, int width, int height, int offset, int iStartByte) {
     uint32_t pixel;
     ((uint8_t *)&pixel)[0] = COLOR_TO_B(g_fc);
@@ -425,6 +518,10 @@ static int8_t drawGlyph(int x1, int y1, int clip_x1, int clip_y1, int clip_x2, i
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void beginPixelDrawing(int x1, int y1, int x2, int y2) {
+    fenceRect(g_buffer, x1, y1, x2, y2);
+}
+
 void drawPixel(int x, int y) {
     *(g_buffer + y * DISPLAY_WIDTH + x) = color16to32(g_fc);
 
@@ -459,24 +556,7 @@ void drawRect(int x1, int y1, int x2, int y2) {
 
 void fillRect(int x1, int y1, int x2, int y2, int r) {
     if (r == 0) {
-        uint32_t color32 = color16to32(g_fc, g_opacity);
-        uint32_t *dst = g_buffer + y1 * DISPLAY_WIDTH + x1;
-        int width = x2 - x1 + 1;
-        int height = y2 - y1 + 1;
-        int nl = DISPLAY_WIDTH - width;
-        if (g_opacity == 255) {
-            for (uint32_t *dstEnd = dst + height * DISPLAY_WIDTH; dst != dstEnd; dst += nl) {
-                for (uint32_t *lineEnd = dst + width; dst != lineEnd; dst++) {
-                    *dst = color32;
-                }
-            }
-        } else {
-            for (uint32_t *dstEnd = dst + height * DISPLAY_WIDTH; dst != dstEnd; dst += nl) {
-                for (uint32_t *lineEnd = dst + width; dst != lineEnd; dst++) {
-                    *dst = blendColor(color32, *dst);
-                }
-            }
-        }
+        fillRect(g_buffer, x1, y1, x2 - x1 + 1, y2 - y1 + 1, color16to32(g_fc, g_opacity));
     } else {
         // draw rounded rect
         fillRect(x1 + r, y1, x2 - r, y1 + r - 1);
@@ -497,59 +577,25 @@ void fillRect(int x1, int y1, int x2, int y2, int r) {
 }
 
 void fillRect(void *dstBuffer, int x1, int y1, int x2, int y2) {
-    uint32_t color32 = color16to32(g_fc);
-    uint32_t *dst = (uint32_t *)dstBuffer + y1 * DISPLAY_WIDTH + x1;
-    int nl = DISPLAY_WIDTH - (x2 - x1 + 1);
-    for (int y = y1; y <= y2; y++) {
-        for (int x = x1; x <= x2; x++) {
-            *dst++ = color32;
-        }
-        dst += nl;
-    }
+    fillRect((uint32_t *)dstBuffer, x1, y1, x2 - x1 + 1, y2 - y1 + 1, color16to32(g_fc));
 
     markDirty(x1, y1, x2, y2);
 }
 
 void drawHLine(int x, int y, int l) {
-    uint32_t color32 = color16to32(g_fc);
-
-    uint32_t *dst = g_buffer + y * DISPLAY_WIDTH + x;
-    uint32_t *dstEnd = dst + l + 1;
-    while (dst < dstEnd) {
-        *dst++ = color32;
-    }
+    fillRect(g_buffer, x, y, l + 1, 1, color16to32(g_fc));
 
     markDirty(x, y, x + l, y);
 }
 
 void drawVLine(int x, int y, int l) {
-    uint32_t color32 = color16to32(g_fc);
-
-    uint32_t *dst = g_buffer + y * DISPLAY_WIDTH + x;
-    uint32_t *dstEnd = dst + (l + 1) * DISPLAY_WIDTH;
-
-    while (dst < dstEnd) {
-        *dst = color32;
-        dst += DISPLAY_WIDTH;
-    }
+    fillRect(g_buffer, x, y, 1, l + 1, color16to32(g_fc));
 
     markDirty(x, y, x, y + l);
 }
 
 void bitBlt(int x1, int y1, int x2, int y2, int dstx, int dsty) {
-    int width = x2 - x1 + 1;
-    int height = y2 - y1 + 1;
-
-    uint32_t *src = g_buffer + y1 * DISPLAY_WIDTH + x1;
-    uint32_t *dst = g_buffer + dsty * DISPLAY_WIDTH + dstx;
-    int nl = DISPLAY_WIDTH - width;
-
-    for (int y = y1; y <= y2; y++, src += nl, dst += nl) {
-        for (uint32_t *lineEnd = dst + width; dst != lineEnd; dst++, src++) {
-            uint8_t *src8 = (uint8_t *)src;
-            *dst = color16to32(RGB_TO_COLOR(src8[2], src8[1], src8[0]));
-        }
-    }
+    bitBlt(g_buffer, g_buffer, x1, y1, x2 - x1 + 1, y2 - y1 + 1, dstx, dsty);
 
     markDirty(dstx, dsty, dstx + x2 - x1, dsty + y2 - y1);
 }
@@ -559,22 +605,109 @@ void bitBlt(void *src, int x1, int y1, int x2, int y2) {
     markDirty(x1, y1, x2, y2);
 }
 
-void bitBlt(void *src, void *dst, int x1, int y1, int x2, int y2) {
-    for (int y = y1; y <= y2; ++y) {
-        for (int x = x1; x <= x2; ++x) {
-            int i = y * DISPLAY_WIDTH + x;
-            ((uint32_t *)dst)[i] = ((uint32_t *)src)[i];
+////////////////////////////////////////////////////////////////////////////////
+// Row based compositor. Source pixel alpha is ignored, whole source is
+// blended with the given opacity. Destination is almost always opaque, in
+// that case blend is dst + (src - dst) * opacity / 255 computed in integers,
+// otherwise it falls back to blendColor.
+
+static const uint32_t ALPHA_MASK = 0xFF000000;
+
+static inline uint32_t blendPixel(uint32_t src, uint32_t dst, uint32_t alpha) {
+    if ((dst & ALPHA_MASK) != ALPHA_MASK) {
+        return blendColor((src & ~ALPHA_MASK) | (alpha << 24), dst);
+    }
+
+    uint32_t invAlpha = 255 - alpha;
+
+    // two channels (blue and red) at a time, x / 255 is (x + 128 + ((x + 128) >> 8)) >> 8
+    uint32_t rb = (src & 0x00FF00FF) * alpha + (dst & 0x00FF00FF) * invAlpha + 0x00800080;
+    rb = ((rb + ((rb >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+
+    uint32_t g = (src & 0x0000FF00) * alpha + (dst & 0x0000FF00) * invAlpha + 0x00008000;
+    g = ((g + ((g >> 8) & 0x0000FF00)) >> 8) & 0x0000FF00;
+
+    return ALPHA_MASK | rb | g;
+}
+
+#if DISPLAY_COMPOSITOR_SSE2
+static inline __m128i blendChannels(__m128i src, __m128i dst, __m128i alpha, __m128i invAlpha) {
+    __m128i x = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(src, alpha), _mm_mullo_epi16(dst, invAlpha)), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+#endif
+
+static void blendRow(const uint32_t *src, uint32_t *dst, int width, uint8_t opacity) {
+#if DISPLAY_COMPOSITOR_SSE2
+    // 4 pixels at a time, same result as blendPixel
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alphaMask = _mm_set1_epi32(ALPHA_MASK);
+    const __m128i alpha = _mm_set1_epi16(opacity);
+    const __m128i invAlpha = _mm_set1_epi16(255 - opacity);
+
+    for (; width >= 4; width -= 4, src += 4, dst += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i *)src);
+        __m128i d = _mm_loadu_si128((const __m128i *)dst);
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(d, alphaMask), alphaMask)) != 0xFFFF) {
+            for (int i = 0; i < 4; i++) {
+                dst[i] = blendPixel(src[i], dst[i], opacity);
+            }
+            continue;
         }
+
+        __m128i lo = blendChannels(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero), alpha, invAlpha);
+        __m128i hi = blendChannels(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero), alpha, invAlpha);
+        _mm_storeu_si128((__m128i *)dst, _mm_or_si128(_mm_packus_epi16(lo, hi), alphaMask));
     }
+#endif
+
+    for (const uint32_t *srcEnd = src + width; src != srcEnd; src++, dst++) {
+        *dst = blendPixel(*src, *dst, opacity);
+    }
+}
+
+void bitBlt(void *src, void *dst, int x1, int y1, int x2, int y2) {
+    bitBlt((uint32_t *)src, (uint32_t *)dst, x1, y1, x2 - x1 + 1, y2 - y1 + 1, x1, y1);
 
     markDirty(x1, y1, x2, y2);
 }
 
+static void compositeRows(void *src, void *dst, int sx, int sy, int sw, int sh, int dx, int dy, uint8_t opacity) {
+    const uint32_t *srcRow = (const uint32_t *)src + sy * DISPLAY_WIDTH + sx;
+    uint32_t *dstRow = (uint32_t *)dst + dy * DISPLAY_WIDTH + dx;
+
+    if (opacity == 255) {
+        size_t rowSize = sw * sizeof(uint32_t);
+        for (int y = 0; y < sh; ++y, srcRow += DISPLAY_WIDTH, dstRow += DISPLAY_WIDTH) {
+            memcpy(dstRow, srcRow, rowSize);
+        }
+    } else {
+        for (int y = 0; y < sh; ++y, srcRow += DISPLAY_WIDTH, dstRow += DISPLAY_WIDTH) {
+            blendRow(srcRow, dstRow, sw, opacity);
+        }
+    }
+}
+
 void bitBlt(void *src, void *dst, int sx, int sy, int sw, int sh, int dx, int dy, uint8_t opacity) {
     if (dst == nullptr) {
         dst = g_buffer;
     }
 
+    if (opacity == 255) {
+        bitBlt((uint32_t *)src, (uint32_t *)dst, sx, sy, sw, sh, dx, dy);
+    } else {
+        // translucent layers are composited by the CPU, row at a time
+        fenceRect((uint32_t *)src, sx, sy, sx + sw - 1, sy + sh - 1);
+        fenceRect((uint32_t *)dst, dx, dy, dx + sw - 1, dy + sh - 1);
+        compositeRows(src, dst, sx, sy, sw, sh, dx, dy, opacity);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// previous, pixel by pixel, compositor kept as benchmark reference
+static void bitBltReference(void *src, void *dst, int sx, int sy, int sw, int sh, int dx, int dy, uint8_t opacity) {
     if (opacity == 255) {
         for (int y = 0; y < sh; ++y) {
             for (int x = 0; x < sw; ++x) {
@@ -595,7 +728,53 @@ void bitBlt(void *src, void *dst, int sx, int sy, int sw, int sh, int dx, int dy
     }
 }
 
+bool benchmarkCompositor(int numFrames, int numOverlays, CompositorBenchmarkResult &result) {
+    uint32_t *page = (uint32_t *)malloc(VRAM_BUFFER_SIZE);
+    uint32_t *overlay = (uint32_t *)malloc(VRAM_BUFFER_SIZE);
+    uint32_t *dst = (uint32_t *)malloc(VRAM_BUFFER_SIZE);
+    if (!page || !overlay || !dst) {
+        free(page);
+        free(overlay);
+        free(dst);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < DISPLAY_WIDTH * DISPLAY_HEIGHT; i++) {
+        page[i] = ALPHA_MASK | (i * 2654435761u >> 8);
+        overlay[i] = ALPHA_MASK | (i * 40503u);
+    }
+
+    // every overlay is inset a bit more than the previous one
+    auto compose = [&](void (*blt)(void *, void *, int, int, int, int, int, int, uint8_t)) {
+        uint32_t startTime = micros();
+        for (int frame = 0; frame < numFrames; frame++) {
+            blt(page, dst, 0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT, 0, 0, 255);
+            for (int i = 0; i < numOverlays; i++) {
+                int inset = 16 * (i + 1);
+                int w = DISPLAY_WIDTH - 2 * inset;
+                int h = DISPLAY_HEIGHT - 2 * inset;
+                if (w > 0 && h > 0) {
+                    blt(overlay, dst, inset, inset, w, h, inset, inset, 128 + 32 * (i % 4));
+                }
+            }
+        }
+        return micros() - startTime;
+    };
+
+    result.referenceTime = compose(bitBltReference);
+    result.time = compose(compositeRows);
+    result.sse2 = DISPLAY_COMPOSITOR_SSE2 != 0;
+
+    free(page);
+    free(overlay);
+    free(dst);
+
+    return true;
+}
+
 void drawBitmap(Image *image, int x, int y) {
+    fenceRect(g_buffer, x, y, x + image->width - 1, y + image->height - 1);
+
     uint32_t *dst = g_buffer + y * DISPLAY_WIDTH + x;
     int nlDst = DISPLAY_WIDTH - image->width;
 
@@ -642,6 +821,8 @@ void drawBitmap(Image *image, int x, int y) {
 void drawStr(const char *text, int textLength, int x, int y, int clip_x1, int clip_y1, int clip_x2, int clip_y2, gui::font::Font &font) {
     g_font = font;
 
+    fenceRect(g_buffer, clip_x1, clip_y1, clip_x2, clip_y2);
+
     if (textLength == -1) {
         char encoding;
         while ((encoding = *text++) != 0) {
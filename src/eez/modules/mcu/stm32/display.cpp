@@ -38,6 +38,7 @@
 
 #include <eez/gui/gui.h>
 #include <eez/modules/mcu/display.h>
+#include <eez/modules/mcu/dma2d_queue.h>
 
 #include <eez/modules/psu/psu.h>
 #include <eez/modules/psu/persist_conf.h>
@@ -69,8 +70,6 @@ static bool g_takeScreenshot;
 
 ////////////////////////////////////////////////////////////////////////////////
 
-#define DMA2D_WAIT while (HAL_DMA2D_PollForTransfer(&hdma2d, 1000) != HAL_OK)
-
 uint32_t vramOffset(uint16_t *vram, int x, int y) {
     return (uint32_t)(vram + y * DISPLAY_WIDTH + x);
 }
@@ -83,67 +82,53 @@ uint32_t vramOffset(uint32_t *vram, int x, int y) {
     return (uint32_t)(vram + y * DISPLAY_WIDTH + x);
 }
 
-void fillRect(uint16_t *dst, int x, int y, int width, int height, uint16_t color) {
-	if (g_opacity == 255) {
-		hdma2d.Init.Mode = DMA2D_R2M;
-		hdma2d.Init.ColorMode = DMA2D_OUTPUT_RGB565;
-		hdma2d.Init.OutputOffset = DISPLAY_WIDTH - width;
-
-		uint32_t colorBGRA;
-		uint8_t *pcolorBGRA = (uint8_t *)&colorBGRA;
-		pcolorBGRA[0] = COLOR_TO_B(color);
-		pcolorBGRA[1] = COLOR_TO_G(color);
-		pcolorBGRA[2] = COLOR_TO_R(color);
-		pcolorBGRA[3] = 255;
-
-		DMA2D_WAIT;
-		HAL_DMA2D_Init(&hdma2d);
-		HAL_DMA2D_Start(&hdma2d, colorBGRA, vramOffset(dst, x, y), width, height);
-	} else {
-		// fill aux. buffer with BGRA color
-		auto auxBuffer = (uint32_t *)VRAM_AUX_BUFFER9_START_ADDRESS;
-
-		hdma2d.Init.Mode = DMA2D_R2M;
-		hdma2d.Init.ColorMode = DMA2D_OUTPUT_ARGB8888;
-		hdma2d.Init.OutputOffset = DISPLAY_WIDTH - width;
-
-		uint32_t colorBGRA;
-		uint8_t *pcolorBGRA = (uint8_t *)&colorBGRA;
-		pcolorBGRA[0] = COLOR_TO_B(color);
-		pcolorBGRA[1] = COLOR_TO_G(color);
-		pcolorBGRA[2] = COLOR_TO_R(color);
-		pcolorBGRA[3] = g_opacity;
-
-		auto auxBufferOffset = vramOffset(auxBuffer, x, y);
-
-		DMA2D_WAIT;
-		HAL_DMA2D_Init(&hdma2d);
-		HAL_DMA2D_Start(&hdma2d, colorBGRA, auxBufferOffset, width, height);
-
-		// blend aux. buffer with dst buffer
-	    hdma2d.Init.Mode = DMA2D_M2M_BLEND;
-	    hdma2d.Init.ColorMode = DMA2D_OUTPUT_RGB565;
-	    hdma2d.Init.OutputOffset = DISPLAY_WIDTH - width;
-
-		hdma2d.LayerCfg[0].InputOffset = DISPLAY_WIDTH - width;
-		hdma2d.LayerCfg[0].InputColorMode = DMA2D_INPUT_RGB565;
-		hdma2d.LayerCfg[0].AlphaMode = DMA2D_NO_MODIF_ALPHA;
-		hdma2d.LayerCfg[0].InputAlpha = 0;
-
-		hdma2d.LayerCfg[1].InputOffset = DISPLAY_WIDTH - width;
-		hdma2d.LayerCfg[1].InputColorMode = DMA2D_INPUT_ARGB8888;
-		hdma2d.LayerCfg[1].AlphaMode = DMA2D_NO_MODIF_ALPHA;
-		hdma2d.LayerCfg[1].InputAlpha = 0;
-
-	    auto dstOffset = vramOffset(dst, x, y);
+static uint32_t colorToBGRA(uint16_t color, uint8_t opacity) {
+    uint32_t colorBGRA;
+    uint8_t *pcolorBGRA = (uint8_t *)&colorBGRA;
+    pcolorBGRA[0] = COLOR_TO_B(color);
+    pcolorBGRA[1] = COLOR_TO_G(color);
+    pcolorBGRA[2] = COLOR_TO_R(color);
+    pcolorBGRA[3] = opacity;
+    return colorBGRA;
+}
 
-	    DMA2D_WAIT;
+// command with RGB565 output to the display sized buffer
+static dma2d_queue::Command rgb565Command(uint8_t mode, void *dst, int width, int height) {
+    dma2d_queue::Command command;
+    memset(&command, 0, sizeof(command));
+    command.config.mode = mode;
+    command.config.outputColorMode = dma2d_queue::COLOR_MODE_RGB565;
+    command.dst = dst;
+    command.outputOffset = DISPLAY_WIDTH - width;
+    command.bgOffset = DISPLAY_WIDTH - width;
+    command.width = width;
+    command.height = height;
+    return command;
+}
 
-	    HAL_DMA2D_Init(&hdma2d);
-	    HAL_DMA2D_ConfigLayer(&hdma2d, 1);
-		HAL_DMA2D_ConfigLayer(&hdma2d, 0);
-		HAL_DMA2D_BlendingStart(&hdma2d, auxBufferOffset, dstOffset, dstOffset, width, height);
-	}
+void fillRect(uint16_t *dst, int x, int y, int width, int height, uint16_t color) {
+    if (g_opacity == 255) {
+        auto command = rgb565Command(dma2d_queue::MODE_FILL, (void *)vramOffset(dst, x, y), width, height);
+        command.color = colorToBGRA(color, 255);
+        dma2d_queue::enqueue(command);
+    } else {
+        // fill aux. buffer with BGRA color
+        auto auxBuffer = (uint32_t *)VRAM_AUX_BUFFER9_START_ADDRESS;
+        auto auxBufferOffset = (void *)vramOffset(auxBuffer, x, y);
+
+        auto command = rgb565Command(dma2d_queue::MODE_FILL, auxBufferOffset, width, height);
+        command.config.outputColorMode = dma2d_queue::COLOR_MODE_ARGB8888;
+        command.color = colorToBGRA(color, g_opacity);
+        dma2d_queue::enqueue(command);
+
+        // blend aux. buffer with dst buffer
+        command = rgb565Command(dma2d_queue::MODE_BLEND, (void *)vramOffset(dst, x, y), width, height);
+        command.config.fg.colorMode = dma2d_queue::COLOR_MODE_ARGB8888;
+        command.config.bg.colorMode = dma2d_queue::COLOR_MODE_RGB565;
+        command.src = auxBufferOffset;
+        command.fgOffset = DISPLAY_WIDTH - width;
+        dma2d_queue::enqueue(command);
+    }
 }
 
 void fillRect(void *dst, int x1, int y1, int x2, int y2) {
@@ -152,54 +137,25 @@ void fillRect(void *dst, int x1, int y1, int x2, int y2) {
 }
 
 void bitBlt(void *src, int srcBpp, uint32_t srcLineOffset, uint16_t *dst, int x, int y, int width, int height) {
-    hdma2d.Init.ColorMode = DMA2D_OUTPUT_RGB565;
-    hdma2d.Init.OutputOffset = DISPLAY_WIDTH - width;
+    dma2d_queue::Command command;
 
     if (srcBpp == 32) {
-        hdma2d.Init.Mode = DMA2D_M2M_BLEND;
-
-        hdma2d.LayerCfg[0].InputOffset = DISPLAY_WIDTH - width;
-        hdma2d.LayerCfg[0].InputColorMode = DMA2D_INPUT_RGB565;
-        hdma2d.LayerCfg[0].AlphaMode = DMA2D_NO_MODIF_ALPHA;
-        hdma2d.LayerCfg[0].InputAlpha = 0;
-
-        hdma2d.LayerCfg[1].InputOffset = srcLineOffset;
-        hdma2d.LayerCfg[1].InputColorMode = DMA2D_INPUT_ARGB8888;
-        hdma2d.LayerCfg[1].AlphaMode = DMA2D_NO_MODIF_ALPHA;
-        hdma2d.LayerCfg[1].InputAlpha = 0;
+        command = rgb565Command(dma2d_queue::MODE_BLEND, (void *)vramOffset(dst, x, y), width, height);
+        command.config.fg.colorMode = dma2d_queue::COLOR_MODE_ARGB8888;
+        command.config.bg.colorMode = dma2d_queue::COLOR_MODE_RGB565;
     } else if (srcBpp == 24) {
-    	hdma2d.Init.Mode = DMA2D_M2M_PFC;
-        hdma2d.Init.RedBlueSwap = DMA2D_RB_SWAP;
-
-        hdma2d.LayerCfg[1].InputOffset = srcLineOffset;
-        hdma2d.LayerCfg[1].InputColorMode = DMA2D_INPUT_RGB888;
-        hdma2d.LayerCfg[1].AlphaMode = DMA2D_NO_MODIF_ALPHA;
-        hdma2d.LayerCfg[1].InputAlpha = 0;
+        command = rgb565Command(dma2d_queue::MODE_CONVERT, (void *)vramOffset(dst, x, y), width, height);
+        command.config.redBlueSwap = 1;
+        command.config.fg.colorMode = dma2d_queue::COLOR_MODE_RGB888;
     } else {
-    	hdma2d.Init.Mode = DMA2D_M2M;
-
-        hdma2d.LayerCfg[1].InputOffset = srcLineOffset;
-        hdma2d.LayerCfg[1].InputColorMode = DMA2D_INPUT_RGB565;
-        hdma2d.LayerCfg[1].AlphaMode = DMA2D_NO_MODIF_ALPHA;
-        hdma2d.LayerCfg[1].InputAlpha = 0;
+        command = rgb565Command(dma2d_queue::MODE_COPY, (void *)vramOffset(dst, x, y), width, height);
+        command.config.fg.colorMode = dma2d_queue::COLOR_MODE_RGB565;
     }
 
-    auto dstOffset = vramOffset(dst, x, y);
+    command.src = src;
+    command.fgOffset = srcLineOffset;
 
-    DMA2D_WAIT;
-
-    HAL_DMA2D_Init(&hdma2d);
-    HAL_DMA2D_ConfigLayer(&hdma2d, 1);
-    if (srcBpp == 32) {
-        HAL_DMA2D_ConfigLayer(&hdma2d, 0);
-        HAL_DMA2D_BlendingStart(&hdma2d, (uint32_t)src, dstOffset, dstOffset, width, height);
-    } else {
-        HAL_DMA2D_Start(&hdma2d, (uint32_t)src, dstOffset, width, height);
-    }
-
-    if (srcBpp == 24) {
-        hdma2d.Init.RedBlueSwap = DMA2D_RB_REGULAR;
-    }
+    dma2d_queue::enqueue(command);
 }
 
 void bitBlt(void *src, int x1, int y1, int x2, int y2) {
@@ -208,40 +164,21 @@ void bitBlt(void *src, int x1, int y1, int x2, int y2) {
 }
 
 void bitBlt(uint16_t *src, uint16_t *dst, int x, int y, int width, int height) {
-    hdma2d.Init.Mode = DMA2D_M2M;
-    hdma2d.Init.ColorMode = DMA2D_OUTPUT_RGB565;
-    hdma2d.Init.OutputOffset = DISPLAY_WIDTH - width;
-
-    hdma2d.LayerCfg[1].InputOffset = DISPLAY_WIDTH - width;
-    hdma2d.LayerCfg[1].InputColorMode = DMA2D_INPUT_RGB565;
-    hdma2d.LayerCfg[1].AlphaMode = DMA2D_NO_MODIF_ALPHA;
-    hdma2d.LayerCfg[1].InputAlpha = 0;
-
-    DMA2D_WAIT;
-
-    HAL_DMA2D_Init(&hdma2d);
-    HAL_DMA2D_ConfigLayer(&hdma2d, 1);
-    HAL_DMA2D_Start(&hdma2d, vramOffset(src, x, y), vramOffset(dst, x, y), width, height);
+    auto command = rgb565Command(dma2d_queue::MODE_COPY, (void *)vramOffset(dst, x, y), width, height);
+    command.config.fg.colorMode = dma2d_queue::COLOR_MODE_RGB565;
+    command.src = (void *)vramOffset(src, x, y);
+    command.fgOffset = DISPLAY_WIDTH - width;
+    dma2d_queue::enqueue(command);
 }
 
 void bitBltRGB888(uint16_t *src, uint8_t *dst, int x, int y, int width, int height) {
-    hdma2d.Init.Mode = DMA2D_M2M_PFC;
-    hdma2d.Init.ColorMode = DMA2D_OUTPUT_RGB888;
-    hdma2d.Init.OutputOffset = DISPLAY_WIDTH - width;
-    hdma2d.Init.RedBlueSwap = DMA2D_RB_SWAP;
-
-    hdma2d.LayerCfg[1].InputOffset = DISPLAY_WIDTH - width;
-    hdma2d.LayerCfg[1].InputColorMode = DMA2D_INPUT_RGB565;
-    hdma2d.LayerCfg[1].AlphaMode = DMA2D_NO_MODIF_ALPHA;
-    hdma2d.LayerCfg[1].InputAlpha = 0;
-
-    DMA2D_WAIT;
-
-    HAL_DMA2D_Init(&hdma2d);
-    HAL_DMA2D_ConfigLayer(&hdma2d, 1);
-    HAL_DMA2D_Start(&hdma2d, vramOffset(src, x, y), vramOffsetRGB888(dst, x, y), width, height);
-
-    hdma2d.Init.RedBlueSwap = DMA2D_RB_REGULAR;
+    auto command = rgb565Command(dma2d_queue::MODE_CONVERT, (void *)vramOffsetRGB888(dst, x, y), width, height);
+    command.config.outputColorMode = dma2d_queue::COLOR_MODE_RGB888;
+    command.config.redBlueSwap = 1;
+    command.config.fg.colorMode = dma2d_queue::COLOR_MODE_RGB565;
+    command.src = (void *)vramOffset(src, x, y);
+    command.fgOffset = DISPLAY_WIDTH - width;
+    dma2d_queue::enqueue(command);
 }
 
 void bitBlt(void *src, void *dst, int x1, int y1, int x2, int y2) {
@@ -250,20 +187,11 @@ void bitBlt(void *src, void *dst, int x1, int y1, int x2, int y2) {
 }
 
 void bitBlt(uint16_t *src, uint16_t *dst, int x, int y, int width, int height, int dstx, int dsty) {
-    hdma2d.Init.Mode = DMA2D_M2M;
-    hdma2d.Init.ColorMode = DMA2D_OUTPUT_RGB565;
-    hdma2d.Init.OutputOffset = DISPLAY_WIDTH - width;
-
-    hdma2d.LayerCfg[1].InputOffset = DISPLAY_WIDTH - width;
-    hdma2d.LayerCfg[1].InputColorMode = DMA2D_INPUT_RGB565;
-    hdma2d.LayerCfg[1].AlphaMode = DMA2D_NO_MODIF_ALPHA;
-    hdma2d.LayerCfg[1].InputAlpha = 0;
-
-    DMA2D_WAIT;
-
-    HAL_DMA2D_Init(&hdma2d);
-    HAL_DMA2D_ConfigLayer(&hdma2d, 1);
-    HAL_DMA2D_Start(&hdma2d, vramOffset(src, x, y), vramOffset(dst, dstx, dsty), width, height);
+    auto command = rgb565Command(dma2d_queue::MODE_COPY, (void *)vramOffset(dst, dstx, dsty), width, height);
+    command.config.fg.colorMode = dma2d_queue::COLOR_MODE_RGB565;
+    command.src = (void *)vramOffset(src, x, y);
+    command.fgOffset = DISPLAY_WIDTH - width;
+    dma2d_queue::enqueue(command);
 }
 
 void bitBlt(void *src, void *dst, int sx, int sy, int sw, int sh, int dx, int dy, uint8_t opacity) {
@@ -271,93 +199,47 @@ void bitBlt(void *src, void *dst, int sx, int sy, int sw, int sh, int dx, int dy
         dst = g_buffer;
     }
 
-	auto srcOffset = vramOffset((uint16_t *)src, sx, sy);
-	auto dstOffset = vramOffset((uint16_t *)dst, dx, dy);
-
-	if (opacity == 255) {
-	    hdma2d.Init.Mode = DMA2D_M2M;
-	    hdma2d.Init.ColorMode = DMA2D_OUTPUT_RGB565;
-	    hdma2d.Init.OutputOffset = DISPLAY_WIDTH - sw;
-
-	    hdma2d.LayerCfg[1].InputOffset = DISPLAY_WIDTH - sw;
-	    hdma2d.LayerCfg[1].InputColorMode = DMA2D_INPUT_RGB565;
-	    hdma2d.LayerCfg[1].AlphaMode = DMA2D_NO_MODIF_ALPHA;
-	    hdma2d.LayerCfg[1].InputAlpha = 0;
-
-	    DMA2D_WAIT;
-
-	    HAL_DMA2D_Init(&hdma2d);
-	    HAL_DMA2D_ConfigLayer(&hdma2d, 1);
-	    HAL_DMA2D_Start(&hdma2d, srcOffset, dstOffset, sw, sh);
-	} else {
-		hdma2d.Init.Mode = DMA2D_M2M_BLEND;
-		hdma2d.Init.ColorMode = DMA2D_OUTPUT_RGB565;
-		hdma2d.Init.OutputOffset = DISPLAY_WIDTH - sw;
-
-		hdma2d.LayerCfg[0].InputOffset = DISPLAY_WIDTH - sw;
-		hdma2d.LayerCfg[0].InputColorMode = DMA2D_INPUT_RGB565;
-		hdma2d.LayerCfg[0].AlphaMode = DMA2D_COMBINE_ALPHA;
-		hdma2d.LayerCfg[0].InputAlpha = 0xFF;
-
-		hdma2d.LayerCfg[1].InputOffset = DISPLAY_WIDTH - sw;
-		hdma2d.LayerCfg[1].InputColorMode = DMA2D_INPUT_RGB565;
-		hdma2d.LayerCfg[1].AlphaMode = DMA2D_COMBINE_ALPHA;
-		hdma2d.LayerCfg[1].InputAlpha = opacity;
-
-		DMA2D_WAIT;
-
-		HAL_DMA2D_Init(&hdma2d);
-		HAL_DMA2D_ConfigLayer(&hdma2d, 1);
-		HAL_DMA2D_ConfigLayer(&hdma2d, 0);
-		HAL_DMA2D_BlendingStart(&hdma2d, srcOffset, dstOffset, dstOffset, sw, sh);
-	}
+    if (opacity == 255) {
+        bitBlt((uint16_t *)src, (uint16_t *)dst, sx, sy, sw, sh, dx, dy);
+    } else {
+        auto command = rgb565Command(dma2d_queue::MODE_BLEND, (void *)vramOffset((uint16_t *)dst, dx, dy), sw, sh);
+        command.config.fg.colorMode = dma2d_queue::COLOR_MODE_RGB565;
+        command.config.fg.alphaMode = dma2d_queue::ALPHA_MODE_COMBINE;
+        command.config.fg.alpha = opacity;
+        command.config.bg.colorMode = dma2d_queue::COLOR_MODE_RGB565;
+        command.config.bg.alphaMode = dma2d_queue::ALPHA_MODE_COMBINE;
+        command.config.bg.alpha = 0xFF;
+        command.src = (void *)vramOffset((uint16_t *)src, sx, sy);
+        command.fgOffset = DISPLAY_WIDTH - sw;
+        dma2d_queue::enqueue(command);
+    }
 }
 
-void bitBltA8Init(uint16_t color) {
-    // initialize everything except lineOffset
+static dma2d_queue::Command g_a8Command;
 
-    hdma2d.Init.Mode = DMA2D_M2M_BLEND;
-    hdma2d.Init.ColorMode = DMA2D_OUTPUT_RGB565;
-    hdma2d.Init.OutputOffset = 0;
+void bitBltA8Init(uint16_t color) {
+    // initialize everything except position and size, config is the same for all glyphs
+    memset(&g_a8Command, 0, sizeof(g_a8Command));
+    g_a8Command.config.mode = dma2d_queue::MODE_BLEND;
+    g_a8Command.config.outputColorMode = dma2d_queue::COLOR_MODE_RGB565;
 
     // background
-    hdma2d.LayerCfg[0].InputColorMode = DMA2D_INPUT_RGB565;
-    hdma2d.LayerCfg[0].AlphaMode = DMA2D_NO_MODIF_ALPHA;
-    hdma2d.LayerCfg[0].InputAlpha = 0;
-    hdma2d.LayerCfg[0].InputOffset = 0;
+    g_a8Command.config.bg.colorMode = dma2d_queue::COLOR_MODE_RGB565;
 
     // foreground
-    uint32_t colorBGRA;
-    uint8_t *pcolorBGRA = (uint8_t *)&colorBGRA;
-    pcolorBGRA[0] = COLOR_TO_B(color);
-    pcolorBGRA[1] = COLOR_TO_G(color);
-    pcolorBGRA[2] = COLOR_TO_R(color);
-    pcolorBGRA[3] = 255;
-
-    hdma2d.LayerCfg[1].InputColorMode = DMA2D_INPUT_A8;
-    hdma2d.LayerCfg[1].AlphaMode = DMA2D_NO_MODIF_ALPHA;
-    hdma2d.LayerCfg[1].InputAlpha = colorBGRA;
-    hdma2d.LayerCfg[1].InputOffset = 0;
-
-    DMA2D_WAIT;
-
-    HAL_DMA2D_Init(&hdma2d);
-    HAL_DMA2D_ConfigLayer(&hdma2d, 0);
-    HAL_DMA2D_ConfigLayer(&hdma2d, 1);
+    g_a8Command.config.fg.colorMode = dma2d_queue::COLOR_MODE_A8;
+    g_a8Command.config.fg.alpha = colorToBGRA(color, 255);
 }
 
 void bitBltA8(const uint8_t *src, uint32_t srcLineOffset, int x, int y, int width, int height) {
-    uint32_t lineOffset = DISPLAY_WIDTH - width;
-    uint32_t dst = vramOffset(g_buffer, x, y);
-
-    DMA2D_WAIT;
-
-    // initialize lineOffset
-    WRITE_REG(hdma2d.Instance->OOR, lineOffset);
-    WRITE_REG(hdma2d.Instance->BGOR, lineOffset);
-    WRITE_REG(hdma2d.Instance->FGOR, srcLineOffset);
-
-    HAL_DMA2D_BlendingStart(&hdma2d, (uint32_t)src, dst, dst, width, height);
+    g_a8Command.src = src;
+    g_a8Command.dst = (void *)vramOffset(g_buffer, x, y);
+    g_a8Command.outputOffset = DISPLAY_WIDTH - width;
+    g_a8Command.bgOffset = DISPLAY_WIDTH - width;
+    g_a8Command.fgOffset = srcLineOffset;
+    g_a8Command.width = width;
+    g_a8Command.height = height;
+    dma2d_queue::enqueue(g_a8Command);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -373,6 +255,7 @@ void setBufferPointer(void *buffer) {
 void turnOn() {
     if (g_displayState != ON && g_displayState != TURNING_ON) {
         __HAL_RCC_DMA2D_CLK_ENABLE();
+        dma2d_queue::init();
 
         // clear video RAM
         g_bufferOld = (uint16_t *)VRAM_BUFFER2_START_ADDRESS;
@@ -431,7 +314,7 @@ void animate() {
 
 		g_animationState.callback(t, g_bufferOld, g_buffer, g_animationBuffer);
 
-		DMA2D_WAIT;
+		dma2d_queue::fence();
 
 		// wait for VSYNC
 		while (!(LTDC->CDSR & LTDC_CDSR_VSYNCS));
@@ -463,6 +346,7 @@ void sync() {
     if (g_displayState == TURNING_OFF) {
         int32_t diff = millis() - g_displayStateTransitionStartTime;
         if (diff >= CONF_TURN_ON_OFF_ANIMATION_DURATION) {
+            dma2d_queue::fence();
             __HAL_RCC_DMA2D_CLK_DISABLE();
 
             // backlight off
@@ -489,7 +373,8 @@ void sync() {
         }
     }
 
-    DMA2D_WAIT;
+    // wait for all commands of this frame
+    dma2d_queue::fence();
 
     if (g_animationState.enabled) {
         animate();
@@ -509,7 +394,7 @@ void sync() {
 
     if (g_takeScreenshot) {
     	bitBltRGB888(g_bufferOld, SCREENSHOOT_BUFFER_START_ADDRESS, 0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT);
-        DMA2D_WAIT;
+        dma2d_queue::fence();
     	g_takeScreenshot = false;
     }
 }
@@ -595,16 +480,18 @@ static int8_t drawGlyph(int x1, int y1, int clip_x1, int clip_y1, int clip_x2, i
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void beginPixelDrawing(int x1, int y1, int x2, int y2) {
+    dma2d_queue::fence(g_buffer + y1 * DISPLAY_WIDTH + x1, g_buffer + y2 * DISPLAY_WIDTH + x2 + 1);
+}
+
 void drawPixel(int x, int y) {
-    DMA2D_WAIT;
-    *(g_buffer + y * DISPLAY_WIDTH + x) = g_fc;
+    auto dest = g_buffer + y * DISPLAY_WIDTH + x;
+    *dest = g_fc;
 
     markDirty(x, y, x, y);
 }
 
 void drawPixel(int x, int y, uint8_t opacity) {
-    DMA2D_WAIT;
-
     auto dest = g_buffer + y * DISPLAY_WIDTH + x;
     *dest = color32to16(
 		blendColor(
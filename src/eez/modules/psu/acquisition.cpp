@@ -0,0 +1,188 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2020-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <eez/memory.h>
+#include <eez/system.h>
+#include <eez/tasks.h>
+
+#include <eez/modules/psu/psu.h>
+#include <eez/modules/psu/acquisition.h>
+
+namespace eez {
+namespace psu {
+namespace acquisition {
+
+const uint32_t POINTS_MAX = ACQUISITION_BUFFER_SIZE / (CH_MAX * 2 * sizeof(float));
+
+// max. time waitCompleted can wait (ms), keeps millis() difference in range
+static const uint32_t MAX_WAIT_TIME = 0x7FFFFFFF;
+
+static struct {
+    volatile State state;
+
+    uint32_t points;
+    float interval;
+    trigger::Source triggerSource;
+
+    volatile uint32_t numPoints;
+    uint64_t lastPointTime; // micros64
+} g_acquisition[CH_MAX];
+
+static float *getVoltageBuffer(int channelIndex) {
+    return (float *)ACQUISITION_BUFFER + channelIndex * 2 * POINTS_MAX;
+}
+
+static float *getCurrentBuffer(int channelIndex) {
+    return getVoltageBuffer(channelIndex) + POINTS_MAX;
+}
+
+void reset() {
+    for (int i = 0; i < CH_MAX; i++) {
+        g_acquisition[i].state = STATE_IDLE;
+        g_acquisition[i].points = POINTS_DEFAULT;
+        g_acquisition[i].interval = INTERVAL_DEFAULT;
+        g_acquisition[i].triggerSource = trigger::SOURCE_IMMEDIATE;
+        g_acquisition[i].numPoints = 0;
+    }
+}
+
+void setPoints(Channel &channel, uint32_t points) {
+    g_acquisition[channel.channelIndex].points = points;
+}
+
+uint32_t getPoints(Channel &channel) {
+    return g_acquisition[channel.channelIndex].points;
+}
+
+void setInterval(Channel &channel, float interval) {
+    g_acquisition[channel.channelIndex].interval = interval;
+}
+
+float getInterval(Channel &channel) {
+    return g_acquisition[channel.channelIndex].interval;
+}
+
+void setTriggerSource(Channel &channel, trigger::Source source) {
+    g_acquisition[channel.channelIndex].triggerSource = source;
+}
+
+trigger::Source getTriggerSource(Channel &channel) {
+    return g_acquisition[channel.channelIndex].triggerSource;
+}
+
+void initiate(Channel &channel, bool immediate) {
+    auto &acquisition = g_acquisition[channel.channelIndex];
+
+    acquisition.state = STATE_IDLE;
+    acquisition.numPoints = 0;
+
+    if (immediate || acquisition.triggerSource == trigger::SOURCE_IMMEDIATE) {
+        acquisition.state = STATE_ACQUIRING;
+    } else {
+        acquisition.state = STATE_INITIATED;
+    }
+}
+
+void abort() {
+    for (int i = 0; i < CH_MAX; i++) {
+        if (g_acquisition[i].state != STATE_COMPLETED) {
+            g_acquisition[i].state = STATE_IDLE;
+        }
+    }
+}
+
+State getState(Channel &channel) {
+    return g_acquisition[channel.channelIndex].state;
+}
+
+bool onTrigger(trigger::Source source) {
+    bool triggered = false;
+    for (int i = 0; i < CH_NUM; i++) {
+        auto &acquisition = g_acquisition[i];
+        if (acquisition.state == STATE_INITIATED && acquisition.triggerSource == source) {
+            acquisition.state = STATE_ACQUIRING;
+            triggered = true;
+        }
+    }
+    return triggered;
+}
+
+void onMonValues(Channel &channel) {
+    auto &acquisition = g_acquisition[channel.channelIndex];
+    if (acquisition.state != STATE_ACQUIRING) {
+        return;
+    }
+
+    uint64_t tickCount = micros64();
+    uint64_t interval = (uint64_t)(acquisition.interval * 1000000.0);
+    if (acquisition.numPoints > 0 && tickCount - acquisition.lastPointTime < interval) {
+        return;
+    }
+
+    // next point is due one interval after this one was due, so the sampling doesn't drift
+    if (acquisition.numPoints > 0 && interval > 0) {
+        acquisition.lastPointTime += interval;
+    } else {
+        acquisition.lastPointTime = tickCount;
+    }
+
+    uint32_t i = acquisition.numPoints;
+    getVoltageBuffer(channel.channelIndex)[i] = channel.u.mon_last;
+    getCurrentBuffer(channel.channelIndex)[i] = channel.i.mon_last;
+    acquisition.numPoints = i + 1;
+
+    if (acquisition.numPoints == acquisition.points) {
+        acquisition.state = STATE_COMPLETED;
+    }
+}
+
+bool waitCompleted(Channel &channel) {
+    auto &acquisition = g_acquisition[channel.channelIndex];
+
+    if (acquisition.state == STATE_ACQUIRING) {
+        // wait for the remaining points, plus one second for the ADC to deliver them
+        double remainingTime = (acquisition.points - acquisition.numPoints) * (double)acquisition.interval * 1000.0 + 1000.0;
+        uint32_t timeout = remainingTime < MAX_WAIT_TIME ? (uint32_t)remainingTime : MAX_WAIT_TIME;
+        uint32_t startTime = millis();
+        while (acquisition.state == STATE_ACQUIRING) {
+            if (millis() - startTime > timeout) {
+                break;
+            }
+            // points are taken in the PSU thread
+            delayWithoutIoLock(1);
+        }
+    }
+
+    return acquisition.state == STATE_COMPLETED;
+}
+
+uint32_t getNumPoints(Channel &channel) {
+    return g_acquisition[channel.channelIndex].numPoints;
+}
+
+const float *getVoltageData(Channel &channel) {
+    return getVoltageBuffer(channel.channelIndex);
+}
+
+const float *getCurrentData(Channel &channel) {
+    return getCurrentBuffer(channel.channelIndex);
+}
+
+} // namespace acquisition
+} // namespace psu
+} // namespace eez
@@ -0,0 +1,80 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2020-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+ 
+#pragma once
+
+#include <eez/modules/psu/trigger.h>
+
+namespace eez {
+namespace psu {
+namespace acquisition {
+
+// Waveform capture of the voltage and current monitor values (MEAS:ARR? / FETC:ARR?).
+// Points are taken in the PSU thread directly from the ADC path.
+
+static const uint32_t POINTS_MIN = 1;
+extern const uint32_t POINTS_MAX;
+static const uint32_t POINTS_DEFAULT = 1024;
+
+static const float INTERVAL_MIN = 0.0f; // take every ADC sample
+static const float INTERVAL_MAX = 3600.0f;
+static const float INTERVAL_DEFAULT = 0.0f;
+
+enum State {
+    STATE_IDLE,
+    STATE_INITIATED, // waiting for trigger
+    STATE_ACQUIRING,
+    STATE_COMPLETED
+};
+
+void reset();
+
+void setPoints(Channel &channel, uint32_t points);
+uint32_t getPoints(Channel &channel);
+
+void setInterval(Channel &channel, float interval);
+float getInterval(Channel &channel);
+
+void setTriggerSource(Channel &channel, trigger::Source source);
+trigger::Source getTriggerSource(Channel &channel);
+
+// Acquisition is waiting for the trigger source set for the channel, unless immediate is requested.
+void initiate(Channel &channel, bool immediate = false);
+void abort();
+
+State getState(Channel &channel);
+
+// Called by trigger module, returns true if some acquisition was waiting for this trigger.
+bool onTrigger(trigger::Source source);
+
+// Called from the PSU thread every time new pair of U and I monitor values is available.
+void onMonValues(Channel &channel);
+
+// Waits until acquisition is completed, but only if it is already running.
+// I/O lock, if held by the caller, is released while waiting.
+// Returns false if there is no completed acquisition.
+bool waitCompleted(Channel &channel);
+
+// Returns acquired points, valid only when state is STATE_COMPLETED.
+uint32_t getNumPoints(Channel &channel);
+const float *getVoltageData(Channel &channel);
+const float *getCurrentData(Channel &channel);
+
+} // namespace acquisition
+} // namespace psu
+} // namespace eez
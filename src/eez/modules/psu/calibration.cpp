@@ -429,6 +429,8 @@ bool save() {
         memcpy(&g_channel->cal_conf.i[1], &g_currents[1].configuration, sizeof(Channel::CalibrationValueConfiguration));
     }
 
+    g_channel->updateCalibrationTables();
+
     // TODO move this to scpi thread
     return persist_conf::saveChannelCalibration(*g_channel);
 }
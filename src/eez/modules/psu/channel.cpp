@@ -24,6 +24,7 @@
 
 #include <eez/firmware.h>
 #include <eez/system.h>
+#include <eez/modules/psu/acquisition.h>
 #include <eez/modules/psu/board.h>
 #include <eez/modules/psu/calibration.h>
 #include <eez/modules/psu/channel_dispatcher.h>
@@ -33,6 +34,7 @@
 #include <eez/modules/psu/ontime.h>
 #include <eez/modules/psu/persist_conf.h>
 #include <eez/modules/psu/profile.h>
+#include <eez/modules/psu/protection.h>
 #include <eez/modules/psu/ramp.h>
 #include <eez/modules/psu/trigger.h>
 #include <eez/scpi/regs.h>
@@ -48,10 +50,93 @@ using namespace scpi;
 
 namespace psu {
 
+static const float MON_FILTER_SCALE = 1E6f; // 1 uV or 1 uA
+
+// integer division rounded half away from zero, so negative values are not biased
+static inline int64_t divRound(int64_t a, int64_t b) {
+    return a >= 0 ? (a + b / 2) / b : (a - b / 2) / b;
+}
+
+void Channel::MonFilter::init(MonFilterType type_, uint8_t count_) {
+    type = type_;
+    count = count_;
+    reset();
+}
+
+void Channel::MonFilter::reset() {
+    empty = true;
+}
+
+float Channel::MonFilter::add(float value) {
+    int32_t x = (int32_t)roundf(value * MON_FILTER_SCALE);
+
+    if (empty) {
+        empty = false;
+        index = 0;
+        for (int i = 0; i < count; ++i) {
+            values[i] = x;
+            sorted[i] = x;
+        }
+        total = (int64_t)count * x;
+        return value;
+    }
+
+    if (type == MON_FILTER_TYPE_EXPONENTIAL) {
+        // total is value multiplied by count, i.e. alpha is 1 / count
+        total += x - divRound(total, count);
+        return divRound(total, count) / MON_FILTER_SCALE;
+    }
+
+    int32_t old = values[index];
+    values[index] = x;
+    index = (index + 1) % count;
+
+    if (type == MON_FILTER_TYPE_MEDIAN) {
+        // remove old value and insert new one, sorted order is preserved
+        int i = 0;
+        while (i < count && sorted[i] != old) {
+            ++i;
+        }
+        if (i < count) {
+            while (i > 0 && sorted[i - 1] > x) {
+                sorted[i] = sorted[i - 1];
+                --i;
+            }
+            while (i < count - 1 && sorted[i + 1] < x) {
+                sorted[i] = sorted[i + 1];
+                ++i;
+            }
+            sorted[i] = x;
+        } else {
+            // sorted window is out of sync with the values, sort it again
+            for (int j = 0; j < count; ++j) {
+                int32_t v = values[j];
+                int k = j;
+                while (k > 0 && sorted[k - 1] > v) {
+                    sorted[k] = sorted[k - 1];
+                    --k;
+                }
+                sorted[k] = v;
+            }
+        }
+
+        if (count % 2) {
+            return sorted[count / 2] / MON_FILTER_SCALE;
+        }
+        return divRound((int64_t)sorted[count / 2 - 1] + sorted[count / 2], 2) / MON_FILTER_SCALE;
+    }
+
+    total += x - old;
+    return divRound(total, count) / MON_FILTER_SCALE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void Channel::Value::init(float set_, float step_, float limit_) {
     set = set_;
     step = step_;
     limit = limit_;
+    mon_filter.init(MON_FILTER_TYPE_BOXCAR, NUM_ADC_AVERAGING_VALUES);
     resetMonValues();
 }
 
@@ -61,39 +146,31 @@ void Channel::Value::resetMonValues() {
     mon_last = 0;
     mon_dac = 0;
 
-    mon_index = -1;
+    mon_filter.reset();
     mon_dac_index = -1;
 
     mon_measured = false;
 }
 
-void Channel::Value::addMonValue(float value, float prec) {
+void Channel::Value::addMonValue(float value, float filteredValue, float prec) {
     if (io_pins::isInhibited()) {
         value = 0;
+        // start filtering from scratch when inhibit is released
+        mon_filter.reset();
     }
     
     mon_last = roundPrec(value, prec);
 
-    if (mon_index == -1) {
-        mon_index = 0;
-        for (int i = 0; i < NUM_ADC_AVERAGING_VALUES; ++i) {
-            mon_arr[i] = value;
-        }
-        mon_total = NUM_ADC_AVERAGING_VALUES * value;
+    if (!mon_measured) {
         mon = mon_last;
         mon_prev = mon_last;
     } else {
-        mon_total -= mon_arr[mon_index];
-        mon_total += value;
-        mon_arr[mon_index] = value;
-        mon_index = (mon_index + 1) % NUM_ADC_AVERAGING_VALUES;
-
         if (io_pins::isInhibited()) {
             mon = 0;
             mon_prev = 0;
         } else {
 #if defined(EEZ_PLATFORM_STM32)
-            float mon_next = mon_total / NUM_ADC_AVERAGING_VALUES;
+            float mon_next = filteredValue;
             if (fabs(mon_prev - mon_next) >= prec) {
                 mon = roundPrec(mon_next, prec);
                 mon_prev = mon_next;
@@ -101,7 +178,7 @@ void Channel::Value::addMonValue(float value, float prec) {
 #endif
             
 #if defined(EEZ_PLATFORM_SIMULATOR)
-            float mon_next = roundPrec(mon_total / NUM_ADC_AVERAGING_VALUES, prec);
+            float mon_next = roundPrec(filteredValue, prec);
             mon = mon_next;
             mon_prev = mon_next;
 #endif
@@ -137,9 +214,9 @@ void Channel::Value::addMonDacValue(float value, float prec) {
 #endif
         
 #if defined(EEZ_PLATFORM_SIMULATOR)
-        float mon_next = roundPrec(mon_total / NUM_ADC_AVERAGING_VALUES, prec);
-        mon = mon_next;
-        mon_prev = mon_next;
+        float mon_dac_next = roundPrec(mon_dac_total / NUM_ADC_AVERAGING_VALUES, prec);
+        mon_dac = mon_dac_next;
+        mon_dac_prev = mon_dac_next;
 #endif
     }
 }
@@ -484,36 +561,12 @@ float Channel::getSwOvpProtectionLevel() {
     return channel_dispatcher::getUProtectionLevel(*this);
 }
 
-bool Channel::checkSwOvpCondition() {
-    float uProtectionLevel = getSwOvpProtectionLevel();
-    return channel_dispatcher::getUMonLast(*this) > uProtectionLevel || (flags.rprogEnabled && channel_dispatcher::getUMonDacLast(*this) > uProtectionLevel);
-}
-
-void Channel::protectionCheck(ProtectionValue &cpv) {
-    bool state;
-    bool condition;
-    float delay;
-
-    if (IS_OVP_VALUE(this, cpv)) {
-        state = (flags.rprogEnabled || prot_conf.flags.u_state) && !((params.features & CH_FEATURE_HW_OVP) && prot_conf.flags.u_type && !prot_conf.flags.u_hwOvpDeactivated);
-        condition = checkSwOvpCondition();
-        delay = prot_conf.u_delay;
-        delay -= PROT_DELAY_CORRECTION;
-    } else if (IS_OCP_VALUE(this, cpv)) {
-        state = prot_conf.flags.i_state;
-        condition = channel_dispatcher::getIMonLast(*this) >= channel_dispatcher::getISet(*this);
-        delay = prot_conf.i_delay;
-        delay -= PROT_DELAY_CORRECTION;
-    } else {
-        state = prot_conf.flags.p_state;
-        condition = channel_dispatcher::getUMonLast(*this) * channel_dispatcher::getIMonLast(*this) > channel_dispatcher::getPowerProtectionLevel(*this);
-        delay = prot_conf.p_delay;
-    }
-
-    if (state && isOutputEnabled() && condition) {
+void Channel::protectionCheck(ProtectionValue &cpv, bool condition, uint32_t delay) {
+    // output is checked each time, because it is disabled if previous protection is tripped
+    if (condition && isOutputEnabled()) {
         if (delay > 0) {
             if (cpv.flags.alarmed) {
-                if (micros() - cpv.alarm_started >= delay * 1000000UL) {
+                if (micros() - cpv.alarm_started >= delay) {
                     cpv.flags.alarmed = 0;
                     protectionEnter(cpv, false);
                 }
@@ -542,6 +595,7 @@ void Channel::reset() {
     flags.outputEnabled = 0;
     flags.senseEnabled = 0;
     flags.rprogEnabled = 0;
+    protection::invalidate();
 
     flags.cvMode = 0;
     flags.ccMode = 0;
@@ -615,6 +669,10 @@ void Channel::reset() {
 
     outputDelayDuration = 0;
 
+    // [SENS[n]]:AVER:TYPE BOXCar
+    // [SENS[n]]:AVER:COUN 10
+    setMonFilter(MON_FILTER_TYPE_BOXCAR, NUM_ADC_AVERAGING_VALUES);
+
 #ifdef EEZ_PLATFORM_SIMULATOR
     simulator.setLoadEnabled(false);
     simulator.load = 10;
@@ -647,6 +705,84 @@ void Channel::clearCalibrationConf() {
     
     cal_conf.calibrationDate = 0;
     strcpy(cal_conf.calibrationRemark, CALIBRATION_REMARK_INIT);
+
+    updateCalibrationTables();
+}
+
+void Channel::updateCalibrationTables() {
+    calTablesU.toDac.build(cal_conf.u, false);
+    calTablesU.fromAdc.build(cal_conf.u, true);
+    for (int i = 0; i < 2; i++) {
+        calTablesI[i].toDac.build(cal_conf.i[i], false);
+        calTablesI[i].fromAdc.build(cal_conf.i[i], true);
+    }
+}
+
+void Channel::CalibrationTable::build(const CalibrationValueConfiguration &cal, bool fromAdc) {
+    if (cal.numPoints < 2 || cal.numPoints > MAX_CALIBRATION_POINTS) {
+        numSegments = 0;
+        return;
+    }
+
+    numSegments = cal.numPoints - 1;
+
+    for (unsigned int i = 0; i < numSegments; i++) {
+        float x1 = fromAdc ? cal.points[i].adc : cal.points[i].value;
+        float y1 = fromAdc ? cal.points[i].value : cal.points[i].dac;
+        float x2 = fromAdc ? cal.points[i + 1].adc : cal.points[i + 1].value;
+        float y2 = fromAdc ? cal.points[i + 1].value : cal.points[i + 1].dac;
+
+        if (x1 == x2) {
+            // value is not remapped
+            segments[i].x1 = 0;
+            segments[i].y1 = 0;
+            segments[i].slope = 1.0f;
+        } else {
+            segments[i].x1 = x1;
+            segments[i].y1 = y1;
+            segments[i].slope = (y2 - y1) / (x2 - x1);
+        }
+
+        if (i > 0) {
+            breakpoints[i - 1] = x1;
+        }
+    }
+
+    sorted = true;
+    for (unsigned int i = 1; i + 1 < numSegments; i++) {
+        if (!(breakpoints[i - 1] <= breakpoints[i])) {
+            sorted = false;
+            break;
+        }
+    }
+}
+
+float Channel::CalibrationTable::remap(float x) const {
+    if (numSegments == 0) {
+        return x;
+    }
+
+    unsigned int i;
+    if (sorted) {
+        // number of breakpoints less than x
+        unsigned int lo = 0;
+        unsigned int hi = numSegments - 1;
+        while (lo < hi) {
+            unsigned int mid = (lo + hi) / 2;
+            if (x > breakpoints[mid]) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        i = lo;
+    } else {
+        for (i = 0; i < numSegments - 1 && x > breakpoints[i]; i++) {
+        }
+    }
+
+    const Segment &segment = segments[i];
+    return segment.y1 + (x - segment.x1) * segment.slope;
 }
 
 void Channel::clearProtectionConf() {
@@ -668,6 +804,8 @@ void Channel::clearProtectionConf() {
     temperature::sensors[temp_sensor::CH1 + channelIndex].prot_conf.state = OTP_CH_DEFAULT_STATE;
     temperature::sensors[temp_sensor::CH1 + channelIndex].prot_conf.level = OTP_CH_DEFAULT_LEVEL;
     temperature::sensors[temp_sensor::CH1 + channelIndex].prot_conf.delay = OTP_CH_DEFAULT_DELAY;
+
+    protection::invalidate();
 }
 
 bool Channel::isPowerOk() {
@@ -829,19 +967,19 @@ float remapValue(float value, Channel::CalibrationValueConfiguration &cal) {
         cal.points[j].dac);
 }
 
+// Sample is remapped only once, filter is applied to the calibrated value.
 void Channel::addUMonAdcValue(float value) {
     if (isVoltageCalibrationEnabled()) {
-        value = remapAdcValue(value, cal_conf.u);
+        value = calTablesU.fromAdc.remap(value);
     }
-    u.addMonValue(value, getVoltageResolution());
+    u.addMonValue(value, u.mon_filter.add(value), getVoltageResolution());
 }
 
 void Channel::addIMonAdcValue(float value) {
     if (isCurrentCalibrationEnabled()) {
-        value = remapAdcValue(value, cal_conf.i[flags.currentCurrentRange]);
+        value = calTablesI[flags.currentCurrentRange].fromAdc.remap(value);
     }
-
-    i.addMonValue(value, getCurrentResolution());
+    i.addMonValue(value, i.mon_filter.add(value), getCurrentResolution());
 }
 
 void Channel::addUMonDacAdcValue(float value) {
@@ -860,6 +998,7 @@ void Channel::onAdcData(AdcDataType adcDataType, float value) {
 
     case ADC_DATA_TYPE_I_MON:
         addIMonAdcValue(value);
+        acquisition::onMonValues(*this);
         break;
 
     case ADC_DATA_TYPE_U_MON_DAC:
@@ -893,9 +1032,29 @@ void Channel::setCvMode(bool cv_mode) {
 }
 
 void Channel::protectionCheck() {
-    protectionCheck(ovp);
-    protectionCheck(ocp);
-    protectionCheck(opp);
+#ifdef DEBUG
+    uint32_t startTime = micros();
+#endif
+
+    const protection::Levels &levels = protection::getLevels(*this);
+
+    if (levels.enabled && isOutputEnabled()) {
+        float uMon = channel_dispatcher::getUMonLast(*this);
+        float iMon = channel_dispatcher::getIMonLast(*this);
+        float uMonDac = levels.rprog ? channel_dispatcher::getUMonDacLast(*this) : 0;
+
+        protectionCheck(ovp, protection::isOvpCondition(levels, uMon, uMonDac), levels.uDelay);
+        protectionCheck(ocp, protection::isOcpCondition(levels, iMon), levels.iDelay);
+        protectionCheck(opp, protection::isOppCondition(levels, uMon, iMon), levels.pDelay);
+    } else {
+        ovp.flags.alarmed = 0;
+        ocp.flags.alarmed = 0;
+        opp.flags.alarmed = 0;
+    }
+
+#ifdef DEBUG
+    protection::onCheckDone(*this, startTime);
+#endif
 }
 
 void Channel::updateAllChannels() {
@@ -1097,6 +1256,7 @@ void Channel::doRemoteProgrammingEnable(bool enable) {
     }
 
     flags.rprogEnabled = enable;
+    protection::invalidate();
 
     if (enable) {
     	channel_dispatcher::setVoltageLimit(*this, channel_dispatcher::getUMaxOvpLimit(*this));
@@ -1116,7 +1276,7 @@ void Channel::doRemoteProgrammingEnable(bool enable) {
     setOperBits(OPER_ISUM_RPROG_ON, enable);
 }
 
-bool Channel::isOutputEnabled() {
+bool Channel::isOutputEnabled() const {
     return isPowerUp() && flags.outputEnabled;
 }
 
@@ -1185,7 +1345,7 @@ bool Channel::isRemoteProgrammingEnabled() {
 
 float Channel::getCalibratedVoltage(float value) {
     if (isVoltageCalibrationEnabled()) {
-        value = remapValue(value, cal_conf.u);
+        value = calTablesU.toDac.remap(value);
     }
 
 #if !defined(EEZ_PLATFORM_SIMULATOR)
@@ -1203,6 +1363,8 @@ void Channel::doSetVoltage(float value) {
         prot_conf.u_level = u.set;
     }
 
+    protection::invalidate();
+
 	value = getCalibratedVoltage(value);
 
     setDacVoltageFloat(value);
@@ -1232,8 +1394,10 @@ void Channel::doSetCurrent(float value) {
     i.set = value;
     i.mon_dac = 0;
 
+    protection::invalidate();
+
     if (isCurrentCalibrationEnabled()) {
-        value = remapValue(value, cal_conf.i[flags.currentCurrentRange]);
+        value = calTablesI[flags.currentCurrentRange].toDac.remap(value);
     }
 
     value += getDualRangeGndOffset();
@@ -1303,6 +1467,7 @@ void Channel::disableProtection() {
         prot_conf.flags.i_state = 0;
         prot_conf.flags.p_state = 0;
         temperature::disableChannelProtection(this);
+        protection::invalidate();
     }
 }
 
@@ -1516,6 +1681,23 @@ void Channel::enableAutoSelectCurrentRange(bool enable) {
     }
 }
 
+void Channel::setMonFilter(MonFilterType type, uint8_t count) {
+    monFilterType = type;
+    monFilterCount = count;
+
+    // filter is used by the PSU thread on every ADC sample
+    if (!isPsuThread()) {
+        sendMessageToPsu(PSU_MESSAGE_SET_MON_FILTER, channelIndex);
+    } else {
+        setMonFilterInPsuThread();
+    }
+}
+
+void Channel::setMonFilterInPsuThread() {
+    u.mon_filter.init(monFilterType, monFilterCount);
+    i.mon_filter.init(monFilterType, monFilterCount);
+}
+
 float Channel::getDualRangeMax() {
     return flags.currentCurrentRange == CURRENT_RANGE_LOW ? (params.I_MAX / 100) : params.I_MAX;
 }
@@ -64,6 +64,12 @@ enum CurrentRangeSelectionMode {
 
 enum CurrentRange { CURRENT_RANGE_HIGH, CURRENT_RANGE_LOW };
 
+enum MonFilterType {
+    MON_FILTER_TYPE_BOXCAR,
+    MON_FILTER_TYPE_EXPONENTIAL,
+    MON_FILTER_TYPE_MEDIAN
+};
+
 enum VoltageProtectionType {
     VOLTAGE_PROTECTION_TYPE_HW = 1,
     VOLTAGE_PROTECTION_TYPE_SW = 0
@@ -250,6 +256,34 @@ public:
         char calibrationRemark[CALIBRATION_REMARK_MAX_LENGTH + 1];
     };
 
+    /// Calibration value configuration compiled for one direction (value to DAC or ADC to value).
+    /// Segment is found with the binary search over inner calibration points and
+    /// remapped value is `y1 + (x - x1) * slope`, so there is no division in the hot path.
+    struct CalibrationTable {
+        struct Segment {
+            float x1;
+            float y1;
+            float slope;
+        };
+
+        /// Number of segments, i.e. number of calibration points - 1.
+        unsigned int numSegments;
+        /// False if inner points are not in ascending order, then segment is found
+        /// with the linear search (same as remapValue and remapAdcValue).
+        bool sorted;
+        /// Inner calibration points, segment i is used for x <= breakpoints[i].
+        float breakpoints[MAX_CALIBRATION_POINTS - 2];
+        Segment segments[MAX_CALIBRATION_POINTS - 1];
+
+        void build(const CalibrationValueConfiguration &cal, bool fromAdc);
+        float remap(float x) const;
+    };
+
+    struct CalibrationValueTables {
+        CalibrationTable toDac;
+        CalibrationTable fromAdc;
+    };
+
     /// Binary flags for the channel protection configuration
     struct ProtectionConfigurationFlags {
         /// Is OVP enabled?
@@ -303,6 +337,24 @@ public:
         unsigned dprogState: 2;
     };
 
+    /// Filter of the measured values. It works with calibrated values converted
+    /// to fixed point integers, so running total doesn't drift. Averages are
+    /// rounded half away from zero, so negative values are not biased.
+    struct MonFilter {
+        MonFilterType type;
+        uint8_t count;
+
+        bool empty;
+        uint8_t index;
+        int32_t values[MON_FILTER_MAX_COUNT]; // circular buffer of the last count values
+        int32_t sorted[MON_FILTER_MAX_COUNT]; // same values sorted, used by median filter
+        int64_t total;
+
+        void init(MonFilterType type_, uint8_t count_);
+        void reset();
+        float add(float value);
+    };
+
     /// Voltage and current data set and measured during runtime.
     struct Value {
         float set;
@@ -317,9 +369,7 @@ public:
 
         // used for calculating average value
         float mon_prev;
-        int8_t mon_index;
-        float mon_arr[NUM_ADC_AVERAGING_VALUES];
-        float mon_total;
+        MonFilter mon_filter;
 
         float mon_dac;
         float mon_dac_prev;
@@ -341,7 +391,7 @@ public:
         void init(float set_, float step_, float limit_);
         void resetMonValues();
         void addMonDacValue(float value, float precision);
-        void addMonValue(float value, float precision);
+        void addMonValue(float value, float filteredValue, float precision);
     };
 
 #ifdef EEZ_PLATFORM_SIMULATOR
@@ -412,6 +462,8 @@ public:
     float p_limit;
 
     CalibrationConfiguration cal_conf;
+    CalibrationValueTables calTablesU;
+    CalibrationValueTables calTablesI[2];
     ChannelProtectionConfiguration prot_conf;
 
     ProtectionValue ovp;
@@ -422,6 +474,11 @@ public:
 
     float outputDelayDuration;
 
+    /// Filter selected by SENSe:AVERage, it is applied to u.mon_filter
+    /// and i.mon_filter inside the PSU thread.
+    MonFilterType monFilterType;
+    uint8_t monFilterCount;
+
 #ifdef EEZ_PLATFORM_SIMULATOR
     Simulator simulator;
 #endif // EEZ_PLATFORM_SIMULATOR
@@ -433,6 +490,9 @@ public:
     /// Clear channel calibration configuration.
     void clearCalibrationConf();
 
+    /// Rebuild calibration tables, must be called every time cal_conf is changed.
+    void updateCalibrationTables();
+
     /// Is channel power ok (state of PWRGOOD bit in IO Expander)?
     bool isPowerOk();
 
@@ -454,7 +514,7 @@ public:
     static void updateAllChannels();
 
     /// Is channel output enabled?
-    bool isOutputEnabled();
+    bool isOutputEnabled() const;
 
     static void syncOutputEnable();
 
@@ -503,6 +563,9 @@ public:
     /// Disable protection for this channel
     void disableProtection();
 
+    /// Software OVP level, depends on OVP type.
+    float getSwOvpProtectionLevel();
+
     /// Turn on/off bit in SCPI Questinable Instrument Isummary register for this channel.
     void setQuesBits(int bit_mask, bool on);
 
@@ -594,6 +657,15 @@ public:
     bool isAutoSelectCurrentRangeEnabled() {
         return flags.autoSelectCurrentRange ? true : false;
     }
+
+    void setMonFilter(MonFilterType type, uint8_t count);
+    void setMonFilterInPsuThread();
+    MonFilterType getMonFilterType() {
+        return monFilterType;
+    }
+    uint8_t getMonFilterCount() {
+        return monFilterCount;
+    }
     float getDualRangeMax();
     void setCurrentRange(uint8_t currentRange);
 
@@ -720,12 +792,9 @@ private:
     static float getChannel5HistoryValue(uint32_t rowIndex, uint8_t columnIndex, float *max);
 
     void clearProtectionConf();
-    void protectionCheck(ProtectionValue &cpv);
+    void protectionCheck(ProtectionValue &cpv, bool condition, uint32_t delay);
     void protectionCheck();
 
-    bool checkSwOvpCondition();
-    float getSwOvpProtectionLevel();
-
     void doCalibrationEnable(bool enable);
     bool isVoltageCalibrationEnabled();
     bool isCurrentCalibrationEnabled();
@@ -755,5 +824,9 @@ private:
 
 extern int g_errorChannelIndex;
 
+// Remap using calibration points directly, Channel uses CalibrationTable built from the same points.
+float remapAdcValue(float value, Channel::CalibrationValueConfiguration &cal);
+float remapValue(float value, Channel::CalibrationValueConfiguration &cal);
+
 } // namespace psu
 } // namespace eez
@@ -18,12 +18,14 @@
 
 #include <float.h>
 #include <assert.h>
+#include <string.h>
 
 #include <eez/modules/psu/psu.h>
 #include <eez/modules/psu/calibration.h>
 #include <eez/modules/psu/channel_dispatcher.h>
 #include <eez/modules/psu/event_queue.h>
 #include <eez/modules/psu/list_program.h>
+#include <eez/modules/psu/protection.h>
 #include <eez/modules/psu/gui/psu.h>
 #include <eez/scpi/regs.h>
 #include <eez/modules/psu/temperature.h>
@@ -38,6 +40,65 @@ namespace channel_dispatcher {
 
 static CouplingType g_couplingType = COUPLING_TYPE_NONE;
 
+// Precomputed per channel dispatch, so hot getters and setters (called by GUI for
+// every displayed value and by SCPI) don't have to check coupling type and
+// tracking flags of all channels on each call. All zero plan means channel is
+// neither coupled nor tracked, so static initialization is already valid.
+struct DispatchPlan {
+    // channels to which set value is dispatched, 0 means channel itself
+    uint8_t numTargets;
+    uint8_t targets[CH_MAX];
+    // voltage is split among targets and summed when monitored (series)
+    unsigned uSplit : 1;
+    // current is split among targets and summed when monitored (parallel)
+    unsigned iSplit : 1;
+    // power is split among targets and summed (series and parallel)
+    unsigned pSplit : 1;
+    // set value is rounded to precision of all tracking channels
+    unsigned tracking : 1;
+};
+
+static DispatchPlan g_dispatchPlans[CH_MAX];
+
+static uint8_t g_trackingChannels[CH_MAX];
+static uint8_t g_numTrackingChannels;
+
+void updateDispatchPlans() {
+    uint8_t numTrackingChannels = 0;
+    for (int i = 0; i < CH_NUM; i++) {
+        if (Channel::get(i).flags.trackingEnabled) {
+            g_trackingChannels[numTrackingChannels++] = i;
+        }
+    }
+    g_numTrackingChannels = numTrackingChannels;
+
+    bool coupled = g_couplingType == COUPLING_TYPE_SERIES || g_couplingType == COUPLING_TYPE_PARALLEL;
+
+    for (int i = 0; i < CH_MAX; i++) {
+        DispatchPlan plan;
+        memset(&plan, 0, sizeof(plan));
+
+        if (i < CH_NUM) {
+            if (i < 2 && coupled) {
+                plan.numTargets = 2;
+                plan.targets[0] = 0;
+                plan.targets[1] = 1;
+                plan.uSplit = g_couplingType == COUPLING_TYPE_SERIES ? 1 : 0;
+                plan.iSplit = g_couplingType == COUPLING_TYPE_PARALLEL ? 1 : 0;
+                plan.pSplit = 1;
+            } else if (Channel::get(i).flags.trackingEnabled) {
+                plan.numTargets = numTrackingChannels;
+                memcpy(plan.targets, g_trackingChannels, numTrackingChannels);
+                plan.tracking = 1;
+            }
+        }
+
+        g_dispatchPlans[i] = plan;
+    }
+
+    protection::invalidate();
+}
+
 CouplingType getCouplingType() {
     return g_couplingType;
 }
@@ -222,6 +283,7 @@ void setCouplingTypeInPsuThread(CouplingType couplingType) {
     }
 
     g_couplingType = couplingType;
+    updateDispatchPlans();
     bp3c::io_exp::switchChannelCoupling(g_couplingType);
 
     if (g_couplingType == COUPLING_TYPE_PARALLEL) {
@@ -258,6 +320,8 @@ void setTrackingChannels(uint16_t trackingEnabled) {
             }
         }
 
+        updateDispatchPlans();
+
         if (resetTrackingChannels) {
             event_queue::pushEvent(event_queue::EVENT_INFO_CHANNELS_TRACKED);
 
@@ -377,6 +441,8 @@ void setTrackingChannels(uint16_t trackingEnabled) {
                     trackingChannel.resetHistory();
                 }
             }
+
+            protection::invalidate();
         }
     }
 }
@@ -389,11 +455,9 @@ CouplingType getType() {
 
 float getTrackingValuePrecision(Unit unit, float value) {
     float precision = 0;
-    for (int i = 0; i < CH_NUM; ++i) {
-        Channel &trackingChannel = Channel::get(i);
-        if (trackingChannel.flags.trackingEnabled) {
-            precision = MAX(precision, trackingChannel.getValuePrecision(unit, value));
-        }
+    for (int i = 0; i < g_numTrackingChannels; ++i) {
+        Channel &trackingChannel = Channel::get(g_trackingChannels[i]);
+        precision = MAX(precision, trackingChannel.getValuePrecision(unit, value));
     }
     return precision;
 }
@@ -414,117 +478,101 @@ float roundChannelValue(const Channel &channel, Unit unit, float value) {
 }
 
 float getUSet(const Channel &channel) {
-    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_SERIES) {
-        return Channel::get(0).u.set + Channel::get(1).u.set;
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.uSplit) {
+        return Channel::get(plan.targets[0]).u.set + Channel::get(plan.targets[1]).u.set;
     }
     return channel.u.set;
 }
 
 float getUSetUnbalanced(const Channel &channel) {
-    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_SERIES) {
-        return Channel::get(0).getUSetUnbalanced() + Channel::get(1).getUSetUnbalanced();
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.uSplit) {
+        return Channel::get(plan.targets[0]).getUSetUnbalanced() + Channel::get(plan.targets[1]).getUSetUnbalanced();
     }
     return channel.u.set;
 }
 
 float getUMon(const Channel &channel) {
-    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_SERIES) {
-        return Channel::get(0).u.mon + Channel::get(1).u.mon;
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.uSplit) {
+        return Channel::get(plan.targets[0]).u.mon + Channel::get(plan.targets[1]).u.mon;
     }
     return channel.u.mon;
 }
 
 float getUMonLast(const Channel &channel) {
-    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_SERIES) {
-        return Channel::get(0).u.mon_last + Channel::get(1).u.mon_last;
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.uSplit) {
+        return Channel::get(plan.targets[0]).u.mon_last + Channel::get(plan.targets[1]).u.mon_last;
     }
     return channel.u.mon_last;
 }
 
 float getUMonDac(const Channel &channel) {
-    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_SERIES) {
-        return Channel::get(0).u.mon_dac + Channel::get(1).u.mon_dac;
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.uSplit) {
+        return Channel::get(plan.targets[0]).u.mon_dac + Channel::get(plan.targets[1]).u.mon_dac;
     }
     return channel.u.mon_dac;
 }
 
 float getUMonDacLast(const Channel &channel) {
-    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_SERIES) {
-        return Channel::get(0).u.mon_dac_last + Channel::get(1).u.mon_dac_last;
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.uSplit) {
+        return Channel::get(plan.targets[0]).u.mon_dac_last + Channel::get(plan.targets[1]).u.mon_dac_last;
     }
     return channel.u.mon_dac_last;
 }
 
 float getULimit(const Channel &channel) {
-    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_SERIES) {
-        return 2 * MIN(Channel::get(0).getVoltageLimit(), Channel::get(1).getVoltageLimit());
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.uSplit) {
+        return 2 * MIN(Channel::get(plan.targets[0]).getVoltageLimit(), Channel::get(plan.targets[1]).getVoltageLimit());
     }
     return channel.getVoltageLimit();
 }
 
 float getUMaxLimit(const Channel &channel) {
-    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_SERIES) {
-        return 2 * MIN(Channel::get(0).getVoltageMaxLimit(), Channel::get(1).getVoltageMaxLimit());
-    } else if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_PARALLEL) {
-        return MIN(Channel::get(0).getVoltageMaxLimit(), Channel::get(1).getVoltageMaxLimit());
-    } else if (channel.flags.trackingEnabled) {
-        float value = channel.getVoltageMaxLimit();
-        for (int i = 0; i < CH_NUM; ++i) {
-            if (i != channel.channelIndex) {
-                const Channel &trackingChannel = Channel::get(i);
-                if (trackingChannel.flags.trackingEnabled) {
-                    value = MIN(value, trackingChannel.getVoltageMaxLimit());
-                }
-            }
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.numTargets > 0) {
+        float value = Channel::get(plan.targets[0]).getVoltageMaxLimit();
+        for (int i = 1; i < plan.numTargets; ++i) {
+            value = MIN(value, Channel::get(plan.targets[i]).getVoltageMaxLimit());
         }
-        return value;
+        return plan.uSplit ? 2 * value : value;
     }
     return channel.getVoltageMaxLimit();
 }
 
 float getUMin(const Channel &channel) {
-    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_SERIES) {
-        return 2 * MAX(Channel::get(0).u.min, Channel::get(1).u.min);
-    } else if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_PARALLEL) {
-        return MAX(Channel::get(0).u.min, Channel::get(1).u.min);
-    } else if (channel.flags.trackingEnabled) {
-        float value = channel.u.min;
-        for (int i = 0; i < CH_NUM; ++i) {
-            if (i != channel.channelIndex) {
-                const Channel &trackingChannel = Channel::get(i);
-                if (trackingChannel.flags.trackingEnabled) {
-                    value = MAX(value, trackingChannel.u.min);
-                }
-            }
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.numTargets > 0) {
+        float value = Channel::get(plan.targets[0]).u.min;
+        for (int i = 1; i < plan.numTargets; ++i) {
+            value = MAX(value, Channel::get(plan.targets[i]).u.min);
         }
-        return value;
+        return plan.uSplit ? 2 * value : value;
     }
     return channel.u.min;
 }
 
 float getUDef(const Channel &channel) {
-    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_SERIES) {
-        return Channel::get(0).u.def + Channel::get(1).u.def;
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.uSplit) {
+        return Channel::get(plan.targets[0]).u.def + Channel::get(plan.targets[1]).u.def;
     }
     return channel.u.def;
 }
 
 float getUMax(const Channel &channel) {
-    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_SERIES) {
-        return 2 * MIN(Channel::get(0).u.max, Channel::get(1).u.max);
-    } else if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_PARALLEL) {
-        return MIN(Channel::get(0).u.max, Channel::get(1).u.max);
-    } else if (channel.flags.trackingEnabled) {
-        float value = channel.u.max;
-        for (int i = 0; i < CH_NUM; ++i) {
-            if (i != channel.channelIndex) {
-                const Channel &trackingChannel = Channel::get(i);
-                if (trackingChannel.flags.trackingEnabled) {
-                    value = MIN(value, trackingChannel.u.max);
-                }
-            }
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.numTargets > 0) {
+        float value = Channel::get(plan.targets[0]).u.max;
+        for (int i = 1; i < plan.numTargets; ++i) {
+            value = MIN(value, Channel::get(plan.targets[i]).u.max);
         }
-        return value;
+        return plan.uSplit ? 2 * value : value;
     }
     return channel.u.max;
 }
@@ -541,8 +589,9 @@ float getUMaxOvpLevel(const Channel &channel) {
 }
 
 float getUProtectionLevel(const Channel &channel) {
-    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_SERIES) {
-        return Channel::get(0).prot_conf.u_level + Channel::get(1).prot_conf.u_level;
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.uSplit) {
+        return Channel::get(plan.targets[0]).prot_conf.u_level + Channel::get(plan.targets[1]).prot_conf.u_level;
     }
     return channel.prot_conf.u_level;
 }
@@ -560,61 +609,54 @@ void setVoltage(Channel &channel, float voltage) {
         return;
     }
 
-    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_SERIES) {
-        Channel::get(0).setVoltage(voltage / 2);
-        Channel::get(1).setVoltage(voltage / 2);
-    } else if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_PARALLEL) {
-        Channel::get(0).setVoltage(voltage);
-        Channel::get(1).setVoltage(voltage);
-    } else if (channel.flags.trackingEnabled) {
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.numTargets == 0) {
+        channel.setVoltage(voltage);
+        return;
+    }
+
+    if (plan.tracking) {
         voltage = roundTrackingValuePrecision(UNIT_VOLT, voltage);
+    } else if (plan.uSplit) {
+        voltage /= 2;
+    }
 
-        for (int i = 0; i < CH_NUM; ++i) {
-            Channel &trackingChannel = Channel::get(i);
-            if (trackingChannel.flags.trackingEnabled) {
-                trackingChannel.setVoltage(voltage);
-            }
-        }
-    } else {
-        channel.setVoltage(voltage);
+    for (int i = 0; i < plan.numTargets; ++i) {
+        Channel::get(plan.targets[i]).setVoltage(voltage);
     }
 }
 
 void setVoltageStep(Channel &channel, float voltageStep) {
-    if (channel.channelIndex < 2 && (g_couplingType == COUPLING_TYPE_SERIES || g_couplingType == COUPLING_TYPE_PARALLEL)) {
-        Channel::get(0).u.step = voltageStep;
-        Channel::get(1).u.step = voltageStep;
-    } else if (channel.flags.trackingEnabled) {
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.numTargets == 0) {
+        channel.u.step = voltageStep;
+        return;
+    }
+
+    if (plan.tracking) {
         voltageStep = roundTrackingValuePrecision(UNIT_VOLT, voltageStep);
+    }
 
-        for (int i = 0; i < CH_NUM; ++i) {
-            Channel &trackingChannel = Channel::get(i);
-            if (trackingChannel.flags.trackingEnabled) {
-                trackingChannel.u.step = voltageStep;
-            }
-        }
-    } else {
-        channel.u.step = voltageStep;
+    for (int i = 0; i < plan.numTargets; ++i) {
+        Channel::get(plan.targets[i]).u.step = voltageStep;
     }
 }
 
 void setVoltageLimit(Channel &channel, float limit) {
-    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_SERIES) {
-        Channel::get(0).setVoltageLimit(limit / 2);
-        Channel::get(1).setVoltageLimit(limit / 2);
-    } else if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_PARALLEL) {
-        Channel::get(0).setVoltageLimit(limit);
-        Channel::get(1).setVoltageLimit(limit);
-    } else if (channel.flags.trackingEnabled) {
-        limit = roundTrackingValuePrecision(UNIT_VOLT, limit);
-        for (int i = 0; i < CH_NUM; ++i) {
-            Channel &trackingChannel = Channel::get(i);
-            if (trackingChannel.flags.trackingEnabled) {
-                trackingChannel.setVoltageLimit(limit);
-            }
-        }
-    } else {
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.numTargets == 0) {
         channel.setVoltageLimit(limit);
+        return;
+    }
+
+    if (plan.tracking) {
+        limit = roundTrackingValuePrecision(UNIT_VOLT, limit);
+    } else if (plan.uSplit) {
+        limit /= 2;
+    }
+
+    for (int i = 0; i < plan.numTargets; ++i) {
+        Channel::get(plan.targets[i]).setVoltageLimit(limit);
     }
 }
 
@@ -660,6 +702,8 @@ void setOvpParameters(Channel &channel, int state, int type, float level, float
         channel.prot_conf.u_level = roundPrec(level, channel.getVoltageResolution());
         channel.prot_conf.u_delay = delay;
     }
+
+    protection::invalidate();
 }
 
 void setOvpState(Channel &channel, int state) {
@@ -676,6 +720,8 @@ void setOvpState(Channel &channel, int state) {
     } else {
         channel.prot_conf.flags.u_state = state;
     }
+
+    protection::invalidate();
 }
 
 void setOvpType(Channel &channel, int type) {
@@ -700,6 +746,8 @@ void setOvpType(Channel &channel, int type) {
             channel.prot_conf.flags.u_type = type;
         }
     }
+
+    protection::invalidate();
 }
 
 void setOvpLevel(Channel &channel, float level) {
@@ -719,6 +767,8 @@ void setOvpLevel(Channel &channel, float level) {
     } else {
         channel.prot_conf.u_level = roundPrec(level, channel.getVoltageResolution());
     }
+
+    protection::invalidate();
 }
 
 void setOvpDelay(Channel &channel, float delay) {
@@ -737,113 +787,98 @@ void setOvpDelay(Channel &channel, float delay) {
     } else {
         channel.prot_conf.u_delay = delay;
     }
+
+    protection::invalidate();
 }
 
 float getISet(const Channel &channel) {
-    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_PARALLEL) {
-        return Channel::get(0).i.set + Channel::get(1).i.set;
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.iSplit) {
+        return Channel::get(plan.targets[0]).i.set + Channel::get(plan.targets[1]).i.set;
     }
     return channel.i.set;
 }
 
 float getISetUnbalanced(const Channel &channel) {
-    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_PARALLEL) {
-        return Channel::get(0).getISetUnbalanced() + Channel::get(1).getISetUnbalanced();
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.iSplit) {
+        return Channel::get(plan.targets[0]).getISetUnbalanced() + Channel::get(plan.targets[1]).getISetUnbalanced();
     }
     return channel.i.set;
 }
 
 float getIMon(const Channel &channel) {
-    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_PARALLEL) {
-        return Channel::get(0).i.mon + Channel::get(1).i.mon;
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.iSplit) {
+        return Channel::get(plan.targets[0]).i.mon + Channel::get(plan.targets[1]).i.mon;
     }
     return channel.i.mon;
 }
 
 float getIMonLast(const Channel &channel) {
-    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_PARALLEL) {
-        return Channel::get(0).i.mon_last + Channel::get(1).i.mon_last;
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.iSplit) {
+        return Channel::get(plan.targets[0]).i.mon_last + Channel::get(plan.targets[1]).i.mon_last;
     }
     return channel.i.mon_last;
 }
 
 float getIMonDac(const Channel &channel) {
-    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_PARALLEL) {
-        return Channel::get(0).i.mon_dac + Channel::get(1).i.mon_dac;
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.iSplit) {
+        return Channel::get(plan.targets[0]).i.mon_dac + Channel::get(plan.targets[1]).i.mon_dac;
     }
     return channel.i.mon_dac;
 }
 
 float getILimit(const Channel &channel) {
-    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_PARALLEL) {
-        return 2 * MIN(Channel::get(0).getCurrentLimit(), Channel::get(1).getCurrentLimit());
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.iSplit) {
+        return 2 * MIN(Channel::get(plan.targets[0]).getCurrentLimit(), Channel::get(plan.targets[1]).getCurrentLimit());
     }
     return channel.getCurrentLimit();
 }
 
 float getIMaxLimit(const Channel &channel) {
-    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_PARALLEL) {
-        return 2 * MIN(Channel::get(0).getMaxCurrentLimit(), Channel::get(1).getMaxCurrentLimit());
-    } else if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_SERIES) {
-        return MIN(Channel::get(0).getMaxCurrentLimit(), Channel::get(1).getMaxCurrentLimit());
-    } else if (channel.flags.trackingEnabled) {
-        float value = channel.getMaxCurrentLimit();
-        for (int i = 0; i < CH_NUM; ++i) {
-            if (i != channel.channelIndex) {
-                const Channel &trackingChannel = Channel::get(i);
-                if (trackingChannel.flags.trackingEnabled) {
-                    value = MIN(value, trackingChannel.getMaxCurrentLimit());
-                }
-            }
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.numTargets > 0) {
+        float value = Channel::get(plan.targets[0]).getMaxCurrentLimit();
+        for (int i = 1; i < plan.numTargets; ++i) {
+            value = MIN(value, Channel::get(plan.targets[i]).getMaxCurrentLimit());
         }
-        return value;
+        return plan.iSplit ? 2 * value : value;
     }
     return channel.getMaxCurrentLimit();
 }
 
 float getIMin(const Channel &channel) {
-    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_PARALLEL) {
-        return 2 * MAX(Channel::get(0).i.min, Channel::get(1).i.min);
-    } else if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_SERIES) {
-        return MAX(Channel::get(0).i.min, Channel::get(1).i.min);
-    } else if (channel.flags.trackingEnabled) {
-        float value = channel.i.min;
-        for (int i = 0; i < CH_NUM; ++i) {
-            if (i != channel.channelIndex) {
-                const Channel &trackingChannel = Channel::get(i);
-                if (trackingChannel.flags.trackingEnabled) {
-                    value = MAX(value, trackingChannel.i.min);
-                }
-            }
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.numTargets > 0) {
+        float value = Channel::get(plan.targets[0]).i.min;
+        for (int i = 1; i < plan.numTargets; ++i) {
+            value = MAX(value, Channel::get(plan.targets[i]).i.min);
         }
-        return value;
+        return plan.iSplit ? 2 * value : value;
     }
     return channel.i.min;
 }
 
 float getIDef(const Channel &channel) {
-    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_PARALLEL) {
-        return Channel::get(0).i.def + Channel::get(1).i.def;
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.iSplit) {
+        return Channel::get(plan.targets[0]).i.def + Channel::get(plan.targets[1]).i.def;
     }
     return channel.i.def;
 }
 
 float getIMax(const Channel &channel) {
-    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_PARALLEL) {
-        return 2 * MIN(Channel::get(0).i.max, Channel::get(1).i.max);
-    } else if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_SERIES) {
-        return MIN(Channel::get(0).i.max, Channel::get(1).i.max);
-    } else if (channel.flags.trackingEnabled) {
-        float value = channel.i.max;
-        for (int i = 0; i < CH_NUM; ++i) {
-            if (i != channel.channelIndex) {
-                const Channel &trackingChannel = Channel::get(i);
-                if (trackingChannel.flags.trackingEnabled) {
-                    value = MIN(value, trackingChannel.i.max);
-                }
-            }
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.numTargets > 0) {
+        float value = Channel::get(plan.targets[0]).i.max;
+        for (int i = 1; i < plan.numTargets; ++i) {
+            value = MIN(value, Channel::get(plan.targets[i]).i.max);
         }
-        return value;
+        return plan.iSplit ? 2 * value : value;
     }
     return channel.i.max;
 }
@@ -861,60 +896,54 @@ void setCurrent(Channel &channel, float current) {
         return;
     }
 
-    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_PARALLEL) {
-        Channel::get(0).setCurrent(current / 2);
-        Channel::get(1).setCurrent(current / 2);
-    } else if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_SERIES) {
-        Channel::get(0).setCurrent(current);
-        Channel::get(1).setCurrent(current);
-    } else if (channel.flags.trackingEnabled) {
-        current = roundTrackingValuePrecision(UNIT_AMPER, current);
-        for (int i = 0; i < CH_NUM; ++i) {
-            Channel &trackingChannel = Channel::get(i);
-            if (trackingChannel.flags.trackingEnabled) {
-                trackingChannel.setCurrent(current);
-            }
-        }
-    } else {
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.numTargets == 0) {
         channel.setCurrent(current);
+        return;
+    }
+
+    if (plan.tracking) {
+        current = roundTrackingValuePrecision(UNIT_AMPER, current);
+    } else if (plan.iSplit) {
+        current /= 2;
+    }
+
+    for (int i = 0; i < plan.numTargets; ++i) {
+        Channel::get(plan.targets[i]).setCurrent(current);
     }
 }
 
 void setCurrentStep(Channel &channel, float currentStep) {
-    if (channel.channelIndex < 2 && (g_couplingType == COUPLING_TYPE_SERIES || g_couplingType == COUPLING_TYPE_PARALLEL)) {
-        Channel::get(0).i.step = currentStep;
-        Channel::get(1).i.step = currentStep;
-    } else if (channel.flags.trackingEnabled) {
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.numTargets == 0) {
+        channel.i.step = currentStep;
+        return;
+    }
+
+    if (plan.tracking) {
         currentStep = roundTrackingValuePrecision(UNIT_AMPER, currentStep);
+    }
 
-        for (int i = 0; i < CH_NUM; ++i) {
-            Channel &trackingChannel = Channel::get(i);
-            if (trackingChannel.flags.trackingEnabled) {
-                trackingChannel.i.step = currentStep;
-            }
-        }
-    } else {
-        channel.i.step = currentStep;
+    for (int i = 0; i < plan.numTargets; ++i) {
+        Channel::get(plan.targets[i]).i.step = currentStep;
     }
 }
 
 void setCurrentLimit(Channel &channel, float limit) {
-    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_PARALLEL) {
-        Channel::get(0).setCurrentLimit(limit / 2);
-        Channel::get(1).setCurrentLimit(limit / 2);
-    } else if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_SERIES) {
-        Channel::get(0).setCurrentLimit(limit);
-        Channel::get(1).setCurrentLimit(limit);
-    } else if (channel.flags.trackingEnabled) {
-        limit = roundTrackingValuePrecision(UNIT_AMPER, limit);
-        for (int i = 0; i < CH_NUM; ++i) {
-            Channel &trackingChannel = Channel::get(i);
-            if (trackingChannel.flags.trackingEnabled) {
-                trackingChannel.setCurrentLimit(limit);
-            }
-        }
-    } else {
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.numTargets == 0) {
         channel.setCurrentLimit(limit);
+        return;
+    }
+
+    if (plan.tracking) {
+        limit = roundTrackingValuePrecision(UNIT_AMPER, limit);
+    } else if (plan.iSplit) {
+        limit /= 2;
+    }
+
+    for (int i = 0; i < plan.numTargets; ++i) {
+        Channel::get(plan.targets[i]).setCurrentLimit(limit);
     }
 }
 
@@ -939,6 +968,8 @@ void setOcpParameters(Channel &channel, int state, float delay) {
         channel.prot_conf.flags.i_state = state;
         channel.prot_conf.i_delay = delay;
     }
+
+    protection::invalidate();
 }
 
 void setOcpState(Channel &channel, int state) {
@@ -954,6 +985,8 @@ void setOcpState(Channel &channel, int state) {
     } else {
         channel.prot_conf.flags.i_state = state;
     }
+
+    protection::invalidate();
 }
 
 void setOcpDelay(Channel &channel, float delay) {
@@ -972,11 +1005,14 @@ void setOcpDelay(Channel &channel, float delay) {
     } else {
         channel.prot_conf.i_delay = delay;
     }
+
+    protection::invalidate();
 }
 
 float getPowerLimit(const Channel &channel) {
-    if (channel.channelIndex < 2 && (g_couplingType == COUPLING_TYPE_SERIES || g_couplingType == COUPLING_TYPE_PARALLEL)) {
-        return 2 * MIN(Channel::get(0).getPowerLimit(), Channel::get(1).getPowerLimit());
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.pSplit) {
+        return 2 * MIN(Channel::get(plan.targets[0]).getPowerLimit(), Channel::get(plan.targets[1]).getPowerLimit());
     }
     return channel.getPowerLimit();
 }
@@ -986,8 +1022,9 @@ float getPowerMinLimit(const Channel &channel) {
 }
 
 float getPowerMaxLimit(const Channel &channel) {
-    if (channel.channelIndex < 2 && (g_couplingType == COUPLING_TYPE_SERIES || g_couplingType == COUPLING_TYPE_PARALLEL)) {
-        return 2 * MIN(Channel::get(0).params.PTOT, Channel::get(1).params.PTOT);
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.pSplit) {
+        return 2 * MIN(Channel::get(plan.targets[0]).params.PTOT, Channel::get(plan.targets[1]).params.PTOT);
     }
     return channel.params.PTOT;
 }
@@ -997,26 +1034,27 @@ float getPowerDefaultLimit(const Channel &channel) {
 }
 
 float getPowerProtectionLevel(const Channel &channel) {
-    if (channel.channelIndex < 2 && (g_couplingType == COUPLING_TYPE_SERIES || g_couplingType == COUPLING_TYPE_PARALLEL)) {
-        return Channel::get(0).prot_conf.p_level + Channel::get(1).prot_conf.p_level;
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.pSplit) {
+        return Channel::get(plan.targets[0]).prot_conf.p_level + Channel::get(plan.targets[1]).prot_conf.p_level;
     }
     return channel.prot_conf.p_level;
 }
 
 void setPowerLimit(Channel &channel, float limit) {
-    if (channel.channelIndex < 2 && (g_couplingType == COUPLING_TYPE_SERIES || g_couplingType == COUPLING_TYPE_PARALLEL)) {
-        Channel::get(0).setPowerLimit(limit / 2);
-        Channel::get(1).setPowerLimit(limit / 2);
-    } else if (channel.flags.trackingEnabled) {
-        limit = roundTrackingValuePrecision(UNIT_WATT, limit);
-        for (int i = 0; i < CH_NUM; ++i) {
-            Channel &trackingChannel = Channel::get(i);
-            if (trackingChannel.flags.trackingEnabled) {
-                trackingChannel.setPowerLimit(limit);
-            }
-        }
-    } else {
+    auto &plan = g_dispatchPlans[channel.channelIndex];
+    if (plan.numTargets == 0) {
         channel.setPowerLimit(limit);
+    } else {
+        if (plan.tracking) {
+            limit = roundTrackingValuePrecision(UNIT_WATT, limit);
+        } else if (plan.pSplit) {
+            limit /= 2;
+        }
+
+        for (int i = 0; i < plan.numTargets; ++i) {
+            Channel::get(plan.targets[i]).setPowerLimit(limit);
+        }
     }
 
     if (getOppLevel(channel) > getPowerLimit(channel)) {
@@ -1025,10 +1063,7 @@ void setPowerLimit(Channel &channel, float limit) {
 }
 
 float getOppLevel(Channel &channel) {
-    if (channel.channelIndex < 2 && (g_couplingType == COUPLING_TYPE_SERIES || g_couplingType == COUPLING_TYPE_PARALLEL)) {
-        return Channel::get(0).prot_conf.p_level + Channel::get(1).prot_conf.p_level;
-    }
-    return channel.prot_conf.p_level;
+    return getPowerProtectionLevel(channel);
 }
 
 float getOppMinLevel(Channel &channel) {
@@ -1079,6 +1114,8 @@ void setOppParameters(Channel &channel, int state, float level, float delay) {
         channel.prot_conf.p_level = roundPrec(level, channel.getPowerResolution());
         channel.prot_conf.p_delay = delay;
     }
+
+    protection::invalidate();
 }
 
 void setOppState(Channel &channel, int state) {
@@ -1095,6 +1132,8 @@ void setOppState(Channel &channel, int state) {
     } else {
         channel.prot_conf.flags.p_state = state;
     }
+
+    protection::invalidate();
 }
 
 void setOppLevel(Channel &channel, float level) {
@@ -1116,6 +1155,8 @@ void setOppLevel(Channel &channel, float level) {
     } else {
         channel.prot_conf.p_level = roundPrec(level, channel.getPowerResolution());
     }
+
+    protection::invalidate();
 }
 
 void setOppDelay(Channel &channel, float delay) {
@@ -1134,6 +1175,8 @@ void setOppDelay(Channel &channel, float delay) {
     } else {
         channel.prot_conf.p_delay = delay;
     }
+
+    protection::invalidate();
 }
 
 void setVoltageRampDuration(Channel &channel, float duration) {
@@ -1949,6 +1992,7 @@ const char *copyChannelToChannel(int srcChannelIndex, int dstChannelIndex) {
 
     if (dstChannel.params.features & CH_FEATURE_RPROG) {
         dstChannel.flags.rprogEnabled = srcChannel.flags.rprogEnabled;
+        protection::invalidate();
     }
 
     auto displayValue1 = srcChannel.flags.displayValue1;
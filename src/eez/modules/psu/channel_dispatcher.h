@@ -44,6 +44,10 @@ CouplingType getCouplingType();
 
 void setTrackingChannels(uint16_t trackingEnabled);
 
+// rebuilds channel dispatch plans, must be called whenever
+// coupling type or channel tracking flag is changed
+void updateDispatchPlans();
+
 float getValuePrecision(const Channel &channel, Unit unit, float value);
 float roundChannelValue(const Channel &channel, Unit unit, float value);
 
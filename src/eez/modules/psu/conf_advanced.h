@@ -79,6 +79,11 @@
 /// Temperature reading interval.
 #define TEMP_SENSOR_READ_EVERY_MS 1000
 
+/// Time constant (in seconds) of the temperature reading filter, 0 to disable.
+#define TEMP_SENSOR_FILTER_TIME_CONSTANT 0
+#define TEMP_SENSOR_FILTER_MIN_TIME_CONSTANT 0
+#define TEMP_SENSOR_FILTER_MAX_TIME_CONSTANT 600
+
 /// Minimum OTP delay
 #define OTP_AUX_MIN_DELAY 0.0f
 
@@ -103,6 +108,10 @@
 /// Size of SCPI parser error queue.
 #define SCPI_PARSER_ERROR_QUEUE_SIZE 20
 
+/// Size in bytes of SCPI output buffer used to coalesce response fragments
+/// before they are sent to the client.
+#define SCPI_OUTPUT_BUFFER_SIZE 1024
+
 /// Since we are not using timer, but ADC interrupt for the OVP and
 /// OCP delay measuring there will be some error (size of which
 /// depends on ADC_SPS value). You can use the following value, which
@@ -153,6 +162,15 @@
     1 // PoM: 0, PoE: 1, see
       // http://brettbeauregard.com/blog/2017/06/introducing-proportional-on-measurement/
 
+/// FAN feed-forward thermal model default coefficients, see aux_ps::fan::FanModel
+#define FAN_MODEL_K_OUT 0.05f
+#define FAN_MODEL_U_DROP 3.0f
+#define FAN_MODEL_RTH 1.5f
+#define FAN_MODEL_GAIN 8.0f
+#define FAN_MODEL_AMBIENT 25.0f
+/// Below PID target by more than this (in oC), PID trim is not allowed to go under feed-forward
+#define FAN_MODEL_TRIM_BAND 2.0f
+
 /// Min. PWM after which fan failed will be asserted if RPM is not measured
 #define FAN_FAILED_THRESHOLD 15
 
@@ -165,9 +183,14 @@
 /// Number of seconds after which main power will be turned off.
 #define FAN_MAX_TEMP_DELAY 30
 
-/// Interval (in minutes) at which "on time" will be written to EEPROM
+/// Interval (in minutes) at which all "on time" counters are committed together
+/// to the EEPROM journal. Can be changed with DEBUg:ONTime:INTerval.
 #define WRITE_ONTIME_INTERVAL 10
 
+/// Interval (in minutes) at which "on time" counters are also written to their
+/// home location (MCU and module EEPROM). They are always written on shutdown.
+#define WRITE_ONTIME_HOME_INTERVAL (24 * 60)
+
 /// Maximum allowed length (including label) of the keypad text.
 #define MAX_KEYPAD_TEXT_LENGTH 128
 
@@ -186,6 +209,9 @@
 /// until we declare ethernet initialization failure.
 #define ETHERNET_DHCP_TIMEOUT 15
 
+/// Maximum number of SCPI clients connected over ethernet at the same time.
+#define ETHERNET_MAX_SESSIONS 4
+
 /// Output power is monitored and if its go below DP_NEG_LEV
 /// that is negative value in Watts (default -5 W),
 /// and that condition lasts more then DP_NEG_DELAY seconds (default 5 s),
@@ -241,6 +267,9 @@
 /// Number of values used for ADC averaging
 #define NUM_ADC_AVERAGING_VALUES 10
 
+/// Max. number of values used by the measurement filter (SENS:AVER:COUN)
+#define MON_FILTER_MAX_COUNT 32
+
 /// Width of the trigger output pulse, in milliseconds.
 #define CONF_TOUTPUT_PULSE_WIDTH_MS 100
 
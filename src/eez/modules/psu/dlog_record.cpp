@@ -106,9 +106,9 @@ int g_stateTransitionError;
 bool g_traceInitiated;
 
 static uint32_t g_countingStarted;
-static uint32_t g_lastTickCount;
-static uint32_t g_seconds;
-static uint32_t g_micros;
+static uint64_t g_countingStartTime; // in micros64
+static bool g_triggerTimestampValid;
+static uint64_t g_triggerTimestamp; // in micros64, time of the trigger that started recording
 static uint32_t g_iSample;
 double g_currentTime;
 static double g_nextTime;
@@ -257,6 +257,13 @@ void fileWrite(bool flush) {
             sd_card::reinitialize();
             return;
         }
+
+        // let the waiting SCPI command run between two buffer writes,
+        // it can also abort the recording
+        yieldIo();
+        if (g_state != STATE_EXECUTING) {
+            return;
+        }
     }
 }
 
@@ -357,8 +364,6 @@ static void writeStringFieldWithIndex(uint8_t id, const char *str, uint8_t index
 
 static void initRecordingStart() {
     g_countingStarted = false;
-    g_seconds = 0;
-    g_micros = 0;
     g_iSample = 0;
     g_currentTime = 0;
     g_nextTime = 0;
@@ -475,20 +480,16 @@ static void setState(State newState) {
     }
 }
 
-static void log(uint32_t tickCount) {
+static void log(uint64_t tickCount) {
     if (!g_countingStarted) {
-        g_lastTickCount = tickCount;
+        // if recording is started by trigger, time is counted from the trigger edge
+        g_countingStartTime = g_triggerTimestampValid ? g_triggerTimestamp : tickCount;
+        g_triggerTimestampValid = false;
         g_countingStarted = true;
     }
-    g_micros += tickCount - g_lastTickCount;
-    g_lastTickCount = tickCount;
 
-    if (g_micros >= 1000000) {
-        ++g_seconds;
-        g_micros -= 1000000;
-    }
-
-    g_currentTime = g_seconds + g_micros * 1E-6;
+    // double holds integer microseconds exactly for much longer than any recording can last
+    g_currentTime = (tickCount - g_countingStartTime) * 1E-6;
 
     if (g_traceInitiated) {
         return;
@@ -699,6 +700,10 @@ int checkDlogParameters(dlog_view::Parameters &parameters, bool doNotCheckFilePa
 void stateTransition(int event, int* perr) {
     g_inStateTransition = true;
 
+    if (event != EVENT_TRIGGER) {
+        g_triggerTimestampValid = false;
+    }
+
     if (!isLowPriorityThread()) {
         sendMessageToLowPriorityThread(THREAD_MESSAGE_DLOG_STATE_TRANSITION, event);
         if (perr) {
@@ -779,7 +784,9 @@ int startImmediately() {
     return err;
 }
 
-void triggerGenerated() {
+void triggerGenerated(uint64_t timestamp) {
+    g_triggerTimestamp = timestamp;
+    g_triggerTimestampValid = true;
     stateTransition(EVENT_TRIGGER);
 }
 
@@ -805,7 +812,7 @@ void reset() {
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void tick(uint32_t tickCount) {
+void tick(uint64_t tickCount) {
     if (g_state == STATE_EXECUTING && g_nextTime <= g_recording.parameters.time && !g_inStateTransition) {
         log(tickCount);
     }
@@ -820,6 +827,87 @@ void log(float *values) {
     }
 }
 
+#if defined(EEZ_PLATFORM_SIMULATOR)
+
+bool wrapSelfTest(char *message, int messageSize) {
+    // first micros64() value for which micros() is wrapped to 0
+    static const uint64_t WRAP_TIME = 0x100000000ULL;
+    static const uint64_t TRIGGER_TIME = WRAP_TIME - 250000; // us
+    static const uint64_t TRIGGER_LATENCY = 30000; // us, first tick after the trigger
+    static const uint64_t TICK_PERIOD = 20000; // us
+    static const float PERIOD = 0.1f;
+    static const float TIME = 1.0f;
+
+    if (g_state != STATE_IDLE || g_inStateTransition) {
+        snprintf(message, messageSize, "dlog must be idle");
+        return false;
+    }
+
+    if (!g_mutexId) {
+        g_mutexId = osMutexCreate(osMutex(g_mutex));
+    }
+
+    dlog_view::Parameters savedParameters;
+    memcpy(&savedParameters, &g_recording.parameters, sizeof(dlog_view::Parameters));
+    uint32_t savedSize = g_recording.size;
+    bool savedTraceInitiated = g_traceInitiated;
+
+    // nothing is selected for logging, so samples are only counted
+    for (int i = 0; i < CH_MAX; i++) {
+        g_recording.parameters.logVoltage[i] = false;
+        g_recording.parameters.logCurrent[i] = false;
+        g_recording.parameters.logPower[i] = false;
+    }
+    g_recording.parameters.period = PERIOD;
+    g_recording.parameters.time = TIME;
+    g_recording.size = 0;
+    g_traceInitiated = false;
+
+    g_countingStarted = false;
+    g_iSample = 0;
+    g_currentTime = 0;
+    g_nextTime = 0;
+
+    // recording is started by the trigger, time is counted from the trigger edge
+    g_triggerTimestamp = TRIGGER_TIME;
+    g_triggerTimestampValid = true;
+
+    g_state = STATE_EXECUTING;
+
+    bool result = true;
+
+    // stop before the last sample, so recording is not finished
+    for (uint64_t t = TRIGGER_TIME + TRIGGER_LATENCY; t < TRIGGER_TIME + (uint64_t)(TIME * 1000000) - TICK_PERIOD; t += TICK_PERIOD) {
+        tick(t);
+
+        double time = (t - TRIGGER_TIME) * 1E-6;
+        uint32_t expectedSize = (uint32_t)floor(time / PERIOD) + 1;
+        if (fabs(g_currentTime - time) > 1E-6 || g_recording.size != expectedSize) {
+            snprintf(message, messageSize, "%u us after trigger: time %g s, %u samples, expected %g s, %u samples",
+                (unsigned)(t - TRIGGER_TIME), g_currentTime, (unsigned)g_recording.size, time, (unsigned)expectedSize);
+            result = false;
+            break;
+        }
+    }
+
+    if (result) {
+        snprintf(message, messageSize, "%u samples recorded through micros() wrap", (unsigned)g_recording.size);
+    }
+
+    g_state = STATE_IDLE;
+    g_countingStarted = false;
+    g_iSample = 0;
+    g_currentTime = 0;
+    g_nextTime = 0;
+    g_traceInitiated = savedTraceInitiated;
+    g_recording.size = savedSize;
+    memcpy(&g_recording.parameters, &savedParameters, sizeof(dlog_view::Parameters));
+
+    return result;
+}
+
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 
 const char *getLatestFilePath() {
@@ -63,15 +63,22 @@ int checkDlogParameters(dlog_view::Parameters &parameters, bool doNotCheckFilePa
 int initiate();
 int initiateTrace();
 int startImmediately();
-void triggerGenerated();
+void triggerGenerated(uint64_t timestamp);
 void toggleStart();
 void toggleStop();
 void abort();
 void reset();
 
-void tick(uint32_t tick_usec);
+void tick(uint64_t tick_usec);
 void log(float *values);
 
+#if defined(EEZ_PLATFORM_SIMULATOR)
+// Runs DLOG sample scheduling for a recording started by trigger, with injected
+// ticks around the 32-bit micros() wrap-around, no waiting. Must be called from
+// the PSU thread while DLOG is idle. Nothing is written to the file.
+bool wrapSelfTest(char *message, int messageSize);
+#endif
+
 void fileWrite(bool flush = false);
 void stateTransition(int event, int *perr = nullptr);
 
@@ -789,25 +789,15 @@ void uploadFile() {
         return;
     }
 
-    scpi_t *context = nullptr;
-
-#if !defined(EEZ_PLATFORM_SIMULATOR)
-    if (psu::serial::isConnected()) {
-        context = &psu::serial::g_scpiContext;
-    }
-#endif
-
-#if OPTION_ETHERNET
-    if (!context && psu::ethernet::isConnected()) {
-        context = &psu::ethernet::g_scpiContext;
-    }
-#endif
-
+    int err;
+    scpi_t *context = psu::scpi::getUploadContext(&err);
     if (!context) {
+        if (err != 0) {
+            psu::gui::errorMessage(Value(err, VALUE_TYPE_SCPI_ERROR));
+        }
         return;
     }
 
-    int err;
     psu::scpi::mmemUpload(g_filePath, context, &err);
 }
 
@@ -44,26 +44,52 @@ namespace ethernet {
 
 TestResult g_testResult = TEST_FAILED;
 
-static bool g_isConnected = false;
+static bool g_isConnected[ETHERNET_MAX_SESSIONS];
+
+// number of received input buffers not yet executed, per session
+static uint32_t g_numPendingInputs[ETHERNET_MAX_SESSIONS];
+static int g_lastServedSessionIndex = ETHERNET_MAX_SESSIONS - 1;
+
+static SessionStatistics g_sessionStatistics[ETHERNET_MAX_SESSIONS];
 
 ////////////////////////////////////////////////////////////////////////////////
 
-size_t ethernet_client_write(const char *data, size_t len) {
-    size_t size = eez::mcu::ethernet::writeBuffer(data, len);
+static int getSessionIndex(scpi_t *context) {
+    return context - g_scpiContext;
+}
+
+static OutputBuffer g_outputBuffer[ETHERNET_MAX_SESSIONS];
+
+static size_t ethernet_client_send(scpi_t *context, const char *data, size_t len) {
+    int sessionIndex = getSessionIndex(context);
+    size_t size = eez::mcu::ethernet::writeBuffer(sessionIndex, data, len);
+    g_sessionStatistics[sessionIndex].numWrites++;
+    g_sessionStatistics[sessionIndex].numBytesSent += size;
     return size;
 }
 
-size_t ethernet_client_write_str(const char *str) {
-    return ethernet_client_write(str, strlen(str));
+size_t ethernet_client_write(scpi_t *context, const char *data, size_t len) {
+    int sessionIndex = getSessionIndex(context);
+
+    // output buffer is used only by the thread that executes SCPI commands,
+    // everything else (i.e. errors pushed from other threads) is sent immediately
+    if (!isScpiThread()) {
+        return ethernet_client_send(context, data, len);
+    }
+
+    return outputBufferWrite(context, g_outputBuffer[sessionIndex], ethernet_client_send, data, len);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 size_t SCPI_Write(scpi_t *context, const char *data, size_t len) {
-    return ethernet_client_write(data, len);
+    return ethernet_client_write(context, data, len);
 }
 
 scpi_result_t SCPI_Flush(scpi_t *context) {
+    if (isScpiThread()) {
+        outputBufferFlush(context, g_outputBuffer[getSessionIndex(context)], ethernet_client_send);
+    }
     return SCPI_RES_OK;
 }
 
@@ -72,7 +98,8 @@ int SCPI_Error(scpi_t *context, int_fast16_t err) {
         char errorOutputBuffer[256];
         sprintf(errorOutputBuffer, "**ERROR: %d,\"%s\"\r\n", (int16_t)err,
                 SCPI_ErrorTranslate(err));
-        ethernet_client_write(errorOutputBuffer, strlen(errorOutputBuffer));
+        ethernet_client_write(context, errorOutputBuffer, strlen(errorOutputBuffer));
+        SCPI_Flush(context);
 
         if (err == SCPI_ERROR_INPUT_BUFFER_OVERRUN) {
             scpi::onBufferOverrun(*context);
@@ -90,7 +117,8 @@ scpi_result_t SCPI_Control(scpi_t *context, scpi_ctrl_name_t ctrl, scpi_reg_val_
         sprintf(outputBuffer, "**CTRL %02x: 0x%X (%d)\r\n", ctrl, val, val);
     }
 
-    ethernet_client_write(outputBuffer, strlen(outputBuffer));
+    ethernet_client_write(context, outputBuffer, strlen(outputBuffer));
+    SCPI_Flush(context);
 
     return SCPI_RES_OK;
 }
@@ -98,29 +126,33 @@ scpi_result_t SCPI_Control(scpi_t *context, scpi_ctrl_name_t ctrl, scpi_reg_val_
 scpi_result_t SCPI_Reset(scpi_t *context) {
     char errorOutputBuffer[256];
     strcpy(errorOutputBuffer, "**Reset\r\n");
-    ethernet_client_write(errorOutputBuffer, strlen(errorOutputBuffer));
+    ethernet_client_write(context, errorOutputBuffer, strlen(errorOutputBuffer));
+    SCPI_Flush(context);
 
     return reset() ? SCPI_RES_OK : SCPI_RES_ERR;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-static scpi_reg_val_t g_scpiPsuRegs[SCPI_PSU_REG_COUNT];
-static scpi_psu_t g_scpiPsuContext = { g_scpiPsuRegs };
+static scpi_reg_val_t g_scpiPsuRegs[ETHERNET_MAX_SESSIONS][SCPI_PSU_REG_COUNT];
+static scpi_psu_t g_scpiPsuContext[ETHERNET_MAX_SESSIONS];
 
 static scpi_interface_t g_scpiInterface = {
     SCPI_Error, SCPI_Write, SCPI_Control, SCPI_Flush, SCPI_Reset,
 };
 
-static char g_scpiInputBuffer[SCPI_PARSER_INPUT_BUFFER_LENGTH];
-static scpi_error_t g_errorQueueData[SCPI_PARSER_ERROR_QUEUE_SIZE + 1];
+static char g_scpiInputBuffer[ETHERNET_MAX_SESSIONS][SCPI_PARSER_INPUT_BUFFER_LENGTH];
+static scpi_error_t g_errorQueueData[ETHERNET_MAX_SESSIONS][SCPI_PARSER_ERROR_QUEUE_SIZE + 1];
 
-scpi_t g_scpiContext;
+scpi_t g_scpiContext[ETHERNET_MAX_SESSIONS];
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void init() {
-    scpi::init(g_scpiContext, g_scpiPsuContext, &g_scpiInterface, g_scpiInputBuffer, SCPI_PARSER_INPUT_BUFFER_LENGTH, g_errorQueueData, SCPI_PARSER_ERROR_QUEUE_SIZE + 1);
+    for (int sessionIndex = 0; sessionIndex < ETHERNET_MAX_SESSIONS; sessionIndex++) {
+        g_scpiPsuContext[sessionIndex].registers = g_scpiPsuRegs[sessionIndex];
+        scpi::init(g_scpiContext[sessionIndex], g_scpiPsuContext[sessionIndex], &g_scpiInterface, g_scpiInputBuffer[sessionIndex], SCPI_PARSER_INPUT_BUFFER_LENGTH, g_errorQueueData[sessionIndex], SCPI_PARSER_ERROR_QUEUE_SIZE + 1);
+    }
 
     if (!persist_conf::isEthernetEnabled()) {
         g_testResult = TEST_SKIPPED;
@@ -158,17 +190,48 @@ void onQueueMessage(uint32_t type, uint32_t param) {
         eez::mcu::ethernet::beginServer(persist_conf::devConf.ethernetScpiPort);
         //DebugTrace("Listening on port %d", (int)persist_conf::devConf.ethernetScpiPort);
     } else if (type == ETHERNET_CLIENT_CONNECTED) {
-        g_isConnected = true;
-        scpi::emptyBuffer(g_scpiContext);
+        int sessionIndex = param;
+        g_isConnected[sessionIndex] = true;
+        g_numPendingInputs[sessionIndex] = 0;
+        g_outputBuffer[sessionIndex].length = 0;
+        scpi::emptyBuffer(g_scpiContext[sessionIndex]);
+
+        SessionStatistics &statistics = g_sessionStatistics[sessionIndex];
+        statistics.connectedTime = millis();
+        statistics.numInputs = 0;
+        statistics.numWrites = 0;
+        statistics.numBytesReceived = 0;
+        statistics.numBytesSent = 0;
     } else if (type == ETHERNET_CLIENT_DISCONNECTED) {
-        g_isConnected = false;
+        int sessionIndex = param;
+        g_isConnected[sessionIndex] = false;
+        g_numPendingInputs[sessionIndex] = 0;
     } else if (type == ETHERNET_INPUT_AVAILABLE) {
-        char *buffer;
-        uint32_t length;
-        eez::mcu::ethernet::getInputBuffer(param, &buffer, &length);
-        if (buffer && length) {
-            input(g_scpiContext, (const char *)buffer, length);
-            eez::mcu::ethernet::releaseInputBuffer();
+        g_numPendingInputs[param]++;
+
+        // Every message executes one input buffer, but not necessarily from the session
+        // that sent the message: sessions are served round robin, so one client
+        // sending a lot of commands can't starve the others.
+        for (int i = 1; i <= ETHERNET_MAX_SESSIONS; i++) {
+            int sessionIndex = (g_lastServedSessionIndex + i) % ETHERNET_MAX_SESSIONS;
+            if (g_numPendingInputs[sessionIndex] > 0) {
+                g_numPendingInputs[sessionIndex]--;
+                g_lastServedSessionIndex = sessionIndex;
+
+                char *buffer;
+                uint32_t length;
+                eez::mcu::ethernet::getInputBuffer(sessionIndex, &buffer, &length);
+                if (buffer && length) {
+                    SessionStatistics &statistics = g_sessionStatistics[sessionIndex];
+                    statistics.numInputs++;
+                    statistics.numBytesReceived += length;
+
+                    input(g_scpiContext[sessionIndex], (const char *)buffer, length);
+                    eez::mcu::ethernet::releaseInputBuffer(sessionIndex);
+                }
+
+                break;
+            }
         }
     }
 }
@@ -178,7 +241,20 @@ uint32_t getIpAddress() {
 }
 
 bool isConnected() {
-    return g_isConnected;
+    for (int sessionIndex = 0; sessionIndex < ETHERNET_MAX_SESSIONS; sessionIndex++) {
+        if (g_isConnected[sessionIndex]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool isConnected(int sessionIndex) {
+    return g_isConnected[sessionIndex];
+}
+
+void getSessionStatistics(int sessionIndex, SessionStatistics &statistics) {
+    memcpy(&statistics, &g_sessionStatistics[sessionIndex], sizeof(SessionStatistics));
 }
 
 void update() {
@@ -193,9 +269,12 @@ void update() {
             eez::mcu::ethernet::beginServer(persist_conf::devConf.ethernetScpiPort);
         }
     } else {
-        if (g_isConnected) {
-            eez::mcu::ethernet::disconnectClient();
-            g_isConnected = false;
+        for (int sessionIndex = 0; sessionIndex < ETHERNET_MAX_SESSIONS; sessionIndex++) {
+            if (g_isConnected[sessionIndex]) {
+                eez::mcu::ethernet::disconnectClient(sessionIndex);
+                g_isConnected[sessionIndex] = false;
+                g_numPendingInputs[sessionIndex] = 0;
+            }
         }
 
         eez::mcu::ethernet::endServer();
@@ -207,6 +286,55 @@ void update() {
     }
 }
 
+#if defined(EEZ_PLATFORM_SIMULATOR)
+
+bool uploadSessionSelfTest(char *message, int messageSize) {
+    bool isConnectedSaved[ETHERNET_MAX_SESSIONS];
+    memcpy(isConnectedSaved, g_isConnected, sizeof(g_isConnected));
+
+    bool result = true;
+    message[0] = 0;
+
+    // every subset of connected sessions, bit i set means session i is connected
+    for (int mask = 0; mask < (1 << ETHERNET_MAX_SESSIONS) && result; mask++) {
+        int numConnected = 0;
+        int connectedSessionIndex = -1;
+        for (int sessionIndex = 0; sessionIndex < ETHERNET_MAX_SESSIONS; sessionIndex++) {
+            g_isConnected[sessionIndex] = (mask & (1 << sessionIndex)) != 0;
+            if (g_isConnected[sessionIndex]) {
+                numConnected++;
+                connectedSessionIndex = sessionIndex;
+            }
+        }
+
+        int err = 0;
+        scpi_t *context = scpi::getUploadContext(&err);
+
+        if (numConnected == 1) {
+            if (context != &g_scpiContext[connectedSessionIndex] || err != 0) {
+                snprintf(message, messageSize, "sessions=0x%x: session %d not selected", mask, connectedSessionIndex);
+                result = false;
+            }
+        } else {
+            int expectedErr = numConnected == 0 ? 0 : SCPI_ERROR_MULTIPLE_REMOTE_SESSIONS;
+            if (context != nullptr || err != expectedErr) {
+                snprintf(message, messageSize, "sessions=0x%x: expected no session and error %d, got error %d", mask, expectedErr, err);
+                result = false;
+            }
+        }
+    }
+
+    memcpy(g_isConnected, isConnectedSaved, sizeof(g_isConnected));
+
+    if (result) {
+        snprintf(message, messageSize, "%d session combinations", 1 << ETHERNET_MAX_SESSIONS);
+    }
+
+    return result;
+}
+
+#endif
+
 } // namespace ethernet
 } // namespace psu
 } // namespace eez
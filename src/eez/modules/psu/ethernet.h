@@ -25,7 +25,17 @@ namespace psu {
 namespace ethernet {
 
 extern TestResult g_testResult;
-extern scpi_t g_scpiContext;
+
+// one SCPI context per client session
+extern scpi_t g_scpiContext[ETHERNET_MAX_SESSIONS];
+
+struct SessionStatistics {
+    uint32_t connectedTime; // millis
+    uint32_t numInputs;
+    uint32_t numWrites; // number of transport writes, buffered response fragments count as one
+    uint64_t numBytesReceived;
+    uint64_t numBytesSent;
+};
 
 void init();
 bool test();
@@ -34,12 +44,22 @@ void onQueueMessage(uint32_t type, uint32_t param);
 
 uint32_t getIpAddress();
 
+// is any client connected
 bool isConnected();
+bool isConnected(int sessionIndex);
+
+void getSessionStatistics(int sessionIndex, SessionStatistics &statistics);
 
 // this function is called when ethernet settings are changed,
 // and it should reconnect to the ethernet with these settings
 void update();
 
+#if defined(EEZ_PLATFORM_SIMULATOR)
+/// Marks sessions as connected in every combination and checks the remote session
+/// selected for the upload started from the front panel, real session state is restored.
+bool uploadSessionSelfTest(char *message, int messageSize);
+#endif
+
 } // namespace ethernet
 } // namespace psu
 } // namespace eez
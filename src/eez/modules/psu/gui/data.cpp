@@ -2074,7 +2074,7 @@ void data_channel_temp(DataOperationEnum operation, Cursor cursor, Value &value)
         int iChannel = cursor >= 0 ? cursor : (g_channel ? g_channel->channelIndex : 0);
         temperature::TempSensorTemperature &tempSensor = temperature::sensors[temp_sensor::CH1 + iChannel];
         if (tempSensor.isInstalled() && tempSensor.isTestOK()) {
-            temperature = tempSensor.temperature;
+            temperature = tempSensor.getTemperature();
         }
 
         value = MakeValue(temperature, UNIT_CELSIUS);
@@ -3128,7 +3128,7 @@ void data_sys_temp_aux(DataOperationEnum operation, Cursor cursor, Value &value)
         float auxTemperature = 0;
         temperature::TempSensorTemperature &tempSensor = temperature::sensors[temp_sensor::AUX];
         if (tempSensor.isInstalled() && tempSensor.isTestOK()) {
-            auxTemperature = tempSensor.temperature;
+            auxTemperature = tempSensor.getTemperature();
         }
         value = MakeValue(auxTemperature, UNIT_CELSIUS);
     }
@@ -60,6 +60,45 @@ namespace file_manager {
 
 static const size_t MAX_FILE_DESCRIPTION_LENGTH = 80;
 
+// Index of already parsed script descriptions, kept inside the scripts directory.
+// Each line is "<name>\t<modified time>\t<description>\n". Entry is used only if
+// modified time still matches the file, otherwise description is parsed again.
+// New descriptions are appended, index is rewritten only when most of the lines
+// are stale.
+#define DESCRIPTIONS_INDEX_FILE_NAME ".descriptions"
+static const uint32_t DESCRIPTIONS_INDEX_MIN_STALE_LINES = 16;
+
+// Thumbnails of the images are cached inside this subdirectory,
+// one "<image file name>.thm" file per image.
+#define THUMBNAILS_DIR_NAME ".thumbnails"
+
+static const uint32_t THUMBNAIL_FILE_MAGIC = 0x4D485445; // "ETHM"
+
+struct ThumbnailFileHeader {
+    uint32_t magic;
+    uint32_t dateTime;
+    uint32_t size;
+    uint16_t width;
+    uint16_t height;
+    uint32_t bpp;
+};
+
+// Thumbnails in RAM are kept at the end of the file manager memory,
+// file items and strings use the rest.
+static const uint32_t NUM_THUMBNAILS = 16;
+static const uint32_t THUMBNAIL_BUFFER_SIZE = 4 * ((THUMBNAIL_MAX_SIZE + 3) / 4);
+static uint8_t * const THUMBNAILS_MEMORY = FILE_MANAGER_MEMORY + FILE_MANAGER_MEMORY_SIZE - NUM_THUMBNAILS * THUMBNAIL_BUFFER_SIZE;
+
+struct Thumbnail {
+    int32_t fileIndex;
+    bool ready;
+    Image image; // image.pixels == nullptr if thumbnail failed to load
+};
+
+static Thumbnail g_thumbnails[NUM_THUMBNAILS];
+static uint32_t g_nextThumbnail;
+static bool g_loadThumbnailsPending;
+
 static State g_state;
 static uint32_t g_loadingStartTickCount;
 
@@ -71,6 +110,7 @@ struct FileItem {
     uint32_t size;
     uint32_t dateTime;
     const char *description;
+    bool descriptionLoaded;
 };
 
 static uint8_t *g_frontBufferPosition;
@@ -95,50 +135,59 @@ static void (*g_fileBrowserOnFileSelected)(const char *filePath);
 static ListViewOption g_rootDirectoryListViewOption = LIST_VIEW_LARGE_ICONS;
 static ListViewOption g_scriptsDirectoryListViewOption = LIST_VIEW_SCRIPTS;
 
+static bool g_loadDescriptionsPending;
+
+// incremented when file items are reloaded or sorted
+static uint32_t g_fileItemsVersion;
+
+// Descriptions are read by the low priority thread into this buffer and
+// set to the file items by the GUI thread.
+static const uint32_t MAX_LOADED_DESCRIPTIONS = 8; // biggest page size
+
+struct LoadedDescription {
+    uint32_t fileIndex;
+    const char *name;
+    uint32_t dateTime;
+    char description[MAX_FILE_DESCRIPTION_LENGTH + 1];
+};
+
+static LoadedDescription g_loadedDescriptions[MAX_LOADED_DESCRIPTIONS];
+static uint32_t g_numLoadedDescriptions;
+static uint32_t g_loadedDescriptionsVersion;
+
+static const char *allocString(const char *str) {
+    size_t len = 4 * ((strlen(str) + 1 + 3) / 4);
+    if (g_frontBufferPosition > g_backBufferPosition - len) {
+        return nullptr;
+    }
+    g_backBufferPosition -= len;
+    strcpy((char *)g_backBufferPosition, str);
+    return (const char *)g_backBufferPosition;
+}
+
+static bool isDescriptionsViewActive() {
+    return isScriptsDirectory() && getListViewOption() == LIST_VIEW_SCRIPTS;
+}
+
 void catalogCallback(void *param, const char *name, FileType type, size_t size) {
     if (g_fileBrowserMode && type != FILE_TYPE_DIRECTORY && type != g_fileBrowserFileType) {
         return;
     }
 
+    // skip descriptions index and thumbnails cache, other files are listed as usual
+    if (type == FILE_TYPE_DIRECTORY ? strcmp(name, THUMBNAILS_DIR_NAME) == 0 : strcmp(name, DESCRIPTIONS_INDEX_FILE_NAME) == 0) {
+        return;
+    }
+
     auto fileInfo = (FileInfo *)param;
  
     char fileNameWithoutExtension[MAX_PATH_LENGTH + 1];
 
-    char description[MAX_FILE_DESCRIPTION_LENGTH + 1];
-    size_t descriptionLen = 0;
-
     if (isScriptsDirectory() && (getListViewOption() == LIST_VIEW_SCRIPTS || getListViewOption() == LIST_VIEW_LARGE_ICONS)) {
         if (type != FILE_TYPE_MICROPYTHON) {
             return;
         }
 
-        description[0] = 0;
-
-        if (getListViewOption() == LIST_VIEW_SCRIPTS) {
-            char filePath[MAX_PATH_LENGTH + 1];
-            strcpy(filePath, g_currentDirectory);
-            strcat(filePath, "/");
-            strcat(filePath, name);
-            File file;
-            if (file.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
-                psu::sd_card::BufferedFileRead bufferedFile(file);
-
-                psu::sd_card::matchZeroOrMoreSpaces(bufferedFile);
-                if (psu::sd_card::match(bufferedFile, '#')) {
-                    psu::sd_card::matchZeroOrMoreSpaces(bufferedFile);
-                    psu::sd_card::matchUntil(bufferedFile, '\n', description, MAX_FILE_DESCRIPTION_LENGTH);
-                    description[MAX_FILE_DESCRIPTION_LENGTH] = 0;
-                }
-
-                file.close();
-            }
-        }
-
-        descriptionLen = strlen(description);
-        if (descriptionLen > 0) {
-            descriptionLen = 4 * ((descriptionLen + 1 + 3) / 4);
-        }
-
         const char *str = strrchr(name, '.');
         if (str) {
             auto n = str - name;
@@ -150,7 +199,7 @@ void catalogCallback(void *param, const char *name, FileType type, size_t size)
 
     size_t nameLen = 4 * ((strlen(name) + 1 + 3) / 4);
 
-    if (g_frontBufferPosition + sizeof(FileItem) > g_backBufferPosition - nameLen - descriptionLen) {
+    if (g_frontBufferPosition + sizeof(FileItem) > g_backBufferPosition - nameLen) {
         return;
     }
 
@@ -163,13 +212,9 @@ void catalogCallback(void *param, const char *name, FileType type, size_t size)
     strcpy((char *)g_backBufferPosition, name);
     fileItem->name = (const char *)g_backBufferPosition;
 
-    if (descriptionLen > 0) {
-        g_backBufferPosition -= descriptionLen;
-        strcpy((char *)g_backBufferPosition, description);
-        fileItem->description = (const char *)g_backBufferPosition;
-    } else {
-        fileItem->description = nullptr;
-    }
+    // description is loaded later, only for the files that are actually displayed
+    fileItem->description = nullptr;
+    fileItem->descriptionLoaded = !isDescriptionsViewActive();
 
     fileItem->size = size;
 
@@ -286,15 +331,241 @@ int compareFunc(const void *p1, const void *p2) {
 } 
 
 void sort() {
+    g_fileItemsVersion++;
     qsort(FILE_MANAGER_MEMORY, g_filesCount, sizeof(FileItem), compareFunc);
 }
 
+static void getDescriptionsIndexFilePath(char *filePath) {
+    strcpy(filePath, g_currentDirectory);
+    strcat(filePath, "/" DESCRIPTIONS_INDEX_FILE_NAME);
+}
+
+static FileItem *findFileItemByName(const char *name) {
+    // files are sorted by name in scripts view
+    int low = 0;
+    int high = g_filesCount - 1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        auto fileItem = (FileItem *)FILE_MANAGER_MEMORY + mid;
+        int result = strcicmp(fileItem->name, name);
+        if (result == 0) {
+            return fileItem;
+        }
+        if (result < 0) {
+            low = mid + 1;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return nullptr;
+}
+
+static void setFileDescription(FileItem *fileItem, const char *description) {
+    if (*description) {
+        auto str = allocString(description);
+        if (!str) {
+            return;
+        }
+        fileItem->description = str;
+    }
+    fileItem->descriptionLoaded = true;
+}
+
+// returns true if index should be rewritten
+static bool loadDescriptionsIndex() {
+    char filePath[MAX_PATH_LENGTH + 1];
+    getDescriptionsIndexFilePath(filePath);
+
+    File file;
+    if (!file.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
+        return false;
+    }
+
+    uint32_t numLines = 0;
+    uint32_t numUsedLines = 0;
+
+    psu::sd_card::BufferedFileRead bufferedFile(file);
+
+    while (true) {
+        char name[MAX_PATH_LENGTH + 1];
+        unsigned int dateTime;
+        char separator[1];
+        char description[MAX_FILE_DESCRIPTION_LENGTH + 1];
+
+        if (
+            !psu::sd_card::matchUntil(bufferedFile, '\t', name, MAX_PATH_LENGTH) ||
+            !psu::sd_card::match(bufferedFile, dateTime) ||
+            !psu::sd_card::matchUntil(bufferedFile, '\t', separator, 0) ||
+            !psu::sd_card::matchUntil(bufferedFile, '\n', description, MAX_FILE_DESCRIPTION_LENGTH)
+        ) {
+            break;
+        }
+
+        numLines++;
+
+        auto fileItem = findFileItemByName(name);
+        if (fileItem && !fileItem->descriptionLoaded && fileItem->dateTime == dateTime) {
+            setFileDescription(fileItem, description);
+            numUsedLines++;
+        }
+    }
+
+    file.close();
+
+    uint32_t numStaleLines = numLines - numUsedLines;
+    return numStaleLines >= DESCRIPTIONS_INDEX_MIN_STALE_LINES && numStaleLines > numUsedLines;
+}
+
+static void writeDescriptionsIndexLine(psu::sd_card::BufferedFileWrite &bufferedFile, const char *name, uint32_t dateTime, const char *description) {
+    char dateTimeStr[16];
+    sprintf(dateTimeStr, "\t%u\t", (unsigned int)dateTime);
+
+    bufferedFile.write((const uint8_t *)name, strlen(name));
+    bufferedFile.write((const uint8_t *)dateTimeStr, strlen(dateTimeStr));
+    if (description) {
+        bufferedFile.write((const uint8_t *)description, strlen(description));
+    }
+    bufferedFile.print('\n');
+}
+
+// writes descriptions of all the loaded file items, without stale lines
+static void saveDescriptionsIndex() {
+    char filePath[MAX_PATH_LENGTH + 1];
+    getDescriptionsIndexFilePath(filePath);
+
+    File file;
+    if (!file.open(filePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
+        return;
+    }
+
+    psu::sd_card::BufferedFileWrite bufferedFile(file);
+
+    for (uint32_t i = 0; i < g_filesCount; i++) {
+        auto fileItem = (FileItem *)FILE_MANAGER_MEMORY + i;
+        if (fileItem->descriptionLoaded) {
+            writeDescriptionsIndexLine(bufferedFile, fileItem->name, fileItem->dateTime, fileItem->description);
+        }
+    }
+
+    bufferedFile.flush();
+
+    file.close();
+}
+
+static void appendDescriptionsIndex() {
+    char filePath[MAX_PATH_LENGTH + 1];
+    getDescriptionsIndexFilePath(filePath);
+
+    File file;
+    if (!file.open(filePath, FILE_OPEN_APPEND | FILE_WRITE)) {
+        return;
+    }
+
+    psu::sd_card::BufferedFileWrite bufferedFile(file);
+
+    for (uint32_t i = 0; i < g_numLoadedDescriptions; i++) {
+        auto &loadedDescription = g_loadedDescriptions[i];
+        writeDescriptionsIndexLine(bufferedFile, loadedDescription.name, loadedDescription.dateTime, loadedDescription.description);
+    }
+
+    bufferedFile.flush();
+
+    file.close();
+}
+
+static void readFileDescription(FileItem *fileItem, char *description) {
+    description[0] = 0;
+
+    char filePath[MAX_PATH_LENGTH + 1];
+    strcpy(filePath, g_currentDirectory);
+    strcat(filePath, "/");
+    strcat(filePath, fileItem->name);
+    strcat(filePath, ".py");
+
+    File file;
+    if (file.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
+        psu::sd_card::BufferedFileRead bufferedFile(file);
+
+        psu::sd_card::matchZeroOrMoreSpaces(bufferedFile);
+        if (psu::sd_card::match(bufferedFile, '#')) {
+            psu::sd_card::matchZeroOrMoreSpaces(bufferedFile);
+            psu::sd_card::matchUntil(bufferedFile, '\n', description, MAX_FILE_DESCRIPTION_LENGTH);
+            description[MAX_FILE_DESCRIPTION_LENGTH] = 0;
+
+            // strip CR and tabs so the description can be stored in the index file
+            for (char *p = description; *p; p++) {
+                if (*p == '\r' || *p == '\t') {
+                    *p = ' ';
+                }
+            }
+            size_t len = strlen(description);
+            while (len > 0 && description[len - 1] == ' ') {
+                description[--len] = 0;
+            }
+        }
+
+        file.close();
+    }
+}
+
+void loadVisibleDescriptions() {
+    if (g_state != STATE_READY || !isDescriptionsViewActive()) {
+        g_loadDescriptionsPending = false;
+        return;
+    }
+
+    uint32_t version = g_fileItemsVersion;
+    uint32_t numLoadedDescriptions = 0;
+
+    uint32_t endPosition = MIN(g_filesStartPosition + getFilesPageSize(), g_filesCount);
+    for (uint32_t i = g_filesStartPosition; i < endPosition && numLoadedDescriptions < MAX_LOADED_DESCRIPTIONS; i++) {
+        auto fileItem = (FileItem *)FILE_MANAGER_MEMORY + i;
+        if (fileItem->descriptionLoaded) {
+            continue;
+        }
+
+        auto &loadedDescription = g_loadedDescriptions[numLoadedDescriptions++];
+        loadedDescription.fileIndex = i;
+        loadedDescription.name = fileItem->name;
+        loadedDescription.dateTime = fileItem->dateTime;
+        readFileDescription(fileItem, loadedDescription.description);
+    }
+
+    if (numLoadedDescriptions == 0 || g_state != STATE_READY || version != g_fileItemsVersion) {
+        g_loadDescriptionsPending = false;
+        return;
+    }
+
+    g_numLoadedDescriptions = numLoadedDescriptions;
+    g_loadedDescriptionsVersion = version;
+
+    appendDescriptionsIndex();
+
+    // buffer is not touched again until GUI thread clears g_loadDescriptionsPending
+    osMessagePut(g_guiMessageQueueId, GUI_QUEUE_MESSAGE(GUI_QUEUE_MESSAGE_TYPE_FILE_MANAGER_DESCRIPTIONS_LOADED, 0), osWaitForever);
+}
+
+void onDescriptionsLoaded() {
+    if (g_state == STATE_READY && g_loadedDescriptionsVersion == g_fileItemsVersion) {
+        for (uint32_t i = 0; i < g_numLoadedDescriptions; i++) {
+            auto &loadedDescription = g_loadedDescriptions[i];
+            auto fileItem = (FileItem *)FILE_MANAGER_MEMORY + loadedDescription.fileIndex;
+            if (!fileItem->descriptionLoaded) {
+                setFileDescription(fileItem, loadedDescription.description);
+            }
+        }
+    }
+
+    g_loadDescriptionsPending = false;
+}
+
 void loadDirectory() {
     if (g_state == STATE_LOADING) {
         return;
     }
 
     g_state = STATE_LOADING;
+    g_fileItemsVersion++;
     g_filesCount = 0;
     g_selectedFileIndex = -1;
     g_savedFilesStartPosition = g_filesStartPosition;
@@ -309,18 +580,227 @@ void loadDirectory() {
     }
 }
 
+static void resetThumbnails() {
+    for (uint32_t i = 0; i < NUM_THUMBNAILS; i++) {
+        g_thumbnails[i].ready = false;
+        g_thumbnails[i].fileIndex = -1;
+    }
+}
+
+static Thumbnail *findThumbnail(uint32_t fileIndex) {
+    for (uint32_t i = 0; i < NUM_THUMBNAILS; i++) {
+        if (g_thumbnails[i].fileIndex == (int32_t)fileIndex) {
+            return &g_thumbnails[i];
+        }
+    }
+    return nullptr;
+}
+
+static Thumbnail *allocThumbnail(uint32_t startPosition, uint32_t endPosition) {
+    // reuse thumbnail which is not visible
+    for (uint32_t i = 0; i < NUM_THUMBNAILS; i++) {
+        uint32_t thumbnailIndex = g_nextThumbnail;
+        g_nextThumbnail = (g_nextThumbnail + 1) % NUM_THUMBNAILS;
+
+        auto thumbnail = &g_thumbnails[thumbnailIndex];
+        if (thumbnail->fileIndex == -1 || (uint32_t)thumbnail->fileIndex < startPosition || (uint32_t)thumbnail->fileIndex >= endPosition) {
+            thumbnail->ready = false;
+            thumbnail->fileIndex = -1;
+            thumbnail->image.pixels = THUMBNAILS_MEMORY + thumbnailIndex * THUMBNAIL_BUFFER_SIZE;
+            return thumbnail;
+        }
+    }
+    return nullptr;
+}
+
+static bool getThumbnailFilePath(FileItem *fileItem, char *filePath) {
+    if (strlen(g_currentDirectory) + sizeof("/" THUMBNAILS_DIR_NAME "/") - 1 + strlen(fileItem->name) + sizeof(".thm") - 1 > MAX_PATH_LENGTH) {
+        return false;
+    }
+    strcpy(filePath, g_currentDirectory);
+    strcat(filePath, "/" THUMBNAILS_DIR_NAME "/");
+    strcat(filePath, fileItem->name);
+    strcat(filePath, ".thm");
+    return true;
+}
+
+static bool loadCachedThumbnail(FileItem *fileItem, Thumbnail *thumbnail) {
+    char filePath[MAX_PATH_LENGTH + 1];
+    if (!getThumbnailFilePath(fileItem, filePath)) {
+        return false;
+    }
+
+    File file;
+    if (!file.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
+        return false;
+    }
+
+    ThumbnailFileHeader header;
+    if (file.read(&header, sizeof(header)) != sizeof(header)) {
+        file.close();
+        return false;
+    }
+
+    // thumbnail is stale if image was modified after it was generated
+    uint32_t pixelsSize = header.width * header.height * header.bpp / 8;
+    if (
+        header.magic != THUMBNAIL_FILE_MAGIC ||
+        header.dateTime != fileItem->dateTime ||
+        header.size != fileItem->size ||
+        (header.bpp != 16 && header.bpp != 24) ||
+        pixelsSize == 0 || pixelsSize > THUMBNAIL_BUFFER_SIZE
+    ) {
+        file.close();
+        return false;
+    }
+
+    if (file.read(thumbnail->image.pixels, pixelsSize) != pixelsSize) {
+        file.close();
+        return false;
+    }
+
+    file.close();
+
+    thumbnail->image.width = header.width;
+    thumbnail->image.height = header.height;
+    thumbnail->image.bpp = header.bpp;
+    thumbnail->image.lineOffset = 0;
+
+    return true;
+}
+
+static bool generateThumbnail(FileItem *fileItem, Thumbnail *thumbnail) {
+    if (strlen(g_currentDirectory) + 1 + strlen(fileItem->name) > MAX_PATH_LENGTH) {
+        return false;
+    }
+
+    char filePath[MAX_PATH_LENGTH + 1];
+    strcpy(filePath, g_currentDirectory);
+    strcat(filePath, "/");
+    strcat(filePath, fileItem->name);
+
+    Image image;
+    if (!imageDecodeThumbnail(filePath, &image)) {
+        return false;
+    }
+
+    uint32_t pixelsSize = image.width * image.height * image.bpp / 8;
+    if (pixelsSize > THUMBNAIL_BUFFER_SIZE) {
+        return false;
+    }
+
+    memcpy(thumbnail->image.pixels, image.pixels, pixelsSize);
+
+    thumbnail->image.width = image.width;
+    thumbnail->image.height = image.height;
+    thumbnail->image.bpp = image.bpp;
+    thumbnail->image.lineOffset = 0;
+
+    return true;
+}
+
+static void saveCachedThumbnail(FileItem *fileItem, Thumbnail *thumbnail) {
+    char filePath[MAX_PATH_LENGTH + 1];
+    if (!getThumbnailFilePath(fileItem, filePath)) {
+        return;
+    }
+
+    File file;
+    if (!file.open(filePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
+        return;
+    }
+
+    ThumbnailFileHeader header;
+    header.magic = THUMBNAIL_FILE_MAGIC;
+    header.dateTime = fileItem->dateTime;
+    header.size = fileItem->size;
+    header.width = (uint16_t)thumbnail->image.width;
+    header.height = (uint16_t)thumbnail->image.height;
+    header.bpp = thumbnail->image.bpp;
+
+    uint32_t pixelsSize = header.width * header.height * header.bpp / 8;
+
+    if (file.write(&header, sizeof(header)) != sizeof(header) || file.write(thumbnail->image.pixels, pixelsSize) != pixelsSize) {
+        file.close();
+        psu::sd_card::deleteFile(filePath, nullptr);
+        return;
+    }
+
+    file.close();
+}
+
+void loadVisibleThumbnails() {
+    g_loadThumbnailsPending = false;
+
+    if (g_state != STATE_READY || getListViewOption() != LIST_VIEW_LARGE_ICONS) {
+        return;
+    }
+
+    uint32_t startPosition = g_filesStartPosition;
+    uint32_t endPosition = MIN(startPosition + getFilesPageSize(), g_filesCount);
+
+    bool cacheDirChecked = false;
+    bool cacheDirExists = false;
+
+    for (uint32_t i = startPosition; i < endPosition && g_state == STATE_READY; i++) {
+        auto fileItem = (FileItem *)FILE_MANAGER_MEMORY + i;
+        if (fileItem->type != FILE_TYPE_IMAGE || findThumbnail(i)) {
+            continue;
+        }
+
+        if (!cacheDirChecked) {
+            cacheDirChecked = true;
+
+            char dirPath[MAX_PATH_LENGTH + 1];
+            if (strlen(g_currentDirectory) + sizeof("/" THUMBNAILS_DIR_NAME) - 1 <= MAX_PATH_LENGTH) {
+                strcpy(dirPath, g_currentDirectory);
+                strcat(dirPath, "/" THUMBNAILS_DIR_NAME);
+                cacheDirExists = psu::sd_card::exists(dirPath, nullptr);
+                if (!cacheDirExists && psu::sd_card::makeDir(dirPath, nullptr)) {
+                    // directory change reloads the current directory,
+                    // thumbnails will be requested again
+                    return;
+                }
+            }
+        }
+
+        auto thumbnail = allocThumbnail(startPosition, endPosition);
+        if (!thumbnail) {
+            break;
+        }
+        thumbnail->fileIndex = i;
+
+        if (!cacheDirExists || !loadCachedThumbnail(fileItem, thumbnail)) {
+            if (generateThumbnail(fileItem, thumbnail)) {
+                if (cacheDirExists) {
+                    saveCachedThumbnail(fileItem, thumbnail);
+                }
+            } else {
+                thumbnail->image.pixels = nullptr;
+            }
+        }
+
+        thumbnail->ready = true;
+    }
+}
+
 void doLoadDirectory() {
     if (g_state != STATE_LOADING) {
         return;
     }
 
     g_frontBufferPosition = FILE_MANAGER_MEMORY;
-    g_backBufferPosition = FILE_MANAGER_MEMORY + FILE_MANAGER_MEMORY_SIZE;
+    g_backBufferPosition = THUMBNAILS_MEMORY;
+
+    resetThumbnails();
 
     int numFiles;
     int err;
     if (psu::sd_card::catalog(g_currentDirectory, 0, catalogCallback, &numFiles, &err)) {
         sort();
+        if (isDescriptionsViewActive() && loadDescriptionsIndex()) {
+            saveDescriptionsIndex();
+        }
         setFilesStartPosition(g_savedFilesStartPosition);
         g_state = STATE_READY;
     } else {
@@ -587,7 +1067,35 @@ const uint32_t getFileDataTime(uint32_t fileIndex) {
 
 const char *getFileDescription(uint32_t fileIndex) {
     auto fileItem = getFileItem(fileIndex);
-    return fileItem && fileItem->description ? fileItem->description : "";
+    if (!fileItem) {
+        return "";
+    }
+
+    if (!fileItem->descriptionLoaded && !g_loadDescriptionsPending) {
+        g_loadDescriptionsPending = true;
+        sendMessageToLowPriorityThread(THREAD_MESSAGE_FILE_MANAGER_LOAD_DESCRIPTIONS);
+    }
+
+    return fileItem->description ? fileItem->description : "";
+}
+
+Image *getFileThumbnail(uint32_t fileIndex) {
+    auto fileItem = getFileItem(fileIndex);
+    if (!fileItem || fileItem->type != FILE_TYPE_IMAGE || getListViewOption() != LIST_VIEW_LARGE_ICONS) {
+        return nullptr;
+    }
+
+    auto thumbnail = findThumbnail(fileIndex);
+    if (thumbnail) {
+        return thumbnail->ready && thumbnail->image.pixels ? &thumbnail->image : nullptr;
+    }
+
+    if (!g_loadThumbnailsPending) {
+        g_loadThumbnailsPending = true;
+        sendMessageToLowPriorityThread(THREAD_MESSAGE_FILE_MANAGER_LOAD_THUMBNAILS);
+    }
+
+    return nullptr;
 }
 
 bool isFileSelected(uint32_t fileIndex) {
@@ -713,19 +1221,10 @@ void openImageFile() {
 }
 
 bool isUploadFileEnabled() {
-#if !defined(EEZ_PLATFORM_SIMULATOR)
-    if (psu::serial::isConnected()) {
-        return true;
-    }
-#endif
-
-#if OPTION_ETHERNET
-    if (psu::ethernet::isConnected()) {
-        return true;
-    }
-#endif
-
-    return false;
+    // also enabled when more than one remote session is connected,
+    // so uploadFile can tell why the upload is not possible
+    int err;
+    return psu::scpi::getUploadContext(&err) != nullptr || err != 0;
 }
 
 void uploadFile() {
@@ -741,21 +1240,12 @@ void uploadFile() {
         return;
     }
 
-    scpi_t *context = nullptr;
-
-#if !defined(EEZ_PLATFORM_SIMULATOR)
-    if (psu::serial::isConnected()) {
-        context = &psu::serial::g_scpiContext;
-    }
-#endif
-
-#if OPTION_ETHERNET
-    if (!context && psu::ethernet::isConnected()) {
-        context = &psu::ethernet::g_scpiContext;
-    }
-#endif
-
+    int err;
+    scpi_t *context = psu::scpi::getUploadContext(&err);
     if (!context) {
+        if (err != 0) {
+            errorMessage(Value(err, VALUE_TYPE_SCPI_ERROR));
+        }
         return;
     }
 
@@ -769,7 +1259,6 @@ void uploadFile() {
     strcat(filePath, "/");
     strcat(filePath, fileItem->name);
 
-    int err;
     if (!psu::scpi::mmemUpload(filePath, context, &err)) {
         errorMessage(Value(err, VALUE_TYPE_SCPI_ERROR));
     }
@@ -1058,7 +1547,10 @@ void data_file_manager_file_type(DataOperationEnum operation, Cursor cursor, Val
 
 void data_file_manager_file_icon(DataOperationEnum operation, Cursor cursor, Value &value) {
     if (operation == DATA_OPERATION_GET) {
-        value = getFileIcon(cursor);
+        // icon is replaced by the thumbnail once it is available
+        if (!getFileThumbnail(cursor)) {
+            value = getFileIcon(cursor);
+        }
     }
 }
 
@@ -1140,6 +1632,15 @@ void data_file_manager_delete_file_enabled(DataOperationEnum operation, Cursor c
     }
 }
 
+void data_file_manager_file_thumbnail(DataOperationEnum operation, Cursor cursor, Value &value) {
+    if (operation == DATA_OPERATION_GET_BITMAP_IMAGE) {
+        auto thumbnail = getFileThumbnail(cursor);
+        if (thumbnail) {
+            value = Value(thumbnail, VALUE_TYPE_POINTER);
+        }
+    }
+}
+
 void data_file_manager_opened_image(DataOperationEnum operation, Cursor cursor, Value &value) {
     if (operation == DATA_OPERATION_GET_BITMAP_IMAGE) {
         if (g_openedImage.pixels) {
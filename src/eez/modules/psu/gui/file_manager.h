@@ -18,6 +18,8 @@
 
 #pragma once
 
+struct Image;
+
 namespace eez {
 namespace gui {
 namespace file_manager {
@@ -59,6 +61,7 @@ const char *getFileName(uint32_t fileIndex);
 const uint32_t getFileSize(uint32_t fileIndex);
 const uint32_t getFileDataTime(uint32_t fileIndex);
 const char *getFileDescription(uint32_t fileIndex);
+Image *getFileThumbnail(uint32_t fileIndex);
 bool isFileSelected(uint32_t fileIndex);
 bool isSelectFileActionEnabled(uint32_t fileIndex);
 void selectFile(uint32_t fileIndex);
@@ -97,6 +100,11 @@ bool isSaveDialog();
 void newFile();
 
 void doLoadDirectory();
+// reads descriptions of the visible scripts and posts them to the GUI thread
+void loadVisibleDescriptions();
+// sets loaded descriptions to the file items, called from the GUI thread
+void onDescriptionsLoaded();
+void loadVisibleThumbnails();
 void doRenameFile();
 void onSdCardMountedChange();
 
@@ -2317,6 +2317,8 @@ void onGuiQueueMessageHook(uint8_t type, int16_t param) {
         g_psuAppContext.doShowAsyncOperationInProgress();
     } else if (type == GUI_QUEUE_MESSAGE_TYPE_HIDE_ASYNC_OPERATION_IN_PROGRESS) {
         g_psuAppContext.doHideAsyncOperationInProgress();
+    } else if (type == GUI_QUEUE_MESSAGE_TYPE_FILE_MANAGER_DESCRIPTIONS_LOADED) {
+        file_manager::onDescriptionsLoaded();
     }
 }
 
@@ -404,7 +404,8 @@ enum {
     GUI_QUEUE_MESSAGE_TYPE_DIALOG_OPEN,
     GUI_QUEUE_MESSAGE_TYPE_DIALOG_CLOSE,
     GUI_QUEUE_MESSAGE_TYPE_SHOW_ASYNC_OPERATION_IN_PROGRESS,
-    GUI_QUEUE_MESSAGE_TYPE_HIDE_ASYNC_OPERATION_IN_PROGRESS
+    GUI_QUEUE_MESSAGE_TYPE_HIDE_ASYNC_OPERATION_IN_PROGRESS,
+    GUI_QUEUE_MESSAGE_TYPE_FILE_MANAGER_DESCRIPTIONS_LOADED
 };
 
 } // namespace gui
@@ -17,6 +17,7 @@
  */
 
 #include <assert.h>
+#include <string.h>
 
 #if defined EEZ_PLATFORM_STM32
 #include <main.h>
@@ -65,6 +66,23 @@ static uint32_t g_pwmPeriodInt[NUM_IO_PINS - DOUT1];
 static bool m_gPwmStarted;
 static float g_pwmStartedFrequency;
 
+// Trigger edges captured by EXTI interrupt, consumed in tick().
+// There is a single producer (interrupt) and a single consumer (PSU thread).
+struct TriggerEvent {
+    uint8_t pin;
+    uint64_t timestamp; // micros64
+};
+
+static const uint32_t TRIGGER_EVENTS_QUEUE_SIZE = 16;
+static TriggerEvent g_triggerEvents[TRIGGER_EVENTS_QUEUE_SIZE];
+static volatile uint32_t g_triggerEventsHead;
+static volatile uint32_t g_triggerEventsTail;
+
+static volatile bool g_extTrigInterruptEnabled[2];
+
+static TriggerLatencyStatistics g_triggerLatencyStatistics[2];
+static volatile bool g_resetTriggerLatencyStatisticsRequested;
+
 #if defined EEZ_PLATFORM_STM32
 
 int ioPinRead(int pin) {
@@ -142,6 +160,10 @@ uint8_t isOutputEnabled() {
     return 0;
 }
 
+static bool isTriggerFunction(unsigned function) {
+    return function == io_pins::FUNCTION_SYSTRIG || function == io_pins::FUNCTION_DLOGTRIG;
+}
+
 void initInputPin(int pin) {
 #if defined EEZ_PLATFORM_STM32
     if (!bp3c::flash_slave::g_bootloaderMode || pin != 0) {
@@ -149,8 +171,15 @@ void initInputPin(int pin) {
 
         const IOPin &ioPin = g_ioPins[pin];
 
+        // DIN1 (PF6) shares EXTI line 6 with the encoder (PC6), so only DIN2 can use interrupt
+        g_extTrigInterruptEnabled[pin] = pin == EXT_TRIG2 && isTriggerFunction(ioPin.function);
+
         GPIO_InitStruct.Pin = pin == 0 ? UART_RX_DIN1_Pin : DIN2_Pin;
-        GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
+        if (g_extTrigInterruptEnabled[pin]) {
+            GPIO_InitStruct.Mode = ioPin.polarity == io_pins::POLARITY_POSITIVE ? GPIO_MODE_IT_RISING : GPIO_MODE_IT_FALLING;
+        } else {
+            GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
+        }
         GPIO_InitStruct.Pull = ioPin.polarity == io_pins::POLARITY_POSITIVE ? GPIO_PULLDOWN : GPIO_PULLUP;
         GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
         HAL_GPIO_Init(pin == 0 ? UART_RX_DIN1_GPIO_Port : DIN2_GPIO_Port, &GPIO_InitStruct);
@@ -282,7 +311,79 @@ void init() {
     refresh(); // this will initialize input pins
 }
 
+void onExtTrigInterrupt(int pin) {
+    if (!g_extTrigInterruptEnabled[pin]) {
+        return;
+    }
+
+    uint64_t timestamp = micros64();
+
+    uint32_t head = g_triggerEventsHead;
+    uint32_t nextHead = (head + 1) % TRIGGER_EVENTS_QUEUE_SIZE;
+    if (nextHead == g_triggerEventsTail) {
+        g_triggerLatencyStatistics[pin].numLost++;
+        return;
+    }
+
+    g_triggerEvents[head].pin = (uint8_t)pin;
+    g_triggerEvents[head].timestamp = timestamp;
+    g_triggerEventsHead = nextHead;
+}
+
+bool isExtTrigInterruptEnabled(int pin) {
+    return g_extTrigInterruptEnabled[pin];
+}
+
+static void addTriggerLatency(int pin, uint32_t latency) {
+    TriggerLatencyStatistics &statistics = g_triggerLatencyStatistics[pin];
+
+    statistics.numTriggers++;
+    statistics.lastLatencyUs = latency;
+    if (latency > statistics.maxLatencyUs) {
+        statistics.maxLatencyUs = latency;
+    }
+    statistics.totalLatencyUs += latency;
+
+    int bucket = 0;
+    while (latency > 0) {
+        latency >>= 1;
+        bucket++;
+    }
+    if (bucket < TRIGGER_LATENCY_HISTOGRAM_SIZE) {
+        statistics.histogram[bucket]++;
+    } else {
+        statistics.overflow++;
+    }
+}
+
+static void onTriggerEdge(int pin, uint64_t timestamp) {
+    trigger::generateTriggerAt(pin == EXT_TRIG1 ? trigger::SOURCE_PIN1 : trigger::SOURCE_PIN2, timestamp);
+    addTriggerLatency(pin, (uint32_t)(micros64() - timestamp));
+}
+
+void getTriggerLatencyStatistics(int pin, TriggerLatencyStatistics &statistics) {
+    memcpy(&statistics, &g_triggerLatencyStatistics[pin], sizeof(TriggerLatencyStatistics));
+}
+
+void resetTriggerLatencyStatistics() {
+    g_resetTriggerLatencyStatisticsRequested = true;
+}
+
 void tick(uint32_t tickCount) {
+    if (g_resetTriggerLatencyStatisticsRequested) {
+        g_resetTriggerLatencyStatisticsRequested = false;
+        memset(g_triggerLatencyStatistics, 0, sizeof(g_triggerLatencyStatistics));
+    }
+
+    // execute triggers captured by interrupt
+    while (g_triggerEventsTail != g_triggerEventsHead) {
+        const TriggerEvent &event = g_triggerEvents[g_triggerEventsTail];
+        if (isTriggerFunction(g_ioPins[event.pin].function)) {
+            onTriggerEdge(event.pin, event.timestamp);
+        }
+        g_triggerEventsTail = (g_triggerEventsTail + 1) % TRIGGER_EVENTS_QUEUE_SIZE;
+    }
+
     // execute input pins function
     const IOPin &inputPin1 = g_ioPins[0];
     int inputPin1Value = ioPinRead(EXT_TRIG1);
@@ -309,12 +410,13 @@ void tick(uint32_t tickCount) {
         Channel::onInhibitedChanged(inhibited);
     }
 
-    if ((inputPin1.function == io_pins::FUNCTION_SYSTRIG || inputPin1.function == io_pins::FUNCTION_DLOGTRIG) && inputPin1State && !g_pinState[0]) {
-        trigger::generateTrigger(trigger::SOURCE_PIN1);
+    // edges of the pins without interrupt are detected here, at the tick time
+    if (!g_extTrigInterruptEnabled[0] && isTriggerFunction(inputPin1.function) && inputPin1State && !g_pinState[0]) {
+        onTriggerEdge(EXT_TRIG1, micros64());
     }
 
-    if ((inputPin2.function == io_pins::FUNCTION_SYSTRIG || inputPin2.function == io_pins::FUNCTION_DLOGTRIG) && inputPin2State && !g_pinState[1]) {
-        trigger::generateTrigger(trigger::SOURCE_PIN2);
+    if (!g_extTrigInterruptEnabled[1] && isTriggerFunction(inputPin2.function) && inputPin2State && !g_pinState[1]) {
+        onTriggerEdge(EXT_TRIG2, micros64());
     }
 
     g_pinState[0] = inputPin1State;
@@ -87,6 +87,28 @@ void ioPinWrite(int pin, int state);
 bool getIsInhibitedByUser();
 void setIsInhibitedByUser(bool isInhibitedByUser);
 
+// Called from the EXTI interrupt on the active edge of the trigger input pin.
+void onExtTrigInterrupt(int pin);
+
+// Bucket 0 counts latencies below 1 us, bucket N latencies in [2^(N-1), 2^N) us.
+// Latencies of 2^(TRIGGER_LATENCY_HISTOGRAM_SIZE - 1) us and above are counted in overflow.
+static const int TRIGGER_LATENCY_HISTOGRAM_SIZE = 16;
+
+struct TriggerLatencyStatistics {
+    uint32_t numTriggers;
+    uint32_t numLost; // trigger queue overflows
+    uint32_t lastLatencyUs;
+    uint32_t maxLatencyUs;
+    uint64_t totalLatencyUs;
+    uint32_t histogram[TRIGGER_LATENCY_HISTOGRAM_SIZE];
+    uint32_t overflow;
+};
+
+bool isExtTrigInterruptEnabled(int pin);
+void getTriggerLatencyStatistics(int pin, TriggerLatencyStatistics &statistics);
+// Statistics are reset in the next tick, i.e. inside the PSU thread.
+void resetTriggerLatencyStatistics();
+
 }
 }
 } // namespace eez::psu::io_pins
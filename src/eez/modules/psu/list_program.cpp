@@ -36,7 +36,6 @@
 
 #include <eez/libs/sd_fat/sd_fat.h>
 
-#define CONF_COUNTER_THRESHOLD_IN_SECONDS 5
 #define CONF_SAVE_LIST_TIMEOUT_MS 2000
 
 namespace eez {
@@ -62,10 +61,10 @@ static struct {
 static struct {
     int32_t counter;
     int16_t it;
-    uint32_t nextPointTime;
-    int32_t currentRemainingDwellTime;
+    uint64_t nextPointTime; // in microseconds
+    int64_t currentRemainingDwellTime; // in microseconds
     float currentTotalDwellTime;
-    uint32_t lastTickCount;
+    uint64_t lastTickCount;
 } g_execution[CH_MAX];
 
 static bool g_active;
@@ -577,7 +576,7 @@ bool setListValue(Channel &channel, int16_t it, int *err) {
     return true;
 }
 
-void tick(uint32_t tick_usec) {
+void tick(uint64_t tick_usec) {
     bool active = false;
 
     for (int i = 0; i < CH_NUM; ++i) {
@@ -591,10 +590,7 @@ void tick(uint32_t tick_usec) {
 
             active = true;
 
-            uint32_t tickCount = millis();
-            if (g_execution[i].currentTotalDwellTime <= CONF_COUNTER_THRESHOLD_IN_SECONDS) {
-                tickCount *= 1000;
-            }
+            uint64_t tickCount = tick_usec;
 
             if (io_pins::isInhibited()) {
                 if (g_execution[i].it != -1) {
@@ -606,13 +602,17 @@ void tick(uint32_t tick_usec) {
                 if (g_execution[i].it == -1) {
                     set = true;
                 } else {
-                    g_execution[i].currentRemainingDwellTime = g_execution[i].nextPointTime - tickCount;
+                    g_execution[i].currentRemainingDwellTime = (int64_t)(g_execution[i].nextPointTime - tickCount);
                     if (g_execution[i].currentRemainingDwellTime <= 0) {
                         set = true;
                     }
                 }
 
                 if (set) {
+                    // next point is scheduled relative to the time current point should have been set,
+                    // so late ticks don't accumulate, unless we are behind more then the whole dwell time
+                    uint64_t pointTime = g_execution[i].it == -1 ? tickCount : g_execution[i].nextPointTime;
+
                     if (++g_execution[i].it == maxListsSize(channel)) {
                         if (g_execution[i].counter > 0) {
                             if (--g_execution[i].counter == 0) {
@@ -634,15 +634,13 @@ void tick(uint32_t tick_usec) {
                     }
 
                     g_execution[i].currentTotalDwellTime = g_channelsLists[i] .dwellList[g_execution[i].it % g_channelsLists[i].dwellListLength];
-                    // if dwell time is greater then CONF_COUNTER_THRESHOLD_IN_SECONDS ...
-                    if (g_execution[i].currentTotalDwellTime > CONF_COUNTER_THRESHOLD_IN_SECONDS) {
-                        // ... then count in milliseconds
-                        g_execution[i].currentRemainingDwellTime = (uint32_t)round(g_execution[i].currentTotalDwellTime * 1000L);
-                    } else {
-                        // ... else count in microseconds
-                        g_execution[i].currentRemainingDwellTime = (uint32_t)round(g_execution[i].currentTotalDwellTime * 1000000L);
+                    g_execution[i].currentRemainingDwellTime = (int64_t)round(g_execution[i].currentTotalDwellTime * 1000000L);
+
+                    if (tickCount - pointTime > (uint64_t)g_execution[i].currentRemainingDwellTime) {
+                        pointTime = tickCount;
                     }
-                    g_execution[i].nextPointTime = tickCount + g_execution[i].currentRemainingDwellTime;
+                    g_execution[i].nextPointTime = pointTime + g_execution[i].currentRemainingDwellTime;
+                    g_execution[i].currentRemainingDwellTime = (int64_t)(g_execution[i].nextPointTime - tickCount);
                 }
             }
 
@@ -701,11 +699,7 @@ bool getCurrentDwellTime(Channel &channel, int32_t &remaining, uint32_t &total)
     int i = channel.flags.trackingEnabled ? getFirstTrackingChannel() : channel.channelIndex;
     if (g_execution[i].counter >= 0) {
         total = (uint32_t)ceilf(g_execution[i].currentTotalDwellTime);
-        if (g_execution[i].currentTotalDwellTime > CONF_COUNTER_THRESHOLD_IN_SECONDS) {
-            remaining = (uint32_t)ceil(g_execution[i].currentRemainingDwellTime / 1000L);
-        } else {
-            remaining = (uint32_t)ceil(g_execution[i].currentRemainingDwellTime / 1000000L);
-        }
+        remaining = (int32_t)(g_execution[i].currentRemainingDwellTime / 1000000L);
         return true;
     }
     return false;
@@ -19,10 +19,23 @@
 #include <eez/modules/psu/psu.h>
 
 #include <stdio.h>
+#include <string.h>
+
+#if defined(EEZ_PLATFORM_STM32)
+#include <rng.h>
+#endif
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+#include <time.h>
+#endif
 
 #include <eez/modules/psu/ontime.h>
 #include <eez/modules/psu/persist_conf.h>
+#include <eez/modules/mcu/eeprom.h>
+#include <eez/firmware.h>
 #include <eez/system.h>
+#include <eez/tasks.h>
+#include <eez/util.h>
 
 #define MIN_TO_MS (60L * 1000L)
 
@@ -38,6 +51,103 @@ ontime::Counter g_moduleCounters[] = {
     ontime::Counter(ontime::ON_TIME_COUNTER_SLOT3)
 };
 
+////////////////////////////////////////////////////////////////////////////////
+
+static const uint32_t ONTIME_JOURNAL_MAGIC = 0x4F4E544AL;
+
+static const uint16_t JOURNAL_RECORD_SIZE = 64;
+static const uint16_t NUM_JOURNAL_RECORDS = mcu::eeprom::EEPROM_ONTIME_JOURNAL_SIZE / JOURNAL_RECORD_SIZE;
+
+struct JournalEntry {
+    uint16_t moduleType;
+    uint16_t reserved;
+    uint32_t moduleId;  // ID from module EEPROM, 0 for the MCU counter
+    uint32_t totalTime;
+};
+
+struct JournalRecord {
+    uint32_t magic;
+    uint32_t sequence;
+    JournalEntry entries[NUM_ON_TIME_COUNTERS];
+    uint32_t reserved;
+    uint32_t checksum;
+};
+
+static_assert(sizeof(JournalRecord) == JOURNAL_RECORD_SIZE, "JournalRecord must fill the record location");
+
+struct Backend {
+    bool (*readJournal)(uint8_t *buffer, uint16_t bufferSize, uint16_t offset);
+    bool (*writeJournal)(const uint8_t *buffer, uint16_t bufferSize, uint16_t offset);
+    uint32_t (*readHome)(int type);
+    bool (*writeHome)(int type, uint32_t time);
+    uint16_t (*getModuleType)(int slotIndex);
+    uint32_t (*getModuleId)(int slotIndex); // 0 if module has no ID
+};
+
+static uint16_t getSlotModuleType(int slotIndex) {
+    return g_slots[slotIndex]->moduleInfo->moduleType;
+}
+
+static uint32_t generateModuleId(int slotIndex) {
+    uint32_t moduleId = 0;
+
+#if defined(EEZ_PLATFORM_STM32)
+    HAL_RNG_GenerateRandomNumber(&hrng, &moduleId);
+#endif
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    uint32_t seed[3] = { (uint32_t)time(NULL), micros(), (uint32_t)slotIndex };
+    moduleId = crc32((const uint8_t *)seed, sizeof(seed));
+#endif
+
+    return moduleId != 0 ? moduleId : 1;
+}
+
+static uint32_t getSlotModuleId(int slotIndex) {
+    uint32_t moduleId;
+    if (persist_conf::readModuleId(slotIndex, moduleId)) {
+        return moduleId;
+    }
+
+    // first boot with this module
+    moduleId = generateModuleId(slotIndex);
+    return persist_conf::writeModuleId(slotIndex, moduleId) ? moduleId : 0;
+}
+
+static const Backend g_eepromBackend = {
+    persist_conf::readOnTimeJournal,
+    persist_conf::writeOnTimeJournal,
+    persist_conf::readTotalOnTime,
+    persist_conf::writeTotalOnTime,
+    getSlotModuleType,
+    getSlotModuleId
+};
+
+struct Persistence {
+    Counter *counters[NUM_ON_TIME_COUNTERS];
+    const Backend *backend;
+    uint32_t commitInterval;    // in minutes
+    uint32_t homeWriteInterval; // in minutes
+    uint32_t lastCommitTickCount;
+    uint32_t lastHomeWriteTickCount;
+    uint16_t moduleTypes[NUM_ON_TIME_COUNTERS];
+    uint32_t moduleIds[NUM_ON_TIME_COUNTERS];
+    uint32_t homeTime[NUM_ON_TIME_COUNTERS];
+    JournalEntry committedEntries[NUM_ON_TIME_COUNTERS];
+    uint32_t sequence;
+    uint16_t recordIndex;
+    Statistics statistics;
+};
+
+static Persistence g_persistence = {
+    { &g_mcuCounter, &g_moduleCounters[0], &g_moduleCounters[1], &g_moduleCounters[2] },
+    &g_eepromBackend,
+    WRITE_ONTIME_INTERVAL,
+    WRITE_ONTIME_HOME_INTERVAL
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 void counterToString(char *str, size_t count, uint32_t counterTime) {
     if (counterTime >= 24 * 60) {
         uint32_t d = counterTime / (24 * 60);
@@ -54,12 +164,11 @@ void counterToString(char *str, size_t count, uint32_t counterTime) {
 }
 
 Counter::Counter(int type_)
-    : typeAndIsActive(type_), totalTime(0), lastTime(0), fractionTime(0),
-      writeInterval(WRITE_ONTIME_INTERVAL * MIN_TO_MS) {
+    : typeAndIsActive(type_), totalTime(0), lastTime(0), fractionTime(0) {
 }
 
-void Counter::init() {
-    totalTime = persist_conf::readTotalOnTime(getType());
+void Counter::init(uint32_t totalTime_) {
+    totalTime = totalTime_;
 }
 
 int Counter::getType() {
@@ -75,24 +184,35 @@ bool Counter::isActive() {
 }
 
 void Counter::start() {
+    start(millis());
+}
+
+void Counter::start(uint32_t tickCountMs) {
     if (!isActive()) {
-        lastTick = millis();
+        lastTick = tickCountMs;
         typeAndIsActive |= 0x80;
     }
 }
 
 void Counter::stop() {
+    stop(millis());
+}
+
+void Counter::stop(uint32_t tickCountMs) {
     if (isActive()) {
-        fractionTime += millis() - lastTick;
+        fractionTime += tickCountMs - lastTick;
         typeAndIsActive &= ~0x80;
         totalTime += lastTime;
         lastTime = 0;
+
+        // count whole minutes now, so they are committed on power down
+        tick(tickCountMs);
     }
 }
 
-void Counter::tick(uint32_t tick_usec) {
+void Counter::tick(uint32_t tickCountMs) {
     if (isActive()) {
-        uint32_t timeMS = millis() - lastTick;
+        uint32_t timeMS = tickCountMs - lastTick;
         lastTick += timeMS;
         fractionTime += timeMS;
     }
@@ -101,10 +221,6 @@ void Counter::tick(uint32_t tick_usec) {
     if (time > 0) {
         lastTime += time;
         fractionTime -= time * MIN_TO_MS;
-
-        if (writeInterval.test(tick_usec)) {
-            persist_conf::writeTotalOnTime(getType(), getTotalTime());
-        }
     }
 }
 
@@ -116,6 +232,466 @@ uint32_t Counter::getLastTime() {
     return lastTime;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+static bool isPresent(int type) {
+    return type == ON_TIME_COUNTER_MCU || g_persistence.moduleTypes[type] != MODULE_TYPE_NONE;
+}
+
+static uint32_t calcRecordChecksum(const JournalRecord &record) {
+    return crc32((const uint8_t *)&record, offsetof(JournalRecord, checksum));
+}
+
+static bool isRecordValid(const JournalRecord &record) {
+    return record.magic == ONTIME_JOURNAL_MAGIC && record.checksum == calcRecordChecksum(record);
+}
+
+static void getEntries(JournalEntry *entries) {
+    memset(entries, 0, NUM_ON_TIME_COUNTERS * sizeof(JournalEntry));
+    for (int type = 0; type < NUM_ON_TIME_COUNTERS; type++) {
+        if (isPresent(type)) {
+            entries[type].moduleType = g_persistence.moduleTypes[type];
+            entries[type].moduleId = g_persistence.moduleIds[type];
+            entries[type].totalTime = g_persistence.counters[type]->getTotalTime();
+        }
+    }
+}
+
+static void load(uint32_t tickCountMs) {
+    const Backend *backend = g_persistence.backend;
+
+    for (int type = 0; type < NUM_ON_TIME_COUNTERS; type++) {
+        g_persistence.moduleTypes[type] = type == ON_TIME_COUNTER_MCU ? MODULE_TYPE_NONE : backend->getModuleType(type - ON_TIME_COUNTER_SLOT1);
+        g_persistence.moduleIds[type] = type != ON_TIME_COUNTER_MCU && isPresent(type) ? backend->getModuleId(type - ON_TIME_COUNTER_SLOT1) : 0;
+        g_persistence.homeTime[type] = isPresent(type) ? backend->readHome(type) : 0;
+    }
+
+    // find the newest valid record
+    JournalRecord record;
+    JournalRecord newest = {};
+    int newestIndex = -1;
+    for (int i = 0; i < NUM_JOURNAL_RECORDS; i++) {
+        if (
+            backend->readJournal((uint8_t *)&record, sizeof(record), i * JOURNAL_RECORD_SIZE) &&
+            isRecordValid(record) &&
+            (newestIndex == -1 || int32_t(record.sequence - newest.sequence) > 0)
+        ) {
+            newest = record;
+            newestIndex = i;
+        }
+    }
+
+    for (int type = 0; type < NUM_ON_TIME_COUNTERS; type++) {
+        uint32_t totalTime = g_persistence.homeTime[type];
+
+        if (newestIndex != -1 && isPresent(type)) {
+            const JournalEntry &entry = newest.entries[type];
+            // for the module use journal only if the record was written for the same module
+            if (
+                type == ON_TIME_COUNTER_MCU ||
+                (
+                    entry.moduleType == g_persistence.moduleTypes[type] &&
+                    entry.moduleId != 0 &&
+                    entry.moduleId == g_persistence.moduleIds[type]
+                )
+            ) {
+                if (entry.totalTime > totalTime) {
+                    totalTime = entry.totalTime;
+                }
+            }
+        }
+
+        g_persistence.counters[type]->init(totalTime);
+    }
+
+    if (newestIndex != -1) {
+        memcpy(g_persistence.committedEntries, newest.entries, sizeof(newest.entries));
+        g_persistence.sequence = newest.sequence;
+        g_persistence.recordIndex = newestIndex;
+    } else {
+        memset(g_persistence.committedEntries, 0, sizeof(g_persistence.committedEntries));
+        g_persistence.sequence = 0;
+        g_persistence.recordIndex = NUM_JOURNAL_RECORDS - 1;
+    }
+
+    g_persistence.lastCommitTickCount = tickCountMs;
+    g_persistence.lastHomeWriteTickCount = tickCountMs;
+}
+
+static void writeHome() {
+    for (int type = 0; type < NUM_ON_TIME_COUNTERS; type++) {
+        if (isPresent(type)) {
+            uint32_t totalTime = g_persistence.counters[type]->getTotalTime();
+            if (totalTime != g_persistence.homeTime[type]) {
+                g_persistence.statistics.numHomeWrites++;
+                if (g_persistence.backend->writeHome(type, totalTime)) {
+                    g_persistence.homeTime[type] = totalTime;
+                } else {
+                    g_persistence.statistics.numErrors++;
+                }
+            }
+        }
+    }
+}
+
+void init() {
+    load(millis());
+}
+
+void tick(uint32_t tickCountMs) {
+    for (int type = 0; type < NUM_ON_TIME_COUNTERS; type++) {
+        if (isPresent(type)) {
+            g_persistence.counters[type]->tick(tickCountMs);
+        }
+    }
+
+    if (tickCountMs - g_persistence.lastHomeWriteTickCount >= g_persistence.homeWriteInterval * MIN_TO_MS) {
+        g_persistence.lastHomeWriteTickCount = tickCountMs;
+        g_persistence.lastCommitTickCount = tickCountMs;
+        writeHome();
+        doCommit();
+    } else if (tickCountMs - g_persistence.lastCommitTickCount >= g_persistence.commitInterval * MIN_TO_MS) {
+        g_persistence.lastCommitTickCount = tickCountMs;
+        doCommit();
+    }
+}
+
+bool commit() {
+    if (!g_shutdownInProgress && !isLowPriorityThread()) {
+        sendMessageToLowPriorityThread(THREAD_MESSAGE_ONTIME_COMMIT);
+        return true;
+    }
+
+    return doCommit();
+}
+
+bool doCommit() {
+    JournalRecord record;
+    getEntries(record.entries);
+
+    if (memcmp(record.entries, g_persistence.committedEntries, sizeof(record.entries)) == 0) {
+        g_persistence.statistics.numCommitsSkipped++;
+        return true;
+    }
+
+    record.magic = ONTIME_JOURNAL_MAGIC;
+    record.sequence = g_persistence.sequence + 1;
+    record.reserved = 0;
+    record.checksum = calcRecordChecksum(record);
+
+    // every commit goes to the next location, failed location is also skipped
+    uint16_t recordIndex = (g_persistence.recordIndex + 1) % NUM_JOURNAL_RECORDS;
+    g_persistence.recordIndex = recordIndex;
+
+    g_persistence.statistics.numJournalWrites++;
+    if (!g_persistence.backend->writeJournal((const uint8_t *)&record, sizeof(record), recordIndex * JOURNAL_RECORD_SIZE)) {
+        g_persistence.statistics.numErrors++;
+        return false;
+    }
+
+    g_persistence.sequence = record.sequence;
+    memcpy(g_persistence.committedEntries, record.entries, sizeof(record.entries));
+
+    g_persistence.statistics.numCommits++;
+    g_persistence.statistics.sequence = record.sequence;
+    g_persistence.statistics.recordIndex = recordIndex;
+
+    return true;
+}
+
+void shutdownSave() {
+    writeHome();
+    doCommit();
+}
+
+void setCommitInterval(uint32_t commitInterval) {
+    g_persistence.commitInterval = commitInterval;
+}
+
+uint32_t getCommitInterval() {
+    return g_persistence.commitInterval;
+}
+
+void getStatistics(Statistics &statistics) {
+    statistics = g_persistence.statistics;
+}
+
+void resetStatistics() {
+    memset(&g_persistence.statistics, 0, sizeof(Statistics));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+
+namespace self_test {
+
+static uint8_t g_journal[mcu::eeprom::EEPROM_ONTIME_JOURNAL_SIZE];
+static uint32_t g_numLocationWrites[NUM_JOURNAL_RECORDS];
+static uint32_t g_home[NUM_ON_TIME_COUNTERS];
+static uint16_t g_moduleTypes[NUM_SLOTS];
+static uint32_t g_moduleIds[NUM_SLOTS];
+
+static bool readJournal(uint8_t *buffer, uint16_t bufferSize, uint16_t offset) {
+    memcpy(buffer, g_journal + offset, bufferSize);
+    return true;
+}
+
+static bool writeJournal(const uint8_t *buffer, uint16_t bufferSize, uint16_t offset) {
+    memcpy(g_journal + offset, buffer, bufferSize);
+    g_numLocationWrites[offset / JOURNAL_RECORD_SIZE]++;
+    return true;
+}
+
+static uint32_t readHome(int type) {
+    return g_home[type];
+}
+
+static bool writeHome(int type, uint32_t time) {
+    g_home[type] = time;
+    return true;
+}
+
+static uint16_t getModuleType(int slotIndex) {
+    return g_moduleTypes[slotIndex];
+}
+
+static uint32_t getModuleId(int slotIndex) {
+    return g_moduleIds[slotIndex];
+}
+
+static const Backend g_backend = {
+    readJournal,
+    writeJournal,
+    readHome,
+    writeHome,
+    getModuleType,
+    getModuleId
+};
+
+static bool checkTotals(const char *step, const uint32_t *expected, char *message, int messageSize) {
+    for (int type = 0; type < NUM_ON_TIME_COUNTERS; type++) {
+        uint32_t totalTime = g_persistence.counters[type]->getTotalTime();
+        if (totalTime != expected[type]) {
+            snprintf(message, messageSize, "%s: counter %d total %u, expected %u",
+                step, type, (unsigned)totalTime, (unsigned)expected[type]);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void getTotals(uint32_t *totals) {
+    for (int type = 0; type < NUM_ON_TIME_COUNTERS; type++) {
+        totals[type] = g_persistence.counters[type]->getTotalTime();
+    }
+}
+
+static void reboot(Counter *counters, uint32_t tickCount) {
+    for (int type = 0; type < NUM_ON_TIME_COUNTERS; type++) {
+        counters[type] = Counter(type);
+    }
+    load(tickCount);
+}
+
+static bool run(char *message, int messageSize) {
+    static const uint32_t DAY_MS = 24 * 60 * MIN_TO_MS;
+    static const uint32_t NUM_DAYS = 3;
+    static const uint32_t COMMIT_INTERVAL = 10;
+
+    static const uint32_t initialHome[NUM_ON_TIME_COUNTERS] = { 5000, 100, 0, 2500 };
+
+    Counter counters[NUM_ON_TIME_COUNTERS] = {
+        Counter(ON_TIME_COUNTER_MCU),
+        Counter(ON_TIME_COUNTER_SLOT1),
+        Counter(ON_TIME_COUNTER_SLOT2),
+        Counter(ON_TIME_COUNTER_SLOT3)
+    };
+
+    for (int type = 0; type < NUM_ON_TIME_COUNTERS; type++) {
+        g_persistence.counters[type] = &counters[type];
+    }
+    g_persistence.backend = &g_backend;
+    g_persistence.commitInterval = COMMIT_INTERVAL;
+    g_persistence.homeWriteInterval = 24 * 60;
+    memset(&g_persistence.statistics, 0, sizeof(Statistics));
+
+    memset(g_journal, 0xFF, sizeof(g_journal));
+    memset(g_numLocationWrites, 0, sizeof(g_numLocationWrites));
+    memcpy(g_home, initialHome, sizeof(g_home));
+    g_moduleTypes[0] = MODULE_TYPE_DCP405;
+    g_moduleTypes[1] = MODULE_TYPE_DCP405;
+    g_moduleTypes[2] = MODULE_TYPE_DCM220;
+    g_moduleIds[0] = 0x5A17C001;
+    g_moduleIds[1] = 0x5A17C002;
+    g_moduleIds[2] = 0x5A17C003;
+
+    // first boot, journal is empty, start one hour before millis() wraps
+    uint32_t tickCount = 0xFFFFFFFF - 60 * MIN_TO_MS;
+    reboot(counters, tickCount);
+    if (!checkTotals("first boot", initialHome, message, messageSize)) {
+        return false;
+    }
+
+    uint32_t activeTime[NUM_ON_TIME_COUNTERS] = { 0 };
+    for (int type = 0; type < NUM_ON_TIME_COUNTERS; type++) {
+        counters[type].start(tickCount);
+    }
+
+    // all counters active, slot 3 counter is stopped for 90.5 minutes on the first day
+    static const uint32_t SLOT3_STOP = DAY_MS / 2;
+    static const uint32_t SLOT3_START = SLOT3_STOP + 90 * MIN_TO_MS + 30 * 1000;
+
+    uint32_t committedTotals[NUM_ON_TIME_COUNTERS];
+    uint32_t previousCommittedTotals[NUM_ON_TIME_COUNTERS];
+    getTotals(committedTotals);
+
+    uint32_t uptime = NUM_DAYS * DAY_MS + 25 * MIN_TO_MS;
+    for (uint32_t time = 1000; time <= uptime; time += 1000) {
+        tickCount += 1000;
+
+        if (time == SLOT3_STOP) {
+            counters[ON_TIME_COUNTER_SLOT3].stop(tickCount);
+        } else if (time == SLOT3_START) {
+            counters[ON_TIME_COUNTER_SLOT3].start(tickCount);
+        }
+
+        for (int type = 0; type < NUM_ON_TIME_COUNTERS; type++) {
+            if (type != ON_TIME_COUNTER_SLOT3 || time <= SLOT3_STOP || time > SLOT3_START) {
+                activeTime[type] += 1000;
+            }
+        }
+
+        uint32_t numJournalWrites = g_persistence.statistics.numJournalWrites;
+
+        tick(tickCount);
+
+        if (g_persistence.statistics.numJournalWrites != numJournalWrites) {
+            memcpy(previousCommittedTotals, committedTotals, sizeof(committedTotals));
+            getTotals(committedTotals);
+        }
+    }
+
+    uint32_t expected[NUM_ON_TIME_COUNTERS];
+    for (int type = 0; type < NUM_ON_TIME_COUNTERS; type++) {
+        expected[type] = initialHome[type] + activeTime[type] / MIN_TO_MS;
+    }
+    if (!checkTotals("uptime", expected, message, messageSize)) {
+        return false;
+    }
+
+    // one journal write per commit interval, home written once per day
+    uint32_t expectedJournalWrites = uptime / (COMMIT_INTERVAL * MIN_TO_MS);
+    uint32_t expectedHomeWrites = NUM_DAYS * NUM_ON_TIME_COUNTERS;
+    if (
+        g_persistence.statistics.numJournalWrites != expectedJournalWrites ||
+        g_persistence.statistics.numHomeWrites != expectedHomeWrites ||
+        g_persistence.statistics.numErrors != 0
+    ) {
+        snprintf(message, messageSize, "uptime: journal writes %u, expected %u, home writes %u, expected %u",
+            (unsigned)g_persistence.statistics.numJournalWrites, (unsigned)expectedJournalWrites,
+            (unsigned)g_persistence.statistics.numHomeWrites, (unsigned)expectedHomeWrites);
+        return false;
+    }
+
+    // writes are spread over all locations
+    uint32_t minLocationWrites = g_numLocationWrites[0];
+    uint32_t maxLocationWrites = g_numLocationWrites[0];
+    for (int i = 1; i < NUM_JOURNAL_RECORDS; i++) {
+        minLocationWrites = MIN(minLocationWrites, g_numLocationWrites[i]);
+        maxLocationWrites = MAX(maxLocationWrites, g_numLocationWrites[i]);
+    }
+    if (maxLocationWrites - minLocationWrites > 1) {
+        snprintf(message, messageSize, "rotation: location writes min %u max %u",
+            (unsigned)minLocationWrites, (unsigned)maxLocationWrites);
+        return false;
+    }
+
+    // power loss, totals from the last commit
+    reboot(counters, tickCount);
+    if (!checkTotals("power loss", committedTotals, message, messageSize)) {
+        return false;
+    }
+
+    // newest record is corrupted, totals from the previous commit
+    g_journal[g_persistence.recordIndex * JOURNAL_RECORD_SIZE + offsetof(JournalRecord, entries)] ^= 0x01;
+    reboot(counters, tickCount);
+    if (!checkTotals("corrupted record", previousCommittedTotals, message, messageSize)) {
+        return false;
+    }
+
+    // home write of the slot 1 module was lost, it is still the same module
+    g_home[ON_TIME_COUNTER_SLOT1] = initialHome[ON_TIME_COUNTER_SLOT1];
+    reboot(counters, tickCount);
+    if (!checkTotals("lost home write", previousCommittedTotals, message, messageSize)) {
+        return false;
+    }
+
+    // other module of the same type in slot 2, its own counter is used
+    g_moduleIds[1] = 0x5A17C004;
+    g_home[ON_TIME_COUNTER_SLOT2] = 777;
+    reboot(counters, tickCount);
+    expected[ON_TIME_COUNTER_MCU] = previousCommittedTotals[ON_TIME_COUNTER_MCU];
+    expected[ON_TIME_COUNTER_SLOT1] = previousCommittedTotals[ON_TIME_COUNTER_SLOT1];
+    expected[ON_TIME_COUNTER_SLOT2] = 777;
+    expected[ON_TIME_COUNTER_SLOT3] = previousCommittedTotals[ON_TIME_COUNTER_SLOT3];
+    if (!checkTotals("module swap", expected, message, messageSize)) {
+        return false;
+    }
+
+    // run 35 minutes, power down and shutdown, then boot without journal
+    for (int type = 0; type < NUM_ON_TIME_COUNTERS; type++) {
+        counters[type].start(tickCount);
+    }
+    for (uint32_t time = 1000; time <= 35 * MIN_TO_MS; time += 1000) {
+        tickCount += 1000;
+        tick(tickCount);
+    }
+    for (int type = 0; type < NUM_ON_TIME_COUNTERS; type++) {
+        counters[type].stop(tickCount);
+        expected[type] += 35;
+    }
+
+    // power down commit, second commit and shutdown have nothing to write
+    // to the journal, shutdown writes all homes
+    uint32_t numJournalWrites = g_persistence.statistics.numJournalWrites;
+    uint32_t numHomeWrites = g_persistence.statistics.numHomeWrites;
+    doCommit();
+    doCommit();
+    shutdownSave();
+    if (
+        g_persistence.statistics.numJournalWrites - numJournalWrites != 1 ||
+        g_persistence.statistics.numHomeWrites - numHomeWrites != NUM_ON_TIME_COUNTERS
+    ) {
+        snprintf(message, messageSize, "shutdown: journal writes %u, home writes %u",
+            (unsigned)(g_persistence.statistics.numJournalWrites - numJournalWrites),
+            (unsigned)(g_persistence.statistics.numHomeWrites - numHomeWrites));
+        return false;
+    }
+
+    memset(g_journal, 0xFF, sizeof(g_journal));
+    reboot(counters, tickCount);
+    if (!checkTotals("shutdown", expected, message, messageSize)) {
+        return false;
+    }
+
+    snprintf(message, messageSize, "journal writes=%u home writes=%u",
+        (unsigned)g_persistence.statistics.numJournalWrites,
+        (unsigned)g_persistence.statistics.numHomeWrites);
+    return true;
+}
+
+} // namespace self_test
+
+bool selfTest(char *message, int messageSize) {
+    Persistence persistence = g_persistence;
+    bool result = self_test::run(message, messageSize);
+    g_persistence = persistence;
+    return result;
+}
+
+#endif // EEZ_PLATFORM_SIMULATOR
+
 } // namespace ontime
 } // namespace psu
 } // namespace eez
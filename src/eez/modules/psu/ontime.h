@@ -18,7 +18,19 @@
 
 #pragma once
 
-#include <eez/modules/psu/timer.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// ON-time counters are persisted together by this module, not by each counter.
+//
+// All totals are committed as one CRC32 checked record to the journal area of
+// the MCU EEPROM, at the commit interval and on power down. Each commit writes
+// the next record location, so writes are spread over the whole area, and the
+// record with the highest sequence number is used on boot. Counter home
+// locations (MCU EEPROM and module EEPROM) are written only on shutdown and
+// at a much longer interval. Journal total of the module counter is used only
+// if the record was written for the same module, recognized by the random ID
+// stored in module EEPROM next to the counter home location.
 
 namespace eez {
 namespace psu {
@@ -30,7 +42,8 @@ enum {
     ON_TIME_COUNTER_MCU, 
     ON_TIME_COUNTER_SLOT1,
     ON_TIME_COUNTER_SLOT2,
-    ON_TIME_COUNTER_SLOT3
+    ON_TIME_COUNTER_SLOT3,
+    NUM_ON_TIME_COUNTERS
 };
 
 class Counter {
@@ -43,10 +56,12 @@ class Counter {
     bool isActive();
 
     void start();
+    void start(uint32_t tickCountMs);
     void stop();
+    void stop(uint32_t tickCountMs);
 
-    void init();
-    void tick(uint32_t tick_usec);
+    void init(uint32_t totalTime);
+    void tick(uint32_t tickCountMs);
 
     uint32_t getTotalTime();
     uint32_t getLastTime();
@@ -57,12 +72,52 @@ class Counter {
     uint32_t lastTime;
     uint32_t lastTick;
     uint32_t fractionTime;
-    Interval writeInterval;
 };
 
 extern ontime::Counter g_mcuCounter;
 extern ontime::Counter g_moduleCounters[];
 
+struct Statistics {
+    uint32_t numCommits;
+    uint32_t numCommitsSkipped; // nothing changed since the last commit
+    uint32_t numJournalWrites;  // EEPROM write calls for the journal
+    uint32_t numHomeWrites;     // EEPROM write calls for the counter home locations
+    uint32_t numErrors;
+    uint32_t sequence;          // sequence number of the last record
+    uint16_t recordIndex;       // location of the last record
+};
+
+// reads counter home locations and journal, call after modules are detected
+void init();
+
+// advances counters and commits them at the commit interval
+void tick(uint32_t tickCountMs);
+
+// Commits from the low priority thread, which also runs tick, so journal state
+// is not shared between threads and EEPROM is not written from the caller's
+// thread. Until the low priority thread is stopped on shutdown, commit called
+// from another thread only posts the request and returns true.
+bool commit();
+// writes journal record if any total changed since the last commit
+bool doCommit();
+
+// commits and writes counter home locations
+void shutdownSave();
+
+// in minutes
+void setCommitInterval(uint32_t commitInterval);
+uint32_t getCommitInterval();
+
+void getStatistics(Statistics &statistics);
+void resetStatistics();
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+// runs long uptime with all counters on RAM storage and checks totals and
+// number of EEPROM write calls, returns false and description of the first
+// failed check
+bool selfTest(char *message, int messageSize);
+#endif
+
 } // namespace ontime
 } // namespace psu
 } // namespace eez
@@ -803,6 +803,40 @@ bool writeTotalOnTime(int type, uint32_t time) {
     }
 }
 
+bool readModuleId(int slotIndex, uint32_t &moduleId) {
+    uint32_t buffer[2];
+
+    if (
+        moduleConfRead(slotIndex, (uint8_t *)buffer, sizeof(buffer), bp3c::eeprom::EEPROM_MODULE_ID_START_ADDRESS, -1) &&
+        buffer[0] != 0 &&
+        buffer[1] == crc32((uint8_t *)(buffer + 0), 4)
+    ) {
+        moduleId = buffer[0];
+        return true;
+    }
+
+    return false;
+}
+
+bool writeModuleId(int slotIndex, uint32_t moduleId) {
+    uint32_t buffer[2];
+
+    buffer[0] = moduleId;
+    buffer[1] = crc32((uint8_t *)(buffer + 0), 4);
+
+    return moduleConfWrite(slotIndex, (uint8_t *)buffer, sizeof(buffer), bp3c::eeprom::EEPROM_MODULE_ID_START_ADDRESS);
+}
+
+bool readOnTimeJournal(uint8_t *buffer, uint16_t bufferSize, uint16_t offset) {
+    assert(offset + bufferSize <= mcu::eeprom::EEPROM_ONTIME_JOURNAL_SIZE);
+    return confRead(buffer, bufferSize, mcu::eeprom::EEPROM_ONTIME_JOURNAL_START_ADDRESS + offset, -1);
+}
+
+bool writeOnTimeJournal(const uint8_t *buffer, uint16_t bufferSize, uint16_t offset) {
+    assert(offset + bufferSize <= mcu::eeprom::EEPROM_ONTIME_JOURNAL_SIZE);
+    return confWrite(buffer, bufferSize, mcu::eeprom::EEPROM_ONTIME_JOURNAL_START_ADDRESS + offset);
+}
+
 void enableOutputProtectionCouple(bool enable) {
     unsigned outputProtectionCouple = enable ? 1 : 0;
 
@@ -1319,6 +1353,8 @@ void loadChannelCalibration(Channel &channel) {
         CH_CAL_CONF_VERSION
     )) {
         channel.clearCalibrationConf();
+    } else {
+        channel.updateCalibrationTables();
     }
 }
 
@@ -262,6 +262,15 @@ void toggleMaxChannelIndex(int channelIndex);
 uint32_t readTotalOnTime(int type);
 bool writeTotalOnTime(int type, uint32_t time);
 
+// module ID is stored in module EEPROM next to the ON-time counter,
+// returns false if it was never written
+bool readModuleId(int slotIndex, uint32_t &moduleId);
+bool writeModuleId(int slotIndex, uint32_t moduleId);
+
+// offset is relative to the start of the ON-time journal area in MCU EEPROM
+bool readOnTimeJournal(uint8_t *buffer, uint16_t bufferSize, uint16_t offset);
+bool writeOnTimeJournal(const uint8_t *buffer, uint16_t bufferSize, uint16_t offset);
+
 void enableOutputProtectionCouple(bool enable);
 bool isOutputProtectionCoupleEnabled();
 
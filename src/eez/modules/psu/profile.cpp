@@ -419,6 +419,19 @@ void loadProfileParametersToCache(int location) {
     }
 }
 
+#if defined(EEZ_PLATFORM_SIMULATOR)
+
+void saveStateSnapshot(Parameters &profile) {
+    memset(&profile, 0, sizeof(Parameters));
+    saveState(profile, g_listsProfile10);
+}
+
+bool recallStateSnapshot(Parameters &profile, int *err) {
+    return recallState(profile, g_listsProfile10, RECALL_OPTION_IGNORE_POWER, err);
+}
+
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 
 static void loadProfileName(int location) {
@@ -464,6 +477,9 @@ static void resetProfileToDefaults(Parameters &profile) {
         profile.channels[i].i_rampDuration = RAMP_DURATION_DEF_VALUE_I;
 
         profile.channels[i].outputDelayDuration = 0;
+
+        profile.channels[i].monFilterType = MON_FILTER_TYPE_BOXCAR;
+        profile.channels[i].monFilterCount = NUM_ADC_AVERAGING_VALUES;
     }
 
     for (int i = 0; i < temp_sensor::MAX_NUM_TEMP_SENSORS; ++i) {
@@ -652,6 +668,9 @@ static void saveState(Parameters &profile, List *lists) {
 
             profile.channels[i].outputDelayDuration = channel.outputDelayDuration;
 
+            profile.channels[i].monFilterType = channel.getMonFilterType();
+            profile.channels[i].monFilterCount = channel.getMonFilterCount();
+
             if (lists) {
                 auto &list = lists[i];
                 memcpy(list.dwellList, list::getDwellList(channel, &list.dwellListLength), sizeof(list.dwellList));
@@ -793,6 +812,12 @@ static bool recallState(Parameters &profile, List *lists, int recallOptions, int
 
             channel.outputDelayDuration = profile.channels[i].outputDelayDuration;
 
+            if (profile.channels[i].monFilterType <= MON_FILTER_TYPE_MEDIAN && profile.channels[i].monFilterCount >= 1 && profile.channels[i].monFilterCount <= MON_FILTER_MAX_COUNT) {
+                channel.setMonFilter((MonFilterType)profile.channels[i].monFilterType, (uint8_t)profile.channels[i].monFilterCount);
+            } else {
+                channel.setMonFilter(MON_FILTER_TYPE_BOXCAR, NUM_ADC_AVERAGING_VALUES);
+            }
+
             auto &list = lists[i];
             channel_dispatcher::setDwellList(channel, list.dwellList, list.dwellListLength);
             channel_dispatcher::setVoltageList(channel, list.voltageList, list.voltageListLength);
@@ -810,6 +835,8 @@ static bool recallState(Parameters &profile, List *lists, int recallOptions, int
         }
     }
 
+    channel_dispatcher::updateDispatchPlans();
+
     Channel::updateAllChannels();
 
     trigger::g_triggerContinuousInitializationEnabled = profile.flags.triggerContinuousInitializationEnabled;
@@ -1028,6 +1055,9 @@ static bool profileWrite(WriteContext &ctx, const Parameters &parameters, List *
 
             WRITE_PROPERTY("outputDelayDuration", channel.outputDelayDuration);
 
+            WRITE_PROPERTY("monFilterType", channel.monFilterType);
+            WRITE_PROPERTY("monFilterCount", channel.monFilterCount);
+
             if (lists) {
                 WRITE_LIST_PROPERTY(
                     "list",
@@ -1464,6 +1494,9 @@ static bool profileReadCallback(ReadContext &ctx, Parameters &parameters, List *
 
         READ_PROPERTY(outputDelayDuration, channel.outputDelayDuration);
 
+        READ_PROPERTY(monFilterType, channel.monFilterType);
+        READ_PROPERTY(monFilterCount, channel.monFilterCount);
+
         if (lists) {
             READ_LIST_PROPERTY(list, channelIndex, lists);
         }
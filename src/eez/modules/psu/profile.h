@@ -74,6 +74,8 @@ struct ChannelParameters {
     float u_rampDuration;
     float i_rampDuration;
     float outputDelayDuration;
+    uint16_t monFilterType;
+    uint16_t monFilterCount;
 #ifdef EEZ_PLATFORM_SIMULATOR
     bool load_enabled;
     float load;
@@ -149,6 +151,14 @@ void setFreezeState(bool value);
 
 void loadProfileParametersToCache(int location);
 
+#if defined(EEZ_PLATFORM_SIMULATOR)
+/// Keeps the current state in RAM, so debug commands which have to change it
+/// (e.g. DEBUg:DISPatch? goes through all coupling modes) can put it back.
+/// Lists are kept in the buffer also used by setName, so one snapshot at a time.
+void saveStateSnapshot(Parameters &profile);
+bool recallStateSnapshot(Parameters &profile, int *err);
+#endif
+
 }
 }
 } // namespace eez::psu::profile
@@ -0,0 +1,430 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2020-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <eez/tasks.h>
+
+#include <eez/modules/psu/psu.h>
+#include <eez/modules/psu/channel_dispatcher.h>
+#include <eez/modules/psu/protection.h>
+
+namespace eez {
+namespace psu {
+namespace protection {
+
+static Levels g_levels[CH_MAX];
+#ifdef DEBUG
+static Statistics g_statistics[CH_MAX];
+#endif
+
+static volatile bool g_invalidated = true;
+
+void invalidate() {
+    g_invalidated = true;
+}
+
+static uint32_t toMicroseconds(float delay) {
+    if (delay <= 0) {
+        return 0;
+    }
+    // elapsed time is integer, so "elapsed >= delay" is same as "elapsed >= ceil(delay)"
+    return (uint32_t)ceilf(delay * 1000000.0f);
+}
+
+static void update() {
+    for (int i = 0; i < CH_NUM; i++) {
+        Channel &channel = Channel::get(i);
+        Levels &levels = g_levels[i];
+
+        levels.enabled = 0;
+        if (
+            (channel.flags.rprogEnabled || channel.prot_conf.flags.u_state) &&
+            !((channel.params.features & CH_FEATURE_HW_OVP) && channel.prot_conf.flags.u_type && !channel.prot_conf.flags.u_hwOvpDeactivated)
+        ) {
+            levels.enabled |= OVP;
+        }
+        if (channel.prot_conf.flags.i_state) {
+            levels.enabled |= OCP;
+        }
+        if (channel.prot_conf.flags.p_state) {
+            levels.enabled |= OPP;
+        }
+
+        levels.rprog = channel.flags.rprogEnabled;
+
+        levels.uLevel = channel.getSwOvpProtectionLevel();
+        levels.iLevel = channel_dispatcher::getISet(channel);
+        levels.pLevel = channel_dispatcher::getPowerProtectionLevel(channel);
+
+        levels.uDelay = toMicroseconds(channel.prot_conf.u_delay - PROT_DELAY_CORRECTION);
+        levels.iDelay = toMicroseconds(channel.prot_conf.i_delay - PROT_DELAY_CORRECTION);
+        levels.pDelay = toMicroseconds(channel.prot_conf.p_delay);
+    }
+}
+
+const Levels &getLevels(const Channel &channel) {
+    if (g_invalidated) {
+        // cleared before update, so invalidate() called during update is not lost
+        g_invalidated = false;
+        update();
+    }
+    return g_levels[channel.channelIndex];
+}
+
+#ifdef DEBUG
+void onCheckDone(const Channel &channel, uint32_t startTime) {
+    Statistics &statistics = g_statistics[channel.channelIndex];
+
+    statistics.check.add(micros() - startTime);
+
+    if (channel.isOutputEnabled()) {
+        if (statistics.outputEnabled) {
+            uint32_t interval = startTime - statistics.lastCheckTime;
+            if (interval > statistics.maxInterval) {
+                statistics.maxInterval = interval;
+            }
+        }
+        statistics.lastCheckTime = startTime;
+        statistics.outputEnabled = true;
+    } else {
+        statistics.outputEnabled = false;
+    }
+}
+
+const Statistics &getStatistics(const Channel &channel) {
+    return g_statistics[channel.channelIndex];
+}
+#endif
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+
+////////////////////////////////////////////////////////////////////////////////
+// step overload
+
+struct StepOverload {
+    const char *name;
+    uint8_t protection;
+    float normalLoad; // ohm
+    float overloadLoad; // ohm
+};
+
+// with U_SET 10 V and I_SET 1 A
+static const StepOverload g_stepOverloads[] = {
+    // OVP level is set below U_SET (not allowed from SCPI or GUI),
+    // so the step from CC (5 V) to CV (10 V) raises U_MON above it
+    { "OVP", OVP, 5.0f, 1000.0f },
+    // 10 mA, then 2 A which puts the channel into CC mode at I_SET
+    { "OCP", OCP, 1000.0f, 5.0f },
+    // 0.1 W, then 8 W in CC mode
+    { "OPP", OPP, 1000.0f, 8.0f }
+};
+
+static ProtectionValue &getProtectionValue(Channel &channel, uint8_t protection) {
+    return protection == OVP ? channel.ovp : protection == OCP ? channel.ocp : channel.opp;
+}
+
+// returns time from the load step to the trip in microseconds, or 0 if protection didn't trip
+static uint32_t stepOverload(Channel &channel, ProtectionValue &cpv, float overloadLoad, float normalLoad, uint32_t duration) {
+    channel_dispatcher::setLoad(channel, overloadLoad);
+    uint32_t startTime = micros();
+
+    while (true) {
+        delayWithoutIoLock(1);
+        uint32_t time = micros() - startTime;
+        if (cpv.flags.tripped) {
+            return time;
+        }
+        if (time >= duration * 1000) {
+            break;
+        }
+    }
+
+    channel_dispatcher::setLoad(channel, normalLoad);
+    return 0;
+}
+
+static bool stepOverloadSelfTest(Channel &channel, const StepOverload &step, char *message, int messageSize) {
+    static const float U_SET = 10.0f;
+    static const float I_SET = 1.0f;
+    static const float OVP_LEVEL = 8.0f; // V
+    static const float OPP_LEVEL = 5.0f; // W
+    static const float DELAY = 0.1f; // s
+    static const uint32_t SHORT_OVERLOAD_DURATION = 20; // ms
+    static const uint32_t LONG_OVERLOAD_DURATION = 1000; // ms
+    // max. time from delay expiry to trip: ADC conversion, check interval and host thread scheduling
+    static const uint32_t MAX_TRIP_LATENCY = 25000; // us
+
+    ProtectionValue &cpv = getProtectionValue(channel, step.protection);
+
+    channel_dispatcher::clearProtection(channel);
+    channel_dispatcher::setVoltage(channel, U_SET);
+    channel_dispatcher::setCurrent(channel, I_SET);
+    channel_dispatcher::setLoadEnabled(channel, true);
+    channel_dispatcher::setLoad(channel, step.normalLoad);
+    channel_dispatcher::outputEnable(channel, true);
+    delayWithoutIoLock(200);
+
+    // U_SET is applied in the PSU thread and it raises OVP level up to U_SET,
+    // so protection is configured afterwards; only the tested protection is enabled
+    // and SW OVP is used because HW OVP is not simulated
+    channel_dispatcher::setOvpParameters(channel, step.protection == OVP, 0, step.protection == OVP ? OVP_LEVEL : U_SET, DELAY);
+    channel_dispatcher::setOcpParameters(channel, step.protection == OCP, DELAY);
+    channel_dispatcher::setOppParameters(channel, step.protection == OPP, OPP_LEVEL, DELAY);
+    delayWithoutIoLock(50);
+
+    bool result = false;
+    // OVP and OCP delays are shortened by PROT_DELAY_CORRECTION to compensate detection latency
+    uint32_t delay = toMicroseconds(step.protection == OPP ? DELAY : DELAY - PROT_DELAY_CORRECTION);
+    uint32_t tripTime;
+
+    if (!channel.isOutputEnabled()) {
+        snprintf(message, messageSize, "%s: output not enabled", step.name);
+    } else if (channel.isTripped()) {
+        snprintf(message, messageSize, "%s: tripped without overload", step.name);
+    } else if ((tripTime = stepOverload(channel, cpv, step.overloadLoad, step.normalLoad, SHORT_OVERLOAD_DURATION)) != 0) {
+        snprintf(message, messageSize, "%s: tripped %u us after %u ms overload, delay is %u us",
+            step.name, (unsigned)tripTime, (unsigned)SHORT_OVERLOAD_DURATION, (unsigned)delay);
+    } else if (delayWithoutIoLock(200), cpv.flags.tripped) {
+        snprintf(message, messageSize, "%s: tripped after %u ms overload was removed", step.name, (unsigned)SHORT_OVERLOAD_DURATION);
+    } else if ((tripTime = stepOverload(channel, cpv, step.overloadLoad, step.normalLoad, LONG_OVERLOAD_DURATION)) == 0) {
+        snprintf(message, messageSize, "%s: didn't trip within %u ms", step.name, (unsigned)LONG_OVERLOAD_DURATION);
+    } else if (tripTime < delay) {
+        snprintf(message, messageSize, "%s: tripped after %u us, before delay of %u us", step.name, (unsigned)tripTime, (unsigned)delay);
+    } else if (tripTime > delay + MAX_TRIP_LATENCY) {
+        snprintf(message, messageSize, "%s: tripped after %u us, latency %u us exceeds %u us",
+            step.name, (unsigned)tripTime, (unsigned)(tripTime - delay), (unsigned)MAX_TRIP_LATENCY);
+    } else {
+        // appended, one entry per protection
+        size_t length = strlen(message);
+        snprintf(message + length, messageSize - length, "%s%s latency=%u us", length > 0 ? " " : "", step.name, (unsigned)(tripTime - delay));
+        result = true;
+    }
+
+    channel_dispatcher::outputEnable(channel, false);
+    delayWithoutIoLock(50);
+
+    return result;
+}
+
+bool stepOverloadSelfTest(Channel &channel, char *message, int messageSize) {
+    if (channel_dispatcher::getCouplingType() != channel_dispatcher::COUPLING_TYPE_NONE || channel.flags.trackingEnabled) {
+        snprintf(message, messageSize, "channel is coupled or tracked");
+        return false;
+    }
+
+    // save settings
+    float uSet = channel.u.set;
+    float iSet = channel.i.set;
+    Channel::ChannelProtectionConfiguration protConf = channel.prot_conf;
+    bool loadEnabled = channel.simulator.getLoadEnabled();
+    float load = channel.simulator.getLoad();
+    bool outputEnabled = channel.isOutputEnabled();
+
+    // message lists trip latency for each protection
+    message[0] = 0;
+
+    bool result = true;
+    for (size_t i = 0; i < sizeof(g_stepOverloads) / sizeof(StepOverload) && result; i++) {
+        result = stepOverloadSelfTest(channel, g_stepOverloads[i], message, messageSize);
+    }
+
+    // restore settings
+    channel_dispatcher::clearProtection(channel);
+    channel_dispatcher::setLoad(channel, load);
+    channel_dispatcher::setLoadEnabled(channel, loadEnabled);
+    channel_dispatcher::setVoltage(channel, uSet);
+    channel_dispatcher::setCurrent(channel, iSet);
+    channel_dispatcher::setOvpParameters(channel, protConf.flags.u_state, protConf.flags.u_type, protConf.u_level, protConf.u_delay);
+    channel_dispatcher::setOcpParameters(channel, protConf.flags.i_state, protConf.i_delay);
+    channel_dispatcher::setOppParameters(channel, protConf.flags.p_state, protConf.p_level, protConf.p_delay);
+    if (outputEnabled) {
+        channel_dispatcher::outputEnable(channel, true);
+    }
+
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// levels
+
+enum SampleOutcome {
+    SAMPLE_NONE,
+    SAMPLE_ALARM,
+    SAMPLE_TRIP
+};
+
+// what Channel::protectionCheck does with one sample, when alarm was started elapsed us ago
+static SampleOutcome getSampleOutcome(bool condition, bool delayed, bool delayElapsed) {
+    if (!condition) {
+        return SAMPLE_NONE;
+    }
+    if (delayed && !delayElapsed) {
+        return SAMPLE_ALARM;
+    }
+    return SAMPLE_TRIP;
+}
+
+// Channel::protectionCheck before the levels were precomputed
+static SampleOutcome getLegacySampleOutcome(Channel &channel, uint8_t protection, float uMon, float iMon, float uMonDac, uint32_t elapsed) {
+    bool state;
+    bool condition;
+    float delay;
+
+    if (protection == OVP) {
+        state = (channel.flags.rprogEnabled || channel.prot_conf.flags.u_state) && !((channel.params.features & CH_FEATURE_HW_OVP) && channel.prot_conf.flags.u_type && !channel.prot_conf.flags.u_hwOvpDeactivated);
+        float uProtectionLevel = channel.getSwOvpProtectionLevel();
+        condition = uMon > uProtectionLevel || (channel.flags.rprogEnabled && uMonDac > uProtectionLevel);
+        delay = channel.prot_conf.u_delay;
+        delay -= PROT_DELAY_CORRECTION;
+    } else if (protection == OCP) {
+        state = channel.prot_conf.flags.i_state;
+        condition = iMon >= channel_dispatcher::getISet(channel);
+        delay = channel.prot_conf.i_delay;
+        delay -= PROT_DELAY_CORRECTION;
+    } else {
+        state = channel.prot_conf.flags.p_state;
+        condition = uMon * iMon > channel_dispatcher::getPowerProtectionLevel(channel);
+        delay = channel.prot_conf.p_delay;
+    }
+
+    return getSampleOutcome(state && condition, delay > 0, elapsed >= delay * 1000000UL);
+}
+
+static SampleOutcome getSampleOutcome(Channel &channel, uint8_t protection, float uMon, float iMon, float uMonDac, uint32_t elapsed) {
+    const Levels &levels = getLevels(channel);
+
+    if (protection == OVP) {
+        return getSampleOutcome(isOvpCondition(levels, uMon, uMonDac), levels.uDelay > 0, elapsed >= levels.uDelay);
+    } else if (protection == OCP) {
+        return getSampleOutcome(isOcpCondition(levels, iMon), levels.iDelay > 0, elapsed >= levels.iDelay);
+    } else {
+        return getSampleOutcome(isOppCondition(levels, uMon, iMon), levels.pDelay > 0, elapsed >= levels.pDelay);
+    }
+}
+
+// value, values just below and above it, zero and double
+static void getValuesAround(float value, float *values) {
+    values[0] = 0;
+    values[1] = nextafterf(value, 0);
+    values[2] = value;
+    values[3] = nextafterf(value, INFINITY);
+    values[4] = 2 * value;
+}
+
+static bool compareSampleOutcomes(Channel &channel, uint8_t protection, char *message, int messageSize) {
+    static const int NUM_VALUES = 5;
+
+    // U_MON values around OVP level and P/I, I_MON values around I_SET and P/U
+    float pLevel = channel_dispatcher::getPowerProtectionLevel(channel);
+    float uLevel = channel.getSwOvpProtectionLevel();
+    float iLevel = channel_dispatcher::getISet(channel);
+    float uValues[2 * NUM_VALUES];
+    float iValues[2 * NUM_VALUES];
+    getValuesAround(uLevel, uValues);
+    getValuesAround(iLevel > 0 ? pLevel / iLevel : 0, uValues + NUM_VALUES);
+    getValuesAround(iLevel, iValues);
+    getValuesAround(uLevel > 0 ? pLevel / uLevel : 0, iValues + NUM_VALUES);
+
+    // elapsed times around the delay, same as in the legacy comparison
+    float delay = protection == OVP ? channel.prot_conf.u_delay - PROT_DELAY_CORRECTION :
+        protection == OCP ? channel.prot_conf.i_delay - PROT_DELAY_CORRECTION : channel.prot_conf.p_delay;
+    uint32_t delayUs = delay > 0 ? (uint32_t)(delay * 1000000UL) : 0;
+    uint32_t elapsedValues[] = { 0, delayUs - 1, delayUs, delayUs + 1, delayUs + 2 };
+
+    for (int u = 0; u < 2 * NUM_VALUES; u++) {
+        for (int i = 0; i < 2 * NUM_VALUES; i++) {
+            for (int uDac = 0; uDac < NUM_VALUES; uDac++) {
+                for (size_t e = 0; e < sizeof(elapsedValues) / sizeof(uint32_t); e++) {
+                    SampleOutcome legacyOutcome = getLegacySampleOutcome(channel, protection, uValues[u], iValues[i], uValues[uDac], elapsedValues[e]);
+                    SampleOutcome outcome = getSampleOutcome(channel, protection, uValues[u], iValues[i], uValues[uDac], elapsedValues[e]);
+                    if (outcome != legacyOutcome) {
+                        snprintf(message, messageSize, "CH%d %s U=%g I=%g U_DAC=%g elapsed=%u us: %d, was %d",
+                            channel.channelIndex + 1, protection == OVP ? "OVP" : protection == OCP ? "OCP" : "OPP",
+                            uValues[u], iValues[i], uValues[uDac], (unsigned)elapsedValues[e], (int)outcome, (int)legacyOutcome);
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+bool levelsSelfTest(char *message, int messageSize) {
+    // delays as set by channel_dispatcher (rounded to ms), around PROT_DELAY_CORRECTION and up to max. delay
+    static const float DELAYS[] = { 0.0f, 0.001f, 0.002f, 0.003f, 0.01f, 0.1f, 1.0f, 10.0f };
+    static const int NUM_DELAYS = sizeof(DELAYS) / sizeof(float);
+    // u_state, i_state, p_state, u_type, u_hwOvpDeactivated and rprogEnabled
+    static const int NUM_FLAG_COMBINATIONS = 1 << 6;
+
+    uint32_t numConfigurations = 0;
+
+    for (int channelIndex = 0; channelIndex < CH_NUM; channelIndex++) {
+        Channel &channel = Channel::get(channelIndex);
+
+        // this runs in the PSU thread, so nobody checks protection with these settings
+        Channel::ChannelProtectionConfiguration protConf = channel.prot_conf;
+        unsigned rprogEnabled = channel.flags.rprogEnabled;
+
+        bool result = true;
+
+        for (int flags = 0; flags < NUM_FLAG_COMBINATIONS && result; flags++) {
+            for (int delayIndex = 0; delayIndex < NUM_DELAYS && result; delayIndex++) {
+                channel.prot_conf.flags.u_state = flags & 1 ? 1 : 0;
+                channel.prot_conf.flags.i_state = flags & 2 ? 1 : 0;
+                channel.prot_conf.flags.p_state = flags & 4 ? 1 : 0;
+                channel.prot_conf.flags.u_type = flags & 8 ? 1 : 0;
+                channel.prot_conf.flags.u_hwOvpDeactivated = flags & 16 ? 1 : 0;
+                channel.flags.rprogEnabled = flags & 32 ? 1 : 0;
+                // different delay for each protection
+                channel.prot_conf.u_delay = DELAYS[delayIndex];
+                channel.prot_conf.i_delay = DELAYS[(delayIndex + 1) % NUM_DELAYS];
+                channel.prot_conf.p_delay = DELAYS[(delayIndex + 2) % NUM_DELAYS];
+                invalidate();
+
+                result =
+                    compareSampleOutcomes(channel, OVP, message, messageSize) &&
+                    compareSampleOutcomes(channel, OCP, message, messageSize) &&
+                    compareSampleOutcomes(channel, OPP, message, messageSize);
+
+                numConfigurations++;
+            }
+        }
+
+        channel.prot_conf = protConf;
+        channel.flags.rprogEnabled = rprogEnabled;
+        invalidate();
+
+        if (!result) {
+            return false;
+        }
+    }
+
+    snprintf(message, messageSize, "configurations=%u", (unsigned)numConfigurations);
+    return true;
+}
+
+#endif
+
+} // namespace protection
+} // namespace psu
+} // namespace eez
@@ -0,0 +1,106 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2020-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <eez/system.h>
+
+namespace eez {
+namespace psu {
+
+struct Channel;
+
+namespace protection {
+
+// Software OVP, OCP and OPP levels, states and delays, derived from channel
+// protection configuration, U_SET/I_SET, remote programming and coupling.
+// They are checked by Channel::protectionCheck on every new ADC value, so
+// instead of evaluating all the settings each time, levels are kept for all
+// channels in one array and recomputed only after invalidate().
+
+static const uint8_t OVP = 1 << 0;
+static const uint8_t OCP = 1 << 1;
+static const uint8_t OPP = 1 << 2;
+
+struct Levels {
+    uint8_t enabled; // OVP | OCP | OPP
+    uint8_t rprog; // OVP is also checked against U_MON_DAC
+    float uLevel;
+    float iLevel;
+    float pLevel;
+    // in microseconds, 0 means trip immediately
+    uint32_t uDelay;
+    uint32_t iDelay;
+    uint32_t pDelay;
+};
+
+inline bool isOvpCondition(const Levels &levels, float uMon, float uMonDac) {
+    return (levels.enabled & OVP) && (uMon > levels.uLevel || (levels.rprog && uMonDac > levels.uLevel));
+}
+
+inline bool isOcpCondition(const Levels &levels, float iMon) {
+    return (levels.enabled & OCP) && iMon >= levels.iLevel;
+}
+
+inline bool isOppCondition(const Levels &levels, float uMon, float iMon) {
+    return (levels.enabled & OPP) && uMon * iMon > levels.pLevel;
+}
+
+#ifdef DEBUG
+struct Statistics {
+    // duration of Channel::protectionCheck
+    RunTimeStatistics check;
+    // max. time between two checks while output is enabled
+    uint32_t maxInterval; // us
+
+    uint32_t lastCheckTime;
+    bool outputEnabled;
+};
+#endif
+
+// Must be called after anything that affects protection levels is changed.
+// Levels are recomputed for all channels on next getLevels call.
+void invalidate();
+
+const Levels &getLevels(const Channel &channel);
+
+#ifdef DEBUG
+// check duration and interval statistics cost two micros() calls per check,
+// so they are collected only in debug build
+void onCheckDone(const Channel &channel, uint32_t startTime);
+
+const Statistics &getStatistics(const Channel &channel);
+#endif
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+// Applies step overload to the simulated load, for OVP, OCP and OPP in turn,
+// and checks that protection trips after its delay (and not before), and that
+// overload shorter than the delay doesn't trip. Channel settings are restored
+// at the end.
+bool stepOverloadSelfTest(Channel &channel, char *message, int messageSize);
+
+// Compares precomputed levels with the per-sample evaluation used before
+// (settings read on every check, float delays), for all channels, over
+// combinations of protection settings, monitored values around the levels
+// and elapsed times around the delays. Must be called from the PSU thread.
+bool levelsSelfTest(char *message, int messageSize);
+#endif
+
+} // namespace protection
+} // namespace psu
+} // namespace eez
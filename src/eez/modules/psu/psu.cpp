@@ -49,6 +49,7 @@
 #include <eez/modules/psu/ramp.h>
 #include <eez/modules/psu/trigger.h>
 #include <eez/modules/psu/ontime.h>
+#include <eez/modules/psu/acquisition.h>
 
 #if OPTION_DISPLAY
 #include <eez/modules/psu/gui/psu.h>
@@ -158,7 +159,9 @@ using namespace scpi;
 #if defined(EEZ_PLATFORM_STM32)
 
 extern "C" void PSU_IncTick() {
-    g_tickCount++;
+    if (++g_tickCount == 0) {
+        g_tickCountHigh++;
+    }
 
     using namespace eez;
     using namespace eez::psu;
@@ -225,9 +228,9 @@ void init() {
 void onThreadMessage(uint8_t type, uint32_t param) {
     if (type == PSU_MESSAGE_TICK) {
 #if defined(EEZ_PLATFORM_STM32)
-        uint32_t tickCount = micros();
+        uint64_t tickCount = micros64();
         ramp::tick(tickCount);
-        dcp405::tickDacRamp(tickCount);
+        dcp405::tickDacRamp((uint32_t)tickCount);
         if (g_tickCount % 5 == 0) {
             tick();
         }
@@ -275,6 +278,8 @@ void onThreadMessage(uint8_t type, uint32_t param) {
         bp3c::flash_slave::doStart();
     } else if (type == PSU_MESSAGE_FLASH_SLAVE_LEAVE_BOOTLOADER_MODE) {
         bp3c::flash_slave::leaveBootloaderMode();
+    } else if (type == PSU_MESSAGE_SET_MON_FILTER) {
+        Channel::get((int)param).setMonFilterInPsuThread();
     }
 }
 
@@ -441,6 +446,9 @@ bool psuReset() {
     //
     trigger::reset();
 
+    //
+    acquisition::reset();
+
     //
     list::reset();
 
@@ -577,6 +585,7 @@ void powerDown() {
             ontime::g_moduleCounters[slotIndex].stop();
         }
     }
+    ontime::commit();
 
     event_queue::pushEvent(event_queue::EVENT_INFO_POWER_DOWN);
 
@@ -680,18 +689,22 @@ static const int NUM_TICK_FUNCS = sizeof(g_tickFuncs) / sizeof(TickFunc);
 static int g_tickFuncIndex = 0;
 
 void tick() {
-    uint32_t tickCount = micros();
+    // trigger, list, ramp and DLOG are scheduled with 64-bit time that never wraps around,
+    // everything else is fine with 32-bit micros
+    uint64_t tickCount64 = micros64();
+    trigger::tick(tickCount64);
 
-    trigger::tick(tickCount);
-    tickCount = micros();
-    list::tick(tickCount);
-    ramp::tick(tickCount);
+    tickCount64 = micros64();
+    uint32_t tickCount = (uint32_t)tickCount64;
+
+    list::tick(tickCount64);
+    ramp::tick(tickCount64);
 
     for (int i = 0; i < CH_NUM; ++i) {
         Channel::get(i).tick(tickCount);
     }
 
-    dlog_record::tick(tickCount);
+    dlog_record::tick(tickCount64);
 
     io_pins::tick(tickCount);
 
@@ -702,6 +715,10 @@ void tick() {
         g_diagCallback();
         g_diagCallback = NULL;
     }
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    simulator::tickThermalPlant();
+#endif
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -754,6 +771,79 @@ static bool g_cc[CH_MAX];
 float g_uSet[CH_MAX];
 float g_iSet[CH_MAX];
 
+// First-order thermal plant of the channel heatsink, used to compare fan
+// controllers: dT/dt = (Tamb + Rth(fan) * P - T) / tau.
+// Coefficients are intentionally not the FAN_MODEL_* ones, so the feed-forward
+// model is evaluated against a plant it doesn't match exactly.
+#define SIM_PLANT_AMBIENT 25.0f
+#define SIM_PLANT_K_OUT 0.08f
+#define SIM_PLANT_U_DROP 2.2f
+#define SIM_PLANT_P_IDLE 1.0f // W, dissipated while output is enabled
+#define SIM_PLANT_RTH 3.0f // oC/W, fan stopped
+#define SIM_PLANT_RTH_FAN_FACTOR 3.0f // Rth is 1 + factor times lower at max. fan speed
+#define SIM_PLANT_TAU 60.0f // s
+
+static bool g_thermalPlantEnabled;
+static uint32_t g_thermalPlantLastTick;
+static float g_thermalPlantTau = SIM_PLANT_TAU;
+
+void tickThermalPlant() {
+    if (!g_thermalPlantEnabled) {
+        return;
+    }
+
+    uint32_t tick = micros();
+    float dt = (tick - g_thermalPlantLastTick) * 1E-6f;
+    g_thermalPlantLastTick = tick;
+
+    float fan = 0;
+#if OPTION_FAN
+    fan = 1.0f * aux_ps::fan::g_fanSpeedPWM / FAN_MAX_PWM;
+#endif
+    float rth = SIM_PLANT_RTH / (1.0f + SIM_PLANT_RTH_FAN_FACTOR * fan);
+
+    float k = dt / g_thermalPlantTau;
+    if (k > 1.0f) {
+        k = 1.0f;
+    }
+
+    for (int i = 0; i < CH_NUM; ++i) {
+        Channel &channel = Channel::get(i);
+
+        float power = 0;
+        if (channel.isOutputEnabled()) {
+            power = SIM_PLANT_K_OUT * channel.u.mon_last * channel.i.mon_last + SIM_PLANT_U_DROP * channel.i.mon_last + SIM_PLANT_P_IDLE;
+        }
+
+        float &temperature = g_temperature[temp_sensor::CH1 + i];
+        temperature += (SIM_PLANT_AMBIENT + rth * power - temperature) * k;
+    }
+}
+
+void setThermalPlantEnabled(bool enabled) {
+    g_thermalPlantLastTick = micros();
+    g_thermalPlantEnabled = enabled;
+}
+
+bool isThermalPlantEnabled() {
+    return g_thermalPlantEnabled;
+}
+
+void setThermalPlantTau(float tau) {
+    g_thermalPlantTau = tau;
+}
+
+float getThermalPlantTau() {
+    return g_thermalPlantTau;
+}
+
+void resetThermalPlant() {
+    for (int i = 0; i < CH_NUM; ++i) {
+        g_temperature[temp_sensor::CH1 + i] = SIM_PLANT_AMBIENT;
+    }
+    g_thermalPlantLastTick = micros();
+}
+
 void init() {
     for (int i = 0; i < temp_sensor::NUM_TEMP_SENSORS; ++i) {
         g_temperature[i] = 25.0f;
@@ -125,6 +125,13 @@ void tick();
 void setTemperature(int sensor, float value);
 float getTemperature(int sensor);
 
+void tickThermalPlant();
+void setThermalPlantEnabled(bool enabled);
+bool isThermalPlantEnabled();
+void setThermalPlantTau(float tau);
+float getThermalPlantTau();
+void resetThermalPlant(); // all channels at ambient temperature
+
 bool getPwrgood(int pin);
 void setPwrgood(int pin, bool on);
 
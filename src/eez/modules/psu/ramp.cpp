@@ -31,8 +31,8 @@ namespace ramp {
 
 static struct {
     int state;
-    float startTime;
-    float currentTime;
+    uint64_t startTime;
+    uint64_t currentTime;
     bool voltageRampDone;
     bool currentRampDone;
 } g_execution[CH_MAX];
@@ -66,38 +66,39 @@ void executionStart(Channel &channel) {
     setActive(true, true);
 }
 
-void tick(uint32_t tickUsec) {
+void tick(uint64_t tickUsec) {
     bool active = false;
 
-    float tick = tickUsec / 1000000.0f;
-
     for (int i = 0; i < CH_NUM; i++) {
         if (g_execution[i].state) {
             auto &channel = Channel::get(i);
             if (channel.isOutputEnabled()) {
-                g_execution[i].currentTime = tick;
+                g_execution[i].currentTime = tickUsec;
 
                 if (g_execution[i].state == 1) {
-                    g_execution[i].startTime = tick;
+                    g_execution[i].startTime = tickUsec;
                     g_execution[i].state = 2;
                 }
 
+                // time since start in seconds, it is small enough to be precise as float
+                float tick = (tickUsec - g_execution[i].startTime) / 1000000.0f;
+
                 if (g_execution[i].state == 2) {
-                    if (tick >= g_execution[i].startTime + channel.outputDelayDuration) {
+                    if (tick >= channel.outputDelayDuration) {
                         g_execution[i].state = 3;
                     }
                 }
 
                 if (g_execution[i].state == 3) {
-                    if (tick < g_execution[i].startTime + channel.outputDelayDuration + channel.u.rampDuration) {
-                        channel_dispatcher::setVoltage(channel, channel.u.triggerLevel * (tick - g_execution[i].startTime - channel.outputDelayDuration) / channel.u.rampDuration);
+                    if (tick < channel.outputDelayDuration + channel.u.rampDuration) {
+                        channel_dispatcher::setVoltage(channel, channel.u.triggerLevel * (tick - channel.outputDelayDuration) / channel.u.rampDuration);
                     } else if (!g_execution[i].voltageRampDone) {
                         channel_dispatcher::setVoltage(channel, channel.u.triggerLevel);
                         g_execution[i].voltageRampDone = true;
                     }
 
-                    if (tick < g_execution[i].startTime + channel.outputDelayDuration + channel.i.rampDuration) {
-                        channel_dispatcher::setCurrent(channel, channel.i.triggerLevel * (tick - g_execution[i].startTime - channel.outputDelayDuration) / channel.i.rampDuration);
+                    if (tick < channel.outputDelayDuration + channel.i.rampDuration) {
+                        channel_dispatcher::setCurrent(channel, channel.i.triggerLevel * (tick - channel.outputDelayDuration) / channel.i.rampDuration);
                     } else if (!g_execution[i].currentRampDone) {
                         channel_dispatcher::setCurrent(channel, channel.i.triggerLevel);
                         g_execution[i].currentRampDone = true;
@@ -147,7 +148,7 @@ void getCountdownTime(int channelIndex, uint32_t &remaining, uint32_t &total) {
         if (g_execution[channelIndex].state == 1) {
             remaining = total;
         } else {
-            int32_t aux = (int32_t)roundf(g_execution[channelIndex].startTime + duration - g_execution[channelIndex].currentTime);
+            int32_t aux = (int32_t)roundf(duration - (g_execution[channelIndex].currentTime - g_execution[channelIndex].startTime) / 1000000.0f);
             if (aux > 0) {
                 remaining = aux;
             } else {
@@ -23,7 +23,7 @@ namespace psu {
 namespace ramp {
 
 void executionStart(Channel &channel);
-void tick(uint32_t tickUsec);
+void tick(uint64_t tickUsec);
 
 bool isActive();
 bool isActive(Channel &channel);
@@ -1,478 +1,1266 @@
-/*
- * EEZ Modular Firmware
- * Copyright (C) 2015-present, Envox d.o.o.
- *
- * This program is free software: you can redistribute it and/or modify
- * it under the terms of the GNU General Public License as published by
- * the Free Software Foundation, either version 3 of the License, or
- * (at your option) any later version.
-
- * This program is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- * GNU General Public License for more details.
-
- * You should have received a copy of the GNU General Public License
- * along with this program.  If not, see <http://www.gnu.org/licenses/>.
- */
-
-#include <math.h>
-#include <stdio.h>
-
-#include <eez/firmware.h>
-#include <eez/system.h>
-
-#if OPTION_FAN
-#include <eez/modules/aux_ps/fan.h>
-#endif
-
-#include <eez/modules/psu/psu.h>
-#include <eez/modules/psu/serial_psu.h>
-#include <eez/modules/psu/temperature.h>
-#include <eez/modules/psu/ontime.h>
-#include <eez/modules/psu/scpi/psu.h>
-#include <eez/modules/psu/event_queue.h>
-#if OPTION_DISPLAY
-#include <eez/modules/psu/gui/psu.h>
-#endif
-
-#include <eez/modules/mcu/eeprom.h>
-
-#include <eez/modules/bp3c/flash_slave.h>
-#include <eez/modules/bp3c/io_exp.h>
-
-#include <eez/modules/dib-dcp405/channel.h>
-
-namespace eez {
-namespace psu {
-
-#ifdef DEBUG
-using namespace debug;
-#endif // DEBUG
-
-namespace scpi {
-
-scpi_result_t scpi_cmd_debug(scpi_t *context) {
-#ifdef DEBUG
-    int32_t cmd;
-    if (SCPI_ParamInt32(context, &cmd, false)) {
-        if (cmd == 23) {
-#if defined(EEZ_PLATFORM_STM32)
-            taskENTER_CRITICAL();
-#endif
-
-            mcu::eeprom::resetAllExceptOnTimeCounters();
-
-#if defined(EEZ_PLATFORM_STM32)
-            taskEXIT_CRITICAL();
-            restart();
-#endif
-        } else if (cmd == 24) {
-        	DebugTrace("Lorem ipsum dolor sit amet, consectetur adipiscing elit. Nam tristique, nisl vitae interdum molestie, tortor nulla condimentum ligula, et egestas risus tortor sodales augue. Proin a congue arcu. Morbi in odio eu eros tincidunt dictum et at metus. In at quam erat. Mauris est ligula, consequat vehicula felis sit amet, blandit sollicitudin augue. Sed ornare purus ut nisi euismod ultrices. Sed rhoncus eros sapien, ac ullamcorper risus blandit ac. Nulla ac aliquam sapien, nec euismod nibh. Fusce volutpat fermentum libero sit amet iaculis. Donec in augue sapien. Vivamus vitae urna sodales, dapibus nisi sed, rhoncus urna.");
-        } else if (cmd == 25) {
-            if (psu::gui::getActivePageId() != PAGE_ID_TOUCH_TEST) {
-                psu::gui::showPage(PAGE_ID_TOUCH_TEST);
-            } else {
-                psu::gui::showPage(PAGE_ID_MAIN);
-            }
-        } else if (cmd == 26) {
-        	psu::gui::showPage(PAGE_ID_DEBUG_VARIABLES);
-        } else if (cmd == 27) {
-            int32_t relay;
-            if (SCPI_ParamInt32(context, &relay, true)) {
-                bp3c::io_exp::switchChannelCoupling(relay);
-            }
-        } else if (cmd == 28) {
-        	psu::gui::showPage(PAGE_ID_DEBUG_POWER_CHANNELS);
-        } else {
-            SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
-            return SCPI_RES_ERR;
-        }
-    } else {
-        // do nothing
-    }
-
-    return SCPI_RES_OK;
-#else
-    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
-    return SCPI_RES_ERR;
-#endif // DEBUG
-}
-
-scpi_result_t scpi_cmd_debugQ(scpi_t *context) {
-#ifdef DEBUG
-    int32_t cmd;
-    if (SCPI_ParamInt32(context, &cmd, false)) {
-        if (cmd == 23) {
-            bp3c::io_exp::init();
-            bp3c::io_exp::test();
-            SCPI_ResultBool(context, bp3c::io_exp::g_testResult == TEST_OK);
-            return SCPI_RES_OK;
-        } else {
-            SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
-            return SCPI_RES_ERR;
-        }
-    }
-
-    static char buffer[2048];
-
-#ifndef __EMSCRIPTEN__
-    for (int i = 0; i < CH_NUM; i++) {
-        if (!measureAllAdcValuesOnChannel(i)) {
-            SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
-            return SCPI_RES_ERR;
-        }
-    }
-#endif
-
-    debug::dumpVariables(buffer);
-
-    SCPI_ResultCharacters(context, buffer, strlen(buffer));
-
-    return SCPI_RES_OK;
-#else
-    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
-    return SCPI_RES_ERR;
-#endif // DEBUG
-}
-
-scpi_result_t scpi_cmd_debugOntimeQ(scpi_t *context) {
-#ifdef DEBUG
-    char buffer[512] = { 0 };
-    char *p = buffer;
-
-    sprintf(p, "power active: %d\n", int(ontime::g_mcuCounter.isActive() ? 1 : 0));
-    p += strlen(p);
-
-    for (int i = 0; i < CH_NUM; ++i) {
-        Channel &channel = Channel::get(i);
-
-        sprintf(p, "CH%d active: %d\n", channel.channelIndex + 1, int(ontime::g_mcuCounter.isActive() ? 1 : 0));
-        p += strlen(p);
-    }
-
-    SCPI_ResultCharacters(context, buffer, strlen(buffer));
-
-    return SCPI_RES_OK;
-#else
-    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
-    return SCPI_RES_ERR;
-#endif // DEBUG
-}
-
-scpi_result_t scpi_cmd_debugVoltage(scpi_t *context) {
-#ifdef DEBUG
-    Channel *channel = param_channel(context);
-    if (!channel) {
-        return SCPI_RES_ERR;
-    }
-
-    uint32_t value;
-    if (!SCPI_ParamUInt32(context, &value, true)) {
-        return SCPI_RES_ERR;
-    }
-
-    channel->setDacVoltage((uint16_t)value);
-
-    return SCPI_RES_OK;
-#else
-    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
-    return SCPI_RES_ERR;
-#endif // DEBUG
-}
-
-scpi_result_t scpi_cmd_debugCurrent(scpi_t *context) {
-#ifdef DEBUG
-    Channel *channel = param_channel(context);
-    if (!channel) {
-        return SCPI_RES_ERR;
-    }
-
-    uint32_t value;
-    if (!SCPI_ParamUInt32(context, &value, true)) {
-        return SCPI_RES_ERR;
-    }
-
-    channel->setDacCurrent((uint16_t)value);
-
-    return SCPI_RES_OK;
-#else
-    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
-    return SCPI_RES_ERR;
-#endif // DEBUG
-}
-
-scpi_result_t scpi_cmd_debugMeasureVoltage(scpi_t *context) {
-#ifdef DEBUG
-    if (serial::g_testResult != TEST_OK) {
-        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
-        return SCPI_RES_ERR;
-    }
-
-    Channel *channel = param_channel(context);
-    if (!channel) {
-        return SCPI_RES_ERR;
-    }
-
-    while (true) {
-        uint32_t tickCount = micros();
-        temperature::tick(tickCount);
-
-#if OPTION_FAN
-        aux_ps::fan::tick(tickCount);
-#endif
-
-        channel->adcMeasureUMon();
-
-        Serial.print((int)debug::g_uMon[channel->channelIndex].get());
-        Serial.print(" ");
-        Serial.print(channel->u.mon_last, 5);
-        Serial.println("V");
-
-        int32_t diff = micros() - tickCount;
-        if (diff < 48000L) {
-            delayMicroseconds(48000L - diff);
-        }
-    }
-
-    return SCPI_RES_OK;
-#else
-    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
-    return SCPI_RES_ERR;
-#endif // DEBUG
-}
-
-scpi_result_t scpi_cmd_debugMeasureCurrent(scpi_t *context) {
-#ifdef DEBUG
-    if (serial::g_testResult != TEST_OK) {
-        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
-        return SCPI_RES_ERR;
-    }
-
-    Channel *channel = param_channel(context);
-    if (!channel) {
-        return SCPI_RES_ERR;
-    }
-
-    while (true) {
-        uint32_t tickCount = micros();
-        temperature::tick(tickCount);
-
-#if OPTION_FAN
-        aux_ps::fan::tick(tickCount);
-#endif
-
-        channel->adcMeasureIMon();
-
-        Serial.print((int)debug::g_iMon[channel->channelIndex].get());
-        Serial.print(" ");
-        Serial.print(channel->i.mon_last, 5);
-        Serial.println("A");
-
-        int32_t diff = micros() - tickCount;
-        if (diff < 48000L) {
-            delayMicroseconds(48000L - diff);
-        }
-    }
-
-    return SCPI_RES_OK;
-#else
-    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
-    return SCPI_RES_ERR;
-#endif // DEBUG
-}
-
-scpi_result_t scpi_cmd_debugFan(scpi_t *context) {
-    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
-    return SCPI_RES_ERR;
-}
-
-scpi_result_t scpi_cmd_debugFanQ(scpi_t *context) {
-    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
-    return SCPI_RES_ERR;
-}
-
-scpi_result_t scpi_cmd_debugFanPid(scpi_t *context) {
-#if OPTION_FAN
-    double Kp;
-    if (!SCPI_ParamDouble(context, &Kp, TRUE)) {
-        return SCPI_RES_ERR;
-    }
-
-    double Ki;
-    if (!SCPI_ParamDouble(context, &Ki, TRUE)) {
-        return SCPI_RES_ERR;
-    }
-
-    double Kd;
-    if (!SCPI_ParamDouble(context, &Kd, TRUE)) {
-        return SCPI_RES_ERR;
-    }
-
-    int32_t POn;
-    if (!SCPI_ParamInt(context, &POn, TRUE)) {
-        return SCPI_RES_ERR;
-    }
-
-    aux_ps::fan::setPidTunings(Kp, Ki, Kd, POn);
-
-    return SCPI_RES_OK;
-#else
-    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
-    return SCPI_RES_ERR;
-#endif
-}
-
-scpi_result_t scpi_cmd_debugFanPidQ(scpi_t *context) {
-#if OPTION_FAN
-    double Kp[4] = { aux_ps::fan::g_Kp, aux_ps::fan::g_Ki, aux_ps::fan::g_Kd, aux_ps::fan::g_POn * 1.0f };
-
-    SCPI_ResultArrayDouble(context, Kp, 4, SCPI_FORMAT_ASCII);
-
-    return SCPI_RES_OK;
-#else
-    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
-    return SCPI_RES_ERR;
-#endif
-}
-
-scpi_result_t scpi_cmd_debugCsvQ(scpi_t *context) {
-    const int count = 1000;
-    double *arr = (double *)malloc(count * sizeof(double));
-    for (int i = 0; i < count; ++i) {
-        arr[i] = 1.0 * rand() / RAND_MAX;
-	}
-    SCPI_ResultArrayDouble(context, arr, count, SCPI_FORMAT_ASCII);
-    free(arr);
-    return SCPI_RES_OK;
-}
-
-scpi_result_t scpi_cmd_debugIoexp(scpi_t *context) {
-#if defined(DEBUG) && defined(EEZ_PLATFORM_STM32)
-    Channel *channel = getSelectedChannel(context);
-    if (!channel) {
-        return SCPI_RES_ERR;
-    }
-
-    int32_t bit;
-    if (!SCPI_ParamInt(context, &bit, TRUE)) {
-        return SCPI_RES_ERR;
-    }
-    if (bit < 0 || bit > 15) {
-        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
-        return SCPI_RES_ERR;
-    }
-
-    int32_t direction;
-    if (!SCPI_ParamInt(context, &direction, TRUE)) {
-        return SCPI_RES_ERR;
-    }
-
-    if (direction != channel->getIoExpBitDirection(bit)) {
-        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
-        return SCPI_RES_ERR;
-    }
-
-    bool state;
-    if (!SCPI_ParamBool(context, &state, TRUE)) {
-        return SCPI_RES_ERR;
-    }
-
-    channel->changeIoExpBit(bit, state);
-
-    return SCPI_RES_OK;
-#else
-    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
-    return SCPI_RES_ERR;
-#endif // DEBUG
-}
-
-scpi_result_t scpi_cmd_debugIoexpQ(scpi_t *context) {
-#if defined(DEBUG) && defined(EEZ_PLATFORM_STM32)
-    Channel *channel = getSelectedChannel(context);
-    if (!channel) {
-        return SCPI_RES_ERR;
-    }
-
-    int32_t bit;
-    if (!SCPI_ParamInt(context, &bit, TRUE)) {
-        return SCPI_RES_ERR;
-    }
-    if (bit < 0 || bit > 15) {
-        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
-        return SCPI_RES_ERR;
-    }
-
-    int32_t direction;
-    if (!SCPI_ParamInt(context, &direction, TRUE)) {
-        return SCPI_RES_ERR;
-    }
-
-    if (direction != channel->getIoExpBitDirection(bit)) {
-        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
-        return SCPI_RES_ERR;
-    }
-
-    bool state = channel->testIoExpBit(bit);
-
-    SCPI_ResultBool(context, state);
-
-    return SCPI_RES_OK;
-#else
-    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
-    return SCPI_RES_ERR;
-#endif // DEBUG
-}
-
-scpi_result_t scpi_cmd_debugDcm220Q(scpi_t *context) {
-#if defined(EEZ_PLATFORM_STM32)
-	char text[100];
-	sprintf(text, "TODO");
-	SCPI_ResultText(context, text);
-	return SCPI_RES_OK;
-#else
-    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
-    return SCPI_RES_ERR;
-#endif // DEBUG
-}
-
-scpi_result_t scpi_cmd_debugDownloadFirmware(scpi_t *context) {
-#if defined(DEBUG) && defined(EEZ_PLATFORM_STM32)
-    int32_t slotIndex;
-    if (!SCPI_ParamInt32(context, &slotIndex, true)) {
-        return SCPI_RES_ERR;
-    }
-
-    if (slotIndex < 1 || slotIndex > 3) {
-        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
-        return SCPI_RES_ERR;
-    }
-
-    char hexFilePath[MAX_PATH_LENGTH + 1];
-    if (!getFilePath(context, hexFilePath, true)) {
-        return SCPI_RES_ERR;
-    }
-
-    bp3c::flash_slave::start(slotIndex - 1, hexFilePath);
-
-    return SCPI_RES_OK;
-#else
-    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
-    return SCPI_RES_ERR;
-#endif // DEBUG
-}
-
-scpi_result_t scpi_cmd_debugEvent(scpi_t *context) {
-    int32_t eventId;
-    if (!SCPI_ParamInt(context, &eventId, TRUE)) {
-        return SCPI_RES_ERR;
-    }
-
-    event_queue::pushEvent(eventId);
-
-    return SCPI_RES_OK;
-}
-
-} // namespace scpi
-} // namespace psu
-} // namespace eez
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <eez/firmware.h>
+#include <eez/debug.h>
+#include <eez/system.h>
+#include <eez/util.h>
+
+#if OPTION_FAN
+#include <eez/modules/aux_ps/fan.h>
+#endif
+
+#include <eez/modules/psu/psu.h>
+#include <eez/modules/psu/channel_dispatcher.h>
+#include <eez/modules/psu/serial_psu.h>
+#include <eez/modules/psu/temperature.h>
+#include <eez/modules/psu/ontime.h>
+#include <eez/modules/psu/persist_conf.h>
+#include <eez/modules/psu/profile.h>
+#include <eez/modules/psu/protection.h>
+#include <eez/modules/psu/trigger.h>
+#include <eez/modules/psu/dlog_record.h>
+#if OPTION_ETHERNET
+#include <eez/modules/psu/ethernet.h>
+#endif
+#include <eez/modules/psu/scpi/psu.h>
+#include <eez/modules/psu/event_queue.h>
+#if OPTION_DISPLAY
+#include <eez/modules/psu/gui/psu.h>
+#include <eez/modules/mcu/display.h>
+#endif
+
+#include <eez/modules/mcu/dma2d_queue.h>
+#include <eez/modules/mcu/eeprom.h>
+
+#include <eez/modules/bp3c/comm.h>
+#include <eez/modules/bp3c/flash_slave.h>
+#include <eez/modules/bp3c/io_exp.h>
+
+#include <eez/modules/dib-dcp405/channel.h>
+
+namespace eez {
+namespace psu {
+
+#ifdef DEBUG
+using namespace debug;
+#endif // DEBUG
+
+namespace scpi {
+
+scpi_result_t scpi_cmd_debug(scpi_t *context) {
+#ifdef DEBUG
+    int32_t cmd;
+    if (SCPI_ParamInt32(context, &cmd, false)) {
+        if (cmd == 23) {
+#if defined(EEZ_PLATFORM_STM32)
+            taskENTER_CRITICAL();
+#endif
+
+            mcu::eeprom::resetAllExceptOnTimeCounters();
+
+#if defined(EEZ_PLATFORM_STM32)
+            taskEXIT_CRITICAL();
+            restart();
+#endif
+        } else if (cmd == 24) {
+        	DebugTrace("Lorem ipsum dolor sit amet, consectetur adipiscing elit. Nam tristique, nisl vitae interdum molestie, tortor nulla condimentum ligula, et egestas risus tortor sodales augue. Proin a congue arcu. Morbi in odio eu eros tincidunt dictum et at metus. In at quam erat. Mauris est ligula, consequat vehicula felis sit amet, blandit sollicitudin augue. Sed ornare purus ut nisi euismod ultrices. Sed rhoncus eros sapien, ac ullamcorper risus blandit ac. Nulla ac aliquam sapien, nec euismod nibh. Fusce volutpat fermentum libero sit amet iaculis. Donec in augue sapien. Vivamus vitae urna sodales, dapibus nisi sed, rhoncus urna.");
+        } else if (cmd == 25) {
+            if (psu::gui::getActivePageId() != PAGE_ID_TOUCH_TEST) {
+                psu::gui::showPage(PAGE_ID_TOUCH_TEST);
+            } else {
+                psu::gui::showPage(PAGE_ID_MAIN);
+            }
+        } else if (cmd == 26) {
+        	psu::gui::showPage(PAGE_ID_DEBUG_VARIABLES);
+        } else if (cmd == 27) {
+            int32_t relay;
+            if (SCPI_ParamInt32(context, &relay, true)) {
+                bp3c::io_exp::switchChannelCoupling(relay);
+            }
+        } else if (cmd == 28) {
+        	psu::gui::showPage(PAGE_ID_DEBUG_POWER_CHANNELS);
+        } else {
+            SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+            return SCPI_RES_ERR;
+        }
+    } else {
+        // do nothing
+    }
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif // DEBUG
+}
+
+scpi_result_t scpi_cmd_debugQ(scpi_t *context) {
+#ifdef DEBUG
+    int32_t cmd;
+    if (SCPI_ParamInt32(context, &cmd, false)) {
+        if (cmd == 23) {
+            bp3c::io_exp::init();
+            bp3c::io_exp::test();
+            SCPI_ResultBool(context, bp3c::io_exp::g_testResult == TEST_OK);
+            return SCPI_RES_OK;
+        } else {
+            SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+            return SCPI_RES_ERR;
+        }
+    }
+
+    static char buffer[2048];
+
+#ifndef __EMSCRIPTEN__
+    for (int i = 0; i < CH_NUM; i++) {
+        if (!measureAllAdcValuesOnChannel(i)) {
+            SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+            return SCPI_RES_ERR;
+        }
+    }
+#endif
+
+    debug::dumpVariables(buffer);
+
+    SCPI_ResultCharacters(context, buffer, strlen(buffer));
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif // DEBUG
+}
+
+scpi_result_t scpi_cmd_debugOntimeQ(scpi_t *context) {
+#ifdef DEBUG
+    char buffer[512] = { 0 };
+    char *p = buffer;
+
+    sprintf(p, "power active: %d\n", int(ontime::g_mcuCounter.isActive() ? 1 : 0));
+    p += strlen(p);
+
+    for (int i = 0; i < CH_NUM; ++i) {
+        Channel &channel = Channel::get(i);
+
+        sprintf(p, "CH%d active: %d\n", channel.channelIndex + 1, int(ontime::g_mcuCounter.isActive() ? 1 : 0));
+        p += strlen(p);
+    }
+
+    SCPI_ResultCharacters(context, buffer, strlen(buffer));
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif // DEBUG
+}
+
+scpi_result_t scpi_cmd_debugOntimeJournalQ(scpi_t *context) {
+    char buffer[128] = { 0 };
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    // runs long uptime on RAM storage, checks totals and EEPROM write calls
+    char message[96];
+    if (ontime::selfTest(message, sizeof(message))) {
+        snprintf(buffer, sizeof(buffer), "self test=PASS %s", message);
+    } else {
+        snprintf(buffer, sizeof(buffer), "self test=FAIL %s", message);
+    }
+    SCPI_ResultText(context, buffer);
+#endif
+
+    ontime::Statistics statistics;
+    ontime::getStatistics(statistics);
+
+    sprintf(buffer, "commits=%u skipped=%u journal_writes=%u home_writes=%u errors=%u",
+        (unsigned)statistics.numCommits,
+        (unsigned)statistics.numCommitsSkipped,
+        (unsigned)statistics.numJournalWrites,
+        (unsigned)statistics.numHomeWrites,
+        (unsigned)statistics.numErrors);
+    SCPI_ResultText(context, buffer);
+
+    sprintf(buffer, "sequence=%u location=%u interval=%u min",
+        (unsigned)statistics.sequence,
+        (unsigned)statistics.recordIndex,
+        (unsigned)ontime::getCommitInterval());
+    SCPI_ResultText(context, buffer);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_debugOntimeInterval(scpi_t *context) {
+    uint32_t commitInterval;
+    if (!SCPI_ParamUInt32(context, &commitInterval, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (commitInterval < 1 || commitInterval > WRITE_ONTIME_HOME_INTERVAL) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+
+    ontime::setCommitInterval(commitInterval);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_debugOntimeIntervalQ(scpi_t *context) {
+    SCPI_ResultUInt32(context, ontime::getCommitInterval());
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_debugVoltage(scpi_t *context) {
+#ifdef DEBUG
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    uint32_t value;
+    if (!SCPI_ParamUInt32(context, &value, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    channel->setDacVoltage((uint16_t)value);
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif // DEBUG
+}
+
+scpi_result_t scpi_cmd_debugCurrent(scpi_t *context) {
+#ifdef DEBUG
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    uint32_t value;
+    if (!SCPI_ParamUInt32(context, &value, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    channel->setDacCurrent((uint16_t)value);
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif // DEBUG
+}
+
+scpi_result_t scpi_cmd_debugMeasureVoltage(scpi_t *context) {
+#ifdef DEBUG
+    if (serial::g_testResult != TEST_OK) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    while (true) {
+        uint32_t tickCount = micros();
+        temperature::tick(tickCount);
+
+#if OPTION_FAN
+        aux_ps::fan::tick(tickCount);
+#endif
+
+        channel->adcMeasureUMon();
+
+        Serial.print((int)debug::g_uMon[channel->channelIndex].get());
+        Serial.print(" ");
+        Serial.print(channel->u.mon_last, 5);
+        Serial.println("V");
+
+        int32_t diff = micros() - tickCount;
+        if (diff < 48000L) {
+            delayMicroseconds(48000L - diff);
+        }
+    }
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif // DEBUG
+}
+
+scpi_result_t scpi_cmd_debugMeasureCurrent(scpi_t *context) {
+#ifdef DEBUG
+    if (serial::g_testResult != TEST_OK) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    while (true) {
+        uint32_t tickCount = micros();
+        temperature::tick(tickCount);
+
+#if OPTION_FAN
+        aux_ps::fan::tick(tickCount);
+#endif
+
+        channel->adcMeasureIMon();
+
+        Serial.print((int)debug::g_iMon[channel->channelIndex].get());
+        Serial.print(" ");
+        Serial.print(channel->i.mon_last, 5);
+        Serial.println("A");
+
+        int32_t diff = micros() - tickCount;
+        if (diff < 48000L) {
+            delayMicroseconds(48000L - diff);
+        }
+    }
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif // DEBUG
+}
+
+scpi_result_t scpi_cmd_debugFan(scpi_t *context) {
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+}
+
+scpi_result_t scpi_cmd_debugFanQ(scpi_t *context) {
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+}
+
+scpi_result_t scpi_cmd_debugFanPid(scpi_t *context) {
+#if OPTION_FAN
+    double Kp;
+    if (!SCPI_ParamDouble(context, &Kp, TRUE)) {
+        return SCPI_RES_ERR;
+    }
+
+    double Ki;
+    if (!SCPI_ParamDouble(context, &Ki, TRUE)) {
+        return SCPI_RES_ERR;
+    }
+
+    double Kd;
+    if (!SCPI_ParamDouble(context, &Kd, TRUE)) {
+        return SCPI_RES_ERR;
+    }
+
+    int32_t POn;
+    if (!SCPI_ParamInt(context, &POn, TRUE)) {
+        return SCPI_RES_ERR;
+    }
+
+    aux_ps::fan::setPidTunings(Kp, Ki, Kd, POn);
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_debugFanPidQ(scpi_t *context) {
+#if OPTION_FAN
+    double Kp[4] = { aux_ps::fan::g_Kp, aux_ps::fan::g_Ki, aux_ps::fan::g_Kd, aux_ps::fan::g_POn * 1.0f };
+
+    SCPI_ResultArrayDouble(context, Kp, 4, SCPI_FORMAT_ASCII);
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_debugFanModel(scpi_t *context) {
+#if OPTION_FAN
+    aux_ps::fan::FanModel model = aux_ps::fan::g_model;
+
+    if (!SCPI_ParamBool(context, &model.enabled, TRUE)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (!SCPI_ParamFloat(context, &model.kOut, FALSE)) {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return SCPI_RES_ERR;
+        }
+    } else {
+        if (!SCPI_ParamFloat(context, &model.uDrop, TRUE)) {
+            return SCPI_RES_ERR;
+        }
+
+        if (!SCPI_ParamFloat(context, &model.rth, TRUE)) {
+            return SCPI_RES_ERR;
+        }
+
+        if (!SCPI_ParamFloat(context, &model.gain, TRUE)) {
+            return SCPI_RES_ERR;
+        }
+
+        if (!SCPI_ParamFloat(context, &model.ambient, FALSE)) {
+            if (SCPI_ParamErrorOccurred(context)) {
+                return SCPI_RES_ERR;
+            }
+        }
+
+        if (model.kOut < 0 || model.kOut > 1 || model.uDrop < 0 || model.rth < 0 || model.gain < 0) {
+            SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+            return SCPI_RES_ERR;
+        }
+    }
+
+    aux_ps::fan::setModel(model);
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_debugFanModelQ(scpi_t *context) {
+#if OPTION_FAN
+    auto &model = aux_ps::fan::g_model;
+    double values[7] = {
+        model.enabled ? 1.0 : 0.0, model.kOut, model.uDrop, model.rth, model.gain, model.ambient,
+        aux_ps::fan::getPredictedTemperature()
+    };
+
+    SCPI_ResultArrayDouble(context, values, 7, SCPI_FORMAT_ASCII);
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_debugFanCompareQ(scpi_t *context) {
+#if OPTION_FAN && defined(EEZ_PLATFORM_SIMULATOR)
+    // heatsink temperature step response, PID only vs. feed-forward model
+    int32_t duration;
+    if (!SCPI_ParamInt(context, &duration, FALSE)) {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return SCPI_RES_ERR;
+        }
+        duration = 40;
+    }
+
+    if (duration < STEP_RESPONSE_MIN_DURATION || duration > STEP_RESPONSE_MAX_DURATION) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+
+    char buffer[128] = { 0 };
+
+    char message[96];
+    aux_ps::fan::StepResponse responses[2];
+    bool result = aux_ps::fan::stepResponseSelfTest(Channel::get(0), duration, responses, message, sizeof(message));
+    snprintf(buffer, sizeof(buffer), "self test=%s %s", result ? "PASS" : "FAIL", message);
+    SCPI_ResultText(context, buffer);
+
+    if (result) {
+        static const char *names[2] = { "pid", "model" };
+        for (int i = 0; i < 2; i++) {
+            snprintf(buffer, sizeof(buffer), "%s: final=%.2f peak=%.2f overshoot=%.2f settling=%.1f s max_pwm=%d",
+                names[i], responses[i].final, responses[i].peak, responses[i].overshoot,
+                responses[i].settlingTime, responses[i].maxPwm);
+            SCPI_ResultText(context, buffer);
+        }
+    }
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_debugCsvQ(scpi_t *context) {
+    const int count = 1000;
+    double *arr = (double *)malloc(count * sizeof(double));
+    for (int i = 0; i < count; ++i) {
+        arr[i] = 1.0 * rand() / RAND_MAX;
+	}
+    SCPI_ResultArrayDouble(context, arr, count, SCPI_FORMAT_ASCII);
+    free(arr);
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_debugIoexp(scpi_t *context) {
+#if defined(DEBUG) && defined(EEZ_PLATFORM_STM32)
+    Channel *channel = getSelectedChannel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    int32_t bit;
+    if (!SCPI_ParamInt(context, &bit, TRUE)) {
+        return SCPI_RES_ERR;
+    }
+    if (bit < 0 || bit > 15) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+
+    int32_t direction;
+    if (!SCPI_ParamInt(context, &direction, TRUE)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (direction != channel->getIoExpBitDirection(bit)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    bool state;
+    if (!SCPI_ParamBool(context, &state, TRUE)) {
+        return SCPI_RES_ERR;
+    }
+
+    channel->changeIoExpBit(bit, state);
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif // DEBUG
+}
+
+scpi_result_t scpi_cmd_debugIoexpQ(scpi_t *context) {
+#if defined(DEBUG) && defined(EEZ_PLATFORM_STM32)
+    Channel *channel = getSelectedChannel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    int32_t bit;
+    if (!SCPI_ParamInt(context, &bit, TRUE)) {
+        return SCPI_RES_ERR;
+    }
+    if (bit < 0 || bit > 15) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+
+    int32_t direction;
+    if (!SCPI_ParamInt(context, &direction, TRUE)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (direction != channel->getIoExpBitDirection(bit)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    bool state = channel->testIoExpBit(bit);
+
+    SCPI_ResultBool(context, state);
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif // DEBUG
+}
+
+scpi_result_t scpi_cmd_debugDcm220Q(scpi_t *context) {
+#if defined(EEZ_PLATFORM_STM32)
+	char text[100];
+	sprintf(text, "TODO");
+	SCPI_ResultText(context, text);
+	return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif // DEBUG
+}
+
+scpi_result_t scpi_cmd_debugDownloadFirmware(scpi_t *context) {
+#if defined(DEBUG) && defined(EEZ_PLATFORM_STM32)
+    int32_t slotIndex;
+    if (!SCPI_ParamInt32(context, &slotIndex, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (slotIndex < 1 || slotIndex > 3) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+
+    char hexFilePath[MAX_PATH_LENGTH + 1];
+    if (!getFilePath(context, hexFilePath, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    bp3c::flash_slave::start(slotIndex - 1, hexFilePath);
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif // DEBUG
+}
+
+scpi_result_t scpi_cmd_debugEvent(scpi_t *context) {
+    int32_t eventId;
+    if (!SCPI_ParamInt(context, &eventId, TRUE)) {
+        return SCPI_RES_ERR;
+    }
+
+    event_queue::pushEvent(eventId);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_debugCalibrationTableQ(scpi_t *context) {
+    // compares Channel::CalibrationTable against remapValue and remapAdcValue
+    // for synthetic 2, 3 and MAX_CALIBRATION_POINTS point calibrations,
+    // table and remap differ only in rounding, so error must stay within MAX_ERROR_ULPS
+    static const unsigned int NUM_POINTS[] = { 2, 3, MAX_CALIBRATION_POINTS };
+    static const int NUM_STEPS = 20000;
+    static const float MAX_ERROR_ULPS = 4.0f;
+
+    struct {
+        unsigned int numPoints;
+        bool fromAdc;
+        float maxError;
+        float maxErrorUlps;
+        float maxErrorX;
+        uint32_t remapTime;
+        uint32_t tableTime;
+    } results[2 * sizeof(NUM_POINTS) / sizeof(NUM_POINTS[0])];
+    unsigned int numResults = 0;
+    int failedResult = -1;
+
+    char buffer[128] = { 0 };
+
+    uint32_t seed = 12345;
+
+    for (unsigned int k = 0; k < sizeof(NUM_POINTS) / sizeof(NUM_POINTS[0]); k++) {
+        Channel::CalibrationValueConfiguration cal;
+        cal.numPoints = NUM_POINTS[k];
+        for (unsigned int i = 0; i < cal.numPoints; i++) {
+            seed = seed * 1103515245 + 12345;
+            float jitter = ((seed >> 16) & 0x7FFF) / 32768.0f - 0.5f;
+            float value = 40.0f * i / (cal.numPoints - 1);
+            cal.points[i].value = value;
+            cal.points[i].dac = 1.01f * value + 0.02f + 0.01f * jitter;
+            cal.points[i].adc = 0.99f * value - 0.01f + 0.01f * jitter;
+        }
+
+        for (int fromAdc = 0; fromAdc < 2; fromAdc++) {
+            Channel::CalibrationTable table;
+            table.build(cal, fromAdc != 0);
+
+            // error is expressed in ULPs of the full scale output value,
+            // relative ULPs are meaningless where output crosses zero
+            float fullScale = 0;
+            for (unsigned int i = 0; i < cal.numPoints; i++) {
+                fullScale = MAX(fullScale, fabsf(fromAdc ? cal.points[i].value : cal.points[i].dac));
+            }
+            float fullScaleUlp = nextafterf(fullScale, INFINITY) - fullScale;
+
+            float maxError = 0;
+            float maxErrorX = 0;
+
+            for (int step = 0; step <= NUM_STEPS; step++) {
+                float x = -4.0f + 48.0f * step / NUM_STEPS;
+
+                float expected = fromAdc ? remapAdcValue(x, cal) : remapValue(x, cal);
+                float actual = table.remap(x);
+
+                float error = fabsf(expected - actual);
+                if (error > maxError) {
+                    maxError = error;
+                    maxErrorX = x;
+                }
+            }
+
+            // single call is shorter than micros() resolution,
+            // so each method is timed over the whole sweep
+            volatile float sink = 0;
+
+            uint32_t startTime = micros();
+            for (int step = 0; step <= NUM_STEPS; step++) {
+                float x = -4.0f + 48.0f * step / NUM_STEPS;
+                sink = sink + (fromAdc ? remapAdcValue(x, cal) : remapValue(x, cal));
+            }
+            uint32_t remapTime = micros() - startTime;
+
+            startTime = micros();
+            for (int step = 0; step <= NUM_STEPS; step++) {
+                float x = -4.0f + 48.0f * step / NUM_STEPS;
+                sink = sink + table.remap(x);
+            }
+            uint32_t tableTime = micros() - startTime;
+
+            auto &result = results[numResults];
+            result.numPoints = cal.numPoints;
+            result.fromAdc = fromAdc != 0;
+            result.maxError = maxError;
+            result.maxErrorUlps = maxError / fullScaleUlp;
+            result.maxErrorX = maxErrorX;
+            result.remapTime = remapTime;
+            result.tableTime = tableTime;
+
+            if (!(result.maxErrorUlps <= MAX_ERROR_ULPS) && failedResult == -1) {
+                failedResult = numResults;
+            }
+
+            numResults++;
+        }
+    }
+
+    if (failedResult == -1) {
+        SCPI_ResultText(context, "self test=PASS");
+    } else {
+        auto &result = results[failedResult];
+        snprintf(buffer, sizeof(buffer), "self test=FAIL points=%u %s error %g ulps at %g exceeds %g ulps",
+            result.numPoints, result.fromAdc ? "adc" : "dac",
+            result.maxErrorUlps, result.maxErrorX, MAX_ERROR_ULPS);
+        SCPI_ResultText(context, buffer);
+    }
+
+    for (unsigned int i = 0; i < numResults; i++) {
+        auto &result = results[i];
+        snprintf(buffer, sizeof(buffer), "points=%u %s max_error=%g (%g ulps) remap=%.1f ns/call table=%.1f ns/call",
+            result.numPoints, result.fromAdc ? "adc" : "dac",
+            result.maxError, result.maxErrorUlps,
+            1000.0f * result.remapTime / (NUM_STEPS + 1), 1000.0f * result.tableTime / (NUM_STEPS + 1));
+        SCPI_ResultText(context, buffer);
+    }
+
+    return SCPI_RES_OK;
+}
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+
+// first modes are coupling types (same order as CouplingType), last one is tracking
+static const int DISPATCH_BENCHMARK_NUM_MODES = 6;
+static const char *g_dispatchBenchmarkModeNames[DISPATCH_BENCHMARK_NUM_MODES] = {
+    "none", "parallel", "series", "common_gnd", "split_rails", "tracking"
+};
+static const int DISPATCH_BENCHMARK_NUM_CALLS = 16;
+
+static int32_t g_dispatchBenchmarkIterations;
+static bool g_dispatchBenchmarkModeDone[DISPATCH_BENCHMARK_NUM_MODES];
+static uint32_t g_dispatchBenchmarkTime[DISPATCH_BENCHMARK_NUM_MODES][CH_MAX];
+
+static uint32_t dispatchBenchmarkChannel(Channel &channel) {
+    volatile float sum = 0;
+
+    uint32_t startTime = micros();
+
+    for (int32_t i = 0; i < g_dispatchBenchmarkIterations; i++) {
+        sum += channel_dispatcher::getUSet(channel);
+        sum += channel_dispatcher::getUMon(channel);
+        sum += channel_dispatcher::getUMonLast(channel);
+        sum += channel_dispatcher::getULimit(channel);
+        sum += channel_dispatcher::getUMin(channel);
+        sum += channel_dispatcher::getUMax(channel);
+        sum += channel_dispatcher::getISet(channel);
+        sum += channel_dispatcher::getIMon(channel);
+        sum += channel_dispatcher::getIMonLast(channel);
+        sum += channel_dispatcher::getILimit(channel);
+        sum += channel_dispatcher::getIMin(channel);
+        sum += channel_dispatcher::getIMax(channel);
+
+        // setters write back the value just read, so levels do not drift between modes
+        channel_dispatcher::setVoltage(channel, channel_dispatcher::getUSet(channel));
+        channel_dispatcher::setCurrent(channel, channel_dispatcher::getISet(channel));
+        channel_dispatcher::setVoltageLimit(channel, channel_dispatcher::getULimit(channel));
+        channel_dispatcher::setCurrentLimit(channel, channel_dispatcher::getILimit(channel));
+    }
+
+    return micros() - startTime;
+}
+
+static void dispatchBenchmarkMode(int mode) {
+    for (int channelIndex = 0; channelIndex < CH_NUM; channelIndex++) {
+        g_dispatchBenchmarkTime[mode][channelIndex] = dispatchBenchmarkChannel(Channel::get(channelIndex));
+    }
+    g_dispatchBenchmarkModeDone[mode] = true;
+}
+
+static void dispatchBenchmarkCallback() {
+    channel_dispatcher::CouplingType savedCouplingType = channel_dispatcher::getCouplingType();
+
+    for (int mode = 0; mode < DISPATCH_BENCHMARK_NUM_MODES; mode++) {
+        g_dispatchBenchmarkModeDone[mode] = false;
+    }
+
+    // setters are asynchronous outside of PSU thread, that's why benchmark runs here
+    channel_dispatcher::setTrackingChannels(0);
+
+    for (int mode = channel_dispatcher::COUPLING_TYPE_NONE; mode <= channel_dispatcher::COUPLING_TYPE_SPLIT_RAILS; mode++) {
+        channel_dispatcher::CouplingType couplingType = (channel_dispatcher::CouplingType)mode;
+        int err;
+        if (couplingType != channel_dispatcher::COUPLING_TYPE_NONE && !channel_dispatcher::isCouplingTypeAllowed(couplingType, &err)) {
+            continue;
+        }
+        channel_dispatcher::setCouplingTypeInPsuThread(couplingType);
+        dispatchBenchmarkMode(mode);
+    }
+
+    channel_dispatcher::setCouplingTypeInPsuThread(channel_dispatcher::COUPLING_TYPE_NONE);
+
+    uint16_t trackingEnabled = 0;
+    for (int channelIndex = 0; channelIndex < CH_NUM; channelIndex++) {
+        int err;
+        if (channel_dispatcher::isTrackingAllowed(Channel::get(channelIndex), &err)) {
+            trackingEnabled |= 1 << channelIndex;
+        }
+    }
+    if (trackingEnabled & (trackingEnabled - 1)) {
+        channel_dispatcher::setTrackingChannels(trackingEnabled);
+        dispatchBenchmarkMode(DISPATCH_BENCHMARK_NUM_MODES - 1);
+        channel_dispatcher::setTrackingChannels(0);
+    }
+
+    channel_dispatcher::setCouplingTypeInPsuThread(savedCouplingType);
+}
+
+#endif
+
+scpi_result_t scpi_cmd_debugDispatchQ(scpi_t *context) {
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    // times channel_dispatcher getter/setter mix used by GUI, for every channel,
+    // in every allowed coupling mode and in tracking mode;
+    // state (levels, limits, coupling, tracking) is recalled afterwards, but outputs
+    // are switched off by coupling changes and coupling events are pushed
+    int32_t iterations;
+    if (!SCPI_ParamInt(context, &iterations, FALSE)) {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return SCPI_RES_ERR;
+        }
+        iterations = 1000000;
+    }
+    if (iterations < 1) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+
+    static profile::Parameters g_snapshot;
+    profile::saveStateSnapshot(g_snapshot);
+    int savedMaxSlotIndex = persist_conf::getMaxSlotIndex();
+
+    g_dispatchBenchmarkIterations = iterations;
+    g_diagCallback = dispatchBenchmarkCallback;
+    while (g_diagCallback) {
+        delayWithoutIoLock(1);
+    }
+
+    persist_conf::setMaxSlotIndex(savedMaxSlotIndex);
+    int err;
+    if (!profile::recallStateSnapshot(g_snapshot, &err)) {
+        SCPI_ErrorPush(context, err);
+        return SCPI_RES_ERR;
+    }
+
+    char buffer[128] = { 0 };
+
+    for (int mode = 0; mode < DISPATCH_BENCHMARK_NUM_MODES; mode++) {
+        if (!g_dispatchBenchmarkModeDone[mode]) {
+            continue;
+        }
+        for (int channelIndex = 0; channelIndex < CH_NUM; channelIndex++) {
+            uint32_t time = g_dispatchBenchmarkTime[mode][channelIndex];
+            snprintf(buffer, sizeof(buffer), "%s CH%d calls=%u time=%u us per_call=%u ns",
+                g_dispatchBenchmarkModeNames[mode], channelIndex + 1,
+                (unsigned)(DISPATCH_BENCHMARK_NUM_CALLS * iterations), (unsigned)time,
+                (unsigned)((uint64_t)time * 1000 / ((uint64_t)DISPATCH_BENCHMARK_NUM_CALLS * iterations)));
+            SCPI_ResultText(context, buffer);
+        }
+    }
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_debugCompositorQ(scpi_t *context) {
+#if defined(EEZ_PLATFORM_SIMULATOR) && OPTION_DISPLAY
+    // composites full screen page stack with translucent overlays,
+    // with pixel by pixel and row based compositor
+    int32_t numFrames;
+    if (!SCPI_ParamInt(context, &numFrames, FALSE)) {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return SCPI_RES_ERR;
+        }
+        numFrames = 50;
+    }
+
+    int32_t numOverlays;
+    if (!SCPI_ParamInt(context, &numOverlays, FALSE)) {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return SCPI_RES_ERR;
+        }
+        numOverlays = 4;
+    }
+
+    if (numFrames < 1 || numOverlays < 0 || numOverlays > 16) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+
+    mcu::display::CompositorBenchmarkResult result;
+    if (!mcu::display::benchmarkCompositor(numFrames, numOverlays, result)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_OUT_OF_DEVICE_MEMORY);
+        return SCPI_RES_ERR;
+    }
+
+    char buffer[128] = { 0 };
+
+    sprintf(buffer, "frames=%d overlays=%d sse2=%d", (int)numFrames, (int)numOverlays, result.sse2 ? 1 : 0);
+    SCPI_ResultText(context, buffer);
+
+    sprintf(buffer, "reference time=%u us fps=", (unsigned)result.referenceTime);
+    strcatFloat(buffer, result.referenceTime > 0 ? numFrames * 1E6f / result.referenceTime : 0, 1);
+    SCPI_ResultText(context, buffer);
+
+    sprintf(buffer, "row time=%u us fps=", (unsigned)result.time);
+    strcatFloat(buffer, result.time > 0 ? numFrames * 1E6f / result.time : 0, 1);
+    SCPI_ResultText(context, buffer);
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_debugDma2dQ(scpi_t *context) {
+    char buffer[128] = { 0 };
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    // simulator executes command queue in software, check order and fences
+    char message[64];
+    if (mcu::dma2d_queue::selfTest(message, sizeof(message))) {
+        SCPI_ResultText(context, "self test=PASS");
+    } else {
+        snprintf(buffer, sizeof(buffer), "self test=FAIL %s", message);
+        SCPI_ResultText(context, buffer);
+    }
+#endif
+
+    mcu::dma2d_queue::Statistics statistics;
+    mcu::dma2d_queue::getStatistics(statistics);
+
+    sprintf(buffer, "commands=%u config_skipped=%u errors=%u max_queued=%u queue_full=%u",
+        (unsigned)statistics.numCommands,
+        (unsigned)statistics.numConfigSkipped,
+        (unsigned)statistics.numErrors,
+        (unsigned)statistics.maxQueued,
+        (unsigned)statistics.numQueueFull);
+    SCPI_ResultText(context, buffer);
+
+    sprintf(buffer, "fences=%u fence_waits=%u",
+        (unsigned)statistics.numFences,
+        (unsigned)statistics.numFenceWaits);
+    SCPI_ResultText(context, buffer);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_debugLayersQ(scpi_t *context) {
+#if OPTION_DISPLAY
+    char buffer[128] = { 0 };
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    // draws nested popups through the compositor in the GUI thread and checks what is drawn
+    char message[96];
+    if (mcu::display::testLayers(message, sizeof(message))) {
+        SCPI_ResultText(context, "self test=PASS");
+    } else {
+        snprintf(buffer, sizeof(buffer), "self test=FAIL %s", message);
+        SCPI_ResultText(context, buffer);
+    }
+#endif
+
+    mcu::display::CompositorStatistics statistics;
+    mcu::display::getCompositorStatistics(statistics);
+
+    sprintf(buffer, "frames=%u full_frames=%u alloc_failures=%u",
+        (unsigned)statistics.numFrames,
+        (unsigned)statistics.numFullFrames,
+        (unsigned)statistics.numAllocFailures);
+    SCPI_ResultText(context, buffer);
+
+    sprintf(buffer, "last frame rect=%d,%d,%d,%d layers=%u composited=%u skipped=%u pixels=%u",
+        statistics.rect.x1, statistics.rect.y1, statistics.rect.x2, statistics.rect.y2,
+        (unsigned)statistics.numLayers,
+        (unsigned)statistics.numLayersComposited,
+        (unsigned)statistics.numLayersSkipped,
+        (unsigned)statistics.numPixelsMoved);
+    SCPI_ResultText(context, buffer);
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+
+static bool g_schedulerWrapSelfTestResult;
+static char g_schedulerWrapSelfTestMessage[96];
+static bool g_dlogWrapSelfTestResult;
+static char g_dlogWrapSelfTestMessage[96];
+
+// runs in the PSU thread, so injected ticks are not mixed with the real ones
+static void wrapSelfTestCallback() {
+    g_schedulerWrapSelfTestResult = trigger::wrapSelfTest(g_schedulerWrapSelfTestMessage, sizeof(g_schedulerWrapSelfTestMessage));
+    g_dlogWrapSelfTestResult = dlog_record::wrapSelfTest(g_dlogWrapSelfTestMessage, sizeof(g_dlogWrapSelfTestMessage));
+}
+
+#endif
+
+scpi_result_t scpi_cmd_debugMicrosQ(scpi_t *context) {
+    char buffer[128] = { 0 };
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    int32_t timeout;
+    if (!SCPI_ParamInt(context, &timeout, FALSE)) {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return SCPI_RES_ERR;
+        }
+        timeout = 10;
+    }
+
+    // trigger, list, ramp and DLOG schedulers are driven with injected ticks, no waiting
+    g_diagCallback = wrapSelfTestCallback;
+    while (g_diagCallback) {
+        delayWithoutIoLock(1);
+    }
+
+    snprintf(buffer, sizeof(buffer), "scheduler self test=%s %s", g_schedulerWrapSelfTestResult ? "PASS" : "FAIL", g_schedulerWrapSelfTestMessage);
+    SCPI_ResultText(context, buffer);
+
+    snprintf(buffer, sizeof(buffer), "dlog self test=%s %s", g_dlogWrapSelfTestResult ? "PASS" : "FAIL", g_dlogWrapSelfTestMessage);
+    SCPI_ResultText(context, buffer);
+
+    // counter itself is checked only if it wraps within the timeout (simulator started with --tick-start)
+    uint32_t untilWrap = 0 - micros();
+    if (untilWrap / 1000 < (uint32_t)timeout * 1000) {
+        char message[96];
+        if (micros64SelfTest(timeout * 1000, message, sizeof(message))) {
+            snprintf(buffer, sizeof(buffer), "counter self test=PASS %s", message);
+        } else {
+            snprintf(buffer, sizeof(buffer), "counter self test=FAIL %s", message);
+        }
+    } else {
+        snprintf(buffer, sizeof(buffer), "counter self test=SKIPPED micros() wraps in %u s, use --tick-start", (unsigned)(untilWrap / 1000000));
+    }
+    SCPI_ResultText(context, buffer);
+#endif
+
+    uint64_t t64 = micros64();
+    uint32_t t = micros();
+    sprintf(buffer, "micros=%u micros64=%llu", (unsigned)t, (unsigned long long)t64);
+    SCPI_ResultText(context, buffer);
+
+    return SCPI_RES_OK;
+}
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+
+static bool g_protectionLevelsSelfTestResult;
+static char g_protectionLevelsSelfTestMessage[96];
+
+static void protectionLevelsSelfTestCallback() {
+    g_protectionLevelsSelfTestResult = protection::levelsSelfTest(g_protectionLevelsSelfTestMessage, sizeof(g_protectionLevelsSelfTestMessage));
+}
+
+#endif
+
+scpi_result_t scpi_cmd_debugProtectionQ(scpi_t *context) {
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    // step overload of the simulated load, checks OVP, OCP and OPP delay and trip latency,
+    // then compares precomputed levels with the previous per-sample evaluation
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    char buffer[128] = { 0 };
+
+    char message[96];
+    if (protection::stepOverloadSelfTest(*channel, message, sizeof(message))) {
+        snprintf(buffer, sizeof(buffer), "step overload self test=PASS %s", message);
+    } else {
+        snprintf(buffer, sizeof(buffer), "step overload self test=FAIL %s", message);
+    }
+    SCPI_ResultText(context, buffer);
+
+    // levels are otherwise used only in the PSU thread
+    g_diagCallback = protectionLevelsSelfTestCallback;
+    while (g_diagCallback) {
+        delayWithoutIoLock(1);
+    }
+
+    snprintf(buffer, sizeof(buffer), "levels self test=%s %s", g_protectionLevelsSelfTestResult ? "PASS" : "FAIL", g_protectionLevelsSelfTestMessage);
+    SCPI_ResultText(context, buffer);
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_debugKeepaliveQ(scpi_t *context) {
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    // output frame scheduler of two PREL6/SMX46 modules
+    char buffer[128] = { 0 };
+
+    char message[96];
+    if (bp3c::comm::outputSchedulerSelfTest(message, sizeof(message))) {
+        snprintf(buffer, sizeof(buffer), "self test=PASS %s", message);
+    } else {
+        snprintf(buffer, sizeof(buffer), "self test=FAIL %s", message);
+    }
+    SCPI_ResultText(context, buffer);
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_debugUploadQ(scpi_t *context) {
+#if defined(EEZ_PLATFORM_SIMULATOR) && OPTION_ETHERNET
+    // remote session selected for the upload started from the front panel
+    char buffer[128] = { 0 };
+
+    char message[96];
+    if (ethernet::uploadSessionSelfTest(message, sizeof(message))) {
+        snprintf(buffer, sizeof(buffer), "self test=PASS %s", message);
+    } else {
+        snprintf(buffer, sizeof(buffer), "self test=FAIL %s", message);
+    }
+    SCPI_ResultText(context, buffer);
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_debugFtoaQ(scpi_t *context) {
+    // compares floatToText against sprintf for every step-th float bit pattern
+    int32_t step;
+    if (!SCPI_ParamInt(context, &step, FALSE)) {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return SCPI_RES_ERR;
+        }
+        step = 65537;
+    }
+    if (step < 1) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+
+    static const int NUM_FORMATS = 3;
+    static const int FORMAT_DECIMAL_PLACES[NUM_FORMATS] = { -1, 2, 3 };
+
+    uint32_t numValues = 0;
+    uint32_t numMismatches = 0;
+    uint32_t sprintfTime = 0;
+    uint32_t floatToTextTime = 0;
+
+    char expected[64];
+    char actual[64];
+
+    for (uint64_t bits = 0; bits <= 0xFFFFFFFF; bits += step) {
+        uint32_t bits32 = (uint32_t)bits;
+        float value;
+        memcpy(&value, &bits32, sizeof(float));
+
+        for (int i = 0; i < NUM_FORMATS; i++) {
+            int numDecimalPlaces = FORMAT_DECIMAL_PLACES[i];
+            bool removeTrailingZeros = i == NUM_FORMATS - 1;
+
+            uint32_t t1 = micros();
+            if (numDecimalPlaces < 0) {
+                sprintf(expected, "%g", value);
+            } else {
+                sprintf(expected, "%.*f", numDecimalPlaces, value);
+            }
+            if (removeTrailingZeros) {
+                removeTrailingZerosFromFloat(expected);
+            }
+            uint32_t t2 = micros();
+            floatToText(actual, value, numDecimalPlaces, removeTrailingZeros);
+            uint32_t t3 = micros();
+
+            sprintfTime += t2 - t1;
+            floatToTextTime += t3 - t2;
+
+            if (strcmp(expected, actual) != 0) {
+                if (numMismatches == 0) {
+                    DebugTrace("FTOA mismatch 0x%08X: %s != %s\n", (unsigned)bits32, actual, expected);
+                }
+                numMismatches++;
+            }
+        }
+
+        numValues++;
+    }
+
+    char buffer[128] = { 0 };
+
+    sprintf(buffer, "values=%u", (unsigned)numValues);
+    SCPI_ResultText(context, buffer);
+    sprintf(buffer, "mismatches=%u", (unsigned)numMismatches);
+    SCPI_ResultText(context, buffer);
+    sprintf(buffer, "sprintf=%u us", (unsigned)sprintfTime);
+    SCPI_ResultText(context, buffer);
+    sprintf(buffer, "floatToText=%u us", (unsigned)floatToTextTime);
+    SCPI_ResultText(context, buffer);
+
+    return SCPI_RES_OK;
+}
+
+} // namespace scpi
+} // namespace psu
+} // namespace eez
@@ -25,13 +25,25 @@
 #include <eez/modules/psu/calibration.h>
 #include <eez/modules/psu/datetime.h>
 #include <eez/modules/psu/devices.h>
+#if OPTION_ETHERNET
+#include <eez/modules/psu/ethernet.h>
+#endif
+#include <eez/modules/psu/io_pins.h>
+#include <eez/modules/psu/protection.h>
 #include <eez/modules/psu/scpi/psu.h>
+#include <eez/modules/psu/sd_card.h>
 #include <eez/modules/psu/temperature.h>
 
+#include <eez/modules/bp3c/comm.h>
+
 #if OPTION_FAN
 #include <eez/modules/aux_ps/fan.h>
 #endif
 
+#if OPTION_DISPLAY
+#include <eez/gui/gui.h>
+#endif
+
 namespace eez {
 namespace psu {
 namespace scpi {
@@ -216,6 +228,21 @@ scpi_result_t scpi_cmd_diagnosticInformationProtectionQ(scpi_t *context) {
         sprintf(buffer, "CH%d p_level=", channelIndex);
         strcatPower(buffer, channel->prot_conf.p_level);
         SCPI_ResultText(context, buffer);
+
+#ifdef DEBUG
+        // worst case detection latency is max. time between two checks plus check duration
+        const protection::Statistics &statistics = protection::getStatistics(*channel);
+        if (statistics.check.count > 0) {
+            sprintf(buffer, "CH%d check count=%u run_avg=%u us run_max=%u us interval_max=%u us latency_max=%u us",
+                channelIndex,
+                (unsigned)statistics.check.count,
+                (unsigned)(statistics.check.totalRunTime / statistics.check.count),
+                (unsigned)statistics.check.maxRunTime,
+                (unsigned)statistics.maxInterval,
+                (unsigned)(statistics.maxInterval + statistics.check.maxRunTime));
+            SCPI_ResultText(context, buffer);
+        }
+#endif
     }
 
     for (int i = 0; i < temp_sensor::NUM_TEMP_SENSORS; ++i) {
@@ -337,6 +364,201 @@ scpi_result_t scpi_cmd_diagnosticInformationRegsQ(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+scpi_result_t scpi_cmd_diagnosticInformationTransferQ(scpi_t *context) {
+    char buffer[128] = { 0 };
+
+    for (int slotIndex = 0; slotIndex < NUM_SLOTS; slotIndex++) {
+        if (g_slots[slotIndex]->moduleInfo->moduleType == MODULE_TYPE_NONE) {
+            continue;
+        }
+
+        bp3c::comm::TransferStatistics statistics;
+        bp3c::comm::getTransferStatistics(slotIndex, statistics);
+
+        sprintf(buffer, "slot%d transfers=%u", slotIndex + 1, (unsigned)statistics.numTransfers);
+        SCPI_ResultText(context, buffer);
+        sprintf(buffer, "slot%d crc_errors=%u", slotIndex + 1, (unsigned)statistics.numCrcErrors);
+        SCPI_ResultText(context, buffer);
+        sprintf(buffer, "slot%d errors=%u", slotIndex + 1, (unsigned)statistics.numErrors);
+        SCPI_ResultText(context, buffer);
+        sprintf(buffer, "slot%d timeouts=%u", slotIndex + 1, (unsigned)statistics.numTimeouts);
+        SCPI_ResultText(context, buffer);
+        sprintf(buffer, "slot%d latency_last=%u us", slotIndex + 1, (unsigned)statistics.lastLatencyUs);
+        SCPI_ResultText(context, buffer);
+        sprintf(buffer, "slot%d latency_avg=%u us", slotIndex + 1, statistics.numTransfers > 0 ? (unsigned)(statistics.totalLatencyUs / statistics.numTransfers) : 0);
+        SCPI_ResultText(context, buffer);
+        sprintf(buffer, "slot%d latency_max=%u us", slotIndex + 1, (unsigned)statistics.maxLatencyUs);
+        SCPI_ResultText(context, buffer);
+
+        if (bp3c::comm::hasOutputScheduler(slotIndex)) {
+            bp3c::comm::OutputStatistics outputStatistics;
+            bp3c::comm::getOutputStatistics(slotIndex, outputStatistics);
+
+            sprintf(buffer, "slot%d keepalive=%u ms", slotIndex + 1, (unsigned)bp3c::comm::getKeepAliveInterval(slotIndex));
+            SCPI_ResultText(context, buffer);
+            sprintf(buffer, "slot%d change_frames=%u", slotIndex + 1, (unsigned)outputStatistics.numChangeFrames);
+            SCPI_ResultText(context, buffer);
+            sprintf(buffer, "slot%d keepalive_frames=%u", slotIndex + 1, (unsigned)outputStatistics.numKeepAliveFrames);
+            SCPI_ResultText(context, buffer);
+            sprintf(buffer, "slot%d actuation_last=%u us", slotIndex + 1, (unsigned)outputStatistics.lastActuationLatencyUs);
+            SCPI_ResultText(context, buffer);
+            sprintf(buffer, "slot%d actuation_max=%u us", slotIndex + 1, (unsigned)outputStatistics.maxActuationLatencyUs);
+            SCPI_ResultText(context, buffer);
+        }
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_diagnosticInformationSessionQ(scpi_t *context) {
+#if OPTION_ETHERNET
+    char buffer[128] = { 0 };
+
+    for (int sessionIndex = 0; sessionIndex < ETHERNET_MAX_SESSIONS; sessionIndex++) {
+        if (!ethernet::isConnected(sessionIndex)) {
+            sprintf(buffer, "session%d disconnected", sessionIndex + 1);
+            SCPI_ResultText(context, buffer);
+            continue;
+        }
+
+        ethernet::SessionStatistics statistics;
+        ethernet::getSessionStatistics(sessionIndex, statistics);
+
+        uint32_t connectedSeconds = (millis() - statistics.connectedTime) / 1000;
+
+        sprintf(buffer, "session%d connected=%u s%s", sessionIndex + 1, (unsigned)connectedSeconds, context == &ethernet::g_scpiContext[sessionIndex] ? " (this)" : "");
+        SCPI_ResultText(context, buffer);
+        sprintf(buffer, "session%d inputs=%u", sessionIndex + 1, (unsigned)statistics.numInputs);
+        SCPI_ResultText(context, buffer);
+        sprintf(buffer, "session%d writes=%u", sessionIndex + 1, (unsigned)statistics.numWrites);
+        SCPI_ResultText(context, buffer);
+        sprintf(buffer, "session%d inputs_rate=%u /s", sessionIndex + 1, connectedSeconds > 0 ? (unsigned)(statistics.numInputs / connectedSeconds) : 0);
+        SCPI_ResultText(context, buffer);
+        sprintf(buffer, "session%d rx=%u bytes", sessionIndex + 1, (unsigned)statistics.numBytesReceived);
+        SCPI_ResultText(context, buffer);
+        sprintf(buffer, "session%d tx=%u bytes", sessionIndex + 1, (unsigned)statistics.numBytesSent);
+        SCPI_ResultText(context, buffer);
+        sprintf(buffer, "session%d rx_rate=%u B/s", sessionIndex + 1, connectedSeconds > 0 ? (unsigned)(statistics.numBytesReceived / connectedSeconds) : 0);
+        SCPI_ResultText(context, buffer);
+        sprintf(buffer, "session%d tx_rate=%u B/s", sessionIndex + 1, connectedSeconds > 0 ? (unsigned)(statistics.numBytesSent / connectedSeconds) : 0);
+        SCPI_ResultText(context, buffer);
+    }
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+static void resultRunTimeStatistics(scpi_t *context, const char *name, const RunTimeStatistics &statistics) {
+    if (statistics.count == 0) {
+        return;
+    }
+
+    char buffer[128] = { 0 };
+    sprintf(buffer, "%s count=%u run_avg=%u us run_max=%u us",
+        name,
+        (unsigned)statistics.count,
+        (unsigned)(statistics.totalRunTime / statistics.count),
+        (unsigned)statistics.maxRunTime);
+    SCPI_ResultText(context, buffer);
+}
+
+scpi_result_t scpi_cmd_diagnosticInformationTasksQ(scpi_t *context) {
+    char buffer[128] = { 0 };
+
+    for (int type = 0; type < LOW_PRIORITY_THREAD_LAST_MESSAGE_TYPE; type++) {
+        auto &statistics = getMessageStatistics((LowPriorityThreadMessage)type);
+        if (statistics.count == 0) {
+            continue;
+        }
+
+        sprintf(buffer, "%s %s count=%u wait_max=%u us io_wait_max=%u us run_avg=%u us run_max=%u us",
+            type < ETHERNET_LAST_MESSAGE_TYPE ? "scpi" : "low",
+            getMessageName((LowPriorityThreadMessage)type),
+            (unsigned)statistics.count,
+            (unsigned)statistics.maxWaitTime,
+            (unsigned)statistics.maxIoLockWaitTime,
+            (unsigned)(statistics.totalRunTime / statistics.count),
+            (unsigned)statistics.maxRunTime);
+        SCPI_ResultText(context, buffer);
+    }
+
+    resultRunTimeStatistics(context, "psu tick", getPsuTickStatistics());
+#if OPTION_DISPLAY
+    resultRunTimeStatistics(context, "gui frame", gui::getFrameStatistics());
+#endif
+
+    return SCPI_RES_OK;
+}
+
+static void resultTransferStatistics(scpi_t *context, const sd_card::TransferStatistics &statistics) {
+    char buffer[128] = { 0 };
+
+    sprintf(buffer, "size=%u bytes", (unsigned)statistics.size);
+    SCPI_ResultText(context, buffer);
+    sprintf(buffer, "crc=0x%08X", (unsigned)statistics.crc);
+    SCPI_ResultText(context, buffer);
+    sprintf(buffer, "time=%u ms", (unsigned)statistics.time);
+    SCPI_ResultText(context, buffer);
+    sprintf(buffer, "rate=");
+    strcatFloat(buffer, statistics.time > 0 ? statistics.size / (statistics.time * 1000.0f) : 0, 3);
+    strcat(buffer, " MB/s");
+    SCPI_ResultText(context, buffer);
+}
+
+scpi_result_t scpi_cmd_diagnosticInformationDownloadQ(scpi_t *context) {
+    resultTransferStatistics(context, sd_card::getLastDownloadStatistics());
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_diagnosticInformationUploadQ(scpi_t *context) {
+    resultTransferStatistics(context, sd_card::getLastUploadStatistics());
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_diagnosticInformationTriggerQ(scpi_t *context) {
+    char buffer[128] = { 0 };
+
+    for (int pin = EXT_TRIG1; pin <= EXT_TRIG2; pin++) {
+        io_pins::TriggerLatencyStatistics statistics;
+        io_pins::getTriggerLatencyStatistics(pin, statistics);
+
+        sprintf(buffer, "din%d mode=%s", pin + 1, io_pins::isExtTrigInterruptEnabled(pin) ? "interrupt" : "polled");
+        SCPI_ResultText(context, buffer);
+        sprintf(buffer, "din%d triggers=%u", pin + 1, (unsigned)statistics.numTriggers);
+        SCPI_ResultText(context, buffer);
+        sprintf(buffer, "din%d lost=%u", pin + 1, (unsigned)statistics.numLost);
+        SCPI_ResultText(context, buffer);
+        sprintf(buffer, "din%d latency_last=%u us", pin + 1, (unsigned)statistics.lastLatencyUs);
+        SCPI_ResultText(context, buffer);
+        sprintf(buffer, "din%d latency_avg=%u us", pin + 1, statistics.numTriggers > 0 ? (unsigned)(statistics.totalLatencyUs / statistics.numTriggers) : 0);
+        SCPI_ResultText(context, buffer);
+        sprintf(buffer, "din%d latency_max=%u us", pin + 1, (unsigned)statistics.maxLatencyUs);
+        SCPI_ResultText(context, buffer);
+
+        for (int bucket = 0; bucket < io_pins::TRIGGER_LATENCY_HISTOGRAM_SIZE; bucket++) {
+            if (statistics.histogram[bucket] > 0) {
+                sprintf(buffer, "din%d latency_lt_%u_us=%u", pin + 1, 1u << bucket, (unsigned)statistics.histogram[bucket]);
+                SCPI_ResultText(context, buffer);
+            }
+        }
+
+        if (statistics.overflow > 0) {
+            sprintf(buffer, "din%d latency_ge_%u_us=%u", pin + 1, 1u << (io_pins::TRIGGER_LATENCY_HISTOGRAM_SIZE - 1), (unsigned)statistics.overflow);
+            SCPI_ResultText(context, buffer);
+        }
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_diagnosticInformationTriggerClear(scpi_t *context) {
+    io_pins::resetTriggerLatencyStatistics();
+    return SCPI_RES_OK;
+}
+
 } // namespace scpi
 } // namespace psu
 } // namespace eez
@@ -168,6 +168,11 @@ scpi_result_t scpi_cmd_displayWindowTextClear(scpi_t *context) {
 
 scpi_result_t scpi_cmd_displayDataQ(scpi_t *context) {
 #if OPTION_DISPLAY
+    // wait for the low priority thread to finish with the screenshot buffers
+    while (g_screenshotEncoding) {
+        delayWithoutIoLock(1);
+    }
+
     const uint8_t *screenshotPixels = mcu::display::takeScreenshot();
 
     unsigned char* imageData;
@@ -18,6 +18,7 @@
 
 #include <eez/modules/psu/psu.h>
 
+#include <eez/modules/psu/acquisition.h>
 #include <eez/modules/psu/channel_dispatcher.h>
 #include <eez/modules/psu/scpi/psu.h>
 
@@ -66,6 +67,132 @@ scpi_result_t scpi_cmd_measureScalarVoltageDcQ(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+static scpi_choice_def_t dataFormatChoice[] = {
+    { "ASCii", DATA_FORMAT_ASCII },
+    { "REAL", DATA_FORMAT_REAL32 },
+    SCPI_CHOICE_LIST_END /* termination of option list */
+};
+
+static void resultFloatArray(scpi_t *context, const float *data, uint32_t numPoints) {
+    auto psuContext = (scpi_psu_t *)context->user_context;
+
+    if (psuContext->dataFormat == DATA_FORMAT_REAL32) {
+        SCPI_ResultArbitraryBlockHeader(context, numPoints * 4);
+
+        static const uint32_t CHUNK_POINTS = 64;
+        uint8_t chunk[CHUNK_POINTS * 4];
+
+        while (numPoints > 0) {
+            uint32_t n = MIN(numPoints, CHUNK_POINTS);
+            for (uint32_t i = 0; i < n; i++) {
+                uint32_t value;
+                memcpy(&value, data + i, 4);
+                chunk[4 * i + 0] = (uint8_t)(value >> 24);
+                chunk[4 * i + 1] = (uint8_t)(value >> 16);
+                chunk[4 * i + 2] = (uint8_t)(value >> 8);
+                chunk[4 * i + 3] = (uint8_t)value;
+            }
+            SCPI_ResultArbitraryBlockData(context, chunk, n * 4);
+            data += n;
+            numPoints -= n;
+        }
+    } else {
+        for (uint32_t i = 0; i < numPoints; i++) {
+            char buffer[32] = { 0 };
+            strcatFloat(buffer, data[i]);
+            SCPI_ResultCharacters(context, buffer, strlen(buffer));
+        }
+    }
+}
+
+static scpi_result_t fetchArray(scpi_t *context, Channel &channel, bool voltage) {
+    if (!acquisition::waitCompleted(channel)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    resultFloatArray(context,
+        voltage ? acquisition::getVoltageData(channel) : acquisition::getCurrentData(channel),
+        acquisition::getNumPoints(channel));
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_fetchArrayVoltageQ(scpi_t *context) {
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    return fetchArray(context, *channel, true);
+}
+
+scpi_result_t scpi_cmd_fetchArrayCurrentQ(scpi_t *context) {
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    return fetchArray(context, *channel, false);
+}
+
+scpi_result_t scpi_cmd_measureArrayVoltageQ(scpi_t *context) {
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    acquisition::initiate(*channel, true);
+
+    return fetchArray(context, *channel, true);
+}
+
+scpi_result_t scpi_cmd_measureArrayCurrentQ(scpi_t *context) {
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    acquisition::initiate(*channel, true);
+
+    return fetchArray(context, *channel, false);
+}
+
+scpi_result_t scpi_cmd_formatData(scpi_t *context) {
+    int32_t format;
+    if (!SCPI_ParamChoice(context, dataFormatChoice, &format, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (format == DATA_FORMAT_REAL32) {
+        // only single precision is supported
+        int32_t length;
+        if (SCPI_ParamInt32(context, &length, false) && length != 32) {
+            SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+            return SCPI_RES_ERR;
+        }
+    }
+
+    auto psuContext = (scpi_psu_t *)context->user_context;
+    psuContext->dataFormat = (DataFormat)format;
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_formatDataQ(scpi_t *context) {
+    auto psuContext = (scpi_psu_t *)context->user_context;
+
+    if (psuContext->dataFormat == DATA_FORMAT_REAL32) {
+        SCPI_ResultCharacters(context, "REAL,32", 7);
+    } else {
+        SCPI_ResultCharacters(context, "ASC", 3);
+    }
+
+    return SCPI_RES_OK;
+}
+
 } // namespace scpi
 } // namespace psu
 } // namespace eez
\ No newline at end of file
@@ -29,6 +29,10 @@
 #include <eez/modules/psu/trigger.h>
 
 #include <eez/modules/psu/sd_card.h>
+#include <eez/modules/psu/serial_psu.h>
+#if OPTION_ETHERNET
+#include <eez/modules/psu/ethernet.h>
+#endif
 
 #if OPTION_DISPLAY
 #include <eez/modules/psu/gui/psu.h>
@@ -172,12 +176,17 @@ scpi_result_t scpi_cmd_mmemoryInformationQ(scpi_t *context) {
 ////////////////////////////////////////////////////////////////////////////////
 
 void uploadCallback(void *param, const void *buffer, int size) {
+    scpi_t *context = (scpi_t *)param;
+
     if (buffer == NULL && size == -1) {
+        // upload is finished, send what is left in the output buffer,
+        // for the upload started from the GUI nothing else will do it
+        if (context->interface && context->interface->flush) {
+            context->interface->flush(context);
+        }
         return;
     }
 
-    scpi_t *context = (scpi_t *)param;
-
     if (buffer == NULL) {
         SCPI_ResultArbitraryBlockHeader(context, size);
     } else {
@@ -191,6 +200,35 @@ bool mmemUpload(const char *filePath, scpi_t *context, int *err) {
     return sd_card::upload(filePath, context, uploadCallback, err);
 }
 
+scpi_t *getUploadContext(int *err) {
+    scpi_t *context = nullptr;
+    int numConnected = 0;
+
+#if !defined(EEZ_PLATFORM_SIMULATOR)
+    if (serial::isConnected()) {
+        context = &serial::g_scpiContext;
+        numConnected++;
+    }
+#endif
+
+#if OPTION_ETHERNET
+    for (int sessionIndex = 0; sessionIndex < ETHERNET_MAX_SESSIONS; sessionIndex++) {
+        if (ethernet::isConnected(sessionIndex)) {
+            context = &ethernet::g_scpiContext[sessionIndex];
+            numConnected++;
+        }
+    }
+#endif
+
+    if (numConnected > 1) {
+        *err = SCPI_ERROR_MULTIPLE_REMOTE_SESSIONS;
+        return nullptr;
+    }
+
+    *err = 0;
+    return context;
+}
+
 scpi_result_t scpi_cmd_mmemoryUploadQ(scpi_t *context) {
     char filePath[MAX_PATH_LENGTH + 1];
     if (!getFilePath(context, filePath, true)) {
@@ -234,6 +272,16 @@ void startDownloading() {
 }
 
 void finishDownloading(int16_t eventId) {
+    if (eventId == event_queue::EVENT_INFO_FILE_DOWNLOAD_SUCCEEDED) {
+        int err;
+        if (!sd_card::downloadCommit(&err)) {
+            eventId = event_queue::EVENT_ERROR_FILE_DOWNLOAD_FAILED;
+            if (err != 0) {
+                generateError(err);
+            }
+        }
+    }
+
 	sd_card::downloadFinished();
 
 	if (eventId != event_queue::EVENT_INFO_FILE_DOWNLOAD_SUCCEEDED) {
@@ -17,9 +17,11 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 
 #include <eez/sound.h>
 #include <eez/system.h>
+#include <eez/tasks.h>
 
 #include <eez/scpi/commands.h>
 
@@ -38,14 +40,76 @@ namespace scpi {
 SCPI_COMMANDS
 #undef SCPI_COMMAND
 
-#define SCPI_COMMAND(P, C) { P, C },
+static scpi_result_t executeCommand(scpi_t *context);
+
+#define SCPI_COMMAND(P, C) { P, executeCommand },
 static const scpi_command_t scpi_commands[] = { SCPI_COMMANDS SCPI_CMD_LIST_END };
+#undef SCPI_COMMAND
+
+#define SCPI_COMMAND(P, C) C,
+static const scpi_command_callback_t g_commandCallbacks[] = { SCPI_COMMANDS };
+#undef SCPI_COMMAND
+
+static const size_t NUM_COMMANDS = sizeof(g_commandCallbacks) / sizeof(scpi_command_callback_t);
+
+// Commands can access everything low priority thread does (SD card, profiles, lists,
+// persistent configuration, ...), so by default they are executed under I/O lock.
+// Commands listed here work only with the PSU thread and the SCPI context state,
+// so they don't have to wait for the low priority thread job to finish.
+static const char *g_commandsWithoutIoLock[] = {
+    "*CLS", "*ESE", "*ESE?", "*ESR?", "*IDN?", "*OPC", "*OPC?", "*SRE", "*SRE?", "*STB?", "*WAI",
+    "SYSTem:ERRor:COUNt?", "SYSTem:ERRor[:NEXT]?",
+    "INSTrument:NSELect", "INSTrument:NSELect?", "INSTrument[:SELect]", "INSTrument[:SELect]?",
+    "MEASure[:SCALar]:CURRent[:DC]?", "MEASure[:SCALar]:POWer[:DC]?", "MEASure[:SCALar][:VOLTage][:DC]?",
+    "MEASure:ARRay:CURRent?", "MEASure:ARRay[:VOLTage]?", "FETCh:ARRay:CURRent?", "FETCh:ARRay[:VOLTage]?",
+    "[SOURce#]:CURRent[:LEVel][:IMMediate][:AMPLitude]", "[SOURce#]:CURRent[:LEVel][:IMMediate][:AMPLitude]?",
+    "[SOURce#]:VOLTage[:LEVel][:IMMediate][:AMPLitude]", "[SOURce#]:VOLTage[:LEVel][:IMMediate][:AMPLitude]?",
+    "OUTPut[:STATe]?",
+    nullptr
+};
+
+static bool g_commandNeedsIoLock[NUM_COMMANDS];
+static bool g_commandsIoLockInitialized;
+
+static void initCommandsIoLock() {
+    if (g_commandsIoLockInitialized) {
+        return;
+    }
+    g_commandsIoLockInitialized = true;
+
+    for (size_t i = 0; i < NUM_COMMANDS; i++) {
+        g_commandNeedsIoLock[i] = true;
+        for (const char **pattern = g_commandsWithoutIoLock; *pattern; pattern++) {
+            if (strcmp(scpi_commands[i].pattern, *pattern) == 0) {
+                g_commandNeedsIoLock[i] = false;
+                break;
+            }
+        }
+    }
+}
+
+static scpi_result_t executeCommand(scpi_t *context) {
+    size_t commandIndex = context->param_list.cmd - scpi_commands;
+    scpi_command_callback_t callback = g_commandCallbacks[commandIndex];
+
+    if (!g_commandNeedsIoLock[commandIndex] || isIoLocked()) {
+        return callback(context);
+    }
+
+    lockIo();
+    scpi_result_t result = callback(context);
+    unlockIo();
+
+    return result;
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void init(scpi_t &scpi_context, scpi_psu_t &scpi_psu_context, scpi_interface_t *interface,
           char *input_buffer, size_t input_buffer_length, scpi_error_t *error_queue_data,
           int16_t error_queue_size) {
+    initCommandsIoLock();
+
     SCPI_Init(&scpi_context, scpi_commands, interface, scpi_units_def, IDN_MANUFACTURER, IDN_MODEL,
               getSerialNumber(), MCU_FIRMWARE, input_buffer, input_buffer_length,
               error_queue_data, error_queue_size);
@@ -53,6 +117,7 @@ void init(scpi_t &scpi_context, scpi_psu_t &scpi_psu_context, scpi_interface_t *
     scpi_psu_context.selectedChannels = 1 << 0; // first channel is selected by default
     scpi_psu_context.currentDirectory[0] = 0;
     scpi_psu_context.isBufferOverrun = false;
+    scpi_psu_context.dataFormat = DATA_FORMAT_ASCII;
     scpi_psu_context.bufferOverrunTime = 0;
 
     scpi_context.user_context = &scpi_psu_context;
@@ -89,6 +154,37 @@ void input(scpi_t &context, const char *str, size_t size) {
     if (result == -1) {
         onBufferOverrun(context);
     }
+
+    // send whatever is left in the output buffer
+    if (context.interface->flush) {
+        context.interface->flush(&context);
+    }
+}
+
+size_t outputBufferWrite(scpi_t *context, OutputBuffer &outputBuffer, OutputWriteFunc writeFunc, const char *data, size_t len) {
+    if (len >= SCPI_OUTPUT_BUFFER_SIZE / 2) {
+        // large block (e.g. arbitrary block data) skips the output buffer and is passed to
+        // the transport directly from the caller memory, but only after what is already buffered;
+        // the transport still copies it (see mcu::ethernet::writeBuffer)
+        outputBufferFlush(context, outputBuffer, writeFunc);
+        return writeFunc(context, data, len);
+    }
+
+    if (outputBuffer.length + len > SCPI_OUTPUT_BUFFER_SIZE) {
+        outputBufferFlush(context, outputBuffer, writeFunc);
+    }
+
+    memcpy(outputBuffer.data + outputBuffer.length, data, len);
+    outputBuffer.length += len;
+
+    return len;
+}
+
+void outputBufferFlush(scpi_t *context, OutputBuffer &outputBuffer, OutputWriteFunc writeFunc) {
+    if (outputBuffer.length > 0) {
+        writeFunc(context, outputBuffer.data, outputBuffer.length);
+        outputBuffer.length = 0;
+    }
 }
 
 void printError(int_fast16_t err) {
@@ -29,12 +29,18 @@ namespace psu {
 namespace scpi {
 
 /// EEZ PSU specific SCPI parser context data.
+enum DataFormat {
+    DATA_FORMAT_ASCII,
+    DATA_FORMAT_REAL32 // IEEE 754 single precision, big-endian, as definite length block
+};
+
 struct scpi_psu_t {
     scpi_reg_val_t *registers;
     uint32_t selectedChannels;
     char currentDirectory[MAX_PATH_LENGTH + 1];
     bool isBufferOverrun;
     uint32_t bufferOverrunTime;
+    DataFormat dataFormat;
 };
 
 void init(scpi_t &scpi_context, scpi_psu_t &scpi_psu_context, scpi_interface_t *interface,
@@ -46,6 +52,19 @@ void input(scpi_t &scpi_context, const char *str, size_t size);
 void emptyBuffer(scpi_t &context);
 void onBufferOverrun(scpi_t &context);
 
+/// Response fragments emitted by the SCPI parser (each value, separator, terminator)
+/// are collected here and sent to the client with a single transport write
+/// on message terminator, when buffer is full or on explicit flush.
+struct OutputBuffer {
+    char data[SCPI_OUTPUT_BUFFER_SIZE];
+    size_t length;
+};
+
+typedef size_t (*OutputWriteFunc)(scpi_t *context, const char *data, size_t len);
+
+size_t outputBufferWrite(scpi_t *context, OutputBuffer &outputBuffer, OutputWriteFunc writeFunc, const char *data, size_t len);
+void outputBufferFlush(scpi_t *context, OutputBuffer &outputBuffer, OutputWriteFunc writeFunc);
+
 void printError(int_fast16_t err);
 
 void resultChoiceName(scpi_t *context, scpi_choice_def_t *choice, int tag);
@@ -54,6 +73,12 @@ void abortDownloading();
 
 bool mmemUpload(const char *filePath, scpi_t *context, int *err);
 
+// Returns the context of the only connected remote session, the upload started from the
+// front panel is sent there. Returns nullptr if no session is connected, or if more than one
+// is connected (err is set to SCPI_ERROR_MULTIPLE_REMOTE_SESSIONS): the file must not end
+// up in the input of a client that didn't ask for it.
+scpi_t *getUploadContext(int *err);
+
 } // namespace scpi
 } // namespace psu
 } // namespace eez
@@ -18,16 +18,218 @@
 
 #include <eez/modules/psu/psu.h>
 
+#include <eez/modules/psu/acquisition.h>
 #include <eez/modules/psu/channel_dispatcher.h>
 #include <eez/modules/psu/profile.h>
 #include <eez/modules/psu/scpi/psu.h>
 
+#include <eez/modules/dib-mio168/dib-mio168.h>
+
 namespace eez {
 namespace psu {
 namespace scpi {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+static scpi_choice_def_t averageTypeChoice[] = {
+    { "BOXCar", MON_FILTER_TYPE_BOXCAR },
+    { "EXPonential", MON_FILTER_TYPE_EXPONENTIAL },
+    { "MEDian", MON_FILTER_TYPE_MEDIAN },
+    SCPI_CHOICE_LIST_END /* termination of option list */
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+scpi_result_t scpi_cmd_senseAverageCount(scpi_t *context) {
+    int32_t count;
+    if (!SCPI_ParamInt32(context, &count, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (count < 1 || count > MON_FILTER_MAX_COUNT) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    channel->setMonFilter(channel->getMonFilterType(), (uint8_t)count);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_senseAverageCountQ(scpi_t *context) {
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultInt(context, channel->getMonFilterCount());
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_senseAverageType(scpi_t *context) {
+    int32_t type;
+    if (!SCPI_ParamChoice(context, averageTypeChoice, &type, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    channel->setMonFilter((MonFilterType)type, channel->getMonFilterCount());
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_senseAverageTypeQ(scpi_t *context) {
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    resultChoiceName(context, averageTypeChoice, channel->getMonFilterType());
+
+    return SCPI_RES_OK;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// MIO168 analog input acquisition, first parameter is slot number (1-3)
+
+static const uint32_t AINPUT_DATA_MAX_ROWS = 64;
+
+// stream position of the last SENS:AINP:DATA? query for each slot
+static uint32_t g_analogInputDataPosition[NUM_SLOTS];
+
+static bool param_mio168Slot(scpi_t *context, int32_t &slotIndex) {
+    if (!SCPI_ParamInt32(context, &slotIndex, true)) {
+        return false;
+    }
+
+    if (slotIndex < 1 || slotIndex > NUM_SLOTS) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return false;
+    }
+
+    slotIndex--;
+
+    if (g_slots[slotIndex]->moduleInfo->moduleType != MODULE_TYPE_DIB_MIO168) {
+        SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+        return false;
+    }
+
+    return true;
+}
+
+scpi_result_t scpi_cmd_senseAinputAverage(scpi_t *context) {
+    int32_t slotIndex;
+    if (!param_mio168Slot(context, slotIndex)) {
+        return SCPI_RES_ERR;
+    }
+
+    int32_t averaging;
+    if (!SCPI_ParamInt32(context, &averaging, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (averaging < dib_mio168::ANALOG_INPUT_AVERAGING_MIN || averaging > dib_mio168::ANALOG_INPUT_AVERAGING_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+
+    dib_mio168::setAnalogInputAveraging(slotIndex, averaging);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_senseAinputAverageQ(scpi_t *context) {
+    int32_t slotIndex;
+    if (!param_mio168Slot(context, slotIndex)) {
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultInt(context, dib_mio168::getAnalogInputAveraging(slotIndex));
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_senseAinputRateQ(scpi_t *context) {
+    int32_t slotIndex;
+    if (!param_mio168Slot(context, slotIndex)) {
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultFloat(context, dib_mio168::getAnalogInputSampleRate(slotIndex));
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_senseAinputDataQ(scpi_t *context) {
+    int32_t slotIndex;
+    if (!param_mio168Slot(context, slotIndex)) {
+        return SCPI_RES_ERR;
+    }
+
+    int32_t maxRows;
+    if (!SCPI_ParamInt32(context, &maxRows, false)) {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return SCPI_RES_ERR;
+        }
+        maxRows = AINPUT_DATA_MAX_ROWS;
+    }
+
+    if (maxRows < 1 || maxRows > (int32_t)AINPUT_DATA_MAX_ROWS) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+
+    // returns rows acquired since the previous query, oldest first
+    uint16_t samples[AINPUT_DATA_MAX_ROWS * dib_mio168::NUM_ANALOG_INPUTS];
+    uint32_t numRows = dib_mio168::readAnalogInputSamples(slotIndex, g_analogInputDataPosition[slotIndex], samples, maxRows);
+
+    for (uint32_t i = 0; i < numRows * dib_mio168::NUM_ANALOG_INPUTS; i++) {
+        SCPI_ResultUInt32(context, samples[i]);
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_senseAinputDlog(scpi_t *context) {
+    int32_t slotIndex;
+    if (!param_mio168Slot(context, slotIndex)) {
+        return SCPI_RES_ERR;
+    }
+
+    bool enabled;
+    if (!SCPI_ParamBool(context, &enabled, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    dib_mio168::setAnalogInputDlogTraceEnabled(slotIndex, enabled);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_senseAinputDlogQ(scpi_t *context) {
+    int32_t slotIndex;
+    if (!param_mio168Slot(context, slotIndex)) {
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultBool(context, dib_mio168::isAnalogInputDlogTraceEnabled(slotIndex));
+
+    return SCPI_RES_OK;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 scpi_result_t scpi_cmd_senseCurrentDcRangeUpper(scpi_t *context) {
     CurrentRangeSelectionMode mode;
 
@@ -112,6 +314,67 @@ scpi_result_t scpi_cmd_senseCurrentDcRangeUpperQ(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+scpi_result_t scpi_cmd_senseSweepPoints(scpi_t *context) {
+    int32_t points;
+    if (!SCPI_ParamInt32(context, &points, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (points < (int32_t)acquisition::POINTS_MIN || points > (int32_t)acquisition::POINTS_MAX) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    acquisition::setPoints(*channel, (uint32_t)points);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_senseSweepPointsQ(scpi_t *context) {
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultUInt32(context, acquisition::getPoints(*channel));
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_senseSweepTinterval(scpi_t *context) {
+    float interval;
+    if (!get_duration_param(context, interval, acquisition::INTERVAL_MIN, acquisition::INTERVAL_MAX, acquisition::INTERVAL_DEFAULT)) {
+        return SCPI_RES_ERR;
+    }
+
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    acquisition::setInterval(*channel, interval);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_senseSweepTintervalQ(scpi_t *context) {
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultFloat(context, acquisition::getInterval(*channel));
+
+    return SCPI_RES_OK;
+}
+
 } // namespace scpi
 } // namespace psu
 } // namespace eez
@@ -325,6 +325,23 @@ scpi_result_t scpi_cmd_simulatorTemperatureQ(scpi_t *context) {
     return result_float(context, 0, value, UNIT_CELSIUS);
 }
 
+scpi_result_t scpi_cmd_simulatorTemperaturePlant(scpi_t *context) {
+    bool enabled;
+    if (!SCPI_ParamBool(context, &enabled, TRUE)) {
+        return SCPI_RES_ERR;
+    }
+
+    simulator::setThermalPlantEnabled(enabled);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_simulatorTemperaturePlantQ(scpi_t *context) {
+    SCPI_ResultBool(context, simulator::isThermalPlantEnabled());
+
+    return SCPI_RES_OK;
+}
+
 scpi_result_t scpi_cmd_simulatorGui(scpi_t *context) {
     SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
     return SCPI_RES_ERR;
@@ -442,6 +459,16 @@ scpi_result_t scpi_cmd_simulatorTemperatureQ(scpi_t *context) {
     return SCPI_RES_ERR;
 }
 
+scpi_result_t scpi_cmd_simulatorTemperaturePlant(scpi_t *context) {
+    SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
+    return SCPI_RES_ERR;
+}
+
+scpi_result_t scpi_cmd_simulatorTemperaturePlantQ(scpi_t *context) {
+    SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
+    return SCPI_RES_ERR;
+}
+
 scpi_result_t scpi_cmd_simulatorGui(scpi_t *context) {
     SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
     return SCPI_RES_ERR;
@@ -42,6 +42,7 @@
 #include <eez/modules/psu/temperature.h>
 
 #include <eez/modules/aux_ps/fan.h>
+#include <eez/modules/bp3c/comm.h>
 #include <eez/modules/mcu/battery.h>
 
 namespace eez {
@@ -403,6 +404,24 @@ scpi_result_t scpi_cmd_systemTemperatureProtectionHighTrippedQ(scpi_t *context)
     return SCPI_RES_OK;
 }
 
+scpi_result_t scpi_cmd_systemTemperatureFilterTime(scpi_t *context) {
+    float timeConstant;
+    if (!get_duration_param(context, timeConstant, TEMP_SENSOR_FILTER_MIN_TIME_CONSTANT,
+                            TEMP_SENSOR_FILTER_MAX_TIME_CONSTANT, TEMP_SENSOR_FILTER_TIME_CONSTANT)) {
+        return SCPI_RES_ERR;
+    }
+
+    temperature::setFilterTimeConstant(timeConstant);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_systemTemperatureFilterTimeQ(scpi_t *context) {
+    SCPI_ResultFloat(context, temperature::getFilterTimeConstant());
+
+    return SCPI_RES_OK;
+}
+
 scpi_result_t scpi_cmd_systemSlotCountQ(scpi_t *context) {
     SCPI_ResultInt(context, NUM_SLOTS);
 
@@ -470,6 +489,46 @@ scpi_result_t scpi_cmd_systemSlotFirmwareQ(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+scpi_result_t scpi_cmd_systemSlotKeepalive(scpi_t *context) {
+    auto module = getModuleFromSlotIndexParam(context);
+    if (!module) {
+        return SCPI_RES_ERR;
+    }
+
+    if (!bp3c::comm::hasOutputScheduler(module->slotIndex)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+        return SCPI_RES_ERR;
+    }
+
+    float interval;
+    if (!get_duration_param(context, interval,
+        bp3c::comm::KEEP_ALIVE_INTERVAL_MIN / 1000.0f,
+        bp3c::comm::KEEP_ALIVE_INTERVAL_MAX / 1000.0f,
+        bp3c::comm::KEEP_ALIVE_INTERVAL_DEFAULT / 1000.0f)) {
+        return SCPI_RES_ERR;
+    }
+
+    bp3c::comm::setKeepAliveInterval(module->slotIndex, (uint32_t)roundf(interval * 1000.0f));
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_systemSlotKeepaliveQ(scpi_t *context) {
+    auto module = getModuleFromSlotIndexParam(context);
+    if (!module) {
+        return SCPI_RES_ERR;
+    }
+
+    if (!bp3c::comm::hasOutputScheduler(module->slotIndex)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+        return SCPI_RES_ERR;
+    }
+
+    SCPI_ResultFloat(context, bp3c::comm::getKeepAliveInterval(module->slotIndex) / 1000.0f);
+
+    return SCPI_RES_OK;
+}
+
 scpi_result_t scpi_cmd_systemChannelCountQ(scpi_t *context) {
     SCPI_ResultInt(context, CH_NUM);
 
@@ -1842,7 +1901,7 @@ scpi_result_t scpi_cmd_systemMeasureScalarTemperatureThermistorDcQ(scpi_t *conte
     }
 
     char buffer[256] = { 0 };
-    strcatFloat(buffer, temperature::sensors[sensor].measure());
+    strcatFloat(buffer, temperature::getSnapshot().temperature[sensor]);
     SCPI_ResultCharacters(context, buffer, strlen(buffer));
 
     return SCPI_RES_OK;
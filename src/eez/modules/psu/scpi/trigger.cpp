@@ -18,6 +18,7 @@
 
 #include <eez/modules/psu/psu.h>
 
+#include <eez/modules/psu/acquisition.h>
 #include <eez/modules/psu/channel_dispatcher.h>
 #include <eez/modules/psu/io_pins.h>
 #include <eez/modules/psu/profile.h>
@@ -195,6 +196,44 @@ scpi_result_t scpi_cmd_triggerDlogSourceQ(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+scpi_result_t scpi_cmd_initiateAcquire(scpi_t *context) {
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    acquisition::initiate(*channel);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_triggerAcquireSource(scpi_t *context) {
+    int32_t source;
+    if (!SCPI_ParamChoice(context, sourceChoice, &source, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    acquisition::setTriggerSource(*channel, (trigger::Source)source);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_triggerAcquireSourceQ(scpi_t *context) {
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    resultChoiceName(context, sourceChoice, acquisition::getTriggerSource(*channel));
+
+    return SCPI_RES_OK;
+}
+
 } // namespace scpi
 } // namespace psu
 } // namespace eez
\ No newline at end of file
@@ -26,6 +26,7 @@
 #endif
 
 #include <eez/firmware.h>
+#include <eez/memory.h>
 
 #include <eez/modules/psu/psu.h>
 
@@ -227,6 +228,10 @@ bool catalog(const char *dirPath, void *param,
             callback(param != nullptr ? param : &fileInfo, name, type, fileInfo.getSize());
         }
 
+        // long directory listing, executed by the low priority thread,
+        // shouldn't hold back remote commands
+        yieldIo();
+
         if (dir.findNext(fileInfo) != SD_FAT_RESULT_OK) {
             break;
         }
@@ -268,6 +273,8 @@ bool catalogLength(const char *dirPath, size_t *length, int *err) {
     return true;
 }
 
+static TransferStatistics g_lastUploadStatistics;
+
 bool upload(const char *filePath, void *param, void (*callback)(void *param, const void *buffer, int size), int *err) {
     if (!sd_card::isMounted(err)) {
         return false;
@@ -293,6 +300,9 @@ bool upload(const char *filePath, void *param, void (*callback)(void *param, con
 
     callback(param, NULL, totalSize);
 
+    uint32_t startTime = millis();
+    uint32_t crc = 0;
+
     const int CHUNK_SIZE = 512;
     uint8_t buffer[CHUNK_SIZE];
 
@@ -301,6 +311,7 @@ bool upload(const char *filePath, void *param, void (*callback)(void *param, con
 
         callback(param, buffer, size);
 
+        crc = crc32_update(crc, buffer, size);
         uploaded += size;
 
 #if OPTION_DISPLAY
@@ -330,6 +341,12 @@ bool upload(const char *filePath, void *param, void (*callback)(void *param, con
 
     callback(param, NULL, -1);
 
+    if (result) {
+        g_lastUploadStatistics.size = uploaded;
+        g_lastUploadStatistics.crc = crc;
+        g_lastUploadStatistics.time = millis() - startTime;
+    }
+
 #if OPTION_DISPLAY
     psu::gui::hideProgressPage();
 #endif
@@ -337,22 +354,29 @@ bool upload(const char *filePath, void *param, void (*callback)(void *param, con
     return result;
 }
 
-bool download(const char *filePath, bool truncate, const void *buffer, size_t size, int *perr) {
-    if (!sd_card::isMounted(perr)) {
-        return false;
-    }
-
-	if (truncate) {
-	    if (!g_downloadFile.open(filePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
-			if (perr) {
-				*perr = SCPI_ERROR_FILE_NAME_NOT_FOUND;
-            }
-			return false;
-		}
-        strcpy(g_downloadFilePath, filePath);
-        g_downloadedFileOffset = 0;
-	}
+// Downloaded data is collected into DOWNLOAD_CHUNK_SIZE chunks inside DOWNLOAD_BUFFER,
+// each full chunk is written to the file with a single write from the low priority
+// thread message queue (see onDownloadWrite), so SCPI input processing is not
+// held back by the file system overhead of writing every arbitrary block.
+// Chunk is cluster sized and file is written from offset 0, so all writes except the last are cluster aligned.
+
+static const uint32_t DOWNLOAD_CHUNK_SIZE = 32 * 1024;
+static const uint32_t DOWNLOAD_NUM_CHUNKS = DOWNLOAD_BUFFER_SIZE / DOWNLOAD_CHUNK_SIZE;
+
+static bool g_downloadActive;
+static uint32_t g_downloadChunkHead; // number of chunks filled
+static uint32_t g_downloadChunkTail; // number of chunks written
+static uint32_t g_downloadChunkFill; // number of bytes in the chunk currently filled
+static int g_downloadWriteError;
+static uint32_t g_downloadCrc;
+static uint32_t g_downloadStartTime;
+static TransferStatistics g_lastDownloadStatistics;
+
+static uint8_t *getDownloadChunk(uint32_t chunkIndex) {
+    return DOWNLOAD_BUFFER + (chunkIndex % DOWNLOAD_NUM_CHUNKS) * DOWNLOAD_CHUNK_SIZE;
+}
 
+static bool downloadWrite(const void *buffer, size_t size, int *perr) {
     int err = 0;
 
     uint32_t timeout = millis() + CONF_DOWNLOAD_TIMEOUT_MS;
@@ -370,7 +394,7 @@ bool download(const char *filePath, bool truncate, const void *buffer, size_t si
         bool ropened = false;
 
         while (millis() < timeout) {
-            if (g_downloadFile.open(filePath, FILE_OPEN_EXISTING | FILE_WRITE)) {
+            if (g_downloadFile.open(g_downloadFilePath, FILE_OPEN_EXISTING | FILE_WRITE)) {
                 if (g_downloadFile.seek(g_downloadedFileOffset)) {
                     ropened = true;
                     break;
@@ -393,11 +417,162 @@ bool download(const char *filePath, bool truncate, const void *buffer, size_t si
     return false;
 }
 
-void downloadFinished() {
+static bool downloadWriteChunk(int *perr) {
+    if (!downloadWrite(getDownloadChunk(g_downloadChunkTail), DOWNLOAD_CHUNK_SIZE, perr)) {
+        return false;
+    }
+    g_downloadChunkTail++;
+    return true;
+}
+
+bool download(const char *filePath, bool truncate, const void *buffer, size_t size, int *perr) {
+    if (!sd_card::isMounted(perr)) {
+        return false;
+    }
+
+	if (truncate) {
+	    if (!g_downloadFile.open(filePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
+			if (perr) {
+				*perr = SCPI_ERROR_FILE_NAME_NOT_FOUND;
+            }
+			return false;
+		}
+        strcpy(g_downloadFilePath, filePath);
+        g_downloadedFileOffset = 0;
+
+        g_downloadActive = true;
+        g_downloadChunkHead = 0;
+        g_downloadChunkTail = 0;
+        g_downloadChunkFill = 0;
+        g_downloadWriteError = 0;
+        g_downloadCrc = 0;
+        g_downloadStartTime = millis();
+	}
+
+    if (g_downloadWriteError) {
+        if (perr) {
+            *perr = g_downloadWriteError;
+        }
+        return false;
+    }
+
+    g_downloadCrc = crc32_update(g_downloadCrc, (const uint8_t *)buffer, size);
+
+    const uint8_t *src = (const uint8_t *)buffer;
+    while (size > 0) {
+        if (g_downloadChunkHead - g_downloadChunkTail == DOWNLOAD_NUM_CHUNKS) {
+            // all chunks are full, write oldest one now
+            if (!downloadWriteChunk(perr)) {
+                return false;
+            }
+        }
+
+        size_t n = MIN(size, DOWNLOAD_CHUNK_SIZE - g_downloadChunkFill);
+        memcpy(getDownloadChunk(g_downloadChunkHead) + g_downloadChunkFill, src, n);
+        g_downloadChunkFill += n;
+        src += n;
+        size -= n;
+
+        if (g_downloadChunkFill == DOWNLOAD_CHUNK_SIZE) {
+            g_downloadChunkHead++;
+            g_downloadChunkFill = 0;
+
+            // one message per chunk, don't wait if queue is full since we are (probably) in the same thread,
+            // chunk will be written when buffer is full or download is committed
+            sendMessageToLowPriorityThread(THREAD_MESSAGE_DOWNLOAD_WRITE, 0, 0);
+        }
+    }
+
+    return true;
+}
+
+void onDownloadWrite() {
+    if (!g_downloadActive || g_downloadWriteError || g_downloadChunkTail == g_downloadChunkHead) {
+        return;
+    }
+
+    int err = 0;
+    if (!downloadWriteChunk(&err)) {
+        g_downloadWriteError = err != 0 ? err : SCPI_ERROR_MASS_STORAGE_ERROR;
+    }
+}
+
+bool downloadCommit(int *perr) {
+    if (g_downloadWriteError) {
+        if (perr) {
+            *perr = g_downloadWriteError;
+        }
+        return false;
+    }
+
+    while (g_downloadChunkTail != g_downloadChunkHead) {
+        if (!downloadWriteChunk(perr)) {
+            return false;
+        }
+    }
+
+    if (g_downloadChunkFill > 0) {
+        if (!downloadWrite(getDownloadChunk(g_downloadChunkHead), g_downloadChunkFill, perr)) {
+            return false;
+        }
+        g_downloadChunkFill = 0;
+    }
+
     g_downloadFile.close();
+
+    // read back the file and compare with CRC of the received data,
+    // download buffer is not used anymore so it is reused for reading
+    File file;
+    if (!file.open(g_downloadFilePath, FILE_OPEN_EXISTING | FILE_READ)) {
+        if (perr) {
+            *perr = SCPI_ERROR_MASS_STORAGE_ERROR;
+        }
+        return false;
+    }
+
+    uint32_t crc = 0;
+    uint32_t fileSize = 0;
+    while (true) {
+        size_t n = file.read(DOWNLOAD_BUFFER, DOWNLOAD_BUFFER_SIZE);
+        if (n == 0) {
+            break;
+        }
+        crc = crc32_update(crc, DOWNLOAD_BUFFER, n);
+        fileSize += n;
+    }
+
+    file.close();
+
+    if (fileSize != g_downloadedFileOffset || crc != g_downloadCrc) {
+        if (perr) {
+            *perr = SCPI_ERROR_MASS_STORAGE_ERROR;
+        }
+        return false;
+    }
+
+    g_lastDownloadStatistics.size = fileSize;
+    g_lastDownloadStatistics.crc = crc;
+    g_lastDownloadStatistics.time = millis() - g_downloadStartTime;
+
+    return true;
+}
+
+void downloadFinished() {
+    if (g_downloadFile.isOpen()) {
+        g_downloadFile.close();
+    }
+    g_downloadActive = false;
     onSdCardFileChangeHook(g_downloadFilePath);
 }
 
+const TransferStatistics &getLastDownloadStatistics() {
+    return g_lastDownloadStatistics;
+}
+
+const TransferStatistics &getLastUploadStatistics() {
+    return g_lastUploadStatistics;
+}
+
 bool moveFile(const char *sourcePath, const char *destinationPath, int *err) {
     if (!sd_card::isMounted(err)) {
         return false;
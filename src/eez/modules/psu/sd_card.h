@@ -56,7 +56,19 @@ bool catalog(const char *dirPath, void *param, void (*callback)(void *param, con
 bool catalogLength(const char *dirPath, size_t *length, int *err);
 bool upload(const char *filePath, void *param, void (*callback)(void *param, const void *buffer, int size), int *err);
 bool download(const char *filePath, bool truncate, const void *buffer, size_t size, int *err);
+void onDownloadWrite();
+// Writes everything still buffered and verifies the file against CRC of the downloaded data.
+bool downloadCommit(int *err);
 void downloadFinished();
+
+struct TransferStatistics {
+    uint32_t size;
+    uint32_t crc;
+    uint32_t time; // ms, for download from the first block until the file was verified
+};
+
+const TransferStatistics &getLastDownloadStatistics();
+const TransferStatistics &getLastUploadStatistics();
 bool moveFile(const char *sourcePath, const char *destinationPath, int *err);
 bool copyFile(const char *sourcePath, const char *destinationPath, bool showProgress, int *err);
 bool deleteFile(const char *filePath, int *err);
@@ -41,17 +41,35 @@ namespace serial {
 
 TestResult g_testResult = TEST_FAILED;
 
-size_t SCPI_Write(scpi_t *context, const char *data, size_t len) {
+static OutputBuffer g_outputBuffer;
+
+static size_t serialWrite(scpi_t *context, const char *data, size_t len) {
     Serial.write(data, len);
     return len;
 }
 
+size_t SCPI_Write(scpi_t *context, const char *data, size_t len) {
+    // output buffer is used only by the thread that executes SCPI commands,
+    // everything else (i.e. GUI file upload) is sent immediately
+    if (!isScpiThread()) {
+        return serialWrite(context, data, len);
+    }
+
+    return outputBufferWrite(context, g_outputBuffer, serialWrite, data, len);
+}
+
 scpi_result_t SCPI_Flush(scpi_t *context) {
+    if (isScpiThread()) {
+        outputBufferFlush(context, g_outputBuffer, serialWrite);
+    }
     return SCPI_RES_OK;
 }
 
 int SCPI_Error(scpi_t *context, int_fast16_t err) {
     if (err != 0) {
+        // error is printed directly, so send buffered response first to keep the order
+        SCPI_Flush(context);
+
         scpi::printError(err);
 
         if (err == SCPI_ERROR_INPUT_BUFFER_OVERRUN) {
@@ -64,6 +82,8 @@ int SCPI_Error(scpi_t *context, int_fast16_t err) {
 
 scpi_result_t SCPI_Control(scpi_t *context, scpi_ctrl_name_t ctrl, scpi_reg_val_t val) {
     if (serial::g_testResult == TEST_OK) {
+        SCPI_Flush(context);
+
         char errorOutputBuffer[256];
         if (SCPI_CTRL_SRQ == ctrl) {
             sprintf(errorOutputBuffer, "**SRQ: 0x%X (%d)\r\n", val, val);
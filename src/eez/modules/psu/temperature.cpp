@@ -21,6 +21,7 @@
 #include <eez/index.h>
 
 #include <float.h>
+#include <math.h>
 
 #include <eez/modules/psu/serial_psu.h>
 
@@ -46,12 +47,21 @@ TempSensorTemperature sensors[temp_sensor::NUM_TEMP_SENSORS] = { TEMP_SENSORS };
 
 static uint32_t g_lastMeasuredTick;
 static uint32_t g_maxTempCheckStartTick;
-static float g_lastMaxChannelTemperature;
+
+static Snapshot g_snapshot;
+
+static float g_filterTimeConstant = TEMP_SENSOR_FILTER_TIME_CONSTANT;
+static float g_filterAlpha;
 
 void init() {
     for (int i = 0; i < temp_sensor::NUM_TEMP_SENSORS; ++i) {
         temp_sensor::sensors[i].init();
+        g_snapshot.temperature[i] = NAN;
     }
+
+    g_snapshot.maxChannelSensorIndex = -1;
+
+    setFilterTimeConstant(g_filterTimeConstant);
 }
 
 bool test() {
@@ -68,28 +78,43 @@ void tick(uint32_t tickCount) {
     if (tickCount - g_lastMeasuredTick >= TEMP_SENSOR_READ_EVERY_MS * 1000L) {
         g_lastMeasuredTick = tickCount;
 
-        for (int i = 0; i < temp_sensor::NUM_TEMP_SENSORS; ++i) {
-            sensors[i].tick(tickCount);
-        }
-
-        // find max. channel temperature
+        // single pass: sample, check OTP and find max. channel temperature
+        float lastMaxChannelTemperature = g_snapshot.maxChannelTemperature;
         float maxChannelTemperature = FLT_MIN;
+        int maxChannelSensorIndex = -1;
 
         for (int i = 0; i < temp_sensor::NUM_TEMP_SENSORS; ++i) {
             temp_sensor::TempSensor &sensor = temp_sensor::sensors[i];
-            if (sensor.getChannel()) {
-                if (sensor.g_testResult == TEST_OK) {
-                    temperature::TempSensorTemperature &sensorTemperature = temperature::sensors[i];
-                    if (sensorTemperature.temperature > maxChannelTemperature) {
-                        maxChannelTemperature = sensorTemperature.temperature;
-                    }
-                }
+            TempSensorTemperature &sensorTemperature = sensors[i];
+
+            if (!sensor.isInstalled() || sensor.g_testResult != TEST_OK) {
+                g_snapshot.temperature[i] = NAN;
+                continue;
+            }
+
+            sensorTemperature.sample(g_filterAlpha);
+
+            if (sensor.g_testResult != TEST_OK) {
+                // sensor failed while reading
+                g_snapshot.temperature[i] = NAN;
+                continue;
+            }
+
+            sensorTemperature.protection_check(tickCount);
+
+            if (sensor.getChannel() && g_snapshot.temperature[i] > maxChannelTemperature) {
+                maxChannelTemperature = g_snapshot.temperature[i];
+                maxChannelSensorIndex = i;
             }
         }
 
+        g_snapshot.tick = tickCount;
+        g_snapshot.maxChannelTemperature = maxChannelTemperature;
+        g_snapshot.maxChannelSensorIndex = maxChannelSensorIndex;
+
         // check if max_channel_temperature is too high
         if (isPowerUp() && maxChannelTemperature > FAN_MAX_TEMP) {
-            if (g_lastMaxChannelTemperature <= FAN_MAX_TEMP) {
+            if (lastMaxChannelTemperature <= FAN_MAX_TEMP) {
                 g_maxTempCheckStartTick = tickCount;
             }
 
@@ -101,8 +126,6 @@ void tick(uint32_t tickCount) {
         } else {
             g_maxTempCheckStartTick = tickCount;
         }
-
-        g_lastMaxChannelTemperature = maxChannelTemperature;
     }
 }
 
@@ -149,13 +172,30 @@ void disableChannelProtection(Channel *channel) {
 }
 
 float getMaxChannelTemperature() {
-    return g_lastMaxChannelTemperature;
+    return g_snapshot.maxChannelTemperature;
+}
+
+const Snapshot &getSnapshot() {
+    return g_snapshot;
+}
+
+void setFilterTimeConstant(float timeConstant) {
+    g_filterTimeConstant = timeConstant;
+    if (timeConstant > 0) {
+        g_filterAlpha = 1.0f - expf(-TEMP_SENSOR_READ_EVERY_MS / (1000.0f * timeConstant));
+    } else {
+        g_filterAlpha = 1.0f;
+    }
+}
+
+float getFilterTimeConstant() {
+    return g_filterTimeConstant;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 TempSensorTemperature::TempSensorTemperature(int sensorIndex_)
-    : temperature(NAN), sensorIndex(sensorIndex_) {
+    : sensorIndex(sensorIndex_) {
 }
 
 const char *TempSensorTemperature::getName() {
@@ -170,26 +210,22 @@ bool TempSensorTemperature::isTestOK() {
     return temp_sensor::sensors[sensorIndex].g_testResult == TEST_OK;
 }
 
-void TempSensorTemperature::tick(uint32_t tick_usec) {
-    if (isInstalled() && isTestOK()) {
-        measure();
-        if (temp_sensor::sensors[sensorIndex].g_testResult == TEST_OK) {
-            protection_check(tick_usec);
-        }
-    }
+float TempSensorTemperature::getTemperature() {
+    return g_snapshot.temperature[sensorIndex];
 }
 
 bool TempSensorTemperature::isChannelSensor(Channel *channel) {
     return temp_sensor::sensors[sensorIndex].isInstalled() && temp_sensor::sensors[sensorIndex].getChannel();
 }
 
-float TempSensorTemperature::measure() {
+float TempSensorTemperature::sample(float alpha) {
+    float &temperature = g_snapshot.temperature[sensorIndex];
     float newTemperature = temp_sensor::sensors[sensorIndex].read();
     if (!isNaN(newTemperature)) {
 		if (isNaN(temperature)) {
 			temperature = newTemperature;
 		} else {
-			temperature = temperature + 1.0f * (newTemperature - temperature);
+			temperature = temperature + alpha * (newTemperature - temperature);
 		}
     }
     return temperature;
@@ -219,7 +255,7 @@ void TempSensorTemperature::set_otp_reg(bool on) {
 
 void TempSensorTemperature::protection_check(uint32_t tick_usec) {
     if (temp_sensor::sensors[sensorIndex].isInstalled()) {
-        if (!otp_tripped && prot_conf.state && temperature >= prot_conf.level) {
+        if (!otp_tripped && prot_conf.state && g_snapshot.temperature[sensorIndex] >= prot_conf.level) {
             float delay = prot_conf.delay;
             if (delay > 0) {
                 if (otp_alarmed) {
@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include <stdint.h>
+
 #include <eez/modules/psu/temp_sensor.h>
 
 namespace eez {
@@ -51,19 +53,36 @@ void disableChannelProtection(Channel *channel);
 
 float getMaxChannelTemperature();
 
+/// Result of the last sampling pass over all the sensors. OTP checks,
+/// fan controller, GUI and SCPI all read from here, sensors are read only
+/// once per TEMP_SENSOR_READ_EVERY_MS.
+struct Snapshot {
+    uint32_t tick; // us
+    float temperature[temp_sensor::NUM_TEMP_SENSORS]; // NAN if not installed or test failed
+    float maxChannelTemperature;
+    int maxChannelSensorIndex; // -1 if there is no channel sensor
+};
+
+const Snapshot &getSnapshot();
+
+/// Time constant (in seconds) of the exponential filter applied to
+/// sensor readings, 0 means filter is disabled.
+void setFilterTimeConstant(float timeConstant);
+float getFilterTimeConstant();
+
 class TempSensorTemperature {
 public:
 	ProtectionConfiguration prot_conf;
-	float temperature;
 
 	TempSensorTemperature(int sensorIndex);
 
     const char *getName();
 	bool isInstalled();
 	bool isTestOK();
-	void tick(uint32_t tick_usec);
+	float getTemperature();
 	bool isChannelSensor(Channel *channel);
-	float measure();
+	float sample(float alpha);
+	void protection_check(uint32_t tick_usec);
 	void clearProtection();
 	bool isTripped();
 
@@ -75,7 +94,6 @@ private:
 	bool otp_tripped;
 
 	void set_otp_reg(bool on);
-	void protection_check(uint32_t tick_usec);
     static void protection_enter(TempSensorTemperature& sensor);
 	void protection_enter();
 };
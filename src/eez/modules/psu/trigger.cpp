@@ -16,8 +16,11 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdio.h>
+
 #include <eez/modules/psu/psu.h>
 
+#include <eez/modules/psu/acquisition.h>
 #include <eez/modules/psu/channel_dispatcher.h>
 #include <eez/modules/psu/io_pins.h>
 #include <eez/modules/psu/list_program.h>
@@ -40,7 +43,7 @@ bool g_triggerContinuousInitializationEnabled;
 
 enum State { STATE_IDLE, STATE_INITIATED, STATE_TRIGGERED, STATE_EXECUTING };
 static State g_state;
-static uint32_t g_triggeredTime;
+static uint64_t g_triggeredTime; // in microseconds
 
 bool g_triggerInProgress[CH_MAX];
 
@@ -104,38 +107,49 @@ void setSource(Source triggerSource) {
     }
 }
 
-void check(uint32_t currentTime) {
-    if (currentTime - g_triggeredTime > g_triggerDelay * 1000L) {
+void check(uint64_t currentTime) {
+    if (currentTime - g_triggeredTime > (uint64_t)(g_triggerDelay * 1000000L)) {
         startImmediately();
     }
 }
 
-int generateTrigger(Source source, bool checkImmediatelly) {
+static int doGenerateTrigger(Source source, bool checkImmediatelly, uint64_t timestamp) {
     bool seqTriggered = g_triggerSource == source && g_state == STATE_INITIATED;
 
     bool dlogTriggered = dlog_record::g_parameters.triggerSource == source && dlog_record::isInitiated();
 
-    if (!seqTriggered && !dlogTriggered) {
+    bool acquisitionTriggered = acquisition::onTrigger(source);
+
+    if (!seqTriggered && !dlogTriggered && !acquisitionTriggered) {
         return SCPI_ERROR_TRIGGER_IGNORED;
     }
 
     if (dlogTriggered) {
-        dlog_record::triggerGenerated();
+        dlog_record::triggerGenerated(timestamp);
     }
 
     if (seqTriggered) {
         setState(STATE_TRIGGERED);
 
-        g_triggeredTime = micros() / 1000;
+        // trigger delay is counted from the moment trigger happened
+        g_triggeredTime = timestamp;
 
         if (checkImmediatelly) {
-            check(g_triggeredTime);
+            check(micros64());
         }
     }
 
     return SCPI_RES_OK;
 }
 
+int generateTrigger(Source source, bool checkImmediatelly) {
+    return doGenerateTrigger(source, checkImmediatelly, micros64());
+}
+
+int generateTriggerAt(Source source, uint64_t timestamp) {
+    return doGenerateTrigger(source, true, timestamp);
+}
+
 bool isTriggerFinishedOnAllChannels() {
     for (int i = 0; i < CH_NUM; ++i) {
         if (g_triggerInProgress[i]) {
@@ -389,6 +403,7 @@ void abort() {
     } else {
         list::abort();
         ramp::abort();
+        acquisition::abort();
 
         bool sync = false;
         for (int i = 0; i < CH_NUM; ++i) {
@@ -406,12 +421,252 @@ void abort() {
     }
 }
 
-void tick(uint32_t tick_usec) {
+void tick(uint64_t tick_usec) {
     if (g_state == STATE_TRIGGERED) {
-        check(tick_usec / 1000);
+        check(tick_usec);
+    }
+}
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+
+// first micros64() value for which micros() is wrapped to 0
+static const uint64_t WRAP_TIME = 0x100000000ULL;
+
+static const uint64_t TEST_TICK_PERIOD = 10000; // us
+
+// same order as in psu::tick
+static void tickSchedulers(uint64_t tickUsec) {
+    tick(tickUsec);
+    list::tick(tickUsec);
+    ramp::tick(tickUsec);
+}
+
+// Trigger at triggerTime with 0.3 s delay, then STEP with 0.2 s output delay and 1 s voltage ramp.
+static bool stepWrapSelfTest(Channel &channel, uint64_t triggerTime, char *message, int messageSize) {
+    static const float DELAY = 0.3f;
+    static const float OUTPUT_DELAY = 0.2f;
+    static const float RAMP_DURATION = 1.0f;
+    static const float VOLTAGE = 10.0f;
+
+    setDelay(DELAY);
+    channel_dispatcher::setVoltageTriggerMode(channel, TRIGGER_MODE_STEP);
+    channel_dispatcher::setCurrentTriggerMode(channel, TRIGGER_MODE_STEP);
+    channel_dispatcher::setTriggerVoltage(channel, VOLTAGE);
+    channel_dispatcher::setTriggerCurrent(channel, 0.5f);
+    channel_dispatcher::setOutputDelayDuration(channel, OUTPUT_DELAY);
+    channel_dispatcher::setVoltageRampDuration(channel, RAMP_DURATION);
+    channel_dispatcher::setCurrentRampDuration(channel, 0);
+
+    int err = initiate();
+    if (err != SCPI_RES_OK) {
+        snprintf(message, messageSize, "step initiate error %d", err);
+        return false;
+    }
+    doGenerateTrigger(SOURCE_BUS, false, triggerTime);
+
+    uint64_t rampStartTime = 0;
+    for (uint64_t t = triggerTime + TEST_TICK_PERIOD; t < triggerTime + 2000000; t += TEST_TICK_PERIOD) {
+        tickSchedulers(t);
+
+        if (t - triggerTime <= (uint64_t)(DELAY * 1000000)) {
+            if (!isTriggered()) {
+                snprintf(message, messageSize, "step trigger %u us, started %u us after trigger",
+                    (unsigned)(WRAP_TIME - triggerTime), (unsigned)(t - triggerTime));
+                return false;
+            }
+            continue;
+        }
+
+        // ramp starts at the first tick after the trigger delay
+        if (rampStartTime == 0) {
+            rampStartTime = t;
+        }
+
+        float time = (t - rampStartTime) / 1000000.0f;
+        float expected;
+        if (time < OUTPUT_DELAY) {
+            expected = 0;
+        } else if (time < OUTPUT_DELAY + RAMP_DURATION) {
+            expected = VOLTAGE * (time - OUTPUT_DELAY) / RAMP_DURATION;
+        } else {
+            expected = VOLTAGE;
+        }
+
+        float uSet = channel_dispatcher::getUSet(channel);
+        if (fabsf(uSet - expected) > 0.01f) {
+            snprintf(message, messageSize, "step trigger %u us, %u us after trigger: %g V, expected %g V",
+                (unsigned)(WRAP_TIME - triggerTime), (unsigned)(t - triggerTime), uSet, expected);
+            return false;
+        }
+
+        // end of the ramp is compared in float, so one tick around it is not checked
+        float endTime = OUTPUT_DELAY + RAMP_DURATION;
+        float tickPeriod = TEST_TICK_PERIOD / 1000000.0f;
+        if (time < endTime - tickPeriod || time > endTime + tickPeriod) {
+            bool finished = time > endTime;
+            if (ramp::isActive(channel) == finished || isIdle() != finished) {
+                snprintf(message, messageSize, "step trigger %u us, %u us after trigger: ramp is %s",
+                    (unsigned)(WRAP_TIME - triggerTime), (unsigned)(t - triggerTime), finished ? "not finished" : "finished");
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// List of 4 points with 0.25 s dwell, executed twice.
+static bool listWrapSelfTest(Channel &channel, uint64_t triggerTime, char *message, int messageSize) {
+    static float dwellList[] = { 0.25f };
+    static float voltageList[] = { 1.0f, 2.0f, 3.0f, 4.0f };
+    static float currentList[] = { 0.5f };
+    static const uint64_t DWELL = 250000; // us
+    static const uint16_t COUNT = 2;
+
+    setDelay(0);
+    channel_dispatcher::setVoltageTriggerMode(channel, TRIGGER_MODE_LIST);
+    channel_dispatcher::setCurrentTriggerMode(channel, TRIGGER_MODE_LIST);
+    channel_dispatcher::setTriggerOnListStop(channel, TRIGGER_ON_LIST_STOP_SET_TO_LAST_STEP);
+    channel_dispatcher::setDwellList(channel, dwellList, 1);
+    channel_dispatcher::setVoltageList(channel, voltageList, 4);
+    channel_dispatcher::setCurrentList(channel, currentList, 1);
+    channel_dispatcher::setListCount(channel, COUNT);
+
+    int err = initiate();
+    if (err != SCPI_RES_OK) {
+        snprintf(message, messageSize, "list initiate error %d", err);
+        return false;
+    }
+    doGenerateTrigger(SOURCE_BUS, false, triggerTime);
+
+    // list starts at the first tick
+    uint64_t listStartTime = triggerTime + TEST_TICK_PERIOD;
+    uint64_t listEndTime = listStartTime + 4 * COUNT * DWELL;
+
+    for (uint64_t t = listStartTime; t < listEndTime + 100000; t += TEST_TICK_PERIOD) {
+        tickSchedulers(t);
+
+        bool finished = t >= listEndTime;
+        if (list::isActive(channel) == finished) {
+            snprintf(message, messageSize, "list trigger %u us, %u us after start: list is %s",
+                (unsigned)(WRAP_TIME - triggerTime), (unsigned)(t - listStartTime), finished ? "not finished" : "finished");
+            return false;
+        }
+
+        // ticks are aligned with the dwell, so each point is set exactly on time
+        float expected = finished ? voltageList[3] : voltageList[((t - listStartTime) / DWELL) % 4];
+        float uSet = channel_dispatcher::getUSet(channel);
+        if (uSet != expected) {
+            snprintf(message, messageSize, "list trigger %u us, %u us after start: %g V, expected %g V",
+                (unsigned)(WRAP_TIME - triggerTime), (unsigned)(t - listStartTime), uSet, expected);
+            return false;
+        }
     }
+
+    return true;
 }
 
+bool wrapSelfTest(char *message, int messageSize) {
+    if (!isIdle() || g_triggerContinuousInitializationEnabled || list::isActive() || ramp::isActive()) {
+        snprintf(message, messageSize, "trigger, list and ramp must be idle");
+        return false;
+    }
+
+    if (channel_dispatcher::getCouplingType() != channel_dispatcher::COUPLING_TYPE_NONE) {
+        snprintf(message, messageSize, "channels must be uncoupled");
+        return false;
+    }
+
+    Channel &channel = Channel::get(0);
+    if (!channel.isOk() || channel.flags.trackingEnabled) {
+        snprintf(message, messageSize, "CH1 must be OK and not tracked");
+        return false;
+    }
+
+    for (int i = 1; i < CH_NUM; i++) {
+        Channel &otherChannel = Channel::get(i);
+        if (otherChannel.getVoltageTriggerMode() != TRIGGER_MODE_FIXED || otherChannel.getCurrentTriggerMode() != TRIGGER_MODE_FIXED) {
+            snprintf(message, messageSize, "CH%d must be in fixed trigger mode", i + 1);
+            return false;
+        }
+    }
+
+    // save everything test is changing
+    Source savedSource = g_triggerSource;
+    float savedDelay = g_triggerDelay;
+    TriggerMode savedVoltageTriggerMode = channel_dispatcher::getVoltageTriggerMode(channel);
+    TriggerMode savedCurrentTriggerMode = channel_dispatcher::getCurrentTriggerMode(channel);
+    TriggerOnListStop savedTriggerOnListStop = channel_dispatcher::getTriggerOnListStop(channel);
+    bool savedTriggerOutputState = channel_dispatcher::getTriggerOutputState(channel);
+    float savedTriggerVoltage = channel_dispatcher::getTriggerVoltage(channel);
+    float savedTriggerCurrent = channel_dispatcher::getTriggerCurrent(channel);
+    float savedOutputDelayDuration = channel.outputDelayDuration;
+    float savedVoltageRampDuration = channel.u.rampDuration;
+    float savedCurrentRampDuration = channel.i.rampDuration;
+    float savedVoltage = channel_dispatcher::getUSet(channel);
+    float savedCurrent = channel_dispatcher::getISet(channel);
+    bool savedOutputEnabled = channel.isOutputEnabled();
+
+    static float savedDwellList[MAX_LIST_LENGTH];
+    static float savedVoltageList[MAX_LIST_LENGTH];
+    static float savedCurrentList[MAX_LIST_LENGTH];
+    uint16_t savedDwellListLength;
+    uint16_t savedVoltageListLength;
+    uint16_t savedCurrentListLength;
+    memcpy(savedDwellList, list::getDwellList(channel, &savedDwellListLength), sizeof(savedDwellList));
+    memcpy(savedVoltageList, list::getVoltageList(channel, &savedVoltageListLength), sizeof(savedVoltageList));
+    memcpy(savedCurrentList, list::getCurrentList(channel, &savedCurrentListLength), sizeof(savedCurrentList));
+    uint16_t savedListCount = list::getListCount(channel);
+
+    setSource(SOURCE_BUS);
+    channel_dispatcher::setTriggerOutputState(channel, true);
+
+    // micros() wraps during the trigger delay, output delay and voltage ramp
+    static const uint32_t STEP_TRIGGER_BEFORE_WRAP[] = { 100000, 400000, 1000000 }; // us
+
+    bool result = true;
+    for (unsigned i = 0; i < sizeof(STEP_TRIGGER_BEFORE_WRAP) / sizeof(uint32_t) && result; i++) {
+        result = stepWrapSelfTest(channel, WRAP_TIME - STEP_TRIGGER_BEFORE_WRAP[i], message, messageSize);
+        abort();
+    }
+
+    // micros() wraps in the middle of the first list pass
+    if (result) {
+        result = listWrapSelfTest(channel, WRAP_TIME - 600000, message, messageSize);
+        abort();
+    }
+
+    if (result) {
+        snprintf(message, messageSize, "step and list scheduled through micros() wrap");
+    }
+
+    // restore
+    setSource(savedSource);
+    setDelay(savedDelay);
+    channel_dispatcher::setVoltageTriggerMode(channel, savedVoltageTriggerMode);
+    channel_dispatcher::setCurrentTriggerMode(channel, savedCurrentTriggerMode);
+    channel_dispatcher::setTriggerOnListStop(channel, savedTriggerOnListStop);
+    channel_dispatcher::setTriggerOutputState(channel, savedTriggerOutputState);
+    channel_dispatcher::setTriggerVoltage(channel, savedTriggerVoltage);
+    channel_dispatcher::setTriggerCurrent(channel, savedTriggerCurrent);
+    channel_dispatcher::setOutputDelayDuration(channel, savedOutputDelayDuration);
+    channel_dispatcher::setVoltageRampDuration(channel, savedVoltageRampDuration);
+    channel_dispatcher::setCurrentRampDuration(channel, savedCurrentRampDuration);
+    channel_dispatcher::setDwellList(channel, savedDwellList, savedDwellListLength);
+    channel_dispatcher::setVoltageList(channel, savedVoltageList, savedVoltageListLength);
+    channel_dispatcher::setCurrentList(channel, savedCurrentList, savedCurrentListLength);
+    channel_dispatcher::setListCount(channel, savedListCount);
+    channel_dispatcher::setVoltage(channel, savedVoltage);
+    channel_dispatcher::setCurrent(channel, savedCurrent);
+    if (channel.isOutputEnabled() != savedOutputEnabled) {
+        channel_dispatcher::outputEnable(channel, savedOutputEnabled);
+    }
+
+    return result;
+}
+
+#endif
+
 } // namespace trigger
 } // namespace psu
 } // namespace eez
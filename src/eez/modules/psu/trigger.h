@@ -52,6 +52,8 @@ void setCurrent(Channel &channel, float value);
 float getCurrent(Channel &channel);
 
 int generateTrigger(Source source, bool checkImmediatelly = true);
+// Same as generateTrigger, but for the trigger that happened at the given time (in micros64).
+int generateTriggerAt(Source source, uint64_t timestamp);
 int startImmediately();
 void startImmediatelyInPsuThread();
 int initiate();
@@ -63,7 +65,14 @@ bool isTriggered();
 bool isActive();
 void abort();
 
-void tick(uint32_t tick_usec);
+void tick(uint64_t tick_usec);
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+// Runs trigger delay, STEP ramp and LIST on CH1 with injected ticks around the
+// 32-bit micros() wrap-around, no waiting. Must be called from the PSU thread.
+// Channel and trigger settings are restored at the end.
+bool wrapSelfTest(char *message, int messageSize);
+#endif
 
 }
 }
@@ -647,7 +647,7 @@ void tick() {
             float temperature;
             temperature::TempSensorTemperature &tempSensor = temperature::sensors[temp_sensor::AUX];
             if (tempSensor.isInstalled() && tempSensor.isTestOK()) {
-                temperature = tempSensor.temperature;
+                temperature = tempSensor.getTemperature();
             } else {
                 temperature = NAN;
             }
@@ -766,7 +766,7 @@ void tick() {
                         float temperature;
                         temperature::TempSensorTemperature &tempSensor = temperature::sensors[temp_sensor::CH1 + channelIndex];
                         if (tempSensor.isInstalled() && tempSensor.isTestOK()) {
-                            temperature = tempSensor.temperature;
+                            temperature = tempSensor.getTemperature();
                         } else {
                             temperature = NAN;
                         }
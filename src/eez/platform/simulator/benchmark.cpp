@@ -0,0 +1,539 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef EEZ_PLATFORM_SIMULATOR_WIN32
+#undef INPUT
+#undef OUTPUT
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <winsock2.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <eez/platform/simulator/benchmark.h>
+
+#include <eez/firmware.h>
+#include <eez/system.h>
+#include <eez/tasks.h>
+
+#include <eez/modules/psu/psu.h>
+#include <eez/modules/psu/dlog_record.h>
+#include <eez/modules/psu/persist_conf.h>
+#include <eez/modules/psu/scpi/psu.h>
+
+#if OPTION_DISPLAY
+#include <eez/gui/gui.h>
+#endif
+
+namespace eez {
+namespace platform {
+namespace simulator {
+namespace benchmark {
+
+void scriptThreadMainLoop(const void *);
+
+osThreadDef(g_scriptTask, scriptThreadMainLoop, osPriorityNormal, 0, 8192);
+
+static const char *g_scriptFilePath;
+static const char *g_reportFilePath;
+static bool g_exitWhenDone;
+
+static const int MAX_LINES = 1024;
+static const int MAX_LINE_LENGTH = 256;
+static char g_lines[MAX_LINES][MAX_LINE_LENGTH];
+static int g_numLines;
+
+static const int MAX_REPEAT_DEPTH = 8;
+
+struct CommandStatistics {
+    char header[48];
+    RunTimeStatistics statistics;
+};
+
+static const int MAX_COMMANDS = 64;
+static CommandStatistics g_commandStatistics[MAX_COMMANDS];
+static int g_numCommands;
+
+struct LoadStatistics {
+    char query[48];
+    uint32_t count;
+    uint32_t numErrors;
+    uint64_t time; // us
+};
+
+static const int MAX_LOADS = 16;
+static LoadStatistics g_loadStatistics[MAX_LOADS];
+static int g_numLoads;
+
+static uint32_t g_numErrors;
+static uint64_t g_startTime;
+
+////////////////////////////////////////////////////////////////////////////////
+
+using namespace eez::scpi;
+using namespace eez::psu::scpi;
+
+static char g_scpiData[SCPI_PARSER_INPUT_BUFFER_LENGTH + 1];
+static size_t g_scpiDataLen;
+
+static size_t SCPI_Write(scpi_t *context, const char *data, size_t len) {
+    len = MIN(len, SCPI_PARSER_INPUT_BUFFER_LENGTH - g_scpiDataLen);
+    if (len > 0) {
+        strncpy(g_scpiData + g_scpiDataLen, data, len);
+        g_scpiDataLen += len;
+        g_scpiData[g_scpiDataLen] = 0;
+    }
+    return len;
+}
+
+static scpi_result_t SCPI_Flush(scpi_t *context) {
+    return SCPI_RES_OK;
+}
+
+static int SCPI_Error(scpi_t *context, int_fast16_t err) {
+    if (err != 0) {
+        g_numErrors++;
+
+        printf("**ERROR: %d,\"%s\"\n", (int)err, SCPI_ErrorTranslate(err));
+
+        if (err == SCPI_ERROR_INPUT_BUFFER_OVERRUN) {
+            psu::scpi::onBufferOverrun(*context);
+        }
+    }
+
+    return 0;
+}
+
+static scpi_result_t SCPI_Control(scpi_t *context, scpi_ctrl_name_t ctrl, scpi_reg_val_t val) {
+    return SCPI_RES_OK;
+}
+
+static scpi_result_t SCPI_Reset(scpi_t *context) {
+    return eez::reset() ? SCPI_RES_OK : SCPI_RES_ERR;
+}
+
+static scpi_reg_val_t g_scpiPsuRegs[SCPI_PSU_REG_COUNT];
+static scpi_psu_t g_scpiPsuContext = { g_scpiPsuRegs };
+
+static scpi_interface_t g_scpiInterface = {
+    SCPI_Error, SCPI_Write, SCPI_Control, SCPI_Flush, SCPI_Reset,
+};
+
+static char g_scpiInputBuffer[SCPI_PARSER_INPUT_BUFFER_LENGTH];
+static scpi_error_t g_errorQueueData[SCPI_PARSER_ERROR_QUEUE_SIZE + 1];
+
+static scpi_t g_scpiContext;
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool parseCommandLine(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--script") == 0 && i + 1 < argc) {
+            g_scriptFilePath = argv[++i];
+        } else if (strcmp(argv[i], "--report") == 0 && i + 1 < argc) {
+            g_reportFilePath = argv[++i];
+        } else if (strcmp(argv[i], "--exit") == 0) {
+            g_exitWhenDone = true;
+        } else if (strcmp(argv[i], "--tick-start") == 0 && i + 1 < argc) {
+            osKernelSysTickStart = strtoull(argv[++i], nullptr, 10);
+        } else {
+            printf("Usage: %s [--script <file> [--report <file>] [--exit]] [--tick-start <ms>]\n", argv[0]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool loadScript() {
+    FILE *fp = fopen(g_scriptFilePath, "r");
+    if (!fp) {
+        printf("Failed to open script file \"%s\"\n", g_scriptFilePath);
+        return false;
+    }
+
+    char line[MAX_LINE_LENGTH];
+    while (fgets(line, MAX_LINE_LENGTH, fp)) {
+        // trim
+        char *begin = line;
+        while (isspace(*begin)) {
+            begin++;
+        }
+        char *end = begin + strlen(begin);
+        while (end > begin && isspace(end[-1])) {
+            end--;
+        }
+        *end = 0;
+
+        if (*begin == 0 || *begin == '#') {
+            continue;
+        }
+
+        if (g_numLines == MAX_LINES) {
+            printf("Script too long, max. %d lines\n", MAX_LINES);
+            fclose(fp);
+            return false;
+        }
+
+        strcpy(g_lines[g_numLines++], begin);
+    }
+
+    fclose(fp);
+    return true;
+}
+
+static RunTimeStatistics &getCommandStatistics(const char *command) {
+    char header[sizeof(CommandStatistics::header)];
+    size_t i;
+    for (i = 0; i < sizeof(header) - 1 && command[i] && !isspace(command[i]); i++) {
+        header[i] = toupper(command[i]);
+    }
+    header[i] = 0;
+
+    for (int i = 0; i < g_numCommands; i++) {
+        if (strcmp(g_commandStatistics[i].header, header) == 0) {
+            return g_commandStatistics[i].statistics;
+        }
+    }
+
+    if (g_numCommands == MAX_COMMANDS) {
+        // table is full, count with the last one
+        return g_commandStatistics[MAX_COMMANDS - 1].statistics;
+    }
+
+    strcpy(g_commandStatistics[g_numCommands].header, header);
+    return g_commandStatistics[g_numCommands++].statistics;
+}
+
+static void executeCommand(const char *command) {
+    g_scpiDataLen = 0;
+    g_scpiData[0] = 0;
+
+    // same as in SCPI thread, command takes I/O lock if it needs it,
+    // so measured latency includes waiting for the low priority thread job
+    uint32_t startTime = micros();
+    psu::scpi::input(g_scpiContext, command, strlen(command));
+    psu::scpi::input(g_scpiContext, "\r\n", 2);
+    uint32_t latency = micros() - startTime;
+
+    getCommandStatistics(command).add(latency);
+
+    if (g_scpiDataLen > 0) {
+        printf("%s", g_scpiData);
+        if (g_scpiData[g_scpiDataLen - 1] != '\n') {
+            printf("\n");
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef EEZ_PLATFORM_SIMULATOR_WIN32
+typedef SOCKET LoadSocket;
+#define INVALID_LOAD_SOCKET INVALID_SOCKET
+#define closeLoadSocket closesocket
+#else
+typedef int LoadSocket;
+#define INVALID_LOAD_SOCKET -1
+#define closeLoadSocket close
+#endif
+
+static LoadSocket connectToScpiServer() {
+    LoadSocket s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s == INVALID_LOAD_SOCKET) {
+        return INVALID_LOAD_SOCKET;
+    }
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(psu::persist_conf::devConf.ethernetScpiPort);
+    if (connect(s, (sockaddr *)&addr, sizeof(addr)) != 0) {
+        closeLoadSocket(s);
+        return INVALID_LOAD_SOCKET;
+    }
+
+    return s;
+}
+
+static bool sendLine(LoadSocket s, const char *line) {
+    char buffer[MAX_LINE_LENGTH + 1];
+    int len = snprintf(buffer, sizeof(buffer), "%s\n", line);
+    return send(s, buffer, len, 0) == len;
+}
+
+// reads (and drops) the response until the end of line
+static bool receiveLine(LoadSocket s) {
+    char buffer[256];
+    while (true) {
+        int len = (int)recv(s, buffer, sizeof(buffer), 0);
+        if (len <= 0) {
+            return false;
+        }
+        if (buffer[len - 1] == '\n') {
+            return true;
+        }
+    }
+}
+
+// Remote SCPI client, sends query count times over the ethernet SCPI server and
+// waits for each response, so the whole transport path (including output
+// buffer coalescing) is measured. Commands without '?' are not waited for,
+// at the end *OPC? is used to wait until they are all executed.
+static void runLoad(int lineNumber, const char *arg) {
+    char *query;
+    int count = (int)strtol(arg, &query, 10);
+    while (isspace(*query)) {
+        query++;
+    }
+
+    if (count <= 0 || !*query) {
+        printf("Script line %d: usage @LOAD <count> <query>\n", lineNumber);
+        return;
+    }
+
+    LoadSocket s = connectToScpiServer();
+    if (s == INVALID_LOAD_SOCKET) {
+        printf("Script line %d: can't connect to SCPI server\n", lineNumber);
+        g_numErrors++;
+        return;
+    }
+
+    bool isQuery = strchr(query, '?') != nullptr;
+    uint32_t numErrors = 0;
+
+    uint64_t startTime = micros64();
+
+    for (int i = 0; i < count && !g_shutdownInProgress; i++) {
+        if (!sendLine(s, query) || (isQuery && !receiveLine(s))) {
+            numErrors++;
+            break;
+        }
+    }
+
+    if (!sendLine(s, "*OPC?") || !receiveLine(s)) {
+        numErrors++;
+    }
+
+    uint64_t time = micros64() - startTime;
+
+    closeLoadSocket(s);
+
+    LoadStatistics *statistics = g_numLoads < MAX_LOADS ? &g_loadStatistics[g_numLoads++] : &g_loadStatistics[MAX_LOADS - 1];
+    strncpy(statistics->query, query, sizeof(statistics->query) - 1);
+    statistics->query[sizeof(statistics->query) - 1] = 0;
+    statistics->count = count;
+    statistics->numErrors = numErrors;
+    statistics->time = time;
+
+    g_numErrors += numErrors;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void printRunTimeStatistics(FILE *fp, const char *name, const RunTimeStatistics &statistics) {
+    if (statistics.count > 0) {
+        fprintf(fp, "%-32s count=%u avg=%u us max=%u us\n",
+            name,
+            (unsigned)statistics.count,
+            (unsigned)(statistics.totalRunTime / statistics.count),
+            (unsigned)statistics.maxRunTime);
+    }
+}
+
+static void printReport(FILE *fp) {
+    fprintf(fp, "# elapsed time: %u ms, SCPI errors: %u\n",
+        (unsigned)((micros64() - g_startTime) / 1000),
+        (unsigned)g_numErrors);
+
+    fprintf(fp, "# SCPI command latency\n");
+    for (int i = 0; i < g_numCommands; i++) {
+        printRunTimeStatistics(fp, g_commandStatistics[i].header, g_commandStatistics[i].statistics);
+    }
+
+    if (g_numLoads > 0) {
+        fprintf(fp, "# remote load\n");
+        for (int i = 0; i < g_numLoads; i++) {
+            auto &statistics = g_loadStatistics[i];
+            fprintf(fp, "%-32s count=%u errors=%u time=%u ms rate=%.0f queries/s\n",
+                statistics.query,
+                (unsigned)statistics.count,
+                (unsigned)statistics.numErrors,
+                (unsigned)(statistics.time / 1000),
+                statistics.time > 0 ? statistics.count * 1E6 / statistics.time : 0.0);
+        }
+    }
+
+    fprintf(fp, "# tick and frame duration\n");
+    printRunTimeStatistics(fp, "psu tick", getPsuTickStatistics());
+#if OPTION_DISPLAY
+    printRunTimeStatistics(fp, "gui frame", gui::getFrameStatistics());
+#endif
+
+    fprintf(fp, "# thread messages\n");
+    for (int type = 0; type < LOW_PRIORITY_THREAD_LAST_MESSAGE_TYPE; type++) {
+        auto &statistics = getMessageStatistics((LowPriorityThreadMessage)type);
+        if (statistics.count > 0) {
+            fprintf(fp, "%s %-40s count=%u wait_max=%u us avg=%u us max=%u us\n",
+                type < ETHERNET_LAST_MESSAGE_TYPE ? "scpi" : "low ",
+                getMessageName((LowPriorityThreadMessage)type),
+                (unsigned)statistics.count,
+                (unsigned)statistics.maxWaitTime,
+                (unsigned)(statistics.totalRunTime / statistics.count),
+                (unsigned)statistics.maxRunTime);
+        }
+    }
+
+    fprintf(fp, "# dlog\n");
+    using namespace psu;
+    fprintf(fp, "dlog state=%d length=%u bytes time=%.3f s rate=%.0f B/s\n",
+        (int)dlog_record::getState(),
+        (unsigned)dlog_record::g_fileLength,
+        dlog_record::g_currentTime,
+        dlog_record::g_currentTime > 0 ? dlog_record::g_fileLength / dlog_record::g_currentTime : 0.0);
+}
+
+static void report() {
+    printReport(stdout);
+
+    if (g_reportFilePath) {
+        FILE *fp = fopen(g_reportFilePath, "w");
+        if (fp) {
+            printReport(fp);
+            fclose(fp);
+        } else {
+            printf("Failed to write report file \"%s\"\n", g_reportFilePath);
+        }
+    }
+}
+
+// returns directive argument if line starts with given directive (case insensitive)
+static const char *matchDirective(const char *line, const char *directive) {
+    for (; *directive; line++, directive++) {
+        if (toupper(*line) != *directive) {
+            return nullptr;
+        }
+    }
+    return line;
+}
+
+static void runScript() {
+    int repeatLine[MAX_REPEAT_DEPTH];
+    int repeatCount[MAX_REPEAT_DEPTH];
+    int repeatDepth = 0;
+
+    for (int i = 0; i < g_numLines && !g_shutdownInProgress; i++) {
+        const char *line = g_lines[i];
+        const char *arg;
+
+        if ((arg = matchDirective(line, "@WAIT"))) {
+            osDelay(atoi(arg));
+        } else if ((arg = matchDirective(line, "@REPEAT"))) {
+            if (repeatDepth == MAX_REPEAT_DEPTH) {
+                printf("Script line %d: too many nested @REPEAT\n", i + 1);
+                return;
+            }
+            int count = atoi(arg);
+            if (count <= 0) {
+                // skip the body, i.e. continue after the matching @END
+                int repeatStartLine = i;
+                int depth = 1;
+                while (++i < g_numLines) {
+                    if (matchDirective(g_lines[i], "@REPEAT")) {
+                        depth++;
+                    } else if (matchDirective(g_lines[i], "@END") && --depth == 0) {
+                        break;
+                    }
+                }
+                if (depth > 0) {
+                    printf("Script line %d: @REPEAT without @END\n", repeatStartLine + 1);
+                    return;
+                }
+                continue;
+            }
+            repeatLine[repeatDepth] = i;
+            repeatCount[repeatDepth] = count;
+            repeatDepth++;
+        } else if (matchDirective(line, "@END")) {
+            if (repeatDepth == 0) {
+                printf("Script line %d: @END without @REPEAT\n", i + 1);
+                return;
+            }
+            if (--repeatCount[repeatDepth - 1] > 0) {
+                i = repeatLine[repeatDepth - 1];
+            } else {
+                repeatDepth--;
+            }
+        } else if (matchDirective(line, "@REPORT")) {
+            report();
+        } else if ((arg = matchDirective(line, "@LOAD"))) {
+            runLoad(i + 1, arg);
+        } else {
+            executeCommand(line);
+        }
+    }
+}
+
+void scriptThreadMainLoop(const void *) {
+    while (!g_isBooted) {
+        osDelay(10);
+    }
+
+    g_startTime = micros64();
+
+    runScript();
+
+    report();
+
+    if (g_exitWhenDone) {
+        eez::shutdown();
+    }
+
+    while (true) {
+        osDelay(1000);
+    }
+}
+
+void start() {
+    if (!g_scriptFilePath) {
+        return;
+    }
+
+    if (!loadScript()) {
+        return;
+    }
+
+    psu::scpi::init(g_scpiContext, g_scpiPsuContext, &g_scpiInterface, g_scpiInputBuffer, SCPI_PARSER_INPUT_BUFFER_LENGTH, g_errorQueueData, SCPI_PARSER_ERROR_QUEUE_SIZE + 1);
+
+    osThreadCreate(osThread(g_scriptTask), nullptr);
+}
+
+} // namespace benchmark
+} // namespace simulator
+} // namespace platform
+} // namespace eez
@@ -0,0 +1,63 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Runs SCPI script given on the simulator command line and prints timing report:
+//
+//     modular-psu-firmware --script load.scpi [--report report.txt] [--exit]
+//
+// Script is executed line by line after boot. Empty lines and lines starting
+// with # are skipped, other lines are SCPI commands, except these directives:
+//
+//     @WAIT <ms>       sleep
+//     @REPEAT <count>  repeat lines until matching @END
+//     @END
+//     @REPORT          print report now
+//     @LOAD <count> <query>
+//                      send query count times from a remote client
+//                      connected to the ethernet SCPI server and
+//                      report queries per second
+//
+// Report contains latency of each executed SCPI command header, PSU tick
+// and GUI frame duration, low priority and SCPI thread message statistics
+// and DLOG throughput, and the rate of each @LOAD. With --exit simulator
+// shuts down after the script.
+// Remote SCPI clients can still connect over ethernet (port 5025) while
+// the script is running.
+//
+// Script runs in real time, there is no virtual time: firmware threads are host
+// threads scheduled by the host OS, and a virtual clock would need cmsis_os layer
+// to schedule them itself. Timings therefore depend on the host and its load,
+// compare them against a baseline taken on the same host, with a margin.
+
+namespace eez {
+namespace platform {
+namespace simulator {
+namespace benchmark {
+
+// returns false if command line is invalid
+bool parseCommandLine(int argc, char **argv);
+
+// starts script thread, if script is given in command line
+void start();
+
+} // namespace benchmark
+} // namespace simulator
+} // namespace platform
+} // namespace eez
@@ -87,7 +87,11 @@ uint32_t osKernelSysTickFrequency;
 uint32_t osKernelSysTickFrequency = 1000000;
 #endif
 
-uint32_t osKernelSysTick() {
+// Initial kernel tick in milliseconds. It is 0 unless set from the command line
+// (--tick-start), which is used to test the 32-bit micros() wrap-around.
+uint64_t osKernelSysTickStart = 0;
+
+uint64_t osKernelSysTickMicros64() {
 #ifdef EEZ_PLATFORM_SIMULATOR_WIN32
     static bool isFirstTime = true;
     static LARGE_INTEGER frequency;
@@ -97,23 +101,40 @@ uint32_t osKernelSysTick() {
         isFirstTime = false;
         QueryPerformanceFrequency(&frequency);
         QueryPerformanceCounter(&startTime);
-        return 0;
+        return osKernelSysTickStart * 1000;
     } else {
         LARGE_INTEGER currentTime;
         QueryPerformanceCounter(&currentTime);
 
-        auto diff = (currentTime.QuadPart - startTime.QuadPart) * 1000 / frequency.QuadPart;
+        auto diff = (currentTime.QuadPart - startTime.QuadPart) * 1000000 / frequency.QuadPart;
 
-        return uint32_t(diff % 4294967296);
+        return osKernelSysTickStart * 1000 + diff;
     }
 #else
+    static bool isFirstTime = true;
+    static uint64_t startTime;
+
     timeval tv;
     gettimeofday(&tv, NULL);
     uint64_t micros = tv.tv_sec * (uint64_t)1000000 + tv.tv_usec;
-    return uint32_t((micros / 1000) % 4294967296);
+
+    if (isFirstTime) {
+        isFirstTime = false;
+        startTime = micros;
+    }
+
+    return osKernelSysTickStart * 1000 + (micros - startTime);
 #endif    
 }
 
+uint64_t osKernelSysTick64() {
+    return osKernelSysTickMicros64() / 1000;
+}
+
+uint32_t osKernelSysTick() {
+    return uint32_t(osKernelSysTick64() % 4294967296);
+}
+
 osMessageQId osMessageCreate(osMessageQId queue_id, osThreadId thread_id) {
     queue_id->tail = 0;
     queue_id->head = 0;
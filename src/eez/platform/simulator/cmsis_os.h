@@ -70,8 +70,12 @@ osStatus osKernelStart(void);
 osStatus osDelay(uint32_t millisec);
 
 uint32_t osKernelSysTick(void);
+uint64_t osKernelSysTick64(void);
+// simulator only, same time base as osKernelSysTick64 but in microseconds
+uint64_t osKernelSysTickMicros64(void);
 
 extern uint32_t osKernelSysTickFrequency;
+extern uint64_t osKernelSysTickStart;
 
 //
 
@@ -18,7 +18,9 @@
 
 #include <eez/platform/simulator/events.h>
 
+#if !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
 #include <SDL.h>
+#endif
 
 #include <eez/firmware.h>
 #include <eez/system.h>
@@ -38,6 +40,9 @@ int g_mouseButton1DownY;
 bool g_mouseButton1IsPressed;
 
 void readEvents() {
+#if defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+    // no window, input comes only from SCPI
+#else
     int yMouseWheel = 0;
     bool mouseButton2IsUp = false;
 
@@ -76,6 +81,7 @@ void readEvents() {
 #if OPTION_DISPLAY && OPTION_ENCODER
     mcu::encoder::write(yMouseWheel, mouseButton2IsUp);
 #endif
+#endif
 }
 
 } // namespace simulator
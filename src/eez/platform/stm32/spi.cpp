@@ -205,27 +205,27 @@ HAL_StatusTypeDef SPI_TransmitReceive(SPI_HandleTypeDef *hspi, uint8_t *pTxData,
 }
 
 HAL_StatusTypeDef transfer1(uint8_t slotIndex, uint8_t *input, uint8_t *output) {
-	return SPI_TransmitReceive(handle[slotIndex], input, output, 1);
+    return SPI_TransmitReceive(handle[slotIndex], input, output, 1);
 }
 
 HAL_StatusTypeDef transfer2(uint8_t slotIndex, uint8_t *input, uint8_t *output) {
-	return SPI_TransmitReceive(handle[slotIndex], input, output, 2);
+    return SPI_TransmitReceive(handle[slotIndex], input, output, 2);
 }
 
 HAL_StatusTypeDef transfer3(uint8_t slotIndex, uint8_t *input, uint8_t *output) {
-	return SPI_TransmitReceive(handle[slotIndex], input, output, 3);
+    return SPI_TransmitReceive(handle[slotIndex], input, output, 3);
 }
 
 HAL_StatusTypeDef transfer4(uint8_t slotIndex, uint8_t *input, uint8_t *output) {
-	return SPI_TransmitReceive(handle[slotIndex], input, output, 4);
+    return SPI_TransmitReceive(handle[slotIndex], input, output, 4);
 }
 
 HAL_StatusTypeDef transfer5(uint8_t slotIndex, uint8_t *input, uint8_t *output) {
-	return SPI_TransmitReceive(handle[slotIndex], input, output, 5);
+    return SPI_TransmitReceive(handle[slotIndex], input, output, 5);
 }
 
 HAL_StatusTypeDef transfer(uint8_t slotIndex, uint8_t *input, uint8_t *output, uint16_t size) {
-	return HAL_SPI_TransmitReceive(handle[slotIndex], input, output, size, 100);
+    return HAL_SPI_TransmitReceive(handle[slotIndex], input, output, size, 100);
 }
 
 HAL_StatusTypeDef transmit(uint8_t slotIndex, uint8_t *input, uint16_t size) {
@@ -240,49 +240,53 @@ HAL_StatusTypeDef transferDMA(uint8_t slotIndex, uint8_t *input, uint8_t *output
 } // namespace eez
 
 void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi) {
-	using namespace eez;
-	using namespace eez::spi;
-	using namespace eez::bp3c::comm;
+    using namespace eez;
+    using namespace eez::spi;
+    using namespace eez::bp3c::comm;
+
+    uint8_t slotIndex;
+    if (hspi == handle[0]) {
+        slotIndex = 0;
+    } else if (hspi == handle[1]) {
+        slotIndex = 1;
+    } else {
+        slotIndex = 2;
+    }
 
-	uint8_t slotIndex;
-	if (hspi == handle[0]) {
-		slotIndex = 0;
-	} else if (hspi == handle[1]) {
-		slotIndex = 1;
-	} else {
-		slotIndex = 2;
-	}
+    deselect(slotIndex);
 
-	deselect(slotIndex);
+    onTransferCompleted(slotIndex, TRANSFER_STATUS_OK);
 
-	auto &slot = *g_slots[slotIndex];
+    auto &slot = *g_slots[slotIndex];
 
-	slot.onSpiDmaTransferCompleted(TRANSFER_STATUS_OK);
+    slot.onSpiDmaTransferCompleted(TRANSFER_STATUS_OK);
 }
 
 void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi) {
-	using namespace eez;
-	using namespace eez::spi;
-	using namespace eez::bp3c::comm;
-
-	uint8_t slotIndex;
-	if (hspi == handle[0]) {
-		slotIndex = 0;
-	} else if (hspi == handle[1]) {
-		slotIndex = 1;
-	} else {
-		slotIndex = 2;
-	}
-
-	deselect(slotIndex);
-
-	auto &slot = *g_slots[slotIndex];
-
-	if (spi::handle[slotIndex]->ErrorCode == HAL_SPI_ERROR_CRC) {
-		slot.onSpiDmaTransferCompleted(TRANSFER_STATUS_CRC_ERROR);
-	} else {
-		slot.onSpiDmaTransferCompleted(TRANSFER_STATUS_ERROR);
-	}
+    using namespace eez;
+    using namespace eez::spi;
+    using namespace eez::bp3c::comm;
+
+    uint8_t slotIndex;
+    if (hspi == handle[0]) {
+        slotIndex = 0;
+    } else if (hspi == handle[1]) {
+        slotIndex = 1;
+    } else {
+        slotIndex = 2;
+    }
+
+    deselect(slotIndex);
+
+    auto &slot = *g_slots[slotIndex];
+
+    if (spi::handle[slotIndex]->ErrorCode == HAL_SPI_ERROR_CRC) {
+        onTransferCompleted(slotIndex, TRANSFER_STATUS_CRC_ERROR);
+        slot.onSpiDmaTransferCompleted(TRANSFER_STATUS_CRC_ERROR);
+    } else {
+        onTransferCompleted(slotIndex, TRANSFER_STATUS_ERROR);
+        slot.onSpiDmaTransferCompleted(TRANSFER_STATUS_ERROR);
+    }
 }
 
 #endif // EEZ_PLATFORM_STM32
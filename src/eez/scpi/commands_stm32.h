@@ -37,6 +37,13 @@
     SCPI_COMMAND("DIAGnostic[:INFOrmation]:PROTection?", scpi_cmd_diagnosticInformationProtectionQ) \
     SCPI_COMMAND("DIAGnostic[:INFOrmation]:TEST?", scpi_cmd_diagnosticInformationTestQ) \
     SCPI_COMMAND("DIAGnostic[:INFOrmation]:REGS?", scpi_cmd_diagnosticInformationRegsQ) \
+    SCPI_COMMAND("DIAGnostic[:INFOrmation]:TRANsfer?", scpi_cmd_diagnosticInformationTransferQ) \
+    SCPI_COMMAND("DIAGnostic[:INFOrmation]:TRIGger?", scpi_cmd_diagnosticInformationTriggerQ) \
+    SCPI_COMMAND("DIAGnostic[:INFOrmation]:TRIGger:CLEar", scpi_cmd_diagnosticInformationTriggerClear) \
+    SCPI_COMMAND("DIAGnostic[:INFOrmation]:SESSion?", scpi_cmd_diagnosticInformationSessionQ) \
+    SCPI_COMMAND("DIAGnostic[:INFOrmation]:DOWNload?", scpi_cmd_diagnosticInformationDownloadQ) \
+    SCPI_COMMAND("DIAGnostic[:INFOrmation]:UPLoad?", scpi_cmd_diagnosticInformationUploadQ) \
+    SCPI_COMMAND("DIAGnostic[:INFOrmation]:TASKs?", scpi_cmd_diagnosticInformationTasksQ) \
     SCPI_COMMAND("DISPlay:BRIGhtness", scpi_cmd_displayBrightness) \
     SCPI_COMMAND("DISPlay:BRIGhtness?", scpi_cmd_displayBrightnessQ) \
     SCPI_COMMAND("DISPlay:VIEW", scpi_cmd_displayView) \
@@ -55,6 +62,11 @@
     SCPI_COMMAND("DISPlay[:WINdow]:DIALog:DATA", scpi_cmd_displayWindowDialogData) \
     SCPI_COMMAND("DISPlay[:WINdow]:DIALog:CLOSe", scpi_cmd_displayWindowDialogClose) \
     SCPI_COMMAND("DISPlay[:WINdow]:ERRor", scpi_cmd_displayWindowError) \
+    SCPI_COMMAND("FETCh:ARRay[:VOLTage]?", scpi_cmd_fetchArrayVoltageQ) \
+    SCPI_COMMAND("FETCh:ARRay:CURRent?", scpi_cmd_fetchArrayCurrentQ) \
+    SCPI_COMMAND("FORMat[:DATA]", scpi_cmd_formatData) \
+    SCPI_COMMAND("FORMat[:DATA]?", scpi_cmd_formatDataQ) \
+    SCPI_COMMAND("INITiate:ACQuire", scpi_cmd_initiateAcquire) \
     SCPI_COMMAND("INITiate:CONTinuous", scpi_cmd_initiateContinuous) \
     SCPI_COMMAND("INITiate:CONTinuous?", scpi_cmd_initiateContinuousQ) \
     SCPI_COMMAND("INITiate:DLOG", scpi_cmd_initiateDlog) \
@@ -79,6 +91,8 @@
     SCPI_COMMAND("MEASure[:SCALar]:CURRent[:DC]?", scpi_cmd_measureScalarCurrentDcQ) \
     SCPI_COMMAND("MEASure[:SCALar]:POWer[:DC]?", scpi_cmd_measureScalarPowerDcQ) \
     SCPI_COMMAND("MEASure[:SCALar][:VOLTage][:DC]?", scpi_cmd_measureScalarVoltageDcQ) \
+    SCPI_COMMAND("MEASure:ARRay:CURRent?", scpi_cmd_measureArrayCurrentQ) \
+    SCPI_COMMAND("MEASure:ARRay[:VOLTage]?", scpi_cmd_measureArrayVoltageQ) \
     SCPI_COMMAND("MEMory:NSTates?", scpi_cmd_memoryNstatesQ) \
     SCPI_COMMAND("MEMory:STATe:CATalog?", scpi_cmd_memoryStateCatalogQ) \
     SCPI_COMMAND("MEMory:STATe:DELete", scpi_cmd_memoryStateDelete) \
@@ -129,6 +143,16 @@
     SCPI_COMMAND("OUTPut[:STATe]:TRIGgered?", scpi_cmd_outputStateTriggeredQ) \
     SCPI_COMMAND("OUTPut:DELay:DURation", scpi_cmd_outputDelayDuration) \
     SCPI_COMMAND("OUTPut:DELay:DURation?", scpi_cmd_outputDelayDurationQ) \
+    SCPI_COMMAND("SENSe:AVERage:COUNt", scpi_cmd_senseAverageCount) \
+    SCPI_COMMAND("SENSe:AVERage:COUNt?", scpi_cmd_senseAverageCountQ) \
+    SCPI_COMMAND("SENSe:AVERage:TYPE", scpi_cmd_senseAverageType) \
+    SCPI_COMMAND("SENSe:AVERage:TYPE?", scpi_cmd_senseAverageTypeQ) \
+    SCPI_COMMAND("SENSe:AINPut:AVERage", scpi_cmd_senseAinputAverage) \
+    SCPI_COMMAND("SENSe:AINPut:AVERage?", scpi_cmd_senseAinputAverageQ) \
+    SCPI_COMMAND("SENSe:AINPut:RATE?", scpi_cmd_senseAinputRateQ) \
+    SCPI_COMMAND("SENSe:AINPut:DATA?", scpi_cmd_senseAinputDataQ) \
+    SCPI_COMMAND("SENSe:AINPut:DLOG", scpi_cmd_senseAinputDlog) \
+    SCPI_COMMAND("SENSe:AINPut:DLOG?", scpi_cmd_senseAinputDlogQ) \
     SCPI_COMMAND("SENSe:CURRent[:DC]:RANGe[:UPPer]", scpi_cmd_senseCurrentDcRangeUpper) \
     SCPI_COMMAND("SENSe:CURRent[:DC]:RANGe[:UPPer]?", scpi_cmd_senseCurrentDcRangeUpperQ) \
     SCPI_COMMAND("SENSe:DLOG:FUNCtion:CURRent", scpi_cmd_senseDlogFunctionCurrent) \
@@ -166,6 +190,10 @@
     SCPI_COMMAND("SENSe:DLOG:TRACe[:DATA]", scpi_cmd_senseDlogTraceData) \
     SCPI_COMMAND("SENSe:DLOG:TRACe:REMark", scpi_cmd_senseDlogTraceRemark) \
     SCPI_COMMAND("SENSe:DLOG:TRACe:REMark?", scpi_cmd_senseDlogTraceRemarkQ) \
+    SCPI_COMMAND("SENSe:SWEep:POINts", scpi_cmd_senseSweepPoints) \
+    SCPI_COMMAND("SENSe:SWEep:POINts?", scpi_cmd_senseSweepPointsQ) \
+    SCPI_COMMAND("SENSe:SWEep:TINTerval", scpi_cmd_senseSweepTinterval) \
+    SCPI_COMMAND("SENSe:SWEep:TINTerval?", scpi_cmd_senseSweepTintervalQ) \
     SCPI_COMMAND("[SOURce#]:CURRent:LIMit[:POSitive][:IMMediate][:AMPLitude]", scpi_cmd_sourceCurrentLimitPositiveImmediateAmplitude) \
     SCPI_COMMAND("[SOURce#]:CURRent:LIMit[:POSitive][:IMMediate][:AMPLitude]?", scpi_cmd_sourceCurrentLimitPositiveImmediateAmplitudeQ) \
     SCPI_COMMAND("[SOURce#]:CURRent:MODE", scpi_cmd_sourceCurrentMode) \
@@ -260,6 +288,8 @@
     SCPI_COMMAND("SYSTem:SLOT:MODel?", scpi_cmd_systemSlotModelQ) \
     SCPI_COMMAND("SYSTem:SLOT:VERSion?", scpi_cmd_systemSlotVersionQ) \
     SCPI_COMMAND("SYSTem:SLOT:FIRMware?", scpi_cmd_systemSlotFirmwareQ) \
+    SCPI_COMMAND("SYSTem:SLOT:KEEPalive", scpi_cmd_systemSlotKeepalive) \
+    SCPI_COMMAND("SYSTem:SLOT:KEEPalive?", scpi_cmd_systemSlotKeepaliveQ) \
     SCPI_COMMAND("SYSTem:CHANnel:INFOrmation:CURRent?", scpi_cmd_systemChannelInformationCurrentQ) \
     SCPI_COMMAND("SYSTem:CHANnel:INFOrmation:ONTime:LAST?", scpi_cmd_systemChannelInformationOntimeLastQ) \
     SCPI_COMMAND("SYSTem:CHANnel:INFOrmation:ONTime:TOTal?", scpi_cmd_systemChannelInformationOntimeTotalQ) \
@@ -342,6 +372,8 @@
     SCPI_COMMAND("SYSTem:TEMPerature:PROTection[:HIGH]:TRIPped?", scpi_cmd_systemTemperatureProtectionHighTrippedQ) \
     SCPI_COMMAND("SYSTem:TEMPerature:PROTection[:HIGH][:LEVel]", scpi_cmd_systemTemperatureProtectionHighLevel) \
     SCPI_COMMAND("SYSTem:TEMPerature:PROTection[:HIGH][:LEVel]?", scpi_cmd_systemTemperatureProtectionHighLevelQ) \
+    SCPI_COMMAND("SYSTem:TEMPerature:FILTer[:TIME]", scpi_cmd_systemTemperatureFilterTime) \
+    SCPI_COMMAND("SYSTem:TEMPerature:FILTer[:TIME]?", scpi_cmd_systemTemperatureFilterTimeQ) \
     SCPI_COMMAND("SYSTem:TIME", scpi_cmd_systemTime) \
     SCPI_COMMAND("SYSTem:TIME:DST", scpi_cmd_systemTimeDst) \
     SCPI_COMMAND("SYSTem:TIME:DST?", scpi_cmd_systemTimeDstQ) \
@@ -354,6 +386,8 @@
     SCPI_COMMAND("SYSTem:MEASure[:SCALar]:TEMPerature[:THERmistor][:DC]?", scpi_cmd_systemMeasureScalarTemperatureThermistorDcQ) \
     SCPI_COMMAND("SYSTem:MEASure[:SCALar][:VOLTage][:DC]?", scpi_cmd_systemMeasureScalarVoltageDcQ) \
     SCPI_COMMAND("SYSTem:CPU:SNO?", scpi_cmd_systemCpuSnoQ) \
+    SCPI_COMMAND("TRIGger:ACQuire:SOURce", scpi_cmd_triggerAcquireSource) \
+    SCPI_COMMAND("TRIGger:ACQuire:SOURce?", scpi_cmd_triggerAcquireSourceQ) \
     SCPI_COMMAND("TRIGger:DLOG:SOURce", scpi_cmd_triggerDlogSource) \
     SCPI_COMMAND("TRIGger:DLOG:SOURce?", scpi_cmd_triggerDlogSourceQ) \
     SCPI_COMMAND("TRIGger:DLOG[:IMMediate]", scpi_cmd_triggerDlogImmediate) \
@@ -384,10 +418,15 @@
     SCPI_COMMAND("SIMUlator:RPOL?", scpi_cmd_simulatorRpolQ) \
     SCPI_COMMAND("SIMUlator:TEMPerature", scpi_cmd_simulatorTemperature) \
     SCPI_COMMAND("SIMUlator:TEMPerature?", scpi_cmd_simulatorTemperatureQ) \
+    SCPI_COMMAND("SIMUlator:TEMPerature:PLANt", scpi_cmd_simulatorTemperaturePlant) \
+    SCPI_COMMAND("SIMUlator:TEMPerature:PLANt?", scpi_cmd_simulatorTemperaturePlantQ) \
     SCPI_COMMAND("SIMUlator:VOLTage:PROGram:EXTernal", scpi_cmd_simulatorVoltageProgramExternal) \
     SCPI_COMMAND("SIMUlator:VOLTage:PROGram:EXTernal?", scpi_cmd_simulatorVoltageProgramExternalQ) \
     SCPI_COMMAND("DEBUg", scpi_cmd_debug) \
     SCPI_COMMAND("DEBUg:ONTime?", scpi_cmd_debugOntimeQ) \
+    SCPI_COMMAND("DEBUg:ONTime:JOURnal?", scpi_cmd_debugOntimeJournalQ) \
+    SCPI_COMMAND("DEBUg:ONTime:INTerval", scpi_cmd_debugOntimeInterval) \
+    SCPI_COMMAND("DEBUg:ONTime:INTerval?", scpi_cmd_debugOntimeIntervalQ) \
     SCPI_COMMAND("DEBUg:VOLTage", scpi_cmd_debugVoltage) \
     SCPI_COMMAND("DEBUg:CURRent", scpi_cmd_debugCurrent) \
     SCPI_COMMAND("DEBUg:MEASure:VOLTage", scpi_cmd_debugMeasureVoltage) \
@@ -396,11 +435,24 @@
     SCPI_COMMAND("DEBUg:FAN?", scpi_cmd_debugFanQ) \
     SCPI_COMMAND("DEBUg:FAN:PID", scpi_cmd_debugFanPid) \
     SCPI_COMMAND("DEBUg:FAN:PID?", scpi_cmd_debugFanPidQ) \
+    SCPI_COMMAND("DEBUg:FAN:MODel", scpi_cmd_debugFanModel) \
+    SCPI_COMMAND("DEBUg:FAN:MODel?", scpi_cmd_debugFanModelQ) \
+    SCPI_COMMAND("DEBUg:FAN:COMPare?", scpi_cmd_debugFanCompareQ) \
     SCPI_COMMAND("DEBUg:CSV?", scpi_cmd_debugCsvQ) \
     SCPI_COMMAND("DEBUg:IOEXp", scpi_cmd_debugIoexp) \
     SCPI_COMMAND("DEBUg:IOEXp?", scpi_cmd_debugIoexpQ) \
     SCPI_COMMAND("DEBUg:DCM220?", scpi_cmd_debugDcm220Q) \
     SCPI_COMMAND("DEBUg:DOWNload:FIRMware", scpi_cmd_debugDownloadFirmware) \
     SCPI_COMMAND("DEBUg:EVENt", scpi_cmd_debugEvent) \
+    SCPI_COMMAND("DEBUg:FTOA?", scpi_cmd_debugFtoaQ) \
+    SCPI_COMMAND("DEBUg:CALibration:TABle?", scpi_cmd_debugCalibrationTableQ) \
+    SCPI_COMMAND("DEBUg:DISPatch?", scpi_cmd_debugDispatchQ) \
+    SCPI_COMMAND("DEBUg:COMPositor?", scpi_cmd_debugCompositorQ) \
+    SCPI_COMMAND("DEBUg:DMA2D?", scpi_cmd_debugDma2dQ) \
+    SCPI_COMMAND("DEBUg:LAYers?", scpi_cmd_debugLayersQ) \
+    SCPI_COMMAND("DEBUg:MICRos?", scpi_cmd_debugMicrosQ) \
+    SCPI_COMMAND("DEBUg:PROTection?", scpi_cmd_debugProtectionQ) \
+    SCPI_COMMAND("DEBUg:KEEPalive?", scpi_cmd_debugKeepaliveQ) \
+    SCPI_COMMAND("DEBUg:UPLoad?", scpi_cmd_debugUploadQ) \
     SCPI_COMMAND("SYSTem:DATE:CLEar", scpi_cmd_systemDateClear) \
     SCPI_COMMAND("SYSTem:TIME:CLEar", scpi_cmd_systemTimeClear)
@@ -35,7 +35,9 @@ void scpi_reg_set(scpi_reg_name_t name, scpi_reg_val_t val) {
     }
 #if OPTION_ETHERNET
     if (ethernet::g_testResult == TEST_OK) {
-        SCPI_RegSet(&ethernet::g_scpiContext, name, val);
+        for (int sessionIndex = 0; sessionIndex < ETHERNET_MAX_SESSIONS; sessionIndex++) {
+            SCPI_RegSet(&ethernet::g_scpiContext[sessionIndex], name, val);
+        }
     }
 #endif
 }
@@ -227,7 +229,9 @@ void reg_set(scpi_psu_reg_name_t name, scpi_reg_val_t val) {
     }
 #if OPTION_ETHERNET
     if (ethernet::g_testResult == TEST_OK) {
-        reg_set(&ethernet::g_scpiContext, name, val);
+        for (int sessionIndex = 0; sessionIndex < ETHERNET_MAX_SESSIONS; sessionIndex++) {
+            reg_set(&ethernet::g_scpiContext[sessionIndex], name, val);
+        }
     }
 #endif
 }
@@ -238,7 +242,9 @@ void reg_set_esr_bits(int bit_mask) {
     }
 #if OPTION_ETHERNET
     if (ethernet::g_testResult == TEST_OK) {
-        SCPI_RegSetBits(&ethernet::g_scpiContext, SCPI_REG_ESR, bit_mask);
+        for (int sessionIndex = 0; sessionIndex < ETHERNET_MAX_SESSIONS; sessionIndex++) {
+            SCPI_RegSetBits(&ethernet::g_scpiContext[sessionIndex], SCPI_REG_ESR, bit_mask);
+        }
     }
 #endif
 }
@@ -266,7 +272,9 @@ void reg_set_ques_bit(int bit_mask, bool on) {
     }
 #if OPTION_ETHERNET
     if (ethernet::g_testResult == TEST_OK) {
-        reg_set_ques_bit(&ethernet::g_scpiContext, bit_mask, on);
+        for (int sessionIndex = 0; sessionIndex < ETHERNET_MAX_SESSIONS; sessionIndex++) {
+            reg_set_ques_bit(&ethernet::g_scpiContext[sessionIndex], bit_mask, on);
+        }
     }
 #endif
 }
@@ -296,7 +304,9 @@ void reg_set_ques_isum_bit(int iChannel, int bit_mask, bool on) {
     }
 #if OPTION_ETHERNET
     if (ethernet::g_testResult == TEST_OK) {
-        reg_set_ques_isum_bit(&ethernet::g_scpiContext, iChannel, bit_mask, on);
+        for (int sessionIndex = 0; sessionIndex < ETHERNET_MAX_SESSIONS; sessionIndex++) {
+            reg_set_ques_isum_bit(&ethernet::g_scpiContext[sessionIndex], iChannel, bit_mask, on);
+        }
     }
 #endif
 }
@@ -324,7 +334,9 @@ void reg_set_oper_bit(int bit_mask, bool on) {
     }
 #if OPTION_ETHERNET
     if (ethernet::g_testResult == TEST_OK) {
-        reg_set_oper_bit(&ethernet::g_scpiContext, bit_mask, on);
+        for (int sessionIndex = 0; sessionIndex < ETHERNET_MAX_SESSIONS; sessionIndex++) {
+            reg_set_oper_bit(&ethernet::g_scpiContext[sessionIndex], bit_mask, on);
+        }
     }
 #endif
 }
@@ -355,7 +367,9 @@ void reg_set_oper_isum_bit(int iChannel, int bit_mask, bool on) {
     }
 #if OPTION_ETHERNET
     if (ethernet::g_testResult == TEST_OK) {
-        reg_set_oper_isum_bit(&ethernet::g_scpiContext, iChannel, bit_mask, on);
+        for (int sessionIndex = 0; sessionIndex < ETHERNET_MAX_SESSIONS; sessionIndex++) {
+            reg_set_oper_isum_bit(&ethernet::g_scpiContext[sessionIndex], iChannel, bit_mask, on);
+        }
     }
 #endif
 }
@@ -33,6 +33,7 @@ void resetContext(scpi_t *context) {
     auto psuContext = (eez::psu::scpi::scpi_psu_t *)context->user_context;
     psuContext->selectedChannels = 1 << 0; // first channel is selected by default
     psuContext->currentDirectory[0] = 0;
+    psuContext->dataFormat = eez::psu::scpi::DATA_FORMAT_ASCII;
     SCPI_ErrorClear(context);
 }
 
@@ -44,7 +45,9 @@ void resetContext() {
 
 #if OPTION_ETHERNET
     if (psu::ethernet::g_testResult == TEST_OK) {
-        scpi::resetContext(&psu::ethernet::g_scpiContext);
+        for (int sessionIndex = 0; sessionIndex < ETHERNET_MAX_SESSIONS; sessionIndex++) {
+            scpi::resetContext(&psu::ethernet::g_scpiContext[sessionIndex]);
+        }
     }
 #endif
 }
@@ -55,7 +58,9 @@ void generateError(int error) {
     }
 #if OPTION_ETHERNET
     if (psu::ethernet::g_testResult == TEST_OK) {
-        SCPI_ErrorPush(&psu::ethernet::g_scpiContext, error);
+        for (int sessionIndex = 0; sessionIndex < ETHERNET_MAX_SESSIONS; sessionIndex++) {
+            SCPI_ErrorPush(&psu::ethernet::g_scpiContext[sessionIndex], error);
+        }
     }
 #endif
     psu::event_queue::pushEvent(error);
@@ -25,8 +25,10 @@
 #include <cmath>
 #include <queue>
 #include <stdio.h>
+#if !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
 #include <SDL.h>
 #include <SDL_audio.h>
+#endif
 
 #elif defined(EEZ_PLATFORM_STM32)
 
@@ -1477,7 +1479,11 @@ static uint32_t g_currentTuneStartPlayTime;
 #if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
 static const uint32_t g_memoryForTuneSamplesSize = 256000;
 int16_t g_memoryForTuneSamples[g_memoryForTuneSamplesSize];
+#if defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+static const uint32_t g_audioDevice = 0; // no audio, tunes are never played
+#else
 SDL_AudioDeviceID g_audioDevice;
+#endif
 #elif defined(EEZ_PLATFORM_STM32)
 static const uint32_t g_memoryForTuneSamplesSize = SOUND_TUNES_MEMORY_SIZE;
 uint8_t *g_memoryForTuneSamples = SOUND_TUNES_MEMORY;
@@ -1545,7 +1551,7 @@ void init() {
 	initTune(g_tunes[POWER_UP_TUNE]);
 #endif
 
-#if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
+#if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__) && !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
 	SDL_InitSubSystem(SDL_INIT_AUDIO);
 
 	SDL_AudioSpec desiredSpec;
@@ -1571,8 +1577,10 @@ void startPlay(int iTune) {
     Tune &tuneDef = g_tunes[iTune];
 	initTune(tuneDef);
 #if defined(EEZ_PLATFORM_SIMULATOR)
+#if !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
     SDL_QueueAudio(g_audioDevice, tuneDef.pSamples, tuneDef.numSamples * 2);
     SDL_PauseAudioDevice(g_audioDevice, 0);
+#endif
 #elif defined(EEZ_PLATFORM_STM32)
 	HAL_DAC_Stop_DMA(&hdac, DAC_CHANNEL_1);
 	HAL_TIM_Base_Stop(&htim6);
@@ -22,6 +22,7 @@
 
 #if defined(EEZ_PLATFORM_STM32)
 volatile uint32_t g_tickCount;
+volatile uint32_t g_tickCountHigh;
 #endif
 
 namespace eez {
@@ -58,10 +59,99 @@ uint32_t micros() {
 #endif
 
 #if defined(EEZ_PLATFORM_SIMULATOR)
-	return osKernelSysTick() * 1000;
+	return uint32_t(osKernelSysTickMicros64() % 4294967296);
 #endif
 }
 
+uint64_t micros64() {
+#if defined(EEZ_PLATFORM_STM32)
+    uint32_t high;
+    uint32_t low;
+    uint32_t cnt;
+    do {
+        high = g_tickCountHigh;
+        low = g_tickCount;
+        cnt = TIM7->CNT;
+    } while (low != g_tickCount || high != g_tickCountHigh);
+    return ((((uint64_t)high) << 32) | low) * 200 + 2 * cnt;
+#endif
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    return osKernelSysTickMicros64();
+#endif
+}
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+
+// Samples micros() and micros64() until micros() wraps around (at most timeout
+// milliseconds) and checks that micros64() keeps counting through the wrap.
+// Simulator has to be started with --tick-start close to 4294967 ms.
+bool micros64SelfTest(uint32_t timeout, char *message, int messageSize) {
+    uint64_t start64 = micros64();
+    uint32_t start = micros();
+
+    uint64_t prev64 = start64;
+    uint32_t prev = start;
+    uint64_t wrap64 = 0;
+    uint32_t numWraps = 0;
+    uint32_t numSamples = 0;
+
+    while (true) {
+        uint64_t t64 = micros64();
+        uint32_t t = micros();
+        numSamples++;
+
+        // micros() is read after micros64(), it can only be a little bit ahead
+        if (t - (uint32_t)t64 > 1000) {
+            snprintf(message, messageSize, "low word %u != %u", (unsigned)(uint32_t)t64, (unsigned)t);
+            return false;
+        }
+
+        if (t64 < prev64) {
+            snprintf(message, messageSize, "micros64 went back by %u us", (unsigned)(prev64 - t64));
+            return false;
+        }
+
+        if (t < prev) {
+            if (numWraps++ == 0) {
+                wrap64 = t64;
+            }
+        }
+
+        // elapsed time from micros64() must match 32-bit elapsed time plus the wraps
+        uint64_t elapsed64 = t64 - start64;
+        uint64_t elapsed = (((uint64_t)numWraps) << 32) + t - start;
+        int64_t diff = (int64_t)(elapsed - elapsed64);
+        if (diff > 1000 || diff < -1000) {
+            snprintf(message, messageSize, "elapsed %u us != %u us", (unsigned)elapsed64, (unsigned)elapsed);
+            return false;
+        }
+
+        prev64 = t64;
+        prev = t;
+
+        if (numWraps > 0 && t64 - wrap64 >= 100000) {
+            break;
+        }
+
+        if (elapsed64 >= timeout * (uint64_t)1000) {
+            break;
+        }
+
+        delay(1);
+    }
+
+    if (numWraps != 1) {
+        snprintf(message, messageSize, "wraps=%u in %u ms, micros=%u", (unsigned)numWraps, (unsigned)timeout, (unsigned)prev);
+        return false;
+    }
+
+    snprintf(message, messageSize, "wraps=%u samples=%u micros64=%llu", (unsigned)numWraps, (unsigned)numSamples, (unsigned long long)prev64);
+    return true;
+}
+
+#endif
+
 void delayMicroseconds(uint32_t microseconds) {
 #if defined(EEZ_PLATFORM_STM32)
 	while (microseconds--) {
@@ -26,6 +26,7 @@
 #include <iwdg.h>
 #define WATCHDOG_RESET(...) HAL_IWDG_Refresh(&hiwdg)
 extern volatile uint32_t g_tickCount;
+extern volatile uint32_t g_tickCountHigh;
 #else
 #define WATCHDOG_RESET(...) 0
 #endif
@@ -33,10 +34,32 @@ extern volatile uint32_t g_tickCount;
 namespace eez {
 
 uint32_t micros();
+// Monotonic microseconds counter that never wraps around.
+// Lower 32 bits are the same as returned by micros().
+uint64_t micros64();
 uint32_t millis();
 void delay(uint32_t millis);
 void delayMicroseconds(uint32_t microseconds);
 
+#if defined(EEZ_PLATFORM_SIMULATOR)
+bool micros64SelfTest(uint32_t timeout, char *message, int messageSize);
+#endif
+
+// Duration statistics of a periodically executed piece of code (tick, frame, ...)
+struct RunTimeStatistics {
+    uint32_t count;
+    uint32_t maxRunTime; // us
+    uint64_t totalRunTime; // us
+
+    void add(uint32_t runTime) {
+        count++;
+        totalRunTime += runTime;
+        if (runTime > maxRunTime) {
+            maxRunTime = runTime;
+        }
+    }
+};
+
 const char *getSerialNumber();
 
 } // namespace eez
@@ -59,6 +59,12 @@ namespace eez {
 #define QUEUE_MESSAGE_TYPE(message) ((message) & 0xFF)
 #define QUEUE_MESSAGE_PARAM(param) ((message) >> 8)
 
+// SCPI queue message params are 8 bit wide, the rest of the param holds 16 bits
+// of the time message was put into the queue, in 256 us units (wraps after 16.7 s),
+// so the time spent in the queue can be measured
+#define SCPI_QUEUE_TIME_SHIFT 8
+#define SCPI_QUEUE_MESSAGE_PARAM(time, param) (((((time) >> SCPI_QUEUE_TIME_SHIFT) & 0xFFFF) << 8) | ((param) & 0xFF))
+
 ////////////////////////////////////////////////////////////////////////////////
 
 void highPriorityThreadMainLoop(const void *);
@@ -110,8 +116,49 @@ osMessageQId g_lowPriorityMessageQueueId;
 static bool g_shutingDown;
 static bool g_isLowPriorityThreadAlive;
 
+struct PendingMessage {
+    uint32_t message;
+    uint32_t time; // micros, when taken from the queue
+};
+
+static PendingMessage g_pendingMessages[LOW_PRIORITY_THREAD_QUEUE_SIZE];
+static int g_numPendingMessages;
+
 char g_listFilePath[CH_MAX][MAX_PATH_LENGTH];
 bool g_screenshotGenerating;
+volatile bool g_screenshotEncoding;
+
+////////////////////////////////////////////////////////////////////////////////
+
+void scpiThreadMainLoop(const void *);
+
+osThreadId g_scpiTaskHandle;
+
+#if defined(EEZ_PLATFORM_STM32)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wwrite-strings"
+#endif
+
+osThreadDef(g_scpiTask, scpiThreadMainLoop, osPriorityNormal, 0, 8192);
+
+#if defined(EEZ_PLATFORM_STM32)
+#pragma GCC diagnostic pop
+#endif
+
+osMessageQDef(g_scpiMessageQueue, SCPI_THREAD_QUEUE_SIZE, uint32_t);
+osMessageQId g_scpiMessageQueueId;
+
+// held by SCPI thread while executing SCPI commands and by low priority (I/O) thread while executing a job
+osMutexDef(g_ioMutex);
+osMutexId(g_ioMutexId);
+static volatile osThreadId g_ioMutexOwner;
+static volatile bool g_isScpiThreadWaitingForIo;
+// time spent waiting for the I/O lock while serving the current message
+static uint32_t g_scpiThreadIoLockWaitTime;
+static uint32_t g_lowPriorityThreadIoLockWaitTime;
+
+static MessageStatistics g_messageStatistics[LOW_PRIORITY_THREAD_LAST_MESSAGE_TYPE];
+static RunTimeStatistics g_psuTickStatistics;
 
 static uint32_t g_timer1LastTickCount;
 
@@ -148,14 +195,23 @@ void highPriorityThreadOneIter() {
         psu::onThreadMessage(type, param);
     } else {
         WATCHDOG_RESET();
+
+        uint32_t startTime = micros();
+
         for (int i = 0; i < NUM_SLOTS; i++) {
             g_slots[i]->tick();
         }
 
         psu::tick();
+
+        g_psuTickStatistics.add(micros() - startTime);
     }
 }
 
+const RunTimeStatistics &getPsuTickStatistics() {
+    return g_psuTickStatistics;
+}
+
 bool isPsuThread() {
     return !g_isBooted || osThreadGetId() == g_highPriorityThreadHandle;
 }
@@ -168,12 +224,341 @@ void sendMessageToPsu(HighPriorityThreadMessage messageType, uint32_t messagePar
 
 void initLowPriorityMessageQueue() {
     g_lowPriorityMessageQueueId = osMessageCreate(osMessageQ(g_lowPriorityMessageQueue), NULL);
+    g_scpiMessageQueueId = osMessageCreate(osMessageQ(g_scpiMessageQueue), NULL);
+    g_ioMutexId = osMutexCreate(osMutex(g_ioMutex));
 }
 
 void startLowPriorityThread() {
     g_isLowPriorityThreadAlive = true;
     g_timer1LastTickCount = micros();
     g_lowPriorityTaskHandle = osThreadCreate(osThread(g_lowPriorityTask), nullptr);
+    g_scpiTaskHandle = osThreadCreate(osThread(g_scpiTask), nullptr);
+}
+
+void lockIo() {
+    osThreadId threadId = osThreadGetId();
+    bool isScpiThread = threadId == g_scpiTaskHandle;
+
+    if (isScpiThread) {
+        g_isScpiThreadWaitingForIo = true;
+    }
+
+    uint32_t startTime = micros();
+    osMutexWait(g_ioMutexId, osWaitForever);
+    uint32_t waitTime = micros() - startTime;
+
+    if (isScpiThread) {
+        g_isScpiThreadWaitingForIo = false;
+        g_scpiThreadIoLockWaitTime += waitTime;
+    } else if (threadId == g_lowPriorityTaskHandle) {
+        g_lowPriorityThreadIoLockWaitTime += waitTime;
+    }
+
+    g_ioMutexOwner = threadId;
+}
+
+void unlockIo() {
+    g_ioMutexOwner = 0;
+    osMutexRelease(g_ioMutexId);
+}
+
+bool isIoLocked() {
+    return g_ioMutexOwner == osThreadGetId();
+}
+
+void yieldIo() {
+    if (!g_isScpiThreadWaitingForIo || osThreadGetId() != g_lowPriorityTaskHandle || !isIoLocked()) {
+        return;
+    }
+
+    unlockIo();
+
+    // mutex is not handed over on release, so wait until the SCPI thread takes it
+    while (g_isScpiThreadWaitingForIo) {
+        osDelay(1);
+    }
+
+    lockIo();
+}
+
+void delayWithoutIoLock(uint32_t ms) {
+    if (isIoLocked()) {
+        unlockIo();
+        osDelay(ms);
+        lockIo();
+    } else {
+        osDelay(ms);
+    }
+}
+
+static void updateMessageStatistics(uint32_t type, uint32_t waitTime, uint32_t ioLockWaitTime, uint32_t runTime) {
+    auto &statistics = g_messageStatistics[type];
+    statistics.count++;
+    if (waitTime > statistics.maxWaitTime) {
+        statistics.maxWaitTime = waitTime;
+    }
+    if (ioLockWaitTime > statistics.maxIoLockWaitTime) {
+        statistics.maxIoLockWaitTime = ioLockWaitTime;
+    }
+    statistics.totalRunTime += runTime;
+    if (runTime > statistics.maxRunTime) {
+        statistics.maxRunTime = runTime;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void scpiThreadOneIter();
+
+void scpiThreadMainLoop(const void *) {
+#ifdef __EMSCRIPTEN__
+    if (g_isLowPriorityThreadAlive) {
+        scpiThreadOneIter();
+    }
+#else
+    g_scpiTaskHandle = osThreadGetId();
+
+    while (g_isLowPriorityThreadAlive) {
+        scpiThreadOneIter();
+    }
+
+    while (true) {
+        osDelay(1);
+    }
+#endif
+}
+
+void scpiThreadOneIter() {
+    using namespace psu;
+
+    osEvent event = osMessageGet(g_scpiMessageQueueId, 25);
+    if (event.status != osEventMessage || g_shutingDown) {
+        return;
+    }
+
+    uint32_t startTime = micros();
+
+    uint32_t message = event.value.v;
+    uint32_t type = QUEUE_MESSAGE_TYPE(message);
+    uint32_t param = QUEUE_MESSAGE_PARAM(message);
+
+    uint32_t queueTime = (param >> 8) << SCPI_QUEUE_TIME_SHIFT;
+    uint32_t waitTime = (startTime - queueTime) & ((0xFFFF << SCPI_QUEUE_TIME_SHIFT) | ((1 << SCPI_QUEUE_TIME_SHIFT) - 1));
+    param &= 0xFF;
+
+    // I/O lock is not taken here, SCPI command takes it only if it can access
+    // something low priority thread works with (see psu::scpi::executeCommand)
+    g_scpiThreadIoLockWaitTime = 0;
+
+    if (type < SERIAL_LAST_MESSAGE_TYPE) {
+        serial::onQueueMessage(type, param);
+    }
+#if OPTION_ETHERNET
+    else if (type < ETHERNET_LAST_MESSAGE_TYPE) {
+        ethernet::onQueueMessage(type, param);
+    }
+#endif
+
+    updateMessageStatistics(type, waitTime, g_scpiThreadIoLockWaitTime, micros() - startTime);
+}
+
+bool isScpiThread() {
+    return osThreadGetId() == g_scpiTaskHandle;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Jobs which user (or remote client) is actively waiting for are served
+// before long running background jobs.
+static int getMessagePriority(uint32_t type) {
+    if (
+        type == THREAD_MESSAGE_SHUTDOWN ||
+        type == THREAD_MESSAGE_SD_DETECT_IRQ ||
+        type == THREAD_MESSAGE_ABORT_DOWNLOADING ||
+        type == THREAD_MESSAGE_DOWNLOAD_WRITE ||
+        type == THREAD_MESSAGE_SOUND_TICK ||
+        type == THREAD_MESSAGE_SELECT_USB_MODE ||
+        type == THREAD_MESSAGE_SELECT_USB_DEVICE_CLASS
+    ) {
+        return 2;
+    }
+
+    if (
+        type == THREAD_MESSAGE_SCREENSHOT ||
+        type == THREAD_MESSAGE_FILE_MANAGER_LOAD_DESCRIPTIONS ||
+        type == THREAD_MESSAGE_FILE_MANAGER_LOAD_THUMBNAILS ||
+        type == THREAD_MESSAGE_DLOG_UPLOAD_FILE ||
+        type == THREAD_MESSAGE_FLASH_SLAVE_UPLOAD_HEX_FILE
+    ) {
+        return 0;
+    }
+
+    return 1;
+}
+
+static void onLowPriorityThreadMessage(uint32_t type, uint32_t param) {
+    using namespace psu;
+
+    if (type < MP_LAST_MESSAGE_TYPE) {
+        mp::onQueueMessage(type, param);
+        return;
+    }
+
+    if (type == THREAD_MESSAGE_SAVE_LIST) {
+        int err;
+        if (!list::saveList(param, &g_listFilePath[param][0], &err)) {
+            generateError(err);
+        }
+    } else if (type == THREAD_MESSAGE_SHUTDOWN) {
+        g_shutingDown = true;
+    }
+#if defined(EEZ_PLATFORM_STM32)
+    else if (type == THREAD_MESSAGE_SD_DETECT_IRQ) {
+        sd_card::onSdDetectInterruptHandler();
+    }
+#endif
+    else if (type == THREAD_MESSAGE_DLOG_STATE_TRANSITION) {
+        dlog_record::stateTransition(param);
+    } else if (type == THREAD_MESSAGE_DLOG_SHOW_FILE) {
+        dlog_view::openFile(nullptr);
+    } else if (type == THREAD_MESSAGE_DLOG_LOAD_BLOCK) {
+        dlog_view::loadBlock();
+    } else if (type == THREAD_MESSAGE_ABORT_DOWNLOADING) {
+        psu::scpi::abortDownloading();
+    } else if (type == THREAD_MESSAGE_DOWNLOAD_WRITE) {
+        sd_card::onDownloadWrite();
+    } else if (type == THREAD_MESSAGE_SCREENSHOT) {
+        if (!sd_card::isMounted(nullptr)) {
+            g_screenshotGenerating = false;
+            generateError(SCPI_ERROR_MISSING_MASS_MEDIA);
+            return;
+        }
+
+        sound::playShutter();
+
+        // Encoding takes a few hundred ms, so it is done without I/O lock to not hold back SCPI commands.
+        // Screenshot buffers are reserved by g_screenshotEncoding until the file is saved.
+        g_screenshotEncoding = true;
+        unlockIo();
+
+        const uint8_t *screenshotPixels = mcu::display::takeScreenshot();
+
+        unsigned char* imageData;
+        size_t imageDataSize;
+        int result = jpegEncode(screenshotPixels, &imageData, &imageDataSize);
+
+        lockIo();
+
+        if (result) {
+            event_queue::pushEvent(SCPI_ERROR_OUT_OF_MEMORY_FOR_REQ_OP);
+            g_screenshotEncoding = false;
+            g_screenshotGenerating = false;
+            return;
+        }
+
+        char filePath[MAX_PATH_LENGTH + 1];
+        uint8_t year, month, day, hour, minute, second;
+        datetime::getDateTime(year, month, day, hour, minute, second);
+        if (persist_conf::devConf.dateTimeFormat == datetime::FORMAT_DMY_24) {
+            sprintf(filePath, "%s/%02d_%02d_%02d-%02d_%02d_%02d.jpg",
+                SCREENSHOTS_DIR,
+                (int)day, (int)month, (int)year,
+                (int)hour, (int)minute, (int)second);
+        } else if (persist_conf::devConf.dateTimeFormat == datetime::FORMAT_MDY_24) {
+            sprintf(filePath, "%s/%02d_%02d_%02d-%02d_%02d_%02d.jpg",
+                SCREENSHOTS_DIR,
+                (int)month, (int)day, (int)year,
+                (int)hour, (int)minute, (int)second);
+        } else if (persist_conf::devConf.dateTimeFormat == datetime::FORMAT_DMY_12) {
+            bool am;
+            datetime::convertTime24to12(hour, am);
+            sprintf(filePath, "%s/%02d_%02d_%02d-%02d_%02d_%02d_%s.jpg",
+                SCREENSHOTS_DIR,
+                (int)day, (int)month, (int)year,
+                (int)hour, (int)minute, (int)second, am ? "AM" : "PM");
+        } else if (persist_conf::devConf.dateTimeFormat == datetime::FORMAT_MDY_12) {
+            bool am;
+            datetime::convertTime24to12(hour, am);
+            sprintf(filePath, "%s/%02d_%02d_%02d-%02d_%02d_%02d_%s.jpg",
+                SCREENSHOTS_DIR,
+                (int)month, (int)day, (int)year,
+                (int)hour, (int)minute, (int)second, am ? "AM" : "PM");
+        }
+
+        uint32_t timeout = millis() + CONF_SCREENSHOT_TIMEOUT_MS;
+        while (millis() < timeout) {
+            File file;
+            if (file.open(filePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
+                size_t written = file.write(imageData, imageDataSize);
+                if (written == imageDataSize) {
+                    if (file.close()) {
+                        // success!
+                        event_queue::pushEvent(event_queue::EVENT_INFO_SCREENSHOT_SAVED);
+                        onSdCardFileChangeHook(filePath);
+                        g_screenshotEncoding = false;
+                        g_screenshotGenerating = false;
+                        return;
+                    }
+                }
+            }
+
+            sd_card::reinitialize();
+        }
+
+        // timeout
+        event_queue::pushEvent(SCPI_ERROR_MASS_STORAGE_ERROR);
+        g_screenshotEncoding = false;
+        g_screenshotGenerating = false;
+    } else if (type == THREAD_MESSAGE_FILE_MANAGER_LOAD_DIRECTORY) {
+        file_manager::doLoadDirectory();
+    } else if (type == THREAD_MESSAGE_FILE_MANAGER_LOAD_DESCRIPTIONS) {
+        file_manager::loadVisibleDescriptions();
+    } else if (type == THREAD_MESSAGE_FILE_MANAGER_LOAD_THUMBNAILS) {
+        file_manager::loadVisibleThumbnails();
+    } else if (type == THREAD_MESSAGE_FILE_MANAGER_UPLOAD_FILE) {
+        file_manager::uploadFile();
+    } else if (type == THREAD_MESSAGE_FILE_MANAGER_OPEN_IMAGE_FILE) {
+        file_manager::openImageFile();
+    } else if (type == THREAD_MESSAGE_FILE_MANAGER_DELETE_FILE) {
+        file_manager::deleteFile();
+    } else if (type == THREAD_MESSAGE_FILE_MANAGER_RENAME_FILE) {
+        file_manager::doRenameFile();
+    } else if (type == THREAD_MESSAGE_DLOG_UPLOAD_FILE) {
+        dlog_view::uploadFile();
+    } else if (type == THREAD_MESSAGE_FLASH_SLAVE_UPLOAD_HEX_FILE) {
+        bp3c::flash_slave::uploadHexFile();
+    } else if (type == THREAD_MESSAGE_RECALL_PROFILE) {
+        int err;
+        if (!profile::recallFromLocation(param, 0, false, &err)) {
+            generateError(err);
+        }
+    } else if (type == THREAD_MESSAGE_LISTS_PAGE_IMPORT_LIST) {
+        psu::gui::ChSettingsListsPage::doImportList();
+    } else if (type == THREAD_MESSAGE_LISTS_PAGE_EXPORT_LIST) {
+        psu::gui::ChSettingsListsPage::doExportList();
+    } else if (type == THREAD_MESSAGE_LOAD_PROFILE) {
+        profile::loadProfileParametersToCache(param);
+    } else if (type == THREAD_MESSAGE_USER_PROFILES_PAGE_SAVE) {
+        psu::gui::UserProfilesPage::doSaveProfile();
+    } else if (type == THREAD_MESSAGE_USER_PROFILES_PAGE_RECALL) {
+        psu::gui::UserProfilesPage::doRecallProfile();
+    } else if (type == THREAD_MESSAGE_USER_PROFILES_PAGE_IMPORT) {
+        psu::gui::UserProfilesPage::doImportProfile();
+    } else if (type == THREAD_MESSAGE_USER_PROFILES_PAGE_EXPORT) {
+        psu::gui::UserProfilesPage::doExportProfile();
+    } else if (type == THREAD_MESSAGE_USER_PROFILES_PAGE_DELETE) {
+        psu::gui::UserProfilesPage::doDeleteProfile();
+    } else if (type == THREAD_MESSAGE_USER_PROFILES_PAGE_EDIT_REMARK) {
+        psu::gui::UserProfilesPage::doEditRemark();
+    } else if (type == THREAD_MESSAGE_SOUND_TICK) {
+        sound::tick();
+    } else if (type == THREAD_MESSAGE_SELECT_USB_MODE) {
+        psu::serial::selectUsbMode(param, psu::serial::g_otgMode);
+    } else if (type == THREAD_MESSAGE_SELECT_USB_DEVICE_CLASS) {
+        psu::serial::selectUsbDeviceClass(param);
+    } else if (type == THREAD_MESSAGE_ONTIME_COMMIT) {
+        ontime::doCommit();
+    }
 }
 
 void lowPriorityThreadOneIter();
@@ -199,166 +584,59 @@ void lowPriorityThreadMainLoop(const void *) {
 void lowPriorityThreadOneIter() {
     using namespace psu;
 
-    osEvent event = osMessageGet(g_lowPriorityMessageQueueId, 25);
-    if (event.status == osEventMessage) {
-    	uint32_t message = event.value.v;
-
-    	uint32_t type = QUEUE_MESSAGE_TYPE(message);
-    	uint32_t param = QUEUE_MESSAGE_PARAM(message);
-        
-        if (type < SERIAL_LAST_MESSAGE_TYPE) {
-            serial::onQueueMessage(type, param);
+    // move everything waiting in the queue to the pending list, so it can be served by priority
+    while (g_numPendingMessages < LOW_PRIORITY_THREAD_QUEUE_SIZE && (g_numPendingMessages == 0 || osMessageWaiting(g_lowPriorityMessageQueueId) > 0)) {
+        osEvent event = osMessageGet(g_lowPriorityMessageQueueId, 25);
+        if (event.status != osEventMessage) {
+            break;
         }
-#if OPTION_ETHERNET
-        else if (type < ETHERNET_LAST_MESSAGE_TYPE) {
-            ethernet::onQueueMessage(type, param);
-        }
-#endif  
-        else if (type < MP_LAST_MESSAGE_TYPE) {
-            mp::onQueueMessage(type, param);
-        } else {
-            if (type == THREAD_MESSAGE_SAVE_LIST) {
-                int err;
-                if (!list::saveList(param, &g_listFilePath[param][0], &err)) {
-                    generateError(err);
-                }
-            } else if (type == THREAD_MESSAGE_SHUTDOWN) {
-                g_shutingDown = true;
+        g_pendingMessages[g_numPendingMessages].message = event.value.v;
+        g_pendingMessages[g_numPendingMessages].time = micros();
+        g_numPendingMessages++;
+    }
+
+    if (g_numPendingMessages > 0) {
+        // first message with the highest priority, messages with the same priority are served in FIFO order
+        int messageIndex = 0;
+        int priority = getMessagePriority(QUEUE_MESSAGE_TYPE(g_pendingMessages[0].message));
+        for (int i = 1; i < g_numPendingMessages; i++) {
+            int messagePriority = getMessagePriority(QUEUE_MESSAGE_TYPE(g_pendingMessages[i].message));
+            if (messagePriority > priority) {
+                messageIndex = i;
+                priority = messagePriority;
             }
-#if defined(EEZ_PLATFORM_STM32)
-			else if (type == THREAD_MESSAGE_SD_DETECT_IRQ) {
-				sd_card::onSdDetectInterruptHandler();
-			}
-#endif
-            else if (type == THREAD_MESSAGE_DLOG_STATE_TRANSITION) {
-                dlog_record::stateTransition(param);
-            } else if (type == THREAD_MESSAGE_DLOG_SHOW_FILE) {
-                dlog_view::openFile(nullptr);
-            } else if (type == THREAD_MESSAGE_DLOG_LOAD_BLOCK) {
-                dlog_view::loadBlock();
-            } else if (type == THREAD_MESSAGE_ABORT_DOWNLOADING) {
-                psu::scpi::abortDownloading();
-            } else if (type == THREAD_MESSAGE_SCREENSHOT) {
-                if (!sd_card::isMounted(nullptr)) {
-                    g_screenshotGenerating = false;
-                    generateError(SCPI_ERROR_MISSING_MASS_MEDIA);
-                    return;
-                }
+        }
 
-                sound::playShutter();
+        uint32_t message = g_pendingMessages[messageIndex].message;
+        uint32_t receivedTime = g_pendingMessages[messageIndex].time;
 
-                const uint8_t *screenshotPixels = mcu::display::takeScreenshot();
+        g_numPendingMessages--;
+        for (int i = messageIndex; i < g_numPendingMessages; i++) {
+            g_pendingMessages[i] = g_pendingMessages[i + 1];
+        }
 
-                unsigned char* imageData;
-                size_t imageDataSize;
+        uint32_t type = QUEUE_MESSAGE_TYPE(message);
+        uint32_t param = QUEUE_MESSAGE_PARAM(message);
 
-                if (jpegEncode(screenshotPixels, &imageData, &imageDataSize)) {
-                    event_queue::pushEvent(SCPI_ERROR_OUT_OF_MEMORY_FOR_REQ_OP);
-                    g_screenshotGenerating = false;
-                    return;
-                }
+        uint32_t waitTime = micros() - receivedTime;
 
-                char filePath[MAX_PATH_LENGTH + 1];
-                uint8_t year, month, day, hour, minute, second;
-                datetime::getDateTime(year, month, day, hour, minute, second);
-                if (persist_conf::devConf.dateTimeFormat == datetime::FORMAT_DMY_24) {
-                    sprintf(filePath, "%s/%02d_%02d_%02d-%02d_%02d_%02d.jpg",
-                        SCREENSHOTS_DIR,
-                        (int)day, (int)month, (int)year,
-                        (int)hour, (int)minute, (int)second);
-                } else if (persist_conf::devConf.dateTimeFormat == datetime::FORMAT_MDY_24) {
-                    sprintf(filePath, "%s/%02d_%02d_%02d-%02d_%02d_%02d.jpg",
-                        SCREENSHOTS_DIR,
-                        (int)month, (int)day, (int)year,
-                        (int)hour, (int)minute, (int)second);
-                } else if (persist_conf::devConf.dateTimeFormat == datetime::FORMAT_DMY_12) {
-                    bool am;
-                    datetime::convertTime24to12(hour, am);
-                    sprintf(filePath, "%s/%02d_%02d_%02d-%02d_%02d_%02d_%s.jpg",
-                        SCREENSHOTS_DIR,
-                        (int)day, (int)month, (int)year,
-                        (int)hour, (int)minute, (int)second, am ? "AM" : "PM");
-                } else if (persist_conf::devConf.dateTimeFormat == datetime::FORMAT_MDY_12) {
-                    bool am;
-                    datetime::convertTime24to12(hour, am);
-                    sprintf(filePath, "%s/%02d_%02d_%02d-%02d_%02d_%02d_%s.jpg",
-                        SCREENSHOTS_DIR,
-                        (int)month, (int)day, (int)year,
-                        (int)hour, (int)minute, (int)second, am ? "AM" : "PM");
-                }
+        g_lowPriorityThreadIoLockWaitTime = 0;
+        lockIo();
+        uint32_t startTime = micros();
 
-                uint32_t timeout = millis() + CONF_SCREENSHOT_TIMEOUT_MS;
-                while (millis() < timeout) {
-                    File file;
-                    if (file.open(filePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
-                        size_t written = file.write(imageData, imageDataSize);
-                        if (written == imageDataSize) {
-                            if (file.close()) {
-                                // success!
-                                event_queue::pushEvent(event_queue::EVENT_INFO_SCREENSHOT_SAVED);
-                                onSdCardFileChangeHook(filePath);
-                                g_screenshotGenerating = false;
-                                return;
-                            }
-                        }
-                    }
+        onLowPriorityThreadMessage(type, param);
 
-                    sd_card::reinitialize();
-                }
+        unlockIo();
 
-                // timeout
-                event_queue::pushEvent(SCPI_ERROR_MASS_STORAGE_ERROR);
-                g_screenshotGenerating = false;
-            } else if (type == THREAD_MESSAGE_FILE_MANAGER_LOAD_DIRECTORY) {
-                file_manager::doLoadDirectory();
-            } else if (type == THREAD_MESSAGE_FILE_MANAGER_UPLOAD_FILE) {
-                file_manager::uploadFile();
-            } else if (type == THREAD_MESSAGE_FILE_MANAGER_OPEN_IMAGE_FILE) {
-                file_manager::openImageFile();
-            } else if (type == THREAD_MESSAGE_FILE_MANAGER_DELETE_FILE) {
-                file_manager::deleteFile();
-            } else if (type == THREAD_MESSAGE_FILE_MANAGER_RENAME_FILE) {
-                file_manager::doRenameFile();
-            } else if (type == THREAD_MESSAGE_DLOG_UPLOAD_FILE) {
-                dlog_view::uploadFile();
-            } else if (type == THREAD_MESSAGE_FLASH_SLAVE_UPLOAD_HEX_FILE) {
-                bp3c::flash_slave::uploadHexFile();
-            } else if (type == THREAD_MESSAGE_RECALL_PROFILE) {
-                int err;
-                if (!profile::recallFromLocation(param, 0, false, &err)) {
-                    generateError(err);
-                }
-            } else if (type == THREAD_MESSAGE_LISTS_PAGE_IMPORT_LIST) {
-                psu::gui::ChSettingsListsPage::doImportList();
-            } else if (type == THREAD_MESSAGE_LISTS_PAGE_EXPORT_LIST) {
-                psu::gui::ChSettingsListsPage::doExportList();
-            } else if (type == THREAD_MESSAGE_LOAD_PROFILE) {
-                profile::loadProfileParametersToCache(param);
-            } else if (type == THREAD_MESSAGE_USER_PROFILES_PAGE_SAVE) {
-                psu::gui::UserProfilesPage::doSaveProfile();
-            } else if (type == THREAD_MESSAGE_USER_PROFILES_PAGE_RECALL) {
-                psu::gui::UserProfilesPage::doRecallProfile();
-            } else if (type == THREAD_MESSAGE_USER_PROFILES_PAGE_IMPORT) {
-                psu::gui::UserProfilesPage::doImportProfile();
-            } else if (type == THREAD_MESSAGE_USER_PROFILES_PAGE_EXPORT) {
-                psu::gui::UserProfilesPage::doExportProfile();
-            } else if (type == THREAD_MESSAGE_USER_PROFILES_PAGE_DELETE) {
-                psu::gui::UserProfilesPage::doDeleteProfile();
-            } else if (type == THREAD_MESSAGE_USER_PROFILES_PAGE_EDIT_REMARK) {
-                psu::gui::UserProfilesPage::doEditRemark();
-            } else if (type == THREAD_MESSAGE_SOUND_TICK) {
-                sound::tick();
-            } else if (type == THREAD_MESSAGE_SELECT_USB_MODE) {
-                psu::serial::selectUsbMode(param, psu::serial::g_otgMode);
-            } else if (type == THREAD_MESSAGE_SELECT_USB_DEVICE_CLASS) {
-                psu::serial::selectUsbDeviceClass(param);
-            }
-        }
+        updateMessageStatistics(type, waitTime, g_lowPriorityThreadIoLockWaitTime, micros() - startTime);
     } else {
         if (g_shutingDown) {
             g_isLowPriorityThreadAlive = false;
             return;
         }
+
+        lockIo();
+
     	uint32_t tickCount = micros();
     	int32_t diff = tickCount - g_timer1LastTickCount;
 
@@ -371,12 +649,7 @@ void lowPriorityThreadOneIter() {
 
     		profile::tick();
 
-            ontime::g_mcuCounter.tick(tickCount);
-            for (int slotIndex = 0; slotIndex < NUM_SLOTS; slotIndex++) {
-                if (g_slots[slotIndex]->moduleInfo->moduleType != MODULE_TYPE_NONE) {
-                    ontime::g_moduleCounters[slotIndex].tick(tickCount);
-                }
-            }
+            ontime::tick(millis());
 
             mcu::battery::tick();
     	}
@@ -394,6 +667,8 @@ void lowPriorityThreadOneIter() {
 #ifdef DEBUG
         psu::debug::tick(tickCount);
 #endif
+
+        unlockIo();
     }
 
     return;
@@ -404,11 +679,32 @@ bool isLowPriorityThreadAlive() {
 }
 
 bool isLowPriorityThread() {
-    return osThreadGetId() == g_lowPriorityTaskHandle;
+    // SCPI thread is considered as low priority thread while it holds I/O lock,
+    // i.e. during SCPI command execution
+    osThreadId threadId = osThreadGetId();
+    return threadId == g_lowPriorityTaskHandle || (threadId == g_scpiTaskHandle && g_ioMutexOwner == threadId);
 }
 
 void sendMessageToLowPriorityThread(LowPriorityThreadMessage messageType, uint32_t messageParam, uint32_t timeoutMillisec) {
-    osMessagePut(g_lowPriorityMessageQueueId, QUEUE_MESSAGE(messageType, messageParam), timeoutMillisec);
+    if (messageType < ETHERNET_LAST_MESSAGE_TYPE) {
+        osMessagePut(g_scpiMessageQueueId, QUEUE_MESSAGE(messageType, SCPI_QUEUE_MESSAGE_PARAM(micros(), messageParam)), timeoutMillisec);
+    } else {
+        osMessagePut(g_lowPriorityMessageQueueId, QUEUE_MESSAGE(messageType, messageParam), timeoutMillisec);
+    }
+}
+
+const MessageStatistics &getMessageStatistics(LowPriorityThreadMessage messageType) {
+    return g_messageStatistics[messageType];
+}
+
+#define LOW_PRIORITY_THREAD_MESSAGE(NAME) #NAME,
+static const char *g_messageNames[] = {
+    LOW_PRIORITY_THREAD_MESSAGES
+};
+#undef LOW_PRIORITY_THREAD_MESSAGE
+
+const char *getMessageName(LowPriorityThreadMessage messageType) {
+    return g_messageNames[messageType];
 }
 
 } // namespace eez
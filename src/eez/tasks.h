@@ -23,6 +23,7 @@
 namespace eez {
 
 #define LOW_PRIORITY_THREAD_QUEUE_SIZE 10
+#define SCPI_THREAD_QUEUE_SIZE 10
 
 enum HighPriorityThreadMessage {
     PSU_MESSAGE_TICK,
@@ -47,59 +48,65 @@ enum HighPriorityThreadMessage {
     PSU_MESSAGE_CALIBRATION_START,
     PSU_MESSAGE_CALIBRATION_STOP,
     PSU_MESSAGE_FLASH_SLAVE_START,
-    PSU_MESSAGE_FLASH_SLAVE_LEAVE_BOOTLOADER_MODE
+    PSU_MESSAGE_FLASH_SLAVE_LEAVE_BOOTLOADER_MODE,
+    PSU_MESSAGE_SET_MON_FILTER
 };
 
+#define LOW_PRIORITY_THREAD_MESSAGES \
+    LOW_PRIORITY_THREAD_MESSAGE(SERIAL_INPUT_AVAILABLE) \
+    LOW_PRIORITY_THREAD_MESSAGE(SERIAL_LINE_STATE_CHANGED) \
+    LOW_PRIORITY_THREAD_MESSAGE(SERIAL_LAST_MESSAGE_TYPE) \
+    LOW_PRIORITY_THREAD_MESSAGE(ETHERNET_CONNECTED) \
+    LOW_PRIORITY_THREAD_MESSAGE(ETHERNET_CLIENT_CONNECTED) \
+    LOW_PRIORITY_THREAD_MESSAGE(ETHERNET_CLIENT_DISCONNECTED) \
+    LOW_PRIORITY_THREAD_MESSAGE(ETHERNET_INPUT_AVAILABLE) \
+    LOW_PRIORITY_THREAD_MESSAGE(ETHERNET_LAST_MESSAGE_TYPE) \
+    LOW_PRIORITY_THREAD_MESSAGE(MP_LOAD_SCRIPT) \
+    LOW_PRIORITY_THREAD_MESSAGE(MP_EXECUTE_SCPI) \
+    LOW_PRIORITY_THREAD_MESSAGE(MP_LAST_MESSAGE_TYPE) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_SAVE_LIST) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_SD_DETECT_IRQ) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_DLOG_STATE_TRANSITION) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_DLOG_SHOW_FILE) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_DLOG_LOAD_BLOCK) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_ABORT_DOWNLOADING) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_DOWNLOAD_WRITE) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_SCREENSHOT) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_FILE_MANAGER_LOAD_DIRECTORY) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_FILE_MANAGER_LOAD_DESCRIPTIONS) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_FILE_MANAGER_LOAD_THUMBNAILS) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_FILE_MANAGER_UPLOAD_FILE) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_FILE_MANAGER_OPEN_IMAGE_FILE) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_FILE_MANAGER_DELETE_FILE) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_FILE_MANAGER_RENAME_FILE) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_DLOG_UPLOAD_FILE) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_FLASH_SLAVE_UPLOAD_HEX_FILE) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_SHUTDOWN) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_RECALL_PROFILE) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_LISTS_PAGE_IMPORT_LIST) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_LISTS_PAGE_EXPORT_LIST) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_LOAD_PROFILE) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_USER_PROFILES_PAGE_SAVE) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_USER_PROFILES_PAGE_RECALL) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_USER_PROFILES_PAGE_IMPORT) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_USER_PROFILES_PAGE_EXPORT) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_USER_PROFILES_PAGE_DELETE) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_USER_PROFILES_PAGE_EDIT_REMARK) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_EVENT_QUEUE_REFRESH) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_SOUND_TICK) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_SELECT_USB_MODE) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_SELECT_USB_DEVICE_CLASS) \
+    LOW_PRIORITY_THREAD_MESSAGE(THREAD_MESSAGE_ONTIME_COMMIT) \
+
+#define LOW_PRIORITY_THREAD_MESSAGE(NAME) NAME,
 enum LowPriorityThreadMessage {
-    SERIAL_INPUT_AVAILABLE,
-    SERIAL_LINE_STATE_CHANGED,
-    
-    SERIAL_LAST_MESSAGE_TYPE,
-
-    ETHERNET_CONNECTED,
-    ETHERNET_CLIENT_CONNECTED,
-    ETHERNET_CLIENT_DISCONNECTED,
-    ETHERNET_INPUT_AVAILABLE,
-
-    ETHERNET_LAST_MESSAGE_TYPE,
-
-    MP_LOAD_SCRIPT,
-    MP_EXECUTE_SCPI,
-
-    MP_LAST_MESSAGE_TYPE,
-
-    THREAD_MESSAGE_SAVE_LIST,
-    THREAD_MESSAGE_SD_DETECT_IRQ,
-    THREAD_MESSAGE_DLOG_STATE_TRANSITION,
-    THREAD_MESSAGE_DLOG_SHOW_FILE,
-    THREAD_MESSAGE_DLOG_LOAD_BLOCK,
-    THREAD_MESSAGE_ABORT_DOWNLOADING,
-    THREAD_MESSAGE_SCREENSHOT,
-    THREAD_MESSAGE_FILE_MANAGER_LOAD_DIRECTORY,
-    THREAD_MESSAGE_FILE_MANAGER_UPLOAD_FILE,
-    THREAD_MESSAGE_FILE_MANAGER_OPEN_IMAGE_FILE,
-    THREAD_MESSAGE_FILE_MANAGER_DELETE_FILE,
-    THREAD_MESSAGE_FILE_MANAGER_RENAME_FILE,
-    THREAD_MESSAGE_DLOG_UPLOAD_FILE,
-    THREAD_MESSAGE_FLASH_SLAVE_UPLOAD_HEX_FILE,
-    THREAD_MESSAGE_SHUTDOWN,
-    THREAD_MESSAGE_RECALL_PROFILE,
-    THREAD_MESSAGE_LISTS_PAGE_IMPORT_LIST,
-    THREAD_MESSAGE_LISTS_PAGE_EXPORT_LIST,
-    THREAD_MESSAGE_LOAD_PROFILE,
-    THREAD_MESSAGE_USER_PROFILES_PAGE_SAVE,
-    THREAD_MESSAGE_USER_PROFILES_PAGE_RECALL,
-    THREAD_MESSAGE_USER_PROFILES_PAGE_IMPORT,
-    THREAD_MESSAGE_USER_PROFILES_PAGE_EXPORT,
-    THREAD_MESSAGE_USER_PROFILES_PAGE_DELETE,
-    THREAD_MESSAGE_USER_PROFILES_PAGE_EDIT_REMARK,
-    THREAD_MESSAGE_EVENT_QUEUE_REFRESH,
-    THREAD_MESSAGE_SOUND_TICK,
-    THREAD_MESSAGE_SELECT_USB_MODE,
-    THREAD_MESSAGE_SELECT_USB_DEVICE_CLASS
+    LOW_PRIORITY_THREAD_MESSAGES
+    LOW_PRIORITY_THREAD_LAST_MESSAGE_TYPE
 };
+#undef LOW_PRIORITY_THREAD_MESSAGE
 
 extern bool g_screenshotGenerating;
+extern volatile bool g_screenshotEncoding;
 
 void initHighPriorityMessageQueue();
 void startHighPriorityThread();
@@ -113,6 +120,40 @@ void startLowPriorityThread();
 bool isLowPriorityThreadAlive();
 bool isLowPriorityThread();
 
+// Serial and ethernet messages (SCPI input) are handled in the SCPI thread,
+// everything else in the low priority thread.
 void sendMessageToLowPriorityThread(LowPriorityThreadMessage messageType, uint32_t messageParam = 0, uint32_t timeoutMillisec = osWaitForever);
 
+bool isScpiThread();
+
+// Serializes SCPI command execution with the low priority thread jobs.
+void lockIo();
+void unlockIo();
+// Returns true if I/O lock is held by the calling thread.
+bool isIoLocked();
+// Called by low priority thread jobs between self-contained steps (one directory entry,
+// one DLOG buffer write): if the SCPI thread waits for the I/O lock, the lock is released
+// until the waiting command is executed. The job must re-check its state afterwards.
+// Remote command latency is thus bounded by the longest step between two yields, which is
+// reported as the I/O lock wait in DIAGnostic:INFOrmation:TASKs?. Jobs without yield points
+// (screenshot save, uploads, profile and list save) still hold the lock for the whole job.
+void yieldIo();
+// osDelay for code which waits for another thread (e.g. the PSU thread) to make progress:
+// if the calling thread holds the I/O lock, it is released while waiting.
+void delayWithoutIoLock(uint32_t ms);
+
+struct MessageStatistics {
+    uint32_t count;
+    uint32_t maxWaitTime; // us, SCPI thread: waiting in the queue (256 us resolution), low priority thread: waiting in the pending list
+    uint32_t maxIoLockWaitTime; // us, waiting for the I/O lock, for SCPI input sum of all commands of that input
+    uint32_t maxRunTime; // us
+    uint64_t totalRunTime; // us
+};
+
+const MessageStatistics &getMessageStatistics(LowPriorityThreadMessage messageType);
+const char *getMessageName(LowPriorityThreadMessage messageType);
+
+// slots and psu::tick() duration
+const RunTimeStatistics &getPsuTickStatistics();
+
 } // namespace eez
\ No newline at end of file
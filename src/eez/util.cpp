@@ -108,12 +108,132 @@ void strcatUInt32(char *str, uint32_t value) {
     sprintf(str, "%lu", (unsigned long)value);
 }
 
+static const double g_powersOf10[] = {
+    1E0, 1E1, 1E2, 1E3, 1E4, 1E5, 1E6, 1E7, 1E8, 1E9
+};
+
+static uint64_t roundHalfEven(double value) {
+    uint64_t result = (uint64_t)value;
+    double fraction = value - result;
+    if (fraction > 0.5 || (fraction == 0.5 && (result & 1))) {
+        result++;
+    }
+    return result;
+}
+
+// Integer scaled formatting, gives the same result as "%g" and "%.*f" printf formats.
+// Float has 24 bits of mantissa and 10^9 has 21 bits after removing powers of 2,
+// so value scaled to (at most) 9 decimal places is exact in double and rounding is done
+// the same way printf does it (round half to even on exact ties).
+// Exponent notation, NaN and infinity are left to sprintf.
+int floatToText(char *text, float value, int numDecimalPlaces, bool removeTrailingZeros) {
+    double absValue = fabs(value);
+
+    uint64_t mantissa;
+    int numFractionDigits;
+
+    if (isnan(value) || isinf(value)) {
+        goto useSprintf;
+    }
+
+    if (numDecimalPlaces >= 0) {
+        if (numDecimalPlaces > 9 || absValue >= 1E6) {
+            goto useSprintf;
+        }
+        mantissa = roundHalfEven(absValue * g_powersOf10[numDecimalPlaces]);
+        numFractionDigits = numDecimalPlaces;
+    } else {
+        // "%g", 6 significant digits
+        if (absValue == 0) {
+            mantissa = 0;
+            numFractionDigits = 0;
+        } else {
+            if (absValue < 1E-4 || absValue >= 1E6) {
+                goto useSprintf;
+            }
+
+            int exponent = 5;
+            while (exponent > -4 && absValue < (exponent >= 0 ? g_powersOf10[exponent] : 1.0 / g_powersOf10[-exponent])) {
+                exponent--;
+            }
+
+            mantissa = roundHalfEven(absValue * g_powersOf10[5 - exponent]);
+            if (mantissa >= 1000000) {
+                // rounded up to the next power of 10
+                exponent++;
+                if (exponent == 6) {
+                    goto useSprintf;
+                }
+                mantissa = 100000;
+            }
+
+            numFractionDigits = 5 - exponent;
+        }
+
+        removeTrailingZeros = true;
+    }
+
+    {
+        char *p = text;
+        if (signbit(value)) {
+            *p++ = '-';
+        }
+
+        char digits[24];
+        int numDigits = 0;
+        do {
+            digits[numDigits++] = '0' + mantissa % 10;
+            mantissa /= 10;
+        } while (mantissa > 0);
+
+        // at least one digit before decimal point
+        while (numDigits <= numFractionDigits) {
+            digits[numDigits++] = '0';
+        }
+
+        int firstFractionDigit = 0;
+        if (removeTrailingZeros) {
+            while (firstFractionDigit < numFractionDigits && digits[firstFractionDigit] == '0') {
+                firstFractionDigit++;
+            }
+        }
+
+        for (int i = numDigits - 1; i >= numFractionDigits; i--) {
+            *p++ = digits[i];
+        }
+
+        if (firstFractionDigit < numFractionDigits) {
+            *p++ = '.';
+            for (int i = numFractionDigits - 1; i >= firstFractionDigit; i--) {
+                *p++ = digits[i];
+            }
+        }
+
+        *p = 0;
+
+        return p - text;
+    }
+
+useSprintf:
+    int n;
+    if (numDecimalPlaces >= 0) {
+        n = sprintf(text, "%.*f", numDecimalPlaces, value);
+    } else {
+        n = sprintf(text, "%g", value);
+    }
+    if (removeTrailingZeros) {
+        removeTrailingZerosFromFloat(text);
+        n = strlen(text);
+    }
+    return n;
+}
+
 void strcatFloat(char *str, float value) {
-    sprintf(str + strlen(str), "%g", value);
+    floatToText(str + strlen(str), value);
 }
 
 void strcatFloat(char *str, float value, int numDecimalPlaces) {
-    sprintf(str + strlen(str), "%.*f", numDecimalPlaces, value);
+    floatToText(str + strlen(str), value, numDecimalPlaces);
 }
 
 void strcatVoltage(char *str, float value) {
@@ -154,36 +274,75 @@ void strcatLoad(char *str, float value) {
     }
 }
 
+// Slicing-by-8 CRC-32 (reflected polynomial 0xEDB88320, same as zlib), see
+// "A Systematic Approach to Building High Performance, Software-based, CRC Generators"
+// by M. Kounavis and F. Berry. Tables are 8 x 256 entries and built on first use.
+static uint32_t g_crc32Table[8][256];
+static volatile bool g_crc32TableInitialized;
+
+static void crc32InitTable() {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int j = 0; j < 8; j++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(int32_t)(crc & 1));
+        }
+        g_crc32Table[0][i] = crc;
+    }
+
+    for (uint32_t i = 0; i < 256; i++) {
+        for (int k = 1; k < 8; k++) {
+            g_crc32Table[k][i] = (g_crc32Table[k - 1][i] >> 8) ^ g_crc32Table[0][g_crc32Table[k - 1][i] & 0xFF];
+        }
+    }
+
+    g_crc32TableInitialized = true;
+}
+
+uint32_t crc32_update(uint32_t crc, const uint8_t *mem_block, size_t block_size) {
+    if (!g_crc32TableInitialized) {
+        crc32InitTable();
+    }
+
+    crc = ~crc;
+
+    // process leading bytes until 4-byte aligned
+    while (block_size > 0 && ((uintptr_t)mem_block & 3) != 0) {
+        crc = (crc >> 8) ^ g_crc32Table[0][(crc ^ *mem_block++) & 0xFF];
+        block_size--;
+    }
+
+    // process 8 bytes at a time (little endian)
+    const uint32_t *p = (const uint32_t *)mem_block;
+    while (block_size >= 8) {
+        uint32_t one = *p++ ^ crc;
+        uint32_t two = *p++;
+        crc = g_crc32Table[7][one & 0xFF] ^
+              g_crc32Table[6][(one >> 8) & 0xFF] ^
+              g_crc32Table[5][(one >> 16) & 0xFF] ^
+              g_crc32Table[4][one >> 24] ^
+              g_crc32Table[3][two & 0xFF] ^
+              g_crc32Table[2][(two >> 8) & 0xFF] ^
+              g_crc32Table[1][(two >> 16) & 0xFF] ^
+              g_crc32Table[0][two >> 24];
+        block_size -= 8;
+    }
+
+    // process remaining bytes
+    mem_block = (const uint8_t *)p;
+    while (block_size-- > 0) {
+        crc = (crc >> 8) ^ g_crc32Table[0][(crc ^ *mem_block++) & 0xFF];
+    }
+
+    return ~crc;
+}
+
 #if defined(EEZ_PLATFORM_STM32)
 uint32_t crc32(const uint8_t *mem_block, size_t block_size) {
 	return HAL_CRC_Calculate(&hcrc, (uint32_t *)mem_block, block_size);
 }
 #else
-/*
-From http://www.hackersdelight.org/hdcodetxt/crc.c.txt:
-
-This is the basic CRC-32 calculation with some optimization but no
-table lookup. The the byte reversal is avoided by shifting the crc reg
-right instead of left and by using a reversed 32-bit word to represent
-the polynomial.
-When compiled to Cyclops with GCC, this function executes in 8 + 72n
-instructions, where n is the number of bytes in the input message. It
-should be doable in 4 + 61n instructions.
-If the inner loop is strung out (approx. 5*8 = 40 instructions),
-it would take about 6 + 46n instructions.
-*/
-
 uint32_t crc32(const uint8_t *mem_block, size_t block_size) {
-    uint32_t crc = 0xFFFFFFFF;
-    for (size_t i = 0; i < block_size; ++i) {
-        uint32_t byte = mem_block[i]; // Get next byte.
-        crc = crc ^ byte;
-        for (int j = 0; j < 8; ++j) { // Do eight times.
-            uint32_t mask = -((int32_t)crc & 1);
-            crc = (crc >> 1) ^ (0xEDB88320 & mask);
-        }
-    }
-    return ~crc;
+    return crc32_update(0, mem_block, block_size);
 }
 #endif
 
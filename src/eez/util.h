@@ -57,6 +57,10 @@ float clamp(float x, float min, float max);
 void strcatInt(char *str, int value);
 void strcatInt32(char *str, int32_t value);
 void strcatUInt32(char *str, uint32_t value);
+// Writes value to text as "%g" (numDecimalPlaces < 0) or "%.*f" printf format would,
+// returns number of characters written.
+int floatToText(char *text, float value, int numDecimalPlaces = -1, bool removeTrailingZeros = false);
+
 void strcatFloat(char *str, float value);
 void strcatFloat(char *str, float value, int numDecimalPlaces);
 
@@ -67,6 +71,10 @@ void strcatDuration(char *str, float value);
 void strcatLoad(char *str, float value);
 
 uint32_t crc32(const uint8_t *message, size_t size);
+// Incremental CRC-32 (zlib compatible), start with crc = 0 and pass the previous
+// result to continue. Always computed in software, because on STM32 crc32()
+// uses the CRC peripheral which can't be resumed from a previous value.
+uint32_t crc32_update(uint32_t crc, const uint8_t *message, size_t size);
 
 uint8_t toBCD(uint8_t bin);
 uint8_t fromBCD(uint8_t bcd);